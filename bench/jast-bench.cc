@@ -0,0 +1,752 @@
+#include "jast/parser-builder.h"
+#include "jast/ast-cloner.h"
+#include "jast/ast-match.h"
+#include "jast/ast-walker.h"
+#include "jast/code-printer.h"
+#include "jast/compact-ast.h"
+#include "jast/scope-resolver.h"
+#include "samples/dump-ast.h"
+#include "perf-counters.h"
+
+#include <benchmark/benchmark.h>
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// jast_bench ::= google-benchmark suite for the hot paths of jast
+//
+//      jast_bench [--corpus <dir>] [--perf] [benchmark flags]...
+//
+// Every .js file in the corpus (bench/corpus by default, or $JAST_CORPUS)
+// is tokenized, parsed, dumped and matched, and the whole corpus is run once
+// more as `all`. Rates are reported as bytes_per_second (MB/s), tokens/s and
+// nodes/s, so they can be compared across files of different sizes, e.g.
+//
+//      jast_bench --benchmark_filter=Parse/all --benchmark_repetitions=5
+//
+// Latency/new and Latency/reused parse one small snippet per iteration,
+// 100 B, 1 KB and 10 KB ones cut from the corpus, with a new ParserBuilder
+// each time or with one reused with Reset(). They report the p50 and p99
+// latency of a single parse.
+//
+// Clone copies the parsed files with an ASTCloner and frees the copies. Its
+// MB/s are those of the source the trees were parsed from, to compare with
+// Parse.
+//
+// Walk/parsed and Walk/compact walk the trees of the corpus as the parser
+// left them and once moved into a CompactAST. Both report the 4 KiB pages
+// the nodes are on, which is what the trees keep resident, and page_fill,
+// the share of those pages the nodes take.
+//
+// ResolveScopes runs the ScopeResolver over the parsed corpus, and over
+// ScopeHeavy code: n functions with parameters, locals, a nested function and
+// a catch clause each. The scopes are dropped and built again every
+// iteration, so it covers both their allocation and the name lookups.
+//
+// Fold/off and Fold/on parse generated code full of constant expressions
+// without and with ASTBuilder's constant folding, and walk the result. They
+// report the size of the tree left for later passes as tree_nodes.
+//
+// ParallelParse parses the whole corpus on 1, 2, 4, ... threads up to the
+// number of cores, each with its own builders. Its bytes_per_second is the
+// total of all the threads, in wall clock time.
+//
+// --perf also reads the hardware counters around the benchmark loops of the
+// corpus and reports IPC, cycles/B and branch, L1d and LLC misses per KB of
+// source. Counters the machine doesn't have are left out, and when there is
+// none the benchmarks run as without --perf.
+using namespace jast;
+
+namespace {
+
+struct CorpusFile {
+    std::string name;
+    std::string source;
+};
+
+std::vector<CorpusFile> corpus;
+
+// set by --perf when some counter could be opened
+std::unique_ptr<PerfCounters> perf;
+
+class NodeCounter : public ASTWalker {
+public:
+    size_t count = 0;
+
+protected:
+    bool Enter(Expression *expr) override
+    {
+        count++;
+        return true;
+    }
+};
+
+// discards everything written to it, DumpAST only pays for the formatting
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int ch) override { return ch; }
+    std::streamsize xsputn(const char *s, std::streamsize n) override
+    {
+        return n;
+    }
+};
+
+Handle<Expression> Parse(const std::string &source, size_t *nodes = nullptr)
+{
+    std::istringstream is(source);
+    ParserBuilder builder(is);
+    auto ast = ParseProgram(builder.Build());
+    if (nodes)
+        *nodes = builder.context()->Counters().ASTNode();
+    return ast;
+}
+
+size_t CountNodes(Handle<Expression> ast)
+{
+    NodeCounter counter;
+    counter.Walk(ast);
+    return counter.count;
+}
+
+// the tokenizer can't tell a division from a regex by itself, the parser
+// tells it after every operand. do the same from the previous token
+bool DivideExpected(TokenType type)
+{
+    switch (type) {
+    case TokenType::IDENTIFIER:
+    case TokenType::NUMBER:
+    case TokenType::STRING:
+    case TokenType::THIS:
+    case TokenType::TRUE_LITERAL:
+    case TokenType::FALSE_LITERAL:
+    case TokenType::NULL_LITERAL:
+    case TokenType::RPAREN:
+    case TokenType::RBRACK:
+    case TokenType::RBRACE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+size_t Tokenize(const std::string &source)
+{
+    std::istringstream is(source);
+    ParserContext context;
+    Scanner scanner(is);
+    Tokenizer tokenizer(&scanner, &context);
+
+    size_t tokens = 0;
+    TokenType type;
+    while ((type = tokenizer.peek()) != TokenType::END_OF_FILE) {
+        if (type == TokenType::ERROR)
+            throw std::runtime_error("tokenizer error");
+        tokens++;
+        tokenizer.advance(DivideExpected(type));
+    }
+    return tokens;
+}
+
+void SetRates(benchmark::State &state, size_t bytes, size_t tokens,
+    size_t nodes)
+{
+    auto iterations = static_cast<double>(state.iterations());
+    if (bytes)
+        state.SetBytesProcessed(static_cast<int64_t>(bytes * iterations));
+    if (tokens) {
+        state.counters["tokens/s"] = benchmark::Counter(tokens * iterations,
+            benchmark::Counter::kIsRate);
+    }
+    if (nodes) {
+        state.counters["nodes/s"] = benchmark::Counter(nodes * iterations,
+            benchmark::Counter::kIsRate);
+    }
+}
+
+void StartPerf()
+{
+    if (perf) {
+        perf->Reset();
+        perf->Start();
+    }
+}
+
+// the events counted since StartPerf(), per byte or KB of the `bytes` of
+// source processed by every iteration
+void StopPerf(benchmark::State &state, size_t bytes)
+{
+    if (!perf)
+        return;
+    perf->Stop();
+
+    double processed = (double)bytes * state.iterations();
+    if (!processed)
+        return;
+
+    auto cycles = perf->value(PerfEvent::kCycles);
+    auto instructions = perf->value(PerfEvent::kInstructions);
+    if (perf->available(PerfEvent::kCycles)) {
+        state.counters["cycles/B"] = cycles / processed;
+        if (perf->available(PerfEvent::kInstructions) && cycles)
+            state.counters["IPC"] = (double)instructions / cycles;
+    }
+
+    auto per_kb = [&](PerfEvent event, const char *name) {
+        if (perf->available(event))
+            state.counters[name] = perf->value(event) * 1024 / processed;
+    };
+    per_kb(PerfEvent::kBranchMisses, "branch-misses/KB");
+    per_kb(PerfEvent::kL1DMisses, "L1d-misses/KB");
+    per_kb(PerfEvent::kLLCMisses, "LLC-misses/KB");
+}
+
+size_t TotalBytes(const std::vector<const CorpusFile*> &files)
+{
+    size_t bytes = 0;
+    for (auto file : files)
+        bytes += file->source.size();
+    return bytes;
+}
+
+void BM_Tokenize(benchmark::State &state,
+    std::vector<const CorpusFile*> files)
+{
+    size_t tokens = 0;
+    try {
+        StartPerf();
+        for (auto _ : state) {
+            tokens = 0;
+            for (auto file : files)
+                tokens += Tokenize(file->source);
+        }
+    } catch (std::exception &e) {
+        state.SkipWithError(e.what());
+        return;
+    }
+    StopPerf(state, TotalBytes(files));
+    SetRates(state, TotalBytes(files), tokens, 0);
+}
+
+void BM_Parse(benchmark::State &state, std::vector<const CorpusFile*> files)
+{
+    size_t tokens = 0;
+    for (auto file : files)
+        tokens += Tokenize(file->source);
+
+    size_t nodes = 0;
+    try {
+        StartPerf();
+        for (auto _ : state) {
+            nodes = 0;
+            for (auto file : files) {
+                size_t created;
+                auto ast = Parse(file->source, &created);
+                nodes += created;
+
+                // freeing the tree is part of the cost of a parse
+                ast.clear();
+            }
+        }
+    } catch (std::exception &e) {
+        state.SkipWithError(e.what());
+        return;
+    }
+    StopPerf(state, TotalBytes(files));
+    SetRates(state, TotalBytes(files), tokens, nodes);
+}
+
+void BM_DumpAST(benchmark::State &state,
+    std::vector<const CorpusFile*> files)
+{
+    std::vector<Handle<Expression>> asts;
+    size_t nodes = 0;
+    for (auto file : files) {
+        asts.push_back(Parse(file->source));
+        nodes += CountNodes(asts.back());
+    }
+
+    NullBuffer buffer;
+    std::ostream os(&buffer);
+    StartPerf();
+    for (auto _ : state) {
+        for (auto &ast : asts) {
+            printer::DumpAST dump(os, 1);
+            ast->Accept(&dump);
+        }
+    }
+    StopPerf(state, TotalBytes(files));
+    SetRates(state, 0, 0, nodes);
+}
+
+void BM_Clone(benchmark::State &state, std::vector<const CorpusFile*> files)
+{
+    std::vector<Handle<Expression>> asts;
+    size_t nodes = 0;
+    for (auto file : files) {
+        asts.push_back(Parse(file->source));
+        nodes += CountNodes(asts.back());
+    }
+
+    ASTCloner cloner;
+    StartPerf();
+    for (auto _ : state) {
+        for (auto &ast : asts) {
+            auto copy = cloner.Clone(ast.GetPtr());
+            benchmark::DoNotOptimize(copy.GetPtr());
+        }
+    }
+    StopPerf(state, TotalBytes(files));
+    SetRates(state, TotalBytes(files), 0, nodes);
+}
+
+// the pages the nodes under `ast` are on and the bytes of the nodes, each
+// node counted once
+class PageCounter : public ASTWalker {
+public:
+    std::unordered_set<uintptr_t> pages;
+    size_t bytes = 0;
+
+protected:
+    bool Enter(Expression *expr) override
+    {
+        if (!nodes_.insert(expr).second)
+            return false;
+        auto first = reinterpret_cast<uintptr_t>(expr);
+        auto size = SizeOfNode(expr->type());
+        for (auto page = first >> 12; page <= (first + size - 1) >> 12; page++)
+            pages.insert(page);
+        bytes += size;
+        return true;
+    }
+
+private:
+    std::unordered_set<Expression*> nodes_;
+};
+
+template <bool compact>
+void BM_Walk(benchmark::State &state, std::vector<const CorpusFile*> files)
+{
+    std::vector<Handle<Expression>> asts;
+    std::vector<std::unique_ptr<CompactAST>> compacted;
+    size_t nodes = 0;
+    for (auto file : files) {
+        auto ast = Parse(file->source);
+        nodes += CountNodes(ast);
+        if (compact) {
+            compacted.push_back(std::make_unique<CompactAST>(ast));
+            ast = compacted.back()->root();
+        }
+        asts.push_back(ast);
+    }
+
+    PageCounter pages;
+    for (auto &ast : asts)
+        pages.Walk(ast);
+
+    StartPerf();
+    for (auto _ : state) {
+        for (auto &ast : asts) {
+            NodeCounter counter;
+            counter.Walk(ast);
+            benchmark::DoNotOptimize(counter.count);
+        }
+    }
+    StopPerf(state, TotalBytes(files));
+    SetRates(state, 0, 0, nodes);
+    state.counters["pages"] = static_cast<double>(pages.pages.size());
+    state.counters["page_fill"] = static_cast<double>(pages.bytes)
+        / (pages.pages.size() * 4096.0);
+
+    // the handles go before the compact trees
+    asts.clear();
+}
+
+// matches two separately parsed copies of every file, so the matcher can't
+// stop at a shared pointer and has to compare every node
+template <typename Matcher>
+void BM_Match(benchmark::State &state, std::vector<const CorpusFile*> files)
+{
+    std::vector<Handle<Expression>> a, b;
+    size_t nodes = 0;
+    for (auto file : files) {
+        a.push_back(Parse(file->source));
+        b.push_back(Parse(file->source));
+        nodes += CountNodes(a.back());
+    }
+
+    StartPerf();
+    for (auto _ : state) {
+        for (size_t i = 0; i < a.size(); i++) {
+            if (!Matcher::match(a[i], b[i])) {
+                state.SkipWithError("the two parses don't match");
+                return;
+            }
+        }
+    }
+    StopPerf(state, TotalBytes(files));
+    SetRates(state, 0, 0, nodes);
+}
+
+// statements of the corpus at any depth, printed back as source
+class StatementCollector : public ASTWalker {
+public:
+    std::vector<std::string> statements;
+
+protected:
+    bool Enter(Expression *expr) override
+    {
+        if (!expr->IsBlockStatement())
+            return true;
+        for (auto &stmt : *expr->AsBlockStatement()->statements()) {
+            std::ostringstream os;
+            CodePrinter printer(os);
+            printer.Print(stmt);
+            statements.push_back(os.str());
+        }
+        return true;
+    }
+};
+
+// up to 1000 snippets of at least `size` bytes, corpus statements no longer
+// than `size` packed together in source order
+std::vector<std::string> Snippets(size_t size)
+{
+    static std::vector<std::string> statements;
+    if (statements.empty()) {
+        StatementCollector collector;
+        for (auto &file : corpus)
+            collector.Walk(Parse(file.source));
+        statements = std::move(collector.statements);
+    }
+
+    std::vector<std::string> snippets;
+    std::string snippet;
+    for (auto &stmt : statements) {
+        if (stmt.size() > size)
+            continue;
+        snippet += stmt;
+        if (snippet.size() < size)
+            continue;
+
+        try {
+            Parse(snippet);
+            snippets.push_back(snippet);
+        } catch (std::exception &) {
+            // a statement only valid in its context, e.g. a return
+        }
+        snippet.clear();
+        if (snippets.size() == 1000)
+            break;
+    }
+    return snippets;
+}
+
+// Latency ::= one parse of a snippet per iteration, freeing the tree
+// included. `reuse` parses all of them with the same ParserBuilder
+void BM_Latency(benchmark::State &state, bool reuse)
+{
+    auto snippets = Snippets(static_cast<size_t>(state.range(0)));
+    if (snippets.empty()) {
+        state.SkipWithError("no snippet of that size in the corpus");
+        return;
+    }
+
+    std::istringstream empty;
+    ParserBuilder builder(empty);
+    std::vector<uint64_t> latencies;
+    size_t next = 0, bytes = 0;
+
+    try {
+        for (auto _ : state) {
+            auto &source = snippets[next++ % snippets.size()];
+            auto start = std::chrono::steady_clock::now();
+            if (reuse) {
+                builder.Reset(source);
+                auto ast = ParseProgram(builder.Build());
+            } else {
+                std::istringstream is(source);
+                ParserBuilder fresh(is);
+                auto ast = ParseProgram(fresh.Build());
+            }
+            auto diff = std::chrono::steady_clock::now() - start;
+            latencies.push_back(std::chrono::duration_cast<
+                std::chrono::nanoseconds>(diff).count());
+            bytes += source.size();
+        }
+    } catch (std::exception &e) {
+        state.SkipWithError(e.what());
+        return;
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    auto percentile = [&latencies](double p) {
+        size_t rank = (size_t)(p / 100 * (latencies.size() - 1));
+        auto nth = latencies.begin() + rank;
+        std::nth_element(latencies.begin(), nth, latencies.end());
+        return (double)*nth;
+    };
+    state.counters["p50_ns"] = percentile(50);
+    state.counters["p99_ns"] = percentile(99);
+}
+
+// the scopes of `trees` resolved again and again with one ScopeManager
+void ResolveScopes(benchmark::State &state,
+    const std::vector<Handle<Expression>> &trees, size_t bytes)
+{
+    std::istringstream empty;
+    ParserBuilder builder(empty);
+    size_t nodes = 0;
+    for (auto &ast : trees)
+        nodes += CountNodes(ast);
+
+    for (auto _ : state) {
+        builder.manager()->Reset();
+        ScopeResolver resolver(builder.manager());
+        for (auto &ast : trees)
+            resolver.Resolve(ast);
+    }
+    SetRates(state, bytes, 0, nodes);
+}
+
+void BM_ResolveScopes(benchmark::State &state,
+    std::vector<const CorpusFile*> files)
+{
+    std::vector<Handle<Expression>> trees;
+    for (auto file : files)
+        trees.push_back(Parse(file->source));
+    ResolveScopes(state, trees, TotalBytes(files));
+}
+
+// `count` functions with a nested function and a catch clause each, which
+// use names of every scope around them
+std::string ScopeHeavyCode(size_t count)
+{
+    std::string code;
+    for (size_t i = 0; i < count; i++) {
+        auto f = "f" + std::to_string(i);
+        code += "function " + f + "(a, b, c, d) {\n"
+            "    var x = a + b, y = c * d, z;\n"
+            "    function g(e) {\n"
+            "        try { z = x + e * y; } catch (err) { return err + a; }\n"
+            "        return z + b + " + f + ";\n"
+            "    }\n"
+            "    for (var i = 0; i < a; i++) { x = g(i) + arguments[0]; }\n"
+            "    return x + y + z + w + console.log(d);\n"
+            "}\n";
+    }
+    return code;
+}
+
+void BM_ScopeHeavy(benchmark::State &state)
+{
+    auto code = ScopeHeavyCode(static_cast<size_t>(state.range(0)));
+    ResolveScopes(state, { Parse(code) }, code.size());
+}
+
+// `count` statements the way code generators and minifiers leave them, with
+// constants spelled out as expressions
+std::string ConstantHeavyCode(size_t count)
+{
+    std::string code;
+    for (size_t i = 0; i < count; i++) {
+        auto n = std::to_string(i);
+        code += "var k" + n + " = 4 * 1024 * 1024 + " + n + ","
+            " s" + n + " = 'id-' + " + n + " + '-' + (1 << 4),"
+            " m" + n + " = (1 << 16) - 1 | 0;\n"
+            "if (!0 && typeof 1 === 'number') {\n"
+            "    f(k" + n + " * (60 * 60 * 1000), !1 ? 'dev' : 'prod',"
+            " 0x7f & ~0x0f, void 0);\n"
+            "}\n";
+    }
+    return code;
+}
+
+// Fold ::= parse of ConstantHeavy code with constant folding off or on, and a
+// walk over the tree it gave, standing in for the passes which come after
+void BM_Fold(benchmark::State &state, bool fold)
+{
+    auto code = ConstantHeavyCode(static_cast<size_t>(state.range(0)));
+    size_t nodes = 0;
+    for (auto _ : state) {
+        std::istringstream is(code);
+        ParserBuilder builder(is);
+        builder.builder()->SetConstantFolding(fold);
+        auto ast = ParseProgram(builder.Build());
+        nodes = CountNodes(ast);
+    }
+    SetRates(state, code.size(), 0, nodes);
+    state.counters["tree_nodes"] = static_cast<double>(nodes);
+}
+
+// ParallelParse ::= every thread parses the whole corpus, nothing is shared
+// but the factory
+void BM_ParallelParse(benchmark::State &state)
+{
+    size_t bytes = 0;
+    for (auto &file : corpus)
+        bytes += file.source.size();
+
+    for (auto _ : state) {
+        for (auto &file : corpus) {
+            auto ast = Parse(file.source);
+            benchmark::DoNotOptimize(ast.GetPtr());
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes * state.iterations()));
+}
+
+// ASTFactory ::= n statements of `a + b * c;` built directly with the
+// factory, and freed, without a parser around it
+void BM_Factory(benchmark::State &state)
+{
+    auto factory = ASTFactory::GetFactoryInstance();
+    Position pos;
+    auto count = static_cast<size_t>(state.range(0));
+
+    for (auto _ : state) {
+        auto list = factory->NewExpressionList();
+        for (size_t i = 0; i < count; i++) {
+            auto product = factory->NewBinaryExpression(pos, nullptr,
+                BinaryOperation::kMultiplication,
+                factory->NewIdentifier(pos, nullptr, "b"),
+                factory->NewIdentifier(pos, nullptr, "c"));
+            list->Insert(factory->NewBinaryExpression(pos, nullptr,
+                BinaryOperation::kAddition,
+                factory->NewIdentifier(pos, nullptr, "a"), product));
+        }
+        auto block = factory->NewBlockStatement(pos, nullptr, list);
+        benchmark::DoNotOptimize(block.GetPtr());
+    }
+
+    // five nodes per statement and the block
+    SetRates(state, 0, 0, count * 5 + 1);
+}
+
+bool ReadCorpus(const std::string &dir)
+{
+    DIR *d = opendir(dir.c_str());
+    if (!d) {
+        std::cerr << dir << ": unable to open the corpus\n";
+        return false;
+    }
+
+    while (auto entry = readdir(d)) {
+        std::string name = entry->d_name;
+        if (name.size() < 4 || name.compare(name.size() - 3, 3, ".js"))
+            continue;
+
+        std::ifstream in(dir + "/" + name);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        corpus.push_back(CorpusFile{ name.substr(0, name.size() - 3),
+            ss.str() });
+    }
+    closedir(d);
+
+    std::sort(corpus.begin(), corpus.end(),
+        [](const CorpusFile &a, const CorpusFile &b) {
+            return a.name < b.name;
+        });
+
+    // a corpus file the parser rejects would only measure the error path
+    for (auto &file : corpus) {
+        try {
+            Parse(file.source);
+        } catch (std::exception &) {
+            std::cerr << file.name << ".js: does not parse\n";
+            return false;
+        }
+    }
+    return !corpus.empty();
+}
+
+template <typename Function>
+void RegisterCorpus(const std::string &name, Function function)
+{
+    std::vector<const CorpusFile*> all;
+    for (auto &file : corpus) {
+        all.push_back(&file);
+        benchmark::RegisterBenchmark((name + "/" + file.name).c_str(),
+            function, std::vector<const CorpusFile*>{ &file });
+    }
+    benchmark::RegisterBenchmark((name + "/all").c_str(), function, all);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    std::string dir = JAST_CORPUS;
+    if (auto env = std::getenv("JAST_CORPUS"))
+        dir = env;
+
+    // --corpus and --perf are ours, everything else goes to google-benchmark
+    bool use_perf = false;
+    int rest = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--corpus") && i + 1 < argc)
+            dir = argv[++i];
+        else if (!strcmp(argv[i], "--perf"))
+            use_perf = true;
+        else
+            argv[rest++] = argv[i];
+    }
+    argc = rest;
+
+    if (use_perf) {
+        perf = std::make_unique<PerfCounters>();
+        if (!perf->error().empty())
+            std::cerr << "perf counters: " << perf->error() << "\n";
+        if (!perf->any()) {
+            std::cerr << "perf counters: none available, running without\n";
+            perf.reset();
+        }
+    }
+
+    if (!ReadCorpus(dir))
+        return -1;
+
+    RegisterCorpus("Tokenize", BM_Tokenize);
+    RegisterCorpus("Parse", BM_Parse);
+    RegisterCorpus("Clone", BM_Clone);
+    RegisterCorpus("DumpAST", BM_DumpAST);
+    RegisterCorpus("Walk/parsed", BM_Walk<false>);
+    RegisterCorpus("Walk/compact", BM_Walk<true>);
+    RegisterCorpus("FastASTMatcher", BM_Match<FastASTMatcher>);
+    RegisterCorpus("LazyASTMatcher", BM_Match<LazyASTMatcher>);
+    benchmark::RegisterBenchmark("ASTFactory", BM_Factory)
+        ->Arg(1000)->Arg(100000);
+    RegisterCorpus("ResolveScopes", BM_ResolveScopes);
+    benchmark::RegisterBenchmark("ResolveScopes/ScopeHeavy", BM_ScopeHeavy)
+        ->Arg(10)->Arg(1000);
+    benchmark::RegisterBenchmark("Fold/off", BM_Fold, false)->Arg(1000);
+    benchmark::RegisterBenchmark("Fold/on", BM_Fold, true)->Arg(1000);
+    benchmark::RegisterBenchmark("ParallelParse", BM_ParallelParse)
+        ->ThreadRange(1, std::max(1u, std::thread::hardware_concurrency()))
+        ->UseRealTime();
+    benchmark::RegisterBenchmark("Latency/new", BM_Latency, false)
+        ->Arg(100)->Arg(1000)->Arg(10000);
+    benchmark::RegisterBenchmark("Latency/reused", BM_Latency, true)
+        ->Arg(100)->Arg(1000)->Arg(10000);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return -1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include "perf-counters.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace jast {
+
+namespace {
+
+const char *event_names[] = {
+#define PERF_EVENT_NAME(Event, name) name,
+PERF_EVENT_LIST(PERF_EVENT_NAME)
+#undef PERF_EVENT_NAME
+};
+
+#ifdef __linux__
+struct EventConfig {
+    uint32_t type;
+    uint64_t config;
+};
+
+const uint64_t kCacheReadMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8)
+    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+EventConfig event_configs[] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | kCacheReadMiss },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | kCacheReadMiss },
+};
+
+static_assert(sizeof(event_configs) / sizeof(event_configs[0])
+    == (size_t)PerfEvent::kNrEvent, "an EventConfig for every PerfEvent");
+
+int OpenEvent(const EventConfig &event)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+        | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // this thread, on any cpu
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+}
+
+const char *PerfEventName(PerfEvent event)
+{
+    return event_names[(int)event];
+}
+
+PerfCounters::PerfCounters()
+{
+    for (auto &fd : fds_)
+        fd = -1;
+
+#ifdef __linux__
+    for (int i = 0; i < (int)PerfEvent::kNrEvent; i++) {
+        fds_[i] = OpenEvent(event_configs[i]);
+        if (fds_[i] < 0 && error_.empty()) {
+            error_ = std::string(event_names[i]) + ": " + strerror(errno);
+            if (errno == EACCES || errno == EPERM)
+                error_ += " (see /proc/sys/kernel/perf_event_paranoid)";
+        }
+    }
+#else
+    error_ = "perf_event_open is only available on Linux";
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+    for (auto fd : fds_) {
+        if (fd >= 0)
+            close(fd);
+    }
+#endif
+}
+
+bool PerfCounters::any() const
+{
+    for (auto fd : fds_) {
+        if (fd >= 0)
+            return true;
+    }
+    return false;
+}
+
+void PerfCounters::Start()
+{
+#ifdef __linux__
+    for (auto fd : fds_) {
+        if (fd >= 0)
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+void PerfCounters::Stop()
+{
+#ifdef __linux__
+    for (auto fd : fds_) {
+        if (fd >= 0)
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+#endif
+}
+
+void PerfCounters::Reset()
+{
+#ifdef __linux__
+    for (auto fd : fds_) {
+        if (fd >= 0)
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    }
+#endif
+}
+
+uint64_t PerfCounters::value(PerfEvent event) const
+{
+#ifdef __linux__
+    int fd = fds_[(int)event];
+    if (fd < 0)
+        return 0;
+
+    // value, time enabled, time running
+    uint64_t data[3];
+    if (read(fd, data, sizeof(data)) != sizeof(data) || !data[2])
+        return 0;
+    if (data[2] == data[1])
+        return data[0];
+    return (uint64_t)((double)data[0] * data[1] / data[2]);
+#else
+    return 0;
+#endif
+}
+
+}
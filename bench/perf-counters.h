@@ -0,0 +1,66 @@
+#ifndef PERF_COUNTERS_H_
+#define PERF_COUNTERS_H_
+
+#include <cstdint>
+#include <string>
+
+namespace jast {
+
+// hardware events read by PerfCounters, with their perf(1) names
+#define PERF_EVENT_LIST(F) \
+    F(Cycles, "cycles") \
+    F(Instructions, "instructions") \
+    F(BranchMisses, "branch-misses") \
+    F(L1DMisses, "L1-dcache-load-misses") \
+    F(LLCMisses, "LLC-load-misses")
+
+enum class PerfEvent {
+#define PERF_EVENT_ENUM(Event, name) k##Event,
+PERF_EVENT_LIST(PERF_EVENT_ENUM)
+#undef PERF_EVENT_ENUM
+    kNrEvent
+};
+
+const char *PerfEventName(PerfEvent event);
+
+// PerfCounters ::= the hardware counters of the calling thread, read with
+// Linux perf_event_open(2)
+//
+// Every event is opened on its own, so a machine (or a VM) without an LLC
+// event still counts cycles and instructions. Events that can't be opened
+// at all, e.g. with a high kernel.perf_event_paranoid, in a container or on
+// other systems than Linux, are not available() and read 0; error() says
+// why. Only user space is counted.
+//
+// Counts accumulate over every Start() / Stop() pair until Reset(). When the
+// kernel multiplexes more events than the PMU has counters, the values are
+// scaled up from the time the event actually ran.
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    bool available(PerfEvent event) const { return fds_[(int)event] >= 0; }
+
+    // at least one event could be opened
+    bool any() const;
+
+    const std::string &error() const { return error_; }
+
+    void Start();
+    void Stop();
+    void Reset();
+
+    uint64_t value(PerfEvent event) const;
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+private:
+    int fds_[(int)PerfEvent::kNrEvent];
+    std::string error_;
+};
+
+}
+
+#endif
@@ -0,0 +1,258 @@
+#include "synthetic.h"
+#include "jast/parser-builder.h"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// jast_scaling ::= parses every synthetic shape at growing sizes and reports
+// how time and memory grow with the input
+//
+//      jast_scaling [--shape <shape>]... [--min <n>] [--max <n>]
+//                   [--factor <f>] [--seed <s>] [--repeat <n>]
+//                   [--timeout <sec>] [--csv]
+//
+// Sizes go from --min to --max (1024 to 1048576 by default), multiplied by
+// --factor (4) every step. Each input is parsed in a child process, so a
+// stack overflow or a timeout is reported as such and the next size still
+// runs, and the peak RSS of the child is the memory of that parse alone.
+// The time is the fastest of --repeat (3) parses, the timeout covers all of
+// them.
+//
+// `exp` is the growth exponent of the parse time between a size and the
+// previous one, log(t2 / t1) / log(bytes2 / bytes1): about 1 when parsing is
+// linear. Rows above 1.25 are marked as super-linear. --csv prints the rows
+// for plotting instead, e.g. with gnuplot:
+//
+//      plot "< grep ^binary scaling.csv" using 3:4 with lines
+using namespace jast;
+
+namespace {
+
+struct Sample {
+    size_t bytes;
+    size_t nodes;
+    double ms;
+    size_t heap;
+};
+
+struct Row {
+    Sample sample;
+    std::string status;
+    long peak_rss_kb;
+};
+
+size_t HeapInUse()
+{
+#ifdef __GLIBC__
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+// runs in the child. the fastest of `repeat` parses is kept, the heap is
+// measured while the AST of the last one is alive
+Sample Measure(SyntheticShape shape, size_t size, uint64_t seed,
+    unsigned repeat)
+{
+    std::string source = GenerateSynthetic(shape, size, seed);
+    Sample sample{ source.size(), 0, 0, 0 };
+
+    for (unsigned i = 0; i < repeat; i++) {
+        std::istringstream is(source);
+        ParserBuilder builder(is);
+
+        size_t before = HeapInUse();
+        auto start = std::chrono::high_resolution_clock::now();
+        auto ast = ParseProgram(builder.Build());
+        auto diff = std::chrono::high_resolution_clock::now() - start;
+
+        double ms = std::chrono::duration_cast<std::chrono::microseconds>(
+            diff).count() / 1e3;
+        if (i == 0 || ms < sample.ms)
+            sample.ms = ms;
+        sample.nodes = builder.context()->Counters().ASTNode();
+        sample.heap = HeapInUse() - before;
+    }
+    return sample;
+}
+
+Row Run(SyntheticShape shape, size_t size, uint64_t seed, unsigned repeat,
+    unsigned timeout)
+{
+    Row row{ Sample{ 0, 0, 0, 0 }, "ok", 0 };
+
+    int fds[2];
+    if (pipe(fds) < 0) {
+        row.status = "pipe failed";
+        return row;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        alarm(timeout);
+
+        Sample sample;
+        try {
+            sample = Measure(shape, size, seed, repeat);
+        } catch (std::exception &) {
+            _exit(2);
+        }
+        ssize_t written = write(fds[1], &sample, sizeof(sample));
+        _exit(written == sizeof(sample) ? 0 : 3);
+    }
+
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        row.status = "fork failed";
+        return row;
+    }
+
+    ssize_t got = read(fds[0], &row.sample, sizeof(row.sample));
+    close(fds[0]);
+
+    int status;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    row.peak_rss_kb = usage.ru_maxrss;
+
+    if (WIFSIGNALED(status)) {
+        int sig = WTERMSIG(status);
+        row.status = sig == SIGALRM ? "timeout"
+            : sig == SIGSEGV ? "crashed (stack overflow?)"
+            : std::string("killed by signal ") + std::to_string(sig);
+    } else if (WEXITSTATUS(status) == 2) {
+        row.status = "syntax error";
+    } else if (WEXITSTATUS(status) != 0 || got != sizeof(row.sample)) {
+        row.status = "failed";
+    }
+    return row;
+}
+
+void Usage(const char *argv0)
+{
+    std::cerr << "usage: " << argv0
+        << " [--shape <shape>]... [--min <n>] [--max <n>] [--factor <f>]\n"
+           "       [--seed <s>] [--repeat <n>] [--timeout <sec>] [--csv]\n\n"
+           "shapes:\n";
+    for (auto shape : SyntheticShapes()) {
+        std::cerr << "  " << SyntheticShapeName(shape) << "\t"
+            << SyntheticShapeHelp(shape) << "\n";
+    }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<SyntheticShape> shapes;
+    size_t min = 1024, max = 1048576, factor = 4;
+    uint64_t seed = 0;
+    unsigned repeat = 3, timeout = 60;
+    bool csv = false;
+
+    for (int i = 1; i < argc; i++) {
+        SyntheticShape shape;
+        if (!strcmp(argv[i], "--shape") && i + 1 < argc
+                && ParseSyntheticShape(argv[i + 1], &shape)) {
+            shapes.push_back(shape);
+            i++;
+        } else if (!strcmp(argv[i], "--min") && i + 1 < argc) {
+            min = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--max") && i + 1 < argc) {
+            max = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--factor") && i + 1 < argc) {
+            factor = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            repeat = std::atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--timeout") && i + 1 < argc) {
+            timeout = std::atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--csv")) {
+            csv = true;
+        } else {
+            Usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (!min || min > max || factor < 2 || !repeat) {
+        Usage(argv[0]);
+        return -1;
+    }
+    if (shapes.empty())
+        shapes = SyntheticShapes();
+
+    if (csv) {
+        std::cout << "shape,size,bytes,parse_ms,nodes,heap_bytes,"
+            "peak_rss_kb,status\n";
+    } else {
+        std::cout << std::left << std::setw(8) << "shape" << std::right
+            << std::setw(10) << "size" << std::setw(12) << "bytes"
+            << std::setw(12) << "parse ms" << std::setw(10) << "ns/byte"
+            << std::setw(12) << "heap KB" << std::setw(12) << "peak KB"
+            << std::setw(7) << "exp" << "\n";
+    }
+
+    std::cout << std::fixed;
+    for (auto shape : shapes) {
+        const char *name = SyntheticShapeName(shape);
+        Row last{ Sample{ 0, 0, 0, 0 }, "", 0 };
+
+        for (size_t size = min; size <= max; size *= factor) {
+            Row row = Run(shape, size, seed, repeat, timeout);
+            auto &s = row.sample;
+
+            if (csv) {
+                std::cout << name << "," << size << "," << s.bytes << ","
+                    << std::setprecision(3) << s.ms << "," << s.nodes << ","
+                    << s.heap << "," << row.peak_rss_kb << ","
+                    << row.status << "\n";
+                continue;
+            }
+
+            std::cout << std::left << std::setw(8) << name << std::right
+                << std::setw(10) << size;
+            if (row.status != "ok") {
+                std::cout << "  " << row.status << "\n";
+                last = row;
+                continue;
+            }
+
+            std::cout << std::setw(12) << s.bytes << std::setprecision(2)
+                << std::setw(12) << s.ms
+                << std::setw(10) << s.ms * 1e6 / s.bytes
+                << std::setw(12) << s.heap / 1024
+                << std::setw(12) << row.peak_rss_kb;
+
+            // tiny timings are all noise
+            if (last.status == "ok" && last.sample.ms >= 1) {
+                double exp = std::log(s.ms / last.sample.ms)
+                    / std::log((double)s.bytes / last.sample.bytes);
+                std::cout << std::setw(7) << exp;
+                if (exp > 1.25)
+                    std::cout << "  super-linear";
+            }
+            std::cout << "\n";
+            last = row;
+        }
+    }
+    return 0;
+}
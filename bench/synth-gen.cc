@@ -0,0 +1,55 @@
+#include "synthetic.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// jast_gen ::= writes a synthetic stress input to stdout
+//
+//      jast_gen --shape <shape> --size <n> [--seed <s>]
+//
+// The same arguments always give the same bytes, see synthetic.h.
+using namespace jast;
+
+static void Usage(const char *argv0)
+{
+    std::cerr << "usage: " << argv0
+        << " --shape <shape> --size <n> [--seed <s>]\n\nshapes:\n";
+    for (auto shape : SyntheticShapes()) {
+        std::cerr << "  " << SyntheticShapeName(shape) << "\t"
+            << SyntheticShapeHelp(shape) << "\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    SyntheticShape shape;
+    bool has_shape = false;
+    size_t size = 0;
+    uint64_t seed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--shape") && i + 1 < argc) {
+            has_shape = ParseSyntheticShape(argv[++i], &shape);
+            if (!has_shape) {
+                std::cerr << argv[i] << ": unknown shape\n";
+                return -1;
+            }
+        } else if (!strcmp(argv[i], "--size") && i + 1 < argc) {
+            size = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            has_shape = false;
+            break;
+        }
+    }
+
+    if (!has_shape || !size) {
+        Usage(argv[0]);
+        return -1;
+    }
+
+    std::cout << GenerateSynthetic(shape, size, seed);
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include "synthetic.h"
+
+#include <random>
+
+namespace jast {
+
+namespace {
+
+class Generator {
+public:
+    Generator(uint64_t seed)
+        : random_{ seed }
+    { }
+
+    // uniform enough for picking tokens, n is always tiny
+    size_t Next(size_t n) { return random_() % n; }
+
+    template <size_t N>
+    const char *Pick(const char *const (&choices)[N])
+    {
+        return choices[Next(N)];
+    }
+
+    std::string Identifier()
+    {
+        static const char *const names[] = {
+            "a", "b", "c", "value", "index", "item", "result", "_tmp", "$el"
+        };
+        return Pick(names);
+    }
+
+    std::string Number()
+    {
+        std::string number = std::to_string(Next(100000));
+        if (Next(4) == 0)
+            number += "." + std::to_string(Next(1000));
+        return number;
+    }
+
+    std::string String(size_t length)
+    {
+        static const char *const escapes[] = {
+            "\\n", "\\t", "\\\\", "\\\"", "\\'"
+        };
+        std::string str = "\"";
+        str.reserve(length + 2);
+        for (size_t i = 0; i < length; i++) {
+            if (Next(16) == 0)
+                str += Pick(escapes);
+            else
+                str += static_cast<char>('a' + Next(26));
+        }
+        return str + "\"";
+    }
+
+    std::string Array(size_t n);
+    std::string Table(size_t n);
+    std::string Object(size_t n);
+    std::string Calls(size_t n);
+    std::string Binary(size_t n);
+    std::string Switch(size_t n);
+    std::string Regex(size_t n);
+
+private:
+    std::mt19937_64 random_;
+};
+
+std::string Generator::Array(size_t n)
+{
+    std::string source = "var array = [";
+    for (size_t i = 0; i < n; i++) {
+        if (i)
+            source += ", ";
+        switch (Next(4)) {
+        case 0: source += Identifier(); break;
+        case 1: source += String(Next(8)); break;
+        default: source += Number(); break;
+        }
+    }
+    return source + "];\n";
+}
+
+std::string Generator::Table(size_t n)
+{
+    std::string source = "var table = [";
+    for (size_t i = 0; i < n; i++) {
+        if (i)
+            source += i % 16 ? ", " : ",\n    ";
+        source += Number();
+    }
+    return source + "];\n";
+}
+
+std::string Generator::Object(size_t n)
+{
+    std::string source = "var config = {";
+    for (size_t i = 0; i < n; i++) {
+        if (i)
+            source += ",";
+        // one key in eight overrides an earlier one
+        size_t key = Next(8) == 0 ? Next(i + 1) : i;
+        source += "\n    key" + std::to_string(key) + ": ";
+        switch (Next(4)) {
+        case 0: source += Identifier(); break;
+        case 1: source += String(Next(8)); break;
+        default: source += Number(); break;
+        }
+    }
+    return source + "\n};\n";
+}
+
+std::string Generator::Calls(size_t n)
+{
+    static const char *const callees[] = { "f", "g", "h", "obj.call" };
+
+    // the extra arguments of every level, closed innermost first
+    std::vector<std::string> rest(n);
+    std::string source = "result = ";
+    for (size_t i = 0; i < n; i++) {
+        source += Pick(callees);
+        source += '(';
+        if (Next(4) == 0)
+            rest[i] = ", " + Number();
+    }
+    source += Identifier();
+
+    for (size_t i = n; i-- > 0; )
+        source += rest[i] + ")";
+    return source + ";\n";
+}
+
+std::string Generator::Binary(size_t n)
+{
+    static const char *const ops[] = {
+        " + ", " - ", " * ", " / ", " % ", " < ", " == ", " && ", " || ",
+        " & ", " | ", " ^ ", " << "
+    };
+
+    std::string source = "result = " + Identifier();
+    for (size_t i = 0; i < n; i++) {
+        source += Pick(ops);
+        source += Next(2) ? Identifier() : Number();
+    }
+    return source + ";\n";
+}
+
+std::string Generator::Switch(size_t n)
+{
+    std::string source = "switch (value) {\n";
+    for (size_t i = 0; i < n; i++) {
+        source += "case " + std::to_string(i) + ":\n";
+        source += "    result = " + Identifier() + " + " + Number() + ";\n";
+        if (Next(4))
+            source += "    break;\n";
+    }
+    return source + "default:\n    result = 0;\n}\n";
+}
+
+std::string Generator::Regex(size_t n)
+{
+    static const char *const regexes[] = {
+        "/ab+c/g", "/[/]x/i", "/\\d+\\/\\d+/", "/^a|b$/m", "/(x)(y)?/"
+    };
+
+    std::string source;
+    for (size_t i = 0; i < n; i++) {
+        auto a = Identifier(), b = Identifier();
+        switch (Next(5)) {
+        case 0:
+            source += a + " = " + b + " / " + Number() + " / " + a + ";\n";
+            break;
+        case 1:
+            source += a + " = " + Pick(regexes) + ";\n";
+            break;
+        case 2:
+            source += "f(" + std::string(Pick(regexes)) + ", " + a
+                + " / 2);\n";
+            break;
+        case 3:
+            source += a + " = (" + b + " + 1) / " + Pick(regexes) + ";\n";
+            break;
+        default:
+            source += a + " = [" + b + "] / 2 / " + Number() + ";\n";
+            break;
+        }
+    }
+    return source;
+}
+
+}
+
+std::vector<SyntheticShape> SyntheticShapes()
+{
+    return {
+#define SHAPE_VALUE(Shape, name, help) SyntheticShape::k##Shape,
+SYNTHETIC_SHAPE_LIST(SHAPE_VALUE)
+#undef SHAPE_VALUE
+    };
+}
+
+const char *SyntheticShapeName(SyntheticShape shape)
+{
+    switch (shape) {
+#define SHAPE_NAME(Shape, name, help) \
+    case SyntheticShape::k##Shape: return name;
+SYNTHETIC_SHAPE_LIST(SHAPE_NAME)
+#undef SHAPE_NAME
+    }
+    return "";
+}
+
+const char *SyntheticShapeHelp(SyntheticShape shape)
+{
+    switch (shape) {
+#define SHAPE_HELP(Shape, name, help) \
+    case SyntheticShape::k##Shape: return help;
+SYNTHETIC_SHAPE_LIST(SHAPE_HELP)
+#undef SHAPE_HELP
+    }
+    return "";
+}
+
+bool ParseSyntheticShape(const std::string &name, SyntheticShape *shape)
+{
+    for (auto s : SyntheticShapes()) {
+        if (name == SyntheticShapeName(s)) {
+            *shape = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string GenerateSynthetic(SyntheticShape shape, size_t n, uint64_t seed)
+{
+    Generator generator(seed);
+    switch (shape) {
+    case SyntheticShape::kArray: return generator.Array(n);
+    case SyntheticShape::kTable: return generator.Table(n);
+    case SyntheticShape::kObject: return generator.Object(n);
+    case SyntheticShape::kCalls: return generator.Calls(n);
+    case SyntheticShape::kString:
+        return "var str = " + generator.String(n) + ";\n";
+    case SyntheticShape::kBinary: return generator.Binary(n);
+    case SyntheticShape::kSwitch: return generator.Switch(n);
+    case SyntheticShape::kRegex: return generator.Regex(n);
+    }
+    return "";
+}
+
+}
@@ -0,0 +1,45 @@
+#ifndef SYNTHETIC_H_
+#define SYNTHETIC_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace jast {
+
+// SyntheticShape ::= an input shape which stresses one path of the parser,
+// the size of every shape is the number of its repeated units
+#define SYNTHETIC_SHAPE_LIST(F) \
+    F(Array,  "array",  "an array literal with n elements") \
+    F(Table,  "table",  "a data table, an array literal of n numbers") \
+    F(Object, "object", "an object literal with n properties, some repeated") \
+    F(Calls,  "calls",  "n nested calls, f(g(f(...)))") \
+    F(String, "string", "a string literal of n characters") \
+    F(Binary, "binary", "a chain of n binary operators") \
+    F(Switch, "switch", "a switch statement with n cases") \
+    F(Regex,  "regex",  "n statements mixing regexes and divisions")
+
+enum class SyntheticShape {
+#define SHAPE_ENUM(Shape, name, help) k##Shape,
+SYNTHETIC_SHAPE_LIST(SHAPE_ENUM)
+#undef SHAPE_ENUM
+};
+
+// all the shapes, in the order of SYNTHETIC_SHAPE_LIST
+std::vector<SyntheticShape> SyntheticShapes();
+
+const char *SyntheticShapeName(SyntheticShape shape);
+const char *SyntheticShapeHelp(SyntheticShape shape);
+
+// returns false if `name` is not a shape
+bool ParseSyntheticShape(const std::string &name, SyntheticShape *shape);
+
+// generates the shape with n units. the output only depends on the shape,
+// n and the seed, on every platform: the random numbers come straight from
+// std::mt19937_64, whose sequence is fixed by the standard, and never go
+// through the implementation defined std::*_distribution
+std::string GenerateSynthetic(SyntheticShape shape, size_t n, uint64_t seed);
+
+}
+
+#endif
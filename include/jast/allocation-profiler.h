@@ -0,0 +1,167 @@
+#ifndef ALLOCATION_PROFILER_H_
+#define ALLOCATION_PROFILER_H_
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace jast {
+
+enum class ASTNodeType;
+class Expression;
+class Statistics;
+
+// heap containers the AST grows while it is parsed
+#define ALLOCATION_CONTAINER_LIST(F) \
+    F(ExpressionList) \
+    F(ClausesList) \
+    F(ProxyArray) \
+    F(ProxyObject) \
+    F(PackedArray)
+
+enum class AllocationContainer {
+#define CONTAINER_ENUM(Container) k##Container,
+ALLOCATION_CONTAINER_LIST(CONTAINER_ENUM)
+#undef CONTAINER_ENUM
+    kNrContainer
+};
+
+// AllocationProfiler ::= opt-in accounting of the heap the parser allocates
+// for the AST
+//
+// While a profiler is started it is the profiler of its thread, and every
+// node the ASTFactory creates and every buffer an ExpressionList, ProxyArray
+// or ProxyObject grows into is counted against it. Each allocation is
+// attributed to the node type (or container) and to the innermost Parser
+// function which was running, e.g. ParseArrayLiteral.
+//
+// These are the bytes allocated, buffers which were later reallocated or
+// freed are still counted. RetainedBytes() measures what a tree holds now.
+//
+// With no profiler started a hook costs one thread local load and a branch,
+// and with DISABLE_COUNTERS the hooks are empty.
+class AllocationProfiler {
+public:
+    struct Count {
+        std::size_t count;
+        std::size_t bytes;
+    };
+
+    // `stats`, when given, also gets its Allocations counter incremented
+    explicit AllocationProfiler(Statistics *stats = nullptr);
+    ~AllocationProfiler();
+
+    // makes this the profiler of the calling thread, until Stop(). a
+    // profiler started while another one runs takes over until it stops
+    void Start();
+    void Stop();
+
+    static AllocationProfiler *current() { return current_; }
+
+    // hooks of the allocating code
+    static void OnNode(ASTNodeType type, std::size_t bytes)
+    {
+#ifndef DISABLE_COUNTERS
+        if (current_)
+            current_->RecordNode(type, bytes);
+#endif
+    }
+
+    static void OnContainer(AllocationContainer container, std::size_t bytes)
+    {
+#ifndef DISABLE_COUNTERS
+        if (current_)
+            current_->RecordContainer(container, bytes);
+#endif
+    }
+
+    Count total() const { return total_; }
+    Count ByNodeType(ASTNodeType type) const;
+    Count ByContainer(AllocationContainer container) const;
+
+    // `site` is a Parser function name, or "(none)" for allocations made
+    // outside of the parser
+    Count BySite(const std::string &site) const;
+
+    // all the sites, the most bytes first
+    std::vector<std::pair<std::string, Count>> Sites() const;
+
+    void Clear();
+
+    // one JSON object with the total and the non empty node types,
+    // containers and sites
+    void DumpJSON(std::ostream &os) const;
+
+    // heap held by the tree under `root` right now: the nodes, their lists,
+    // property maps and out of line strings. shared nodes of a hash-consed
+    // tree are counted once
+    static std::size_t RetainedBytes(Expression *root);
+
+    // the heap buffer of `str`, 0 when it is short enough to be stored
+    // inside of the std::string itself
+    static std::size_t StringBytes(const std::string &str);
+
+    AllocationProfiler(const AllocationProfiler &) = delete;
+    AllocationProfiler &operator=(const AllocationProfiler &) = delete;
+
+private:
+    friend class AllocationSite;
+
+    static const int kMaxNodeTypes = 64;
+
+    void RecordNode(ASTNodeType type, std::size_t bytes);
+    void RecordContainer(AllocationContainer container, std::size_t bytes);
+    void Record(Count &count, std::size_t bytes);
+
+    static thread_local AllocationProfiler *current_;
+
+    Statistics *stats_;
+    AllocationProfiler *previous_;
+    bool running_;
+    const char *site_;
+    Count total_;
+    Count types_[kMaxNodeTypes];
+    Count containers_[(int)AllocationContainer::kNrContainer];
+    std::unordered_map<const char*, Count> sites_;
+};
+
+// AllocationSite ::= attributes the allocations made until the end of the
+// scope to `name`. `name` must outlive the profiler, __func__ is expected
+#ifndef DISABLE_COUNTERS
+class AllocationSite {
+public:
+    explicit AllocationSite(const char *name)
+        : profiler_{ AllocationProfiler::current() }, previous_{ nullptr }
+    {
+        if (profiler_) {
+            previous_ = profiler_->site_;
+            profiler_->site_ = name;
+        }
+    }
+
+    ~AllocationSite()
+    {
+        if (profiler_)
+            profiler_->site_ = previous_;
+    }
+
+    AllocationSite(const AllocationSite &) = delete;
+    AllocationSite &operator=(const AllocationSite &) = delete;
+
+private:
+    AllocationProfiler *profiler_;
+    const char *previous_;
+};
+#else
+class AllocationSite {
+public:
+    explicit AllocationSite(const char *) { }
+};
+#endif
+
+}
+
+#endif
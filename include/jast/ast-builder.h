@@ -2,11 +2,14 @@
 #define AST_BUILDER_H_
 
 #include "jast/astfactory.h"
+#include "jast/constant-folder.h"
 #include "jast/source-locator.h"
 #include "jast/context.h"
 #include "jast/expression.h"
 #include "jast/scope.h"
-#include <list>
+#include "jast/hash-cons.h"
+#include <memory>
+#include <vector>
 
 namespace jast {
 
@@ -17,7 +20,8 @@ class ASTBuilder {
 public:
     ASTBuilder(ParserContext *ctx, ASTFactory *factory,
             SourceLocator *locator, ScopeManager *manager)
-        : factory_{ factory }, locator_{ locator }, ctx_{ ctx }, manager_{manager}
+        : factory_{ factory }, locator_{ locator }, ctx_{ ctx }, manager_{manager},
+          folding_{ false }, packing_{ false }
     { }
 
     // creates a heap allocated expression list and return a pointer to it.
@@ -38,9 +42,9 @@ public:
     Handle<Expression> NewIntegralLiteral(double value);
 
     // create a new node representing JavaScript string
-    Handle<Expression> NewStringLiteral(const std::string &str);
+    Handle<Expression> NewStringLiteral(std::string str);
 
-    Handle<Expression> NewTemplateLiteral(const std::string &str);
+    Handle<Expression> NewTemplateLiteral(std::string str);
 
     Handle<Expression> NewRegExpLiteral(const std::string &str, const std::vector<RegExpFlags> &flags);
 
@@ -48,6 +52,18 @@ public:
     // after passing `arr` to this function, your arr becomes unusable
     Handle<Expression> NewArrayLiteral(ProxyArray arr);
 
+    // create a new array node holding the values of `arr` (see PackedArray)
+    Handle<Expression> NewPackedArrayLiteral(PackedArray arr);
+
+    // create the literal node of the element `i` of `arr` in `scope`, at
+    // the position it was written
+    Handle<Expression> NewElementLiteral(const PackedArray &arr, size_t i,
+        Scope *scope);
+
+    // replace the values of the packed `array` by the literal nodes of its
+    // elements (see NewElementLiteral()), nothing if it isn't packed
+    void UnpackArrayLiteral(ArrayLiteral *array);
+
     // create a new node representing JavaScript object
     Handle<Expression> NewObjectLiteral(ProxyObject obj);
 
@@ -82,7 +98,8 @@ public:
         Handle<Expression> rhs);
 
     // create a new node representing JavaScript assign expression
-    Handle<Expression> NewAssignExpression(Handle<Expression> lhs, Handle<Expression> rhs);
+    Handle<Expression> NewAssignExpression(AssignOperation op, Handle<Expression> lhs,
+                                                        Handle<Expression> rhs);
 
     // create a new node representing JavaScript ternary expression
     Handle<Expression> NewTernaryExpression(Handle<Expression> first, Handle<Expression> second,
@@ -149,17 +166,61 @@ public:
     SourceLocator *locator() { return locator_; }
     ScopeManager *manager() { return manager_; }
 
+    // with hash-consing on, identical immutable expressions are created only
+    // once and shared (see hash-cons.h). off by default, turning it off drops
+    // the table but keeps the nodes already shared
+    void SetHashConsing(bool enable);
+
+    // null if hash-consing is off. positions of shared nodes are found here
+    HashConsTable *hash_cons() { return hash_cons_.get(); }
+
+    // with constant folding on, prefix, binary and ternary expressions whose
+    // operands are literals are evaluated as they are built (see
+    // constant-folder.h), `&&`, `||` and `?:` as soon as their test is one.
+    // `1 + 2 * 3` becomes the literal 7. off by default
+    void SetConstantFolding(bool enable) { folding_ = enable; }
+    bool constant_folding() const { return folding_; }
+
+    // with array packing on, the parser keeps array literals of at least
+    // PackedArray::kMinSize numbers or strings as values instead of nodes
+    // (see ArrayLiteral). their exprs() is empty until UnpackArrayLiteral(),
+    // so it is only for code which reads packed(). off by default
+    void SetArrayPacking(bool enable) { packing_ = enable; }
+    bool array_packing() const { return packing_; }
+
+    // lets go of the nodes of the last parse and empties the hash-consing
+    // table, keeping the memory of both for the next one
+    void Reset();
+
     template <typename T>
     inline Handle<Expression> save(Handle<T> handle) {
         exprs_.push_back(handle);
+        count(handle.GetPtr());
         return handle;
     }
 private:
+    // returns the canonical node for `expr` when hash-consing, saves new nodes
+    Handle<Expression> intern(Handle<Expression> expr);
+
+    // the literal of `value`, null for Constant::Kind::kNone
+    Handle<Expression> NewConstant(const Constant &value);
+
+    // adds a newly created node to the per node type statistics
+    void count(Expression *expr)
+    {
+#ifndef DISABLE_COUNTERS
+        ctx_->Counters().CountNode(expr->type(), SizeOfNode(expr->type()));
+#endif
+    }
+
     ASTFactory *factory_;
     SourceLocator *locator_;
     ParserContext *ctx_;
     ScopeManager *manager_;
-    std::list<Handle<Expression>> exprs_;
+    std::vector<Handle<Expression>> exprs_;
+    std::unique_ptr<HashConsTable> hash_cons_;
+    bool folding_;
+    bool packing_;
 };
 
 }
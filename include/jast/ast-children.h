@@ -0,0 +1,72 @@
+#ifndef AST_CHILDREN_H_
+#define AST_CHILDREN_H_
+
+#include "jast/expression.h"
+#include "jast/statement.h"
+
+namespace jast {
+
+// VisitSlots ::= calls the VisitSlots() of the class of `expr`, which gives
+// `v` a reference to every child, to read or replace it in place
+//
+// `v` has two members, usually templates since the slots of a few nodes hold
+// a derived type (the prototype of a function, the declarations of a list,
+// the cases of a switch):
+//
+//      v.Slot(Handle<T> &slot)             one child, which may be null
+//      v.List(std::vector<Handle<T>> &)    a list of children, in order
+//
+// Slots and lists come in source order, ForEachChild() below gives the same
+// children in the same order. Nothing here adds a reference to a node.
+template <typename V>
+void VisitSlots(Expression *expr, V &&v)
+{
+    switch (expr->type()) {
+#define VISIT_SLOTS(Type) \
+    case ASTNodeType::k##Type: \
+        static_cast<Type*>(expr)->VisitSlots(v); \
+        break;
+AST_NODE_LIST(VISIT_SLOTS)
+#undef VISIT_SLOTS
+    default:
+        break;
+    }
+}
+
+namespace internal {
+
+template <typename Fn>
+struct ChildVisitor {
+    Fn &fn;
+
+    template <typename T>
+    void Slot(Handle<T> &slot)
+    {
+        if (slot)
+            fn(static_cast<Expression*>(slot.GetPtr()));
+    }
+
+    template <typename T>
+    void List(std::vector<Handle<T>> &list)
+    {
+        for (auto &slot : list)
+            Slot(slot);
+    }
+};
+
+}
+
+// ForEachChild ::= calls `fn(Expression *)` for every direct child of `expr`
+// in source order. missing (null) children are skipped.
+//
+// Handy for passes which only need to walk the tree and don't care about the
+// kind of the node, everything else should use an ASTVisitor.
+template <typename Fn>
+void ForEachChild(Expression *expr, Fn &&fn)
+{
+    VisitSlots(expr, internal::ChildVisitor<Fn>{ fn });
+}
+
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef AST_CLONER_H_
+#define AST_CLONER_H_
+
+#include "jast/astfactory.h"
+#include "jast/frozen-ast.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace jast {
+
+// ASTCloner ::= deep copy of a tree, or of any subtree, made by an ASTFactory
+//
+// Every node is copied once, with its position, its scope, the bindings set
+// by the ScopeResolver and its hash, and every list (ExpressionList,
+// ClausesList, ProxyArray, PackedArray, ProxyObject) is copied with it. The
+// nodes come from the factory given, a node before its children, so a
+// factory which allocates from an arena clones into it in preorder (see
+// CompactAST).
+// Nothing is parsed again.
+//
+// The copy points to the same Scopes as the tree it was cloned from, which
+// must outlive it, and their root() stays the original node. A node which
+// is in more than one place, the body of the labels of a switch case or the
+// nodes of a hash-consed tree, is copied once and shared the same way.
+//
+// The tree cloned from is only read, no reference count of it changes, so
+// threads may clone the same tree at once, e.g. one a FrozenAST shares. Like
+// the ASTWalker, the pending nodes are kept in a heap allocated stack. An
+// ASTCloner keeps its stacks from one Clone() to the next.
+class ASTCloner {
+public:
+    explicit ASTCloner(ASTFactory *factory = ASTFactory::GetFactoryInstance())
+        : factory_{ factory }
+    { }
+
+    // the copy of the tree under `root`, null for a null `root`
+    Handle<Expression> Clone(Expression *root);
+
+    // the copy of the subtree of a frozen node, which the copy doesn't share
+    Handle<Expression> Clone(NodeRef node);
+
+    ASTCloner(const ASTCloner &) = delete;
+    ASTCloner &operator=(const ASTCloner &) = delete;
+
+private:
+    struct Collector;
+    struct Filler;
+
+    struct Frame {
+        Expression *node;
+        // the copy of the node is results_[results], those of its children
+        // follow it
+        size_t results;
+        bool leave;
+    };
+
+    void Run(Expression *root);
+
+    // a copy of `node` with the same data, and the same number of children
+    // in every list, which are all null
+    Handle<Expression> Shell(Expression *node);
+    Handle<ExpressionList> ShellList(ExpressionList *list);
+
+    ASTFactory *factory_;
+    std::vector<Frame> stack_;
+    std::vector<Expression*> children_;
+    std::vector<Handle<Expression>> results_;
+    // the copies of the nodes with more than one reference, which may be
+    // in more than one place
+    std::unordered_map<Expression*, Expression*> copies_;
+};
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef AST_HASH_H_
+#define AST_HASH_H_
+
+#include "jast/handle.h"
+
+#include <cstdint>
+
+namespace jast {
+
+class Expression;
+
+// HashSensitivity ::= what goes into the structural hash of a node
+enum class HashSensitivity {
+    // node types, operators and the shape of the tree, which is what
+    // FastASTMatcher compares
+    kTypes,
+
+    // types plus names and literal values, which is what LazyASTMatcher
+    // compares
+    kTypesAndValues
+};
+
+// StructuralHasher ::= computes Merkle hashes of AST subtrees
+//
+// The hash of a node combines its type (and value) with the hashes of its
+// children, so it is computed bottom up in one pass over the tree and stored
+// in the node. Two subtrees with different hashes never match, equal hashes
+// still have to be confirmed by a matcher.
+//
+// Hashes are a cache: a node that was already hashed with the same
+// sensitivity is not visited again. The ASTRewriter resets the hashes of
+// what it changes, a tree changed any other way has to be Clear()ed before
+// it is hashed or matched again.
+class StructuralHasher {
+public:
+    // hashes every node under `root` and returns the hash of `root`
+    static uint64_t Hash(Handle<Expression> root,
+        HashSensitivity sensitivity = HashSensitivity::kTypes);
+
+    // forgets the hashes of `root` and everything under it
+    static void Clear(Handle<Expression> root);
+
+    // stored hash of `expr` if it was computed with `sensitivity`, else 0
+    static uint64_t Get(Expression *expr, HashSensitivity sensitivity);
+
+    // true if the stored hashes prove that `a` and `b` can't match. values
+    // are compared only if `values` is set
+    static bool Differ(Expression *a, Expression *b, bool values);
+};
+
+}
+
+#endif
@@ -8,7 +8,12 @@ namespace jast {
 class Expression;
 
 // FastASTMatcher ::= matches the two AST
-// fast because it just compares the types of AST nodes
+// fast because it just compares the types of AST nodes (and operators), names
+// and literal values are ignored.
+//
+// Both matchers first compare the structural hashes of the nodes when they
+// were computed with StructuralHasher (see ast-hash.h), and only recurse into
+// the children when the hashes are equal.
 class FastASTMatcher {
 public:
     static bool match(Handle<Expression> a, Handle<Expression> b);
@@ -0,0 +1,113 @@
+#ifndef AST_PASS_H_
+#define AST_PASS_H_
+
+#include "jast/expression.h"
+#include "jast/statistics.h"
+
+#include <memory>
+#include <vector>
+
+namespace jast {
+
+// ASTPass ::= a transformation of the tree, done in place
+class ASTPass {
+public:
+    virtual ~ASTPass() = default;
+
+    // names the pass in the Statistics and the traces
+    virtual const char *name() const = 0;
+
+    // rewrites the tree under `root`, and may replace `root` itself. returns
+    // true if anything changed. the structural hashes (see ast-hash.h) of the
+    // nodes which changed, and of their ancestors, are reset to 0
+    virtual bool Run(Handle<Expression> &root) = 0;
+};
+
+// StatementPass ::= a pass which replaces or removes statements
+//
+// The tree is walked with an ASTWalker and the statements of a node are
+// rewritten when the node is left, after everything under them was. The
+// statements are those of blocks, the branches of if statements and the
+// bodies of loops. The root itself is never replaced.
+//
+// The nodes whose statements changed, and the nodes above them, have their
+// structural hash reset.
+//
+// Statements are never hash-consed (see HashConsTable), so rewriting one
+// changes a single place in the tree. The body of a switch case is shared by
+// the labels in front of it, and is rewritten once for each.
+class StatementPass : public ASTPass {
+public:
+    bool Run(Handle<Expression> &root) override;
+
+protected:
+    // returns what replaces `stmt`: `stmt` itself, another statement, or
+    // null to remove it. a removed branch or loop body, or a statement
+    // following a label, becomes an empty statement
+    virtual Handle<Expression> RewriteStatement(Handle<Expression> stmt)
+    {
+        return stmt;
+    }
+
+    // rewrites the list of statements of a block, after every statement of
+    // it went through RewriteStatement(). returns true if it changed
+    virtual bool RewriteBlock(std::vector<Handle<Expression>> &stmts)
+    {
+        return false;
+    }
+
+private:
+    class Rewriter;
+
+    Handle<Expression> RewriteSlot(Handle<Expression> stmt);
+
+    bool changed_ = false;
+};
+
+// PassManager ::= runs passes over a tree, one after the other
+//
+// With a Statistics, the nodes of the tree are counted before and after
+// every pass and recorded with CountPass(), and Run() is timed as the
+// optimize phase. Counting walks the whole tree, so it is left out without
+// one.
+//
+// The passes of jast reset the hashes of what they change, so the tree can be
+// hashed and matched right after Run(). Other passes which change nodes in
+// place have to do the same, or StructuralHasher::Clear() the tree.
+class PassManager {
+public:
+    explicit PassManager(Statistics *stats = nullptr)
+        : stats_{ stats }
+    { }
+
+    void Add(std::unique_ptr<ASTPass> pass);
+
+    template <typename Pass, typename... Args>
+    Pass *Add(Args&&... args)
+    {
+        Pass *pass = new Pass(std::forward<Args>(args)...);
+        Add(std::unique_ptr<ASTPass>(pass));
+        return pass;
+    }
+
+    size_t size() const { return passes_.size(); }
+
+    // runs all the passes, and runs them again while the last round changed
+    // the tree, at most `rounds` times. returns true if anything changed
+    bool Run(Handle<Expression> &root, int rounds = 1);
+
+private:
+    bool RunRounds(Handle<Expression> &root, int rounds);
+    bool RunPass(ASTPass *pass, Handle<Expression> &root);
+
+    Statistics *stats_;
+    std::vector<std::unique_ptr<ASTPass>> passes_;
+};
+
+// the nodes of the tree under `root`, a shared node once for every
+// occurrence
+size_t CountNodes(Expression *root);
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef AST_REWRITER_H_
+#define AST_REWRITER_H_
+
+#include "jast/expression.h"
+
+#include <vector>
+
+namespace jast {
+
+// ASTRewriter ::= depth first traversal of the AST which replaces, removes
+// and inserts nodes in place
+//
+// Every node is entered, its children are rewritten, and then it is left.
+// Leave() returns what takes the place of the node in its parent, which is
+// stored in the parent's slot (see VisitSlots() in ast-children.h). Only the
+// parents of the nodes that changed are written to, the rest of the tree,
+// and the spine above a change, stay as they are.
+//
+// Returning null removes the node: from a list (statements, arguments, array
+// elements...) it is erased, a single slot is left null, which is only fine
+// for the children a node may miss, e.g. the value of a return. In Leave(),
+// InsertBefore() and InsertAfter() put more nodes next to the one being left
+// in its list; they are dropped when it isn't in one. Nodes returned or
+// inserted are not walked.
+//
+// The structural hashes (see ast-hash.h) of the nodes whose slots are
+// written to, and of their ancestors, are reset. A Leave() which changes a
+// node in place instead of returning a new one has to StructuralHasher::
+// Clear() the tree before it is hashed or matched again.
+//
+// A few slots hold a derived type (the prototype of a function, the
+// declarations of a list, the cases of a switch), their replacement must be
+// of that type.
+//
+// Like the ASTWalker, the pending nodes are kept in a heap allocated stack,
+// so the depth of the tree is only limited by memory. Shared nodes of a
+// hash-consed tree must not be rewritten, a new child would show up at every
+// occurrence of its parent.
+class ASTRewriter {
+public:
+    ASTRewriter() = default;
+    virtual ~ASTRewriter() = default;
+
+    // rewrites the tree under `root` and returns what replaced it, null when
+    // it was removed. not to be called again from Enter() or Leave()
+    Handle<Expression> Rewrite(Handle<Expression> root);
+
+protected:
+    // called before the children of `expr`. returning false skips the
+    // children and the Leave() of `expr`, which stays
+    virtual bool Enter(Expression *expr) { return true; }
+
+    // called after all the children of `expr` were rewritten, returns `expr`,
+    // another node to replace it with, or null to remove it
+    virtual Handle<Expression> Leave(Handle<Expression> expr) { return expr; }
+
+    // from Leave(), adds `node` right before or after the node being left
+    void InsertBefore(Handle<Expression> node);
+    void InsertAfter(Handle<Expression> node);
+
+private:
+    struct Applier;
+
+    struct Frame {
+        Expression *node;
+        // the leave frame of the parent, SIZE_MAX for the root
+        size_t parent;
+        // groups_ of the children start there
+        size_t groups;
+        bool leave;
+        // a child was replaced, removed or inserted
+        bool changed;
+        // something changed deeper in the subtree
+        bool stale;
+    };
+
+    // what a node left in its place: results_[begin, end), of which `self` is
+    // the node itself or its replacement, SIZE_MAX if removed
+    struct Group {
+        size_t begin;
+        size_t end;
+        size_t self;
+    };
+
+    void Run(Expression *root);
+    void LeaveNode(Frame &frame);
+    void Apply(Expression *node, size_t first);
+
+    std::vector<Frame> stack_;
+    std::vector<Expression*> children_;
+    std::vector<Group> groups_;
+
+    // nodes which were walked are owned by their parents until those are
+    // rewritten, the others are held here
+    std::vector<Expression*> results_;
+    std::vector<Handle<Expression>> owned_;
+
+    std::vector<Handle<Expression>> before_;
+    std::vector<Handle<Expression>> after_;
+};
+
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef AST_WALKER_H_
+#define AST_WALKER_H_
+
+#include "jast/expression.h"
+
+#include <vector>
+
+namespace jast {
+
+// ASTWalker ::= depth first traversal of the AST with an explicit stack
+//
+// Unlike an ASTVisitor, which recurses through Accept() once per level of
+// the tree, the walker keeps the pending nodes in a heap allocated stack. The
+// depth of the tree it can walk is only limited by memory, e.g. the left deep
+// tree of a 1M term `a + b + c + ...` chain.
+//
+// Children are entered in source order (see ForEachChild). Shared nodes of a
+// hash-consed tree are walked once for every occurrence.
+class ASTWalker {
+public:
+    ASTWalker() = default;
+    virtual ~ASTWalker() = default;
+
+    void Walk(Expression *root);
+    void Walk(Handle<Expression> root) { Walk(root.GetPtr()); }
+
+protected:
+    // called before the children of `expr`. returning false skips the
+    // children and the Leave() of `expr`
+    virtual bool Enter(Expression *expr) { return true; }
+
+    // called after all the children of `expr` were left
+    virtual void Leave(Expression *expr) { }
+
+private:
+    void Run(Expression *root);
+
+    struct Frame {
+        Expression *node;
+        bool leave;
+    };
+
+    std::vector<Frame> stack_;
+    std::vector<Expression*> children_;
+};
+
+}
+
+#endif
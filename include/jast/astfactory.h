@@ -6,11 +6,19 @@
 
 namespace jast {
 
+class NodeArena;
+
 // ASTFactory ::= factory for all the AST nodes it can be override'd so as
 // to provide custom allocation. By default it uses operator new
 class ASTFactory {
-    ASTFactory() { }
+protected:
+    ASTFactory() : arena_{ nullptr } { }
+
+    // makes the nodes and the lists in `arena`, see CompactAST
+    explicit ASTFactory(NodeArena *arena) : arena_{ arena } { }
 public:
+    virtual ~ASTFactory() = default;
+
     // GetFactoryInstance ::= returns singleton instance of ASTFactory
     static ASTFactory *GetFactoryInstance();
 
@@ -33,6 +41,8 @@ public:
 
     virtual Handle<Expression> NewArrayLiteral(Position &loc, Scope *scope, ProxyArray arr);
 
+    virtual Handle<Expression> NewPackedArrayLiteral(Position &loc, Scope *scope, PackedArray arr);
+
     virtual Handle<Expression> NewObjectLiteral(Position &loc, Scope *scope, ProxyObject obj);
 
     virtual Handle<Expression> NewIdentifier(Position &loc, Scope *scope, std::string name);
@@ -60,7 +70,7 @@ public:
                     BinaryOperation op, Handle<Expression> lhs, Handle<Expression> rhs);
     
     virtual Handle<Expression> NewAssignExpression(Position &loc, Scope *scope,
-                                    Handle<Expression> lhs, Handle<Expression> rhs);
+                    AssignOperation op, Handle<Expression> lhs, Handle<Expression> rhs);
     
     virtual Handle<Expression> NewTernaryExpression(Position &loc, Scope *scope,
         Handle<Expression> first, Handle<Expression> second, Handle<Expression> third);
@@ -124,6 +134,16 @@ public:
             Handle<ClausesList> clauses);
 
     virtual Handle<Expression> NewThrowStatement(Position &loc, Scope *scope, Handle<Expression> expr);
+
+private:
+    template <typename T, typename... Args>
+    Handle<T> Make(Args&&... args);
+
+    // Make(), counted by the allocation profiler of the thread
+    template <typename T, typename... Args>
+    Handle<T> MakeNode(Args&&... args);
+
+    NodeArena *arena_;
 };
 
 }
@@ -0,0 +1,135 @@
+#ifndef CLONE_DETECTOR_H_
+#define CLONE_DETECTOR_H_
+
+#include "jast/ast-hash.h"
+#include "jast/expression.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace jast {
+
+// CloneFragment ::= one occurrence of duplicated code
+struct CloneFragment {
+    // index of the file as returned by CloneDetector::AddFile
+    size_t file;
+
+    // smallest and largest position of the nodes in the fragment
+    Position begin;
+    Position end;
+
+    // number of AST nodes in the fragment
+    size_t size;
+
+    Expression *node;
+};
+
+// CloneGroup ::= fragments which are clones of each other
+struct CloneGroup {
+    std::vector<CloneFragment> fragments;
+
+    // true if every fragment matches the others (FastASTMatcher or
+    // LazyASTMatcher depending on the sensitivity), false for near miss
+    // clones found through their similarity
+    bool exact;
+
+    // estimated similarity of the fragments, 1 for exact clones
+    double similarity;
+};
+
+// CloneDetector ::= finds duplicated code across a corpus of files
+//
+// Every file is parsed and structurally hashed (see ast-hash.h) on its own,
+// files are spread over `threads` worker threads. Every subtree with at
+// least `min_nodes` nodes becomes a candidate fragment:
+//
+//  - candidates are bucketed by their structural hash, a bucket is split
+//    into exact clone groups by the matcher, so collisions never get
+//    reported
+//  - with `near_miss` set, a MinHash signature of the set of distinct
+//    subtrees under each candidate is built bottom up together with the
+//    hash. signatures are banded into an LSH index and candidates sharing a
+//    band with an estimated similarity of at least `similarity` form near
+//    miss groups
+//
+// Clones of subtrees inside bigger reported clones are not reported again.
+// All the work is linear in the size of the corpus except the verification
+// of a bucket, which is linear in the number of distinct trees in it.
+class CloneDetector {
+public:
+    struct Options {
+        size_t min_nodes = 30;
+
+        // kTypes finds clones with renamed identifiers and changed literals
+        HashSensitivity sensitivity = HashSensitivity::kTypes;
+
+        bool near_miss = false;
+        double similarity = 0.8;
+
+        // 0 for std::thread::hardware_concurrency()
+        unsigned threads = 0;
+    };
+
+    CloneDetector();
+    CloneDetector(const Options &options);
+    ~CloneDetector();
+
+    // adds a file to the corpus, returns its index
+    size_t AddFile(const std::string &name, const std::string &source);
+
+    // parses, fingerprints and groups all files added so far
+    std::vector<CloneGroup> Run();
+
+    const std::string &name(size_t file) const { return files_[file].name; }
+
+    // parse error of the file, empty if it was parsed
+    const std::string &error(size_t file) const { return files_[file].error; }
+
+    size_t size() const { return files_.size(); }
+
+private:
+    struct File;
+
+    void Process(File &file);
+    void FindExactClones(std::vector<CloneGroup> &groups);
+    void FindNearMissClones(std::vector<CloneGroup> &groups);
+    std::vector<CloneGroup> RemoveNested(std::vector<CloneGroup> groups);
+
+    // number of MinHash values in a signature, banded into kBands bands
+    static const int kSignatureSize = 32;
+    static const int kBands = 8;
+
+    // members of an LSH bucket a new candidate is compared with
+    static const size_t kBucketCompare = 16;
+
+    struct Candidate {
+        Expression *node;
+        uint64_t hash;
+        size_t size;
+
+        // preorder index of the root, the fragment covers the nodes
+        // [index, index + size)
+        size_t index;
+        Position begin;
+        Position end;
+
+        // only with near_miss
+        std::vector<uint64_t> signature;
+    };
+
+    struct File {
+        std::string name;
+        std::string source;
+        std::string error;
+        Handle<Expression> ast;
+        std::vector<Candidate> candidates;
+    };
+
+    Options options_;
+    std::vector<File> files_;
+};
+
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef CODE_PRINTER_H_
+#define CODE_PRINTER_H_
+
+#include "jast/astvisitor.h"
+#include "jast/source-map.h"
+
+#include <iosfwd>
+#include <string>
+
+namespace jast {
+
+// CodePrinter ::= regenerates JavaScript source from the AST.
+//
+// Parentheses are inserted from operator precedence, so the output parses back
+// into the same tree. With `minify` set, all optional whitespace is dropped.
+// If a SourceMapGenerator is given, the identifiers, literals and `this` are
+// mapped back to their loc(). Other nodes aren't: the parser leaves their
+// loc() where they end, not where they start.
+class CodePrinter : public ASTVisitor {
+public:
+    CodePrinter(std::ostream &os, SourceMapGenerator *map = nullptr,
+        bool minify = false);
+    ~CodePrinter();
+
+    // prints a whole program. The top level BlockStatement produced by
+    // ParseProgram is printed without braces. Throws std::runtime_error on a
+    // getter or setter whose value is not a function
+    void Print(Handle<Expression> program);
+
+    // writes buffered output to the stream
+    void Flush();
+
+    // index of the original source in the source map, defaults to 0
+    void SetSourceIndex(int index) { source_index_ = index; }
+
+    // adds identifier names to the `names` field of the source map. identifiers
+    // are printed as they were written, so this is off by default
+    void SetRecordNames(bool record) { record_names_ = record; }
+
+#define DECLARE_VISITOR_METHOD(type) void Visit(type *) override;
+AST_NODE_LIST(DECLARE_VISITOR_METHOD)
+#undef DECLARE_VISITOR_METHOD
+
+private:
+    // precedence of the expression when it appears as an operand
+    static int Precedence(Expression *expr);
+
+    void PrintExpression(Expression *expr, int precedence);
+    void PrintExpression(const Handle<Expression> &expr, int precedence)
+    {
+        PrintExpression(expr.GetPtr(), precedence);
+    }
+
+    void PrintStatement(Expression *stmt);
+    void PrintStatement(const Handle<Expression> &stmt)
+    {
+        PrintStatement(stmt.GetPtr());
+    }
+    void PrintStatementList(ExpressionList *list);
+    void PrintBlockBody(Expression *stmt);
+    void PrintExpressionList(ExpressionList *list);
+    // the `(args)` of a function, and its `{ body }`
+    void PrintParameters(FunctionPrototype *proto);
+    void PrintFunctionBody(FunctionStatement *stmt);
+
+    // remembers the position of the token `expr` so that it is mapped at the
+    // next emitted token, see IsToken()
+    inline void Mark(Expression *expr)
+    {
+        if (map_) {
+            pending_ = expr;
+        }
+    }
+    void AddPendingMapping(const std::string *name);
+
+    // emits a token, inserting a space if it would otherwise merge with the
+    // previous token. `name` is recorded for the pending mapping, if any
+    void Emit(const char *str, size_t len, const std::string *name = nullptr);
+    void Emit(const char *str);
+    void Emit(const std::string &str) { Emit(str.data(), str.length()); }
+    void EmitStringLiteral(const std::string &str, char quote);
+    void EmitNumber(double value);
+    void EmitProperty(const std::string &name);
+
+    // optional whitespace
+    void Space();
+    void Newline();
+
+    std::ostream &os_;
+    SourceMapGenerator *map_;
+    bool minify_;
+    int source_index_;
+    bool record_names_;
+
+    std::string buffer_;
+    char last_;
+    int indent_;
+    size_t line_;
+    size_t column_;
+    Expression *pending_;
+};
+
+}
+
+#endif
@@ -11,14 +11,14 @@ namespace jast {
 class JSError : public std::runtime_error {
 public:
     JSError(std::string prefix, std::string msg)
-        : std::runtime_error(std::move(msg)), prefix_{ std::move(prefix) }
+        : std::runtime_error(prefix + ": " + msg), prefix_{ std::move(prefix) }
     { }
 
+    // the message is formatted once by the constructor, so errors thrown on
+    // different threads don't share a buffer
     const char *what() const noexcept override
     {
-        static std::string result;
-        result = (prefix_ + ": " + std::runtime_error::what());
-        return result.c_str();
+        return std::runtime_error::what();
     }
 private:
     std::string prefix_;
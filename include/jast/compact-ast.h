@@ -0,0 +1,116 @@
+#ifndef COMPACT_AST_H_
+#define COMPACT_AST_H_
+
+#include "jast/expression.h"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace jast {
+
+// NodeArena ::= one block of memory which nodes and lists are made in, one
+// after the other
+//
+// An object made in the block holds a reference to itself, so it stays
+// there when the handles to it are gone, until the arena goes. An object
+// which doesn't fit any more is made on the heap as usual. See the
+// ASTFactory constructor which takes an arena.
+class NodeArena {
+public:
+    explicit NodeArena(size_t capacity);
+
+    // every handle to the nodes of the block must be gone by then
+    ~NodeArena();
+
+    template <typename T, typename... Args>
+    T *New(Args&&... args)
+    {
+        void *memory = Allocate(sizeof(T), alignof(T));
+        if (!memory)
+            return new T(std::forward<Args>(args)...);
+
+        T *object = new (memory) T(std::forward<Args>(args)...);
+        object->increment();
+        objects_.push_back(Object{ object, AsNode(object) });
+        return object;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    // bytes taken by the objects of the block, alignment included
+    size_t used() const { return used_; }
+
+    // true if `object` is in the block
+    bool Contains(const void *object) const
+    {
+        auto p = static_cast<const char*>(object);
+        return p >= block_.get() && p < block_.get() + used_;
+    }
+
+    NodeArena(const NodeArena &) = delete;
+    NodeArena &operator=(const NodeArena &) = delete;
+
+private:
+    struct Object {
+        RefCountObject *object;
+        // null for the lists
+        Expression *node;
+    };
+
+    static Expression *AsNode(Expression *node) { return node; }
+    static Expression *AsNode(RefCountObject *) { return nullptr; }
+
+    // null when the block is full
+    void *Allocate(size_t size, size_t align);
+
+    std::unique_ptr<char[]> block_;
+    size_t capacity_;
+    size_t used_;
+    std::vector<Object> objects_;
+};
+
+// CompactAST ::= a tree moved into one NodeArena, in depth first order
+//
+// The parser makes the children of a node before the node, in between the
+// vectors and strings it throws away, so a finished tree is spread over the
+// heap. Compacting clones it (see ASTCloner) into a block sized for it, a
+// node right before its first child, and lets the original go. A walk over
+// the compact tree then reads the block from the start to the end.
+//
+// The block holds the nodes and the lists of blocks, arguments, comma
+// expressions and switch cases, as the ASTFactory makes them. The vectors of
+// children and the strings longer than what std::string keeps inline stay on
+// the heap, allocated in the same order and to their exact size.
+//
+// The compact tree is an AST like any other, which passes may rewrite: nodes
+// taken out of it stay in the block, nodes put into it are on the heap. The
+// handles to its nodes must be dropped before the CompactAST goes.
+class CompactAST {
+public:
+    // moves the tree under `root`, which is released unless another handle
+    // holds it
+    explicit CompactAST(Handle<Expression> root);
+
+    Handle<Expression> root() const { return root_; }
+
+    const NodeArena &arena() const { return arena_; }
+
+    // bytes the tree under `root` takes in a block, an upper bound with
+    // shared nodes
+    static size_t BlockSize(Expression *root);
+
+    CompactAST(const CompactAST &) = delete;
+    CompactAST &operator=(const CompactAST &) = delete;
+
+private:
+    // released before the arena
+    NodeArena arena_;
+    Handle<Expression> root_;
+};
+
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef CONSTANT_FOLDER_H_
+#define CONSTANT_FOLDER_H_
+
+#include "jast/ast-pass.h"
+#include "jast/expression.h"
+
+#include <string>
+
+namespace jast {
+
+// Constant ::= the value of a literal, or of an operation on literals
+class Constant {
+public:
+    enum class Kind {
+        // not a constant, or one which can't be told exactly
+        kNone,
+        kUndefined,
+        kNull,
+        kBoolean,
+        kNumber,
+        // as written in the source, escape sequences included (see
+        // StringLiteral)
+        kString,
+    };
+
+    Constant() : kind_{ Kind::kNone }, boolean_{ false }, number_{ 0 } { }
+
+    static Constant Undefined() { return Constant(Kind::kUndefined); }
+    static Constant Null() { return Constant(Kind::kNull); }
+    static Constant Boolean(bool value);
+    static Constant Number(double value);
+    static Constant String(std::string value);
+
+    Kind kind() const { return kind_; }
+    explicit operator bool() const { return kind_ != Kind::kNone; }
+
+    bool boolean() const { return boolean_; }
+    double number() const { return number_; }
+    const std::string &string() const { return string_; }
+
+private:
+    explicit Constant(Kind kind)
+        : kind_{ kind }, boolean_{ false }, number_{ 0 }
+    { }
+
+    Kind kind_;
+    bool boolean_;
+    double number_;
+    std::string string_;
+};
+
+// ConstantFolder ::= evaluates JavaScript operators on constants, exactly as
+// an engine would
+//
+// Only results which are certain are produced, anything else is kNone and
+// stays an expression:
+//  * strings with escape sequences or non-ASCII characters are compared,
+//    converted to numbers or tested for truth only where the raw text
+//    decides, since their value isn't known without unescaping
+//  * NaN and the infinities have no literal, `0 / 0` and `1 / 0` stay
+//  * `in`, `instanceof`, `delete`, `++` and `--` don't fold, on constants
+//    they throw or need a reference
+class ConstantFolder {
+public:
+    // the value of a literal node, kNone for anything else
+    static Constant Evaluate(Expression *expr);
+
+    static Constant Binary(BinaryOperation op, const Constant &lhs,
+        const Constant &rhs);
+
+    static Constant Prefix(PrefixOperation op, const Constant &operand);
+
+    // true for a name or a property, which an operator can't be folded to:
+    // `(true && o.m)()` calls `m` without `this`, `typeof (1 && x)` throws
+    // for an undeclared `x` and `delete (1 && x)` deletes nothing
+    static bool IsReference(Expression *expr);
+
+    // ToBoolean, false if the answer isn't certain
+    static bool ToBoolean(const Constant &value, bool *result);
+
+    // ToNumber, false if the answer isn't certain
+    static bool ToNumber(const Constant &value, double *result);
+
+    // Number::toString(10), shortest digits that read back as `value`
+    static std::string NumberToString(double value);
+};
+
+// ConstantFoldingPass ::= folds a tree built without constant folding the
+// way the ASTBuilder would have (see ASTBuilder::SetConstantFolding())
+//
+// It is an ASTRewriter, only the nodes which fold and their parents are
+// written to. Not for hash-consed trees.
+class ConstantFoldingPass : public ASTPass {
+public:
+    const char *name() const override { return "ConstantFolding"; }
+
+    bool Run(Handle<Expression> &root) override;
+};
+
+}
+
+#endif
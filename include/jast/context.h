@@ -1,11 +1,11 @@
 #ifndef CONTEXT_H_
 #define CONTEXT_H_
 
+#include "jast/scope.h"
 #include "jast/statistics.h"
 
 namespace jast {
 
-class Scope;
 class ParserContextImpl;
 
 // class to store complete context of parser independant of
@@ -17,6 +17,13 @@ public:
 
     Scope *GetGlobalScope();
 
+    // a scope from the pool of the context, alive until ReleaseScopes()
+    Scope *NewScope(Expression *root, Scope *parent, Scope::Kind kind);
+
+    // destroys the scopes of NewScope(), their memory is kept for the next
+    // ones
+    void ReleaseScopes();
+
     Statistics &Counters();
 private:
     ParserContextImpl *impl_;
@@ -0,0 +1,65 @@
+#ifndef DEAD_CODE_H_
+#define DEAD_CODE_H_
+
+#include "jast/ast-pass.h"
+
+namespace jast {
+
+// Dead code passes ::= remove statements which can never run or do nothing
+//
+// A statement is kept when it declares something, a `var` (jast doesn't tell
+// it from `let` and `const`) or a named function anywhere in it: the name is
+// hoisted to the whole function whether the statement runs or not. Tests
+// are only evaluated when they are built from literals and operators,
+// nothing with side effects is ever removed.
+
+// DeadBranchElimination ::= `if (1) a; else b;` is `a;`, and `if (0) a;` is
+// removed
+class DeadBranchElimination : public StatementPass {
+public:
+    const char *name() const override { return "DeadBranches"; }
+
+protected:
+    Handle<Expression> RewriteStatement(Handle<Expression> stmt) override;
+};
+
+// UnreachableCodeElimination ::= removes the statements of a block which
+// follow a return, throw, break or continue, or a block or if statement
+// which always ends in one
+class UnreachableCodeElimination : public StatementPass {
+public:
+    const char *name() const override { return "UnreachableCode"; }
+
+protected:
+    bool RewriteBlock(std::vector<Handle<Expression>> &stmts) override;
+};
+
+// EmptyBlockElimination ::= removes empty statements and `{}` from blocks,
+// and an empty else. a block in a block loses its braces, unless something
+// is declared right in it: `let` and `const` would leak out
+class EmptyBlockElimination : public StatementPass {
+public:
+    const char *name() const override { return "EmptyBlocks"; }
+
+protected:
+    Handle<Expression> RewriteStatement(Handle<Expression> stmt) override;
+    bool RewriteBlock(std::vector<Handle<Expression>> &stmts) override;
+};
+
+// DeadLoopElimination ::= removes `while (false) ...`, which never runs its
+// body
+class DeadLoopElimination : public StatementPass {
+public:
+    const char *name() const override { return "DeadLoops"; }
+
+protected:
+    Handle<Expression> RewriteStatement(Handle<Expression> stmt) override;
+};
+
+// adds the passes above, ordered so that each one cleans up after those
+// before it and a single round is usually enough
+void AddDeadCodePasses(PassManager *manager);
+
+}
+
+#endif
@@ -5,10 +5,13 @@
 #include "jast/source-locator.h"
 #include "jast/scope.h"
 #include "jast/handle.h"
+#include "jast/allocation-profiler.h"
 
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <string>
-#include <map>
+#include <utility>
 #include <cassert>
 
 namespace jast {
@@ -24,6 +27,7 @@ public: \
     friend class Expression; \
     friend class ASTBuilder; \
     friend class ASTFactory; \
+    friend class ASTCloner; \
     Type(const Position &pos, Scope *scope) \
         : Expression(pos, scope) \
     { } \
@@ -95,10 +99,13 @@ AST_NODE_LIST(AST_NODE_TYPE)
 
 extern const char *type_as_string[(int)ASTNodeType::kNrType];
 
+// sizeof() of the node class of `type`
+size_t SizeOfNode(ASTNodeType type);
+
 class Expression : public RefCountObject {
 protected:
     Expression(const Position &loc, Scope *scope) :
-        loc_{ loc }, scope_{ scope }
+        loc_{ loc }, scope_{ scope }, hash_{ 0 }
     { }
 public:
     virtual ~Expression() { }
@@ -121,13 +128,175 @@ AST_NODE_LIST(IS_EXPRESSION_FUNCTION)
 #undef IS_EXPRESSION_FUNCTION
 
     const Position &loc() const { return loc_;}
+
+    // calls v.Slot(Handle<T> &) for every child and v.List(std::vector<
+    // Handle<T>> &) for every list of children, in source order. the node
+    // classes with children hide this, see VisitSlots() in ast-children.h
+    template <typename V>
+    void VisitSlots(V &&v) { }
+
+    // structural hash of the subtree, 0 if not computed (see ast-hash.h).
+    // relaxed atomic, threads hashing a shared tree don't race
+    uint64_t hash() const { return hash_.load(std::memory_order_relaxed); }
+    void SetHash(uint64_t hash)
+    {
+        hash_.store(hash, std::memory_order_relaxed);
+    }
 private:
     Position loc_;
     Scope *scope_;
+    std::atomic<uint64_t> hash_;
 };
 
 using ProxyArray = std::vector<Handle<Expression>>;
-using ProxyObject = std::map<std::string, Handle<Expression>>;
+
+// the kind of an object literal property: a value, or the function of a
+// `get` or `set` accessor
+enum class PropertyKind {
+    kValue,
+    kGetter,
+    kSetter
+};
+
+// ProxyObject ::= the properties of an object literal, in source order
+//
+// Properties are kept one after the other in a vector, duplicates included,
+// so building an object of n properties is linear and a handful of
+// allocations. Looking up a name scans them until there are kIndexedSize of
+// them, then an open addressing index of their positions is built on the
+// first Find() and kept up to date from there. The names are const, as the
+// index goes by them, only the values can be changed in place. The kinds are
+// kept beside the properties once an accessor is appended.
+class ProxyObject {
+public:
+    using value_type = std::pair<const std::string, Handle<Expression>>;
+    using iterator = std::vector<value_type>::iterator;
+    using const_iterator = std::vector<value_type>::const_iterator;
+    using size_type = std::vector<value_type>::size_type;
+
+    static const size_t kIndexedSize = 16;
+
+    // adds a property after the others, even if one has the same name
+    void Append(std::string name, Handle<Expression> value,
+        PropertyKind kind = PropertyKind::kValue);
+
+    // growing copies the const names, the parser reserves all of them
+    void Reserve(size_t size);
+
+    // the property `name` has the value of, the last one of that name. null
+    // if there is none
+    value_type *Find(const std::string &name);
+
+    size_type size() const { return props_.size(); }
+    bool empty() const { return props_.empty(); }
+    size_type capacity() const { return props_.capacity(); }
+
+    value_type &operator[](size_t i) { return props_[i]; }
+
+    // the kind of the property `i`
+    PropertyKind kind(size_t i) const
+    {
+        return i < kinds_.size() ? kinds_[i] : PropertyKind::kValue;
+    }
+
+    iterator begin() { return props_.begin(); }
+    iterator end() { return props_.end(); }
+    const_iterator begin() const { return props_.begin(); }
+    const_iterator end() const { return props_.end(); }
+
+    // heap held by the index, 0 before it is built
+    size_t IndexBytes() const { return index_.capacity() * sizeof(uint32_t); }
+    // heap held by the kinds, 0 without accessors
+    size_t KindBytes() const { return kinds_.capacity() * sizeof(PropertyKind); }
+
+    bool operator==(const ProxyObject &other) const
+    {
+        if (props_ != other.props_)
+            return false;
+        for (size_t i = 0; i < props_.size(); i++) {
+            if (kind(i) != other.kind(i))
+                return false;
+        }
+        return true;
+    }
+private:
+    // the bucket of `name`, or the empty one where it would go
+    uint32_t *Bucket(const std::string &name);
+    void Index(uint32_t position);
+    void BuildIndex();
+
+    std::vector<value_type> props_;
+    // empty until the first accessor, then one for each property
+    std::vector<PropertyKind> kinds_;
+    // power of two buckets, 1 + the position of a property or 0 when empty
+    std::vector<uint32_t> index_;
+};
+
+// PackedArray ::= the elements of an array literal of only numbers or only
+// strings, as values instead of nodes
+//
+// Data tables are written as array literals of thousands of numbers or
+// strings, a node and a handle for each of which take ten times the value.
+// A packed array keeps the numbers in one vector of doubles, the strings one
+// after the other in one buffer with the offset each of them ends at, and
+// where each element was written as two 32 bit numbers.
+class PackedArray {
+public:
+    enum class Kind { kNumber, kString };
+
+    // the parser packs array literals of at least kMinSize elements, when
+    // ASTBuilder::SetArrayPacking() is on
+    static const size_t kMinSize = 16;
+
+    explicit PackedArray(Kind kind)
+        : kind_{ kind }
+    { }
+
+    Kind kind() const { return kind_; }
+
+    // a number to a kNumber array, a string to a kString one, written at
+    // `loc`
+    void Append(double value, const Position &loc);
+    void Append(const std::string &value, const Position &loc);
+
+    size_t size() const
+    {
+        return kind_ == Kind::kNumber ? numbers_.size() : ends_.size();
+    }
+    bool empty() const { return size() == 0; }
+
+    double number(size_t i) const { return numbers_[i]; }
+    std::string string(size_t i) const
+    {
+        size_t begin = i ? ends_[i - 1] : 0;
+        return strings_.substr(begin, ends_[i] - begin);
+    }
+
+    // where the element `i` was written
+    Position position(size_t i) const
+    {
+        return Position(locs_[i].col, locs_[i].row);
+    }
+
+    // heap held by the values and the positions
+    size_t OwnedBytes() const;
+
+    // numbers are compared bit for bit, the positions don't count
+    bool operator==(const PackedArray &other) const;
+private:
+    struct Loc {
+        uint32_t col;
+        uint32_t row;
+    };
+
+    void AppendPosition(const Position &loc);
+
+    Kind kind_;
+    std::vector<double> numbers_;
+    std::string strings_;
+    std::vector<uint32_t> ends_;
+    std::vector<Loc> locs_;
+};
 
 // ExpressionList ::= helper class representing a list of expressions
 class ExpressionList : public RefCountObject {
@@ -140,7 +309,22 @@ public:
 
     void Insert(Handle<Expression> expr)
     {
+        auto capacity = exprs_.capacity();
         exprs_.push_back(expr);
+        if (exprs_.capacity() != capacity) {
+            AllocationProfiler::OnContainer(AllocationContainer::kExpressionList,
+                exprs_.capacity() * sizeof(Handle<Expression>));
+        }
+    }
+
+    // room for `size` expressions, without growing the list until then
+    void Reserve(size_t size)
+    {
+        if (size <= exprs_.capacity())
+            return;
+        exprs_.reserve(size);
+        AllocationProfiler::OnContainer(AllocationContainer::kExpressionList,
+            exprs_.capacity() * sizeof(Handle<Expression>));
     }
 
     size_t Size()
@@ -148,6 +332,9 @@ public:
         return exprs_.size();
     }
 
+    template <typename V>
+    void VisitSlots(V &&v) { v.List(exprs_); }
+
     std::vector<Handle<Expression>> &raw_list() { return exprs_; }
 
     ~ExpressionList()
@@ -197,20 +384,46 @@ public:
         : Expression(loc, scope), value_(value)
     { }
 
-    double value() { return value_; }
+    double value() const { return value_; }
     DEFINE_NODE_TYPE(IntegralLiteral);
 };
 
+// string() is the text of the literal as it was written, escape sequences
+// included, which the printer and the matchers go by. value() is the string
+// it stands for, decoded the first time it is asked for and kept. A literal
+// without escape sequences is its own value, which is never copied.
+//
+// value() is const and may be called from several threads at once, as on a
+// FrozenAST: the first decoded value to be published is the one kept.
 class StringLiteral : public Expression {
 private:
     std::string str_;
 public:
-    StringLiteral(Position &loc, Scope *scope, const std::string &str)
-        : Expression(loc, scope), str_(str)
+    StringLiteral(Position &loc, Scope *scope, std::string str)
+        : Expression(loc, scope), str_(std::move(str))
     { }
 
-    std::string &string() { return str_; }
+    const std::string &string() const { return str_; }
+
+    // value() is decoded again from the new text. Not while other threads
+    // read the literal
+    void set_string(std::string str)
+    {
+        ResetValue();
+        str_ = std::move(str);
+    }
+
+    // \n, \x41, \u00e9, \u{1F600}, ... decoded, as UTF-8
+    const std::string &value() const;
     DEFINE_NODE_TYPE(StringLiteral);
+private:
+    void ResetValue();
+
+    // null until value() is first asked for, &str_ without escapes
+    mutable std::atomic<const std::string*> value_{ nullptr };
+    // what value_ points to with escapes, set by the thread which published
+    // it
+    mutable std::unique_ptr<std::string> decoded_;
 };
 
 class TemplateLiteral : public Expression {
@@ -218,27 +431,56 @@ private:
     std::string template_string_;
 
 public:
-    TemplateLiteral(Position &loc, Scope *scope, const std::string &template_string)
-        : Expression(loc, scope), template_string_{ template_string }
+    TemplateLiteral(Position &loc, Scope *scope, std::string template_string)
+        : Expression(loc, scope), template_string_{ std::move(template_string) }
     { }
 
     std::string &template_string() { return template_string_; }
+    const std::string &template_string() const { return template_string_; }
     DEFINE_NODE_TYPE(TemplateLiteral);
 };
 
+// A packed array literal (see PackedArray), which the parser only makes with
+// ASTBuilder::SetArrayPacking() on, has no children, its elements are
+// values like the characters of a string: exprs() is empty and packed()
+// holds them. Code which needs nodes for them asks the ASTBuilder to make
+// them (see ASTBuilder::UnpackArrayLiteral()), which is a change to the tree.
 class ArrayLiteral : public Expression {
 public:
     ArrayLiteral(Position &loc, Scope *scope, ProxyArray exprs)
         : Expression(loc, scope), exprs_{ std::move(exprs) }
     { }
 
+    ArrayLiteral(Position &loc, Scope *scope, PackedArray packed)
+        : Expression(loc, scope),
+          packed_{ new PackedArray(std::move(packed)) }
+    { }
+
+    // empty when the array is packed
     ProxyArray &exprs() { return exprs_; }
 
-    typename ProxyArray::size_type length() { return exprs_.size(); }
+    // null unless the array is packed
+    const PackedArray *packed() const { return packed_.get(); }
+
+    // the nodes of the elements in place of the packed values
+    void Unpack(ProxyArray exprs)
+    {
+        packed_.reset();
+        exprs_ = std::move(exprs);
+    }
+
+    typename ProxyArray::size_type length() const
+    {
+        return packed_ ? packed_->size() : exprs_.size();
+    }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.List(exprs_); }
 
     DEFINE_NODE_TYPE(ArrayLiteral);
 private:
     ProxyArray exprs_;
+    std::unique_ptr<PackedArray> packed_;
 };
 
 class ObjectLiteral : public Expression {
@@ -251,6 +493,13 @@ public:
     bool IsEmpty() { return Props.empty(); }
     ProxyObject::size_type GetPropertyCount() { return Props.size(); }
 
+    template <typename V>
+    void VisitSlots(V &&v)
+    {
+        for (auto &prop : Props)
+            v.Slot(prop.second);
+    }
+
     DEFINE_NODE_TYPE(ObjectLiteral);
 private:
     ProxyObject Props;
@@ -266,7 +515,13 @@ public:
 
     const std::string &GetName() const { return name_; }
     bool ProduceRValue() override { return false; }
+
+    // set by the ScopeResolver, unresolved until then
+    const Binding &binding() const { return binding_; }
+    void SetBinding(const Binding &binding) { binding_ = binding; }
     DEFINE_NODE_TYPE(Identifier);
+private:
+    Binding binding_;
 };
 
 class BooleanLiteral : public Expression {
@@ -275,7 +530,7 @@ public:
     BooleanLiteral(Position &loc, Scope *scope, bool val)
         : Expression(loc, scope), pred_(val) { }
 
-    bool pred() { return pred_; }
+    bool pred() const { return pred_; }
     DEFINE_NODE_TYPE(BooleanLiteral);
 };
 
@@ -299,9 +554,13 @@ public:
         return regex_;
     }
 
+    const std::string &regex() const { return regex_; }
+
     std::vector<RegExpFlags> &flags() {
         return flags_;
     }
+
+    const std::vector<RegExpFlags> &flags() const { return flags_; }
     DEFINE_NODE_TYPE(RegExpLiteral);
 private:
     std::string regex_;
@@ -317,6 +576,13 @@ public:
     Handle<ExpressionList> args() { return args_; }
     auto length() { return args()->Size(); }
 
+    template <typename V>
+    void VisitSlots(V &&v)
+    {
+        if (args_)
+            args_->VisitSlots(v);
+    }
+
     DEFINE_NODE_TYPE(ArgumentList);
 private:
     Handle<ExpressionList> args_;
@@ -347,10 +613,13 @@ public:
     { }
 
     Handle<Expression> member() { return member_; }
-    MemberAccessKind kind() { return kind_; }
+    MemberAccessKind kind() const { return kind_; }
 
     Handle<Expression> expr() { return expr_; }
     bool ProduceRValue() override { return false; }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(expr_); v.Slot(member_); }
     DEFINE_NODE_TYPE(CallExpression);
 private:
     MemberAccessKind kind_;
@@ -392,10 +661,13 @@ public:
     { }
 
     Handle<Expression> member() { return member_; }
-    MemberAccessKind kind() { return kind_; }
+    MemberAccessKind kind() const { return kind_; }
 
     Handle<Expression> expr() { return expr_; }
     bool ProduceRValue() override { return false; }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(expr_); v.Slot(member_); }
     DEFINE_NODE_TYPE(MemberExpression);
 private:
     MemberAccessKind kind_;
@@ -411,6 +683,9 @@ public:
 
     Handle<Expression> member() { return member_; }
     bool ProduceRValue() override { return false; }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(member_); }
     DEFINE_NODE_TYPE(NewExpression);
 private:
     Handle<Expression> member_;
@@ -434,8 +709,11 @@ public:
     { }
 
 
-    PrefixOperation op() { return op_; }
+    PrefixOperation op() const { return op_; }
     Handle<Expression> expr() { return expr_; }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(expr_); }
     DEFINE_NODE_TYPE(PrefixExpression);
 private:
     PrefixOperation op_;
@@ -454,8 +732,11 @@ public:
     { }
 
 
-    PostfixOperation op() { return op_; }
+    PostfixOperation op() const { return op_; }
     Handle<Expression> expr() { return expr_; }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(expr_); }
     DEFINE_NODE_TYPE(PostfixExpression);
 private:
     PostfixOperation op_;
@@ -488,13 +769,33 @@ enum class BinaryOperation {
     kIn
 };
 
+// `=` and the compound assignments, which apply the binary operation of the
+// same name to the target and the value
+enum class AssignOperation {
+    kAssign,
+    kAddition,
+    kSubtraction,
+    kMultiplication,
+    kDivision,
+    kMod,
+    kShiftRight,
+    kShiftLeft,
+    kShiftZeroRight,
+    kBitAnd,
+    kBitOr,
+    kBitXor
+};
+
 class BinaryExpression : public Expression {
     DEFINE_NODE_TYPE(BinaryExpression);
 public:
 
-    BinaryOperation op() { return op_; }
+    BinaryOperation op() const { return op_; }
     Handle<Expression> lhs() { return lhs_; }
     Handle<Expression> rhs() { return rhs_; }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(lhs_); v.Slot(rhs_); }
 private:
     BinaryOperation op_;
     Handle<Expression> lhs_;
@@ -507,13 +808,19 @@ public:
 
 class AssignExpression : public Expression {
 public:
-    AssignExpression(Position &loc, Scope *scope, Handle<Expression> lhs, Handle<Expression> rhs)
-        : Expression(loc, scope), lhs_(lhs), rhs_(rhs) { }
+    AssignExpression(Position &loc, Scope *scope, AssignOperation op,
+        Handle<Expression> lhs, Handle<Expression> rhs)
+        : Expression(loc, scope), op_(op), lhs_(lhs), rhs_(rhs) { }
 
+    AssignOperation op() const { return op_; }
     Handle<Expression> lhs() { return lhs_; }
     Handle<Expression> rhs() { return rhs_; }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(lhs_); v.Slot(rhs_); }
     DEFINE_NODE_TYPE(AssignExpression);
 private:
+    AssignOperation op_;
     Handle<Expression> lhs_;
     Handle<Expression> rhs_;
 };
@@ -529,6 +836,14 @@ public:
     Handle<Expression> first() { return first_; }
     Handle<Expression> second() { return second_; }
     Handle<Expression> third() { return third_; }
+
+    template <typename V>
+    void VisitSlots(V &&v)
+    {
+        v.Slot(first_);
+        v.Slot(second_);
+        v.Slot(third_);
+    }
     DEFINE_NODE_TYPE(TernaryExpression);
 private:
     Handle<Expression> first_;
@@ -543,6 +858,13 @@ public:
     { }
 
     Handle<ExpressionList> exprs() { return exprs_; }
+
+    template <typename V>
+    void VisitSlots(V &&v)
+    {
+        if (exprs_)
+            exprs_->VisitSlots(v);
+    }
     DEFINE_NODE_TYPE(CommaExpression);
 private:
     Handle<ExpressionList> exprs_;
@@ -556,12 +878,21 @@ public:
 
 
     std::string &name() { return name_; }
+    const std::string &name() const { return name_; }
 
     Handle<Expression> expr() { return init_; }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(init_); }
+
+    // slot of the declared name, set by the ScopeResolver
+    const Binding &binding() const { return binding_; }
+    void SetBinding(const Binding &binding) { binding_ = binding; }
     DEFINE_NODE_TYPE(Declaration);
 private:
     std::string name_;
     Handle<Expression> init_;
+    Binding binding_;
 };
 
 class DeclarationList : public Expression {
@@ -577,6 +908,9 @@ public:
     {
         exprs_.push_back(Handle<Declaration>(decl));
     }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.List(exprs_); }
     DEFINE_NODE_TYPE(DeclarationList);
 private:
     std::vector<Handle<Declaration>> exprs_;
@@ -0,0 +1,190 @@
+#ifndef FROZEN_AST_H_
+#define FROZEN_AST_H_
+
+#include "jast/expression.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace jast {
+
+class FrozenAST;
+
+// NodeRef ::= a borrowed view of one node of a FrozenAST
+//
+// Two words, copied freely, and neither a NodeRef nor anything reached
+// through it touches a reference count. The node is only handed out as a
+// const pointer: its plain data (names, values, operators) can be read,
+// its Handle returning accessors can't be called.
+//
+// The children are those of ForEachChild(), in source order and without the
+// missing ones. A node shared by a hash-consed tree has one NodeRef, with its
+// own parent, for every place it occurs in.
+class NodeRef {
+public:
+    NodeRef() : ast_{ nullptr }, index_{ kNone } { }
+
+    explicit operator bool() const { return index_ != kNone; }
+
+    const Expression *get() const;
+    const Expression *operator->() const { return get(); }
+
+    ASTNodeType type() const { return get()->type(); }
+    const Position &loc() const { return get()->loc(); }
+
+    // the node as a `T`, null when it is not one
+    template <typename T>
+    const T *As() const { return dynamic_cast<const T*>(get()); }
+
+    // preorder number of the node, 0 for the root. the nodes of its subtree
+    // are numbered index() to index() + subtree_size() - 1
+    uint32_t index() const { return index_; }
+    uint32_t subtree_size() const;
+
+    // a null NodeRef for the root
+    NodeRef parent() const;
+
+    size_t size() const;
+    NodeRef child(size_t i) const;
+
+    class iterator {
+    public:
+        iterator(const FrozenAST *ast, const uint32_t *child)
+            : ast_{ ast }, child_{ child }
+        { }
+
+        NodeRef operator*() const { return NodeRef(ast_, *child_); }
+        iterator &operator++() { child_++; return *this; }
+        bool operator==(const iterator &other) const
+        {
+            return child_ == other.child_;
+        }
+        bool operator!=(const iterator &other) const
+        {
+            return child_ != other.child_;
+        }
+
+    private:
+        const FrozenAST *ast_;
+        const uint32_t *child_;
+    };
+
+    // the children, `for (NodeRef child : node)`
+    iterator begin() const;
+    iterator end() const;
+
+    bool operator==(const NodeRef &other) const
+    {
+        return ast_ == other.ast_ && index_ == other.index_;
+    }
+    bool operator!=(const NodeRef &other) const { return !(*this == other); }
+
+private:
+    friend class FrozenAST;
+
+    static const uint32_t kNone = UINT32_MAX;
+
+    NodeRef(const FrozenAST *ast, uint32_t index)
+        : ast_{ ast }, index_{ index }
+    { }
+
+    const FrozenAST *ast_;
+    uint32_t index_;
+};
+
+// FrozenAST ::= an AST which won't change any more, shared by any number of
+// threads through NodeRefs
+//
+// Freezing takes the tree over and indexes it once, in preorder: every node
+// gets its number, its parent and its children. Readers then only follow
+// that index and read the nodes, so they neither race on the non-atomic
+// reference counts nor bounce the cache lines of atomic ones (see
+// docs/concurrency.md). Preorder numbers split the tree into ranges of work,
+// node(i) for i in [a, b).
+//
+// The tree is released with the FrozenAST, when the last shared_ptr
+// returned by Freeze() is gone. NodeRefs must not outlive it. Before the
+// FrozenAST is shared, the freezing thread must drop the other handles into
+// the tree, the ParserBuilder which built it included, or keep them until
+// the sharing is over.
+class FrozenAST {
+public:
+    static std::shared_ptr<const FrozenAST> Freeze(Handle<Expression> root);
+
+    explicit FrozenAST(Handle<Expression> root);
+
+    // null NodeRef for an empty tree
+    NodeRef root() const { return node(0); }
+
+    // number of nodes, counting a shared node once for every occurrence
+    size_t size() const { return entries_.size(); }
+
+    NodeRef node(size_t index) const
+    {
+        return index < entries_.size() ? NodeRef(this, (uint32_t)index)
+                                       : NodeRef();
+    }
+
+    FrozenAST(const FrozenAST &) = delete;
+    FrozenAST &operator=(const FrozenAST &) = delete;
+
+private:
+    friend class NodeRef;
+
+    struct Entry {
+        const Expression *node;
+        uint32_t parent;
+        uint32_t subtree_size;
+        uint32_t first_child;   // in children_
+        uint32_t children;
+    };
+
+    Handle<Expression> root_;
+    std::vector<Entry> entries_;
+    std::vector<uint32_t> children_;
+};
+
+inline const Expression *NodeRef::get() const
+{
+    return ast_->entries_[index_].node;
+}
+
+inline uint32_t NodeRef::subtree_size() const
+{
+    return ast_->entries_[index_].subtree_size;
+}
+
+inline NodeRef NodeRef::parent() const
+{
+    uint32_t parent = ast_->entries_[index_].parent;
+    return parent == kNone ? NodeRef() : NodeRef(ast_, parent);
+}
+
+inline size_t NodeRef::size() const
+{
+    return ast_->entries_[index_].children;
+}
+
+inline NodeRef NodeRef::child(size_t i) const
+{
+    auto &entry = ast_->entries_[index_];
+    return NodeRef(ast_, ast_->children_[entry.first_child + i]);
+}
+
+inline NodeRef::iterator NodeRef::begin() const
+{
+    auto &entry = ast_->entries_[index_];
+    return iterator(ast_, ast_->children_.data() + entry.first_child);
+}
+
+inline NodeRef::iterator NodeRef::end() const
+{
+    auto &entry = ast_->entries_[index_];
+    return iterator(ast_, ast_->children_.data() + entry.first_child
+        + entry.children);
+}
+
+}
+
+#endif
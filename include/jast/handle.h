@@ -2,8 +2,10 @@
 #define HANDLE_H_
 
 
+#include <atomic>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 #include "jast/macros.h"
 
@@ -19,6 +21,24 @@ public:
 
   virtual ~RefCountObject() = default;
 
+  // with ATOMIC_REFCOUNT (the JAST_ATOMIC_REFCOUNT cmake option) threads may
+  // copy and drop handles to objects they share, the last one to let go sees
+  // every write made to the object before it is deleted. otherwise an object
+  // and every handle to it belong to one thread at a time, see
+  // docs/concurrency.md
+#ifdef ATOMIC_REFCOUNT
+  inline int decrement() {
+    return reference_count_.fetch_sub(1, std::memory_order_acq_rel) - 1;
+  }
+
+  inline int increment() {
+    return reference_count_.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  inline int GetNumReferences() const {
+    return reference_count_.load(std::memory_order_relaxed);
+  }
+#else
   inline int decrement() {
     return --reference_count_;
   }
@@ -30,9 +50,36 @@ public:
   inline int GetNumReferences() const {
     return reference_count_;
   }
+#endif
+
+  // deletes `object`. Objects released by its destructor are queued and
+  // deleted one after another once it's gone, so freeing a tree takes
+  // constant stack space however deep the tree is.
+  static void Release(RefCountObject *object) {
+    thread_local std::vector<RefCountObject*> pending;
+    thread_local bool releasing = false;
+
+    if (releasing) {
+      pending.push_back(object);
+      return;
+    }
+
+    releasing = true;
+    delete object;
+    while (!pending.empty()) {
+      object = pending.back();
+      pending.pop_back();
+      delete object;
+    }
+    releasing = false;
+  }
 
 private:
+#ifdef ATOMIC_REFCOUNT
+  std::atomic<int> reference_count_;
+#else
   int reference_count_;
+#endif
 };
 
 // class T should be a subtype of ReferenceCount class.
@@ -59,11 +106,14 @@ public:
   }
 
   Ref<T> &operator=(const Ref<T> &ref) {
-    clear();
-    ptr_ = ref.ptr_;
-    if (ptr_ != nullptr) {
-      ptr_->increment();
+    // taken before the old object is released, which may be the same one or
+    // own `ref`
+    T *ptr = ref.ptr_;
+    if (ptr != nullptr) {
+      ptr->increment();
     }
+    clear();
+    ptr_ = ptr;
     return *this;
   }
 
@@ -80,11 +130,11 @@ public:
 
   inline void clear() {
     if (ptr_ != nullptr) {
-      ptr_->decrement();
-      if (ptr_->GetNumReferences() <= 0) {
-        delete ptr_;
-      }
+      T *ptr = ptr_;
       ptr_ = nullptr;
+      if (ptr->decrement() <= 0) {
+        RefCountObject::Release(ptr);
+      }
     }
   }
 
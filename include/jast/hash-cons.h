@@ -0,0 +1,78 @@
+#ifndef HASH_CONS_H_
+#define HASH_CONS_H_
+
+#include "jast/expression.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace jast {
+
+// HashConsTable ::= keeps one canonical node for every distinct immutable
+// expression
+//
+// Nodes are interned bottom up as the builder creates them, so the children
+// of a node are canonical already and two nodes are identical when their own
+// fields are equal and they point to the same children. Interning is
+// therefore O(1) per node and never walks a subtree.
+//
+// Only expressions are shared (literals, identifiers, operators, calls,
+// member accesses, array and object literals). Statements, declarations and
+// functions are never shared since they own scopes and labels, and anything
+// containing them has a unique child so it isn't shared either.
+//
+// A shared node has the position of its first occurrence. Every occurrence is
+// recorded in a side table, see positions().
+//
+// Shared nodes must not be modified in place: a change would show up at every
+// occurrence.
+class HashConsTable {
+public:
+    HashConsTable();
+    ~HashConsTable();
+
+    // returns the canonical node equal to `expr`, `expr` itself when it is the
+    // first of its kind or can't be shared
+    Handle<Expression> Intern(Handle<Expression> expr);
+
+    // true for the node types which can be shared
+    static bool IsShareable(ASTNodeType type);
+
+    // positions of all occurrences of `expr`, in the order they were created,
+    // which is the source order. the k-th occurrence found by a left to right
+    // walk of the tree is at the k-th position
+    std::vector<Position> positions(Expression *expr) const;
+
+    // number of times `expr` was created, 0 if `expr` isn't canonical
+    size_t occurrences(Expression *expr) const;
+
+    // number of distinct canonical nodes
+    size_t nodes() const { return nodes_; }
+
+    // number of nodes which were replaced by a canonical node
+    size_t hits() const { return hits_; }
+
+    // sizeof() of the replaced nodes, heap memory they own isn't counted
+    size_t saved_bytes() const { return saved_bytes_; }
+
+    // drops all the canonical nodes, nodes already in a tree stay alive
+    void Clear();
+
+private:
+    uint64_t HashNode(Expression *expr) const;
+    bool Equal(Expression *a, Expression *b) const;
+
+    std::unordered_multimap<uint64_t, Handle<Expression>> table_;
+
+    // positions of the second and later occurrences of shared nodes
+    std::unordered_map<Expression*, std::vector<Position>> positions_;
+
+    size_t nodes_;
+    size_t hits_;
+    size_t saved_bytes_;
+};
+
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define PARSER_BUILDER_H_
 
 #include <memory>
+#include <sstream>
 #include "jast/parser.h"
 #include "jast/ast-builder.h"
 #include "jast/astfactory.h"
@@ -11,6 +12,13 @@
 
 namespace jast {
 
+// ParserBuilder ::= builds a parser and everything it needs for one input
+//
+// A builder can be reused for many small inputs with Reset(), which is much
+// cheaper than building a new one: the context, tokenizer, scopes and
+// builder are kept with the memory of their buffers and tables, only the
+// state of the last parse is dropped. The statistics keep adding up across
+// parses.
 class ParserBuilder {
 public:
     ParserBuilder(std::istream &is, const std::string &filename = "STDIN")
@@ -30,11 +38,38 @@ public:
         return parser_.get();
     }
 
+    // parses `is` next, whatever happened to the last parse. the AST of the
+    // last parse is no longer kept alive by the builder
+    //
+    // the scopes go back to the pool of the context and are handed out again
+    // by the next parse, the names interned for them are dropped. GetScope()
+    // of the trees parsed before, and what ResolveScopes() bound in them, are
+    // invalid after a Reset(): resolve and use them before, or parse them
+    // with a ParserBuilder of their own
+    void Reset(std::istream &is) {
+        stream_->reset(is);
+        lex_->reset(stream_.get());
+        manager_->Reset();
+        builder_->Reset();
+        parser_->Reset();
+    }
+
+    // parses a copy of `source` next, held by the builder
+    void Reset(const std::string &source) {
+        source_.str(source);
+        source_.clear();
+        Reset(source_);
+    }
+
     ParserContext *context() { return context_.get(); }
 
+    ASTBuilder *builder() { return builder_.get(); }
+
+    ScopeManager *manager() { return manager_.get(); }
+
 private:
     std::unique_ptr<ParserContext> context_;
-    std::unique_ptr<CharacterStream> stream_;
+    std::unique_ptr<StandardCharacterStream> stream_;
     std::unique_ptr<Tokenizer> lex_;
     std::unique_ptr<SourceLocator> locator_;
     ASTFactory* factory_;
@@ -42,6 +77,7 @@ private:
     std::unique_ptr<ASTBuilder> builder_;
     std::unique_ptr<Parser> parser_;
     std::string filename_;
+    std::istringstream source_;
 };
 
 }
@@ -16,6 +16,10 @@ class Expression;
 class Declaration;
 class ExpressionList;
 class FunctionPrototype;
+class PackedArray;
+enum class BinaryOperation;
+enum class AssignOperation;
+enum class PropertyKind;
 
 
 // ParserFlags := represents various parsing flags
@@ -42,7 +46,6 @@ private:
 // A recursive descent parser plus operator precedance parser for JavaScript
 class Parser {
 public:
-    friend class NewScope;
     friend class NonRegexEnvironment;
     friend class ForInLoopParsingEnvironment;
 
@@ -54,6 +57,12 @@ public:
 
     Handle<Expression> ParseObjectMethod(const std::string &name);
     Handle<Expression> ParseArrayLiteral();
+    // takes the next element of an array literal into `packed` if it is a
+    // lone literal of its kind, false and nothing taken otherwise
+    bool ParsePackedElement(PackedArray &packed);
+    // makes nodes of the elements packed so far and appends them to `exprs`
+    void UnpackElements(PackedArray &packed,
+        std::vector<Handle<Expression>> &exprs);
     Handle<Expression> ParseObjectLiteral();
 
     Handle<Expression> ParseDotExpression();
@@ -110,7 +119,26 @@ public:
 
     Handle<Expression> ParseVariableOrExpressionOptional();
 
+    // forgets the state left by the last parse, which may have ended with an
+    // error. the operator stacks keep their memory
+    void Reset();
+
 private:
+    // operator precedence engine behind the binary, ternary and assign
+    // expression parsers, see parser.cc
+    enum class OperatorLevel {
+        kBinary,
+        kTernary,
+        kAssign
+    };
+
+    // parses an expression of the grammar `level` whose binary operators at
+    // the top level bind at least as strong as `power`. `lhs` is an already
+    // parsed first operand, if any
+    Handle<Expression> ParseOperators(OperatorLevel level, int power,
+        Handle<Expression> lhs);
+    void ReduceBinary(size_t base, int power);
+
     String GetStringLiteral();
     String GetIdentifierName();
     double ParseNumber(const Token &token);
@@ -129,6 +157,39 @@ private:
     Tokenizer *lex_;
     ScopeManager *manager_;
     ParserFlags flags_;
+
+    // OperatorFrame ::= pending operator of ParseOperators()
+    struct OperatorFrame {
+        enum Kind {
+            kBinary,
+            kAssign,
+            kQuestion,  // waiting for the `:` of a ternary
+            kColon      // waiting for the last operand of a ternary
+        };
+
+        Kind kind;
+        BinaryOperation op;
+        int power;
+        AssignOperation assign;     // only for kAssign
+    };
+
+    // shared by nested ParseOperators() calls, each one works above the
+    // sizes it found on entry
+    std::vector<Handle<Expression>> operands_;
+    std::vector<OperatorFrame> operators_;
+
+    // PropertyFrame ::= property of an object literal ParseObjectLiteral()
+    // is still reading
+    struct PropertyFrame {
+        std::string name;
+        Handle<Expression> value;
+        PropertyKind kind;
+    };
+
+    // shared by nested ParseObjectLiteral() calls like the operators. the
+    // ProxyObject is sized once from it, as its const names would be copied
+    // each time it grew
+    std::vector<PropertyFrame> properties_;
 };
 
 extern Handle<Expression> ParseProgram(Parser *parser);
@@ -1,12 +1,48 @@
 #ifndef SCANNER_H_
 #define SCANNER_H_
 
+#include "jast/trace.h"
+
+#include <cstddef>
+#include <cstdio>
 #include <string>
 #include <iosfwd>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace jast {
 
+namespace internal {
+
+// the first character of [begin, end) which is `a`, `b` or `c`, or `end`
+inline const char *FindAnyOf(const char *begin, const char *end, char a,
+    char b, char c)
+{
+#if defined(__SSE2__)
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c);
+    for (; end - begin >= 16; begin += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, va),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, vb), _mm_cmpeq_epi8(chunk, vc)));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask)
+            return begin + __builtin_ctz(mask);
+    }
+#endif
+    for (; begin != end; begin++) {
+        if (*begin == a || *begin == b || *begin == c)
+            return begin;
+    }
+    return end;
+}
+
+}
+
 class CharacterStream {
 public:
     virtual ~CharacterStream() = default;
@@ -16,20 +52,49 @@ public:
     virtual int read(std::string &str, int num) = 0;
 
     virtual char readchar() = 0;
+
+    // appends to `str` the characters before the first one which is `a`,
+    // `b` or `c`, which is left in the stream, and returns their number
+    virtual size_t readuntil(std::string &str, char a, char b, char c)
+    {
+        size_t count = 0;
+        char ch = readchar();
+        while (ch != EOF && ch != a && ch != b && ch != c) {
+            str.push_back(ch);
+            count++;
+            ch = readchar();
+        }
+        if (ch != EOF)
+            putback(ch);
+        return count;
+    }
 };
 
 // simple scanner class
+//
+// Reads what the stream has ready a chunk at a time, and one character at a
+// time when it has nothing ready (e.g. a terminal), so that it never waits
+// for more input than the tokenizer asks for.
 template <class StreamType, class BufferType>
 class BufferedCharacterStream : public CharacterStream {
 public:
-    BufferedCharacterStream(StreamType &is) : is_(is), buffer_(0) { }
+    BufferedCharacterStream(StreamType &is)
+        : is_(&is), buffer_(0), begin_(0), end_(0)
+    { }
     ~BufferedCharacterStream() = default;
 
+    // reads `is` from now on, the putback buffer keeps its memory
+    void reset(StreamType &is) {
+        is_ = &is;
+        buffer_.clear();
+        begin_ = end_ = 0;
+    }
+
     // read a character from stream
     int read(std::string &str, int num) override  {
         str.resize(num, '\0');
 
-        if (is_.eof())
+        if (is_->eof())
             return -1;
         // FIXME: make it working
         // auto size = is_.readsome(str.data(), num);
@@ -46,15 +111,66 @@ public:
             buffer_.pop_back();
             return ch;
         }
-        if (is_.fail() || is_.eof()) {
+        if (begin_ == end_ && !fill())
             return EOF;
+        return chunk_[begin_++];
+    }
+
+    size_t readuntil(std::string &str, char a, char b, char c) override {
+        // the characters put back come first
+        size_t count = 0;
+        while (!buffer_.empty()) {
+            char ch = buffer_.back();
+            if (ch == EOF || ch == a || ch == b || ch == c)
+                return count;
+            str.push_back(ch);
+            buffer_.pop_back();
+            count++;
+        }
+
+        while (begin_ != end_ || fill()) {
+            const char *begin = chunk_.data() + begin_;
+            const char *end = chunk_.data() + end_;
+            const char *stop = internal::FindAnyOf(begin, end, a, b, c);
+            str.append(begin, stop);
+            count += stop - begin;
+            begin_ += stop - begin;
+            if (stop != end)
+                break;
         }
-        return is_.get();
+        return count;
     }
 
 private:
-    StreamType &is_;
+    static const size_t kChunkSize = 16384;
+
+    // reads the next chunk, false at the end of the stream
+    bool fill() {
+        if (is_->fail() || is_->eof())
+            return false;
+        if (chunk_.empty())
+            chunk_.resize(kChunkSize);
+        begin_ = 0;
+        {
+            TraceScope trace("refill", "tokenizer");
+            end_ = is_->readsome(chunk_.data(), chunk_.size());
+        }
+        if (end_ > 0)
+            return true;
+
+        int ch = is_->get();
+        if (ch == EOF)
+            return false;
+        chunk_[0] = (char)ch;
+        end_ = 1;
+        return true;
+    }
+
+    StreamType *is_;
     BufferType buffer_;
+    std::vector<char> chunk_;
+    size_t begin_;
+    size_t end_;
 };
 
 using Scanner = BufferedCharacterStream<std::istream, std::vector<char>>;
@@ -0,0 +1,45 @@
+#ifndef SCOPE_RESOLVER_H_
+#define SCOPE_RESOLVER_H_
+
+#include "jast/expression.h"
+#include "jast/scope.h"
+
+namespace jast {
+
+// ScopeResolver ::= builds the function and catch scopes of a parsed tree and
+// binds every variable to its declaration
+//
+// The parser puts every node in the global scope. Resolve() opens a Scope
+// for every function and catch clause and points each node at its innermost
+// scope. Parameters, `var`s and function declarations are hoisted into the
+// scope of their function, a catch parameter gets a scope of its own. Each
+// declaration takes the next slot of its scope, parameters first, and the
+// Binding (depth, slot) is stored on the Declaration, FunctionPrototype or
+// catch parameter.
+//
+// Every Identifier used as a variable is then looked up once, from its
+// scope outwards, and gets the Binding of the declaration it names, or a
+// global one when no scope declares it. Later passes just read binding().
+// Names after a `.` and labels aren't variables and stay unresolved.
+// `arguments` is declared in the innermost function using it.
+//
+// The scopes belong to the ScopeManager and go with its Reset() or its
+// ParserBuilder, the bindings are plain numbers and stay with the tree. A
+// hash-consed tree shares identifiers between scopes, so Resolve() refuses
+// it. The statements of case clauses which fall through are shared by the
+// parser and resolved once.
+class ScopeResolver {
+public:
+    explicit ScopeResolver(ScopeManager *manager);
+
+    // throws std::runtime_error when an identifier is reached twice, as in a
+    // hash-consed tree, before any variable is looked up
+    void Resolve(Handle<Expression> root);
+
+private:
+    ScopeManager *manager_;
+};
+
+}
+
+#endif
@@ -1,8 +1,11 @@
 #ifndef SYMBOL_TABLE_H_
 #define SYMBOL_TABLE_H_
 
-#include <map>
-#include <list>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 namespace jast {
 
@@ -10,52 +13,145 @@ class ParserContext;
 class Expression;
 class SymT;
 
-class Scope {
-public:
-    using Value = Expression;
-public:
-    Scope(Value *root, Scope *parent);
-    ~Scope();
+// Binding ::= what a name refers to once the scopes are resolved (see
+// scope-resolver.h): the slot of a declaration in the scope at `depth`, the
+// global scope being at 0, or a global which no scope declares
+struct Binding {
+    static const uint32_t kUnresolved = UINT32_MAX;
+    static const uint32_t kGlobal = UINT32_MAX - 1;
 
-    SymT *symbol_table();
+    Binding() : depth{ kUnresolved }, slot{ 0 } { }
+    Binding(uint32_t depth, uint32_t slot) : depth{ depth }, slot{ slot } { }
 
-    Scope *parent() { return parent_; }
+    static Binding Global() { return Binding(kGlobal, 0); }
 
-private:
-    // root of tree where scope starts
-    Value *root_;
-    SymT *symbol_table_;
-    Scope *parent_;
+    // false for names which aren't variables, e.g. `b` in `a.b` or labels
+    bool resolved() const { return depth != kUnresolved; }
+    bool global() const { return depth == kGlobal; }
+
+    bool operator==(const Binding &other) const
+    {
+        return depth == other.depth && slot == other.slot;
+    }
+    bool operator!=(const Binding &other) const { return !(*this == other); }
+
+    uint32_t depth;
+    uint32_t slot;
 };
 
+class Scope;
+
+// SymT ::= the declarations of a scope, an open addressing hash table keyed
+// by interned names
+//
+// Most scopes declare a handful of names, so the first kInlineEntries live
+// in the SymT itself and are found by comparing pointers one after the
+// other. Past that they move to a heap table with linear probing, kept at
+// most half full.
 class SymT {
 public:
-    using Name = std::string;
+    // interned by the ScopeManager, equal names are the same pointer
+    using Name = const std::string *;
     using Value = Expression;
 
+    struct Entry {
+        Value *value;
+        uint32_t slot;
+    };
+
+    static const uint32_t kInlineEntries = 8;
+
     SymT(Scope *scope);
 
-    void Push(const Name &name, Value *value);
+    // declares `name` in the next slot and returns it. declaring a name again
+    // keeps its slot and its first value
+    uint32_t Push(Name name, Value *value);
+
+    bool Exists(Name name) const { return Lookup(name) != nullptr; }
 
-    bool Exists(const Name &name) const;
+    Value *Get(Name name);
 
-    Value *Get(const Name &name);
+    // null if `name` isn't declared here
+    const Entry *Lookup(Name name) const;
+
+    // number of slots
+    size_t size() const { return size_; }
+
+    // forgets the names, a heap table is kept for the next ones
+    void Clear();
 
     Scope *scope();
+
+    SymT(const SymT &) = delete;
+    SymT &operator=(const SymT &) = delete;
 private:
-    std::map<Name, Value*> entries_;
+    struct Bucket {
+        Name name;
+        Entry entry;
+    };
+
+    // the bucket of `name`, or the empty one where it would go
+    Bucket *Find(Name name) const;
+    void Grow();
+
+    Name inline_names_[kInlineEntries];
+    Entry inline_entries_[kInlineEntries];
+    // power of two buckets, null while the inline entries are enough
+    std::unique_ptr<Bucket[]> table_;
+    uint32_t capacity_;
+    uint32_t size_;
     Scope *scope_;
 };
 
+class Scope {
+public:
+    using Value = Expression;
+
+    enum class Kind {
+        kGlobal,
+        // parameters, `var`s and functions declared in the function
+        kFunction,
+        // the parameter of a catch clause, `var`s go to the function
+        kCatch,
+    };
+public:
+    Scope(Value *root, Scope *parent, Kind kind = Kind::kFunction);
+
+    SymT *symbol_table();
+
+    Scope *parent() { return parent_; }
+
+    Value *root() { return root_; }
+    Kind kind() const { return kind_; }
+
+    // number of scopes around this one
+    uint32_t depth() const { return depth_; }
+
+    // the scope `var` declarations in this one go to, skipping catch scopes
+    Scope *VarScope();
+
+private:
+    // root of tree where scope starts
+    Value *root_;
+    SymT symbol_table_;
+    Scope *parent_;
+    Kind kind_;
+    uint32_t depth_;
+};
+
 // ScopeManager manages stack of scope. It keeps a pointer to the current scope
 // and hence current SymT.
+//
+// The scopes it creates, from the pool of the ParserContext, and the names it
+// interns live until Reset(), or the manager dies with its ParserBuilder.
 class ScopeManager {
 public:
     ScopeManager(ParserContext *context);
 
     // NewScope creates a new scope and pushes the current scope to the stack
     // and makes current_ point to new scope
-    Scope *NewScope(SymT::Value *value);
+    Scope *NewScope(SymT::Value *value,
+        Scope::Kind kind = Scope::Kind::kFunction);
 
     // pops the scope from stack, and current now points to popped scope.
     Scope *PopScope();
@@ -64,13 +160,22 @@ public:
 
     Scope *global_scope() { return global_scope_; }
 
+    ParserContext *context() { return context_; }
+
+    // the one copy of `name`, for the symbol tables
+    SymT::Name Intern(const std::string &name);
+
+    // back to an empty global scope, for parsing the next input
+    void Reset();
+
 private:
     void PushScope(Scope *scope);
 
     ParserContext *context_;
     Scope *global_scope_;
     Scope *current_;
-    std::list<Scope*> scope_stack_;
+    std::vector<Scope*> scope_stack_;
+    std::unordered_set<std::string> names_;
 };
 
 }
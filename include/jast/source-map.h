@@ -0,0 +1,93 @@
+#ifndef SOURCE_MAP_H_
+#define SOURCE_MAP_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace jast {
+
+// VLQ ::= base64 variable length quantity used by the `mappings` field of
+// Source Map v3
+class VLQ {
+public:
+    // appends encoded `value` to `out`
+    static void Encode(std::string &out, int64_t value);
+
+    // decodes one value from `in` starting at `pos` and moves `pos` past it.
+    // returns false if the input is not a valid VLQ
+    static bool Decode(const std::string &in, size_t &pos, int64_t &value);
+};
+
+// SourceMapGenerator ::= collects mappings from generated code positions to
+// the original source positions and writes them out as a Source Map v3
+// document.
+//
+// Mappings must be added in increasing generated position (which is what a
+// printer does naturally). Each mapping is encoded into the `mappings` string
+// as soon as it is added, so the cost per mapping is a few VLQ digits and no
+// intermediate list is kept around.
+class SourceMapGenerator {
+public:
+    SourceMapGenerator(const std::string &file = "");
+
+    // registers an original source file and returns its index
+    int AddSource(const std::string &name, const std::string &content = "");
+
+    // registers a symbol name and returns its index
+    int AddName(const std::string &name);
+
+    // maps generated (line, col) to original (line, col) of source `source`.
+    // all lines and columns are zero based. `name` is -1 for no name.
+    void AddMapping(size_t gen_line, size_t gen_col, size_t src_line,
+        size_t src_col, int source = 0, int name = -1);
+
+    std::string mappings() const
+    {
+        return std::string(mappings_.data(), length_);
+    }
+
+    size_t size() const { return count_; }
+
+    // writes the complete source map as JSON
+    void Write(std::ostream &os) const;
+
+    std::string ToString() const;
+
+private:
+    // makes room for `length` more characters of mappings
+    char *Reserve(size_t length);
+
+    std::string file_;
+    std::vector<std::string> sources_;
+    std::vector<std::string> contents_;
+    std::vector<std::string> names_;
+
+    // open addressing index over names_, looked up for every mapped
+    // identifier. a slot holds the hash and index + 1 of the name, 0 if empty
+    struct NameSlot {
+        size_t hash;
+        int index;
+    };
+    std::vector<NameSlot> name_slots_;
+
+    // encoded mappings, only the first length_ characters are used. segments
+    // are written in place so that no bounds check is done per character
+    std::vector<char> mappings_;
+    size_t length_;
+    size_t count_;
+
+    // state of the last written segment, VLQ fields are relative to these
+    size_t gen_line_;
+    int64_t gen_col_;
+    int64_t source_;
+    int64_t src_line_;
+    int64_t src_col_;
+    int64_t name_;
+    bool line_has_segment_;
+};
+
+}
+
+#endif
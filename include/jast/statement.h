@@ -16,6 +16,13 @@ public:
 
     Handle<ExpressionList> statements() { return stmts_; }
     void PushExpression(Handle<Expression> expr);
+
+    template <typename V>
+    void VisitSlots(V &&v)
+    {
+        if (stmts_)
+            stmts_->VisitSlots(v);
+    }
     DEFINE_NODE_TYPE(BlockStatement);
 private:
     Handle<ExpressionList> stmts_;
@@ -39,8 +46,18 @@ public:
     Handle<Expression> condition() { return condition_; }
     Handle<Expression> update() { return update_; }
     Handle<Expression> body() { return body_; }
+    void SetBody(Handle<Expression> body) { body_ = body; }
 
-    ForKind kind() { return kind_; }
+    ForKind kind() const { return kind_; }
+
+    template <typename V>
+    void VisitSlots(V &&v)
+    {
+        v.Slot(init_);
+        v.Slot(condition_);
+        v.Slot(update_);
+        v.Slot(body_);
+    }
 
     DEFINE_NODE_TYPE(ForStatement);
 private:
@@ -62,6 +79,10 @@ public:
 
     ExprPtr condition() { return condition_; }
     ExprPtr body() { return body_; }
+    void SetBody(ExprPtr body) { body_ = body; }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(condition_); v.Slot(body_); }
 
     DEFINE_NODE_TYPE(WhileStatement);
 private:
@@ -77,6 +98,9 @@ public:
 
 
     Handle<Expression> label() { return label_; }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(label_); }
     DEFINE_NODE_TYPE(BreakStatement);
 private:
     Handle<Expression> label_;
@@ -91,6 +115,9 @@ public:
 
     Handle<Expression> label() { return label_; }
 
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(label_); }
+
     DEFINE_NODE_TYPE(ContinueStatement);
 private:
     Handle<Expression> label_;
@@ -105,6 +132,9 @@ public:
 
     Handle<Expression> expr() { return expr_; }
 
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(expr_); }
+
     DEFINE_NODE_TYPE(ThrowStatement);
 private:
     Handle<Expression> expr_;
@@ -123,6 +153,15 @@ public:
     Handle<Expression> catch_expr() { return catch_expr_; }
     Handle<Expression> catch_block() { return catch_block_; }
     Handle<Expression> finally() { return finally_; }
+
+    template <typename V>
+    void VisitSlots(V &&v)
+    {
+        v.Slot(try_block_);
+        v.Slot(catch_expr_);
+        v.Slot(catch_block_);
+        v.Slot(finally_);
+    }
     DEFINE_NODE_TYPE(TryCatchStatement);
 private:
     Handle<Expression> try_block_;
@@ -140,6 +179,10 @@ public:
 
     Handle<Expression> expr() { return expr_; }
     std::string &label() { return label_; }
+    const std::string &label() const { return label_; }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(expr_); }
 
     DEFINE_NODE_TYPE(LabelledStatement);
 private:
@@ -158,6 +201,9 @@ public:
     Handle<Expression> clause() { return clause_; }
     Handle<Expression> stmt() { return stmt_; }
 
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(clause_); v.Slot(stmt_); }
+
     DEFINE_NODE_TYPE(CaseClauseStatement);
 private:
     Handle<Expression> clause_;
@@ -196,6 +242,9 @@ public:
     iterator end() { return cases_.end(); }
 
     auto Size() { return cases_.size(); }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.List(cases_); v.Slot(default_); }
 private:
     Handle<Expression> default_;
     std::vector<Handle<CaseClauseStatement>> cases_;
@@ -212,6 +261,14 @@ public:
     Handle<Expression> default_clause() { return clauses_->def(); }
     Handle<ClausesList> clauses() { return clauses_; }
     Handle<Expression> expr() { return expr_; }
+
+    template <typename V>
+    void VisitSlots(V &&v)
+    {
+        v.Slot(expr_);
+        if (clauses_)
+            clauses_->VisitSlots(v);
+    }
     DEFINE_NODE_TYPE(SwitchStatement);
 private:
     Handle<Expression> expr_;
@@ -229,6 +286,10 @@ public:
 
     ExprPtr condition() { return condition_; }
     ExprPtr body() { return body_; }
+    void SetBody(ExprPtr body) { body_ = body; }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(body_); v.Slot(condition_); }
 private:
     Handle<Expression> condition_;
     Handle<Expression> body_;
@@ -245,9 +306,16 @@ public:
     { }
     const std::string &GetName() const;
     const std::vector<std::string> &GetArgs() const;
+
+    // slot of the name, set by the ScopeResolver: in the enclosing scope for
+    // a declaration, in the function's own for a named function expression.
+    // the arguments take the first slots of the function's scope, in order
+    const Binding &binding() const { return binding_; }
+    void SetBinding(const Binding &binding) { binding_ = binding; }
 private:
     std::string name_;
     std::vector<std::string> args_;
+    Binding binding_;
 };
 
 // FunctionStatement - captures the function statement
@@ -262,6 +330,9 @@ public:
 
     Handle<FunctionPrototype> proto() { return proto_; }
     Handle<Expression> body() { return body_; }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(proto_); v.Slot(body_); }
 private:
     Handle<FunctionPrototype> proto_;
     Handle<Expression> body_;
@@ -278,6 +349,10 @@ public:
 
     Handle<Expression> condition() { return condition_; }
     Handle<Expression> body() { return body_; }
+    void SetBody(ExprPtr body) { body_ = body; }
+
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(condition_); v.Slot(body_); }
 private:
     Handle<Expression> condition_;
     Handle<Expression> body_;
@@ -297,6 +372,16 @@ public:
     Handle<Expression> condition() { return condition_; }
     Handle<Expression> body() { return body_; }
     Handle<Expression> els() { return else_; }
+    void SetBody(ExprPtr body) { body_ = body; }
+    void SetElse(ExprPtr el) { else_ = el; }
+
+    template <typename V>
+    void VisitSlots(V &&v)
+    {
+        v.Slot(condition_);
+        v.Slot(body_);
+        v.Slot(else_);
+    }
 private:
     Handle<Expression> condition_;
     Handle<Expression> body_;
@@ -311,6 +396,9 @@ public:
 
     Handle<Expression> expr() { return expr_; }
 
+    template <typename V>
+    void VisitSlots(V &&v) { v.Slot(expr_); }
+
     DEFINE_NODE_TYPE(ReturnStatement);
 private:
     Handle<Expression> expr_;
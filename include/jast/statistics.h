@@ -1,10 +1,27 @@
 #ifndef STATISTICS_H_
 #define STATISTICS_H_
 
+#include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
 
+// Statistics ::= counters, per node type counts and phase timers of a parser
+//
+// Everything here compiles to nothing when DISABLE_COUNTERS is defined (the
+// JAST_DISABLE_COUNTERS cmake option): the counters stay 0, CountNode() and
+// PhaseTimer are empty inline functions, and the outputs only print zeros.
+//
+// With the counters compiled in, phase timing is still off until
+// SetTimersEnabled(true), so an untimed parse doesn't read the clock on every
+// token.
 namespace jast {
 
+enum class ASTNodeType;
+
 #define COUNTER_TYPE(F) \
     F(Token) \
     F(ASTNode) \
@@ -12,6 +29,77 @@ namespace jast {
     F(Allocations) \
     F(Line)
 
+// phases nest, the tokenizer runs inside the parser, so each phase is timed
+// inclusively. read and visit are timed by the caller around its own code,
+// optimize by the PassManager
+#define STATISTICS_PHASE_LIST(F) \
+    F(Read, "read") \
+    F(Tokenize, "tokenize") \
+    F(Parse, "parse") \
+    F(Scope, "scope") \
+    F(Optimize, "optimize") \
+    F(Visit, "visit")
+
+enum class Phase {
+#define PHASE_ENUM(Phase, name) k##Phase,
+STATISTICS_PHASE_LIST(PHASE_ENUM)
+#undef PHASE_ENUM
+    kNrPhase
+};
+
+// LatencyHistogram ::= durations in power of two nanosecond buckets, bucket i
+// holds durations in [2^(i-1), 2^i) ns and bucket 0 holds 0 ns. fixed size, so
+// recording is a few instructions and two histograms merge by addition
+class LatencyHistogram {
+public:
+    static const int kBuckets = 64;
+
+    LatencyHistogram()
+        : buckets_{ 0 }, count_{ 0 }, sum_{ 0 }, min_{ UINT64_MAX }, max_{ 0 }
+    { }
+
+    void Record(uint64_t ns)
+    {
+        buckets_[Bucket(ns)]++;
+        count_++;
+        sum_ += ns;
+        if (ns < min_)
+            min_ = ns;
+        if (ns > max_)
+            max_ = ns;
+    }
+
+    static int Bucket(uint64_t ns)
+    {
+        return ns ? std::min(64 - __builtin_clzll(ns), kBuckets - 1) : 0;
+    }
+
+    // exclusive upper bound of bucket i in ns, the last bucket has none
+    static uint64_t UpperBound(int bucket)
+    {
+        return bucket >= 63 ? UINT64_MAX : (uint64_t)1 << bucket;
+    }
+
+    // upper bound of the bucket holding the p-th percentile (0 < p <= 100),
+    // so it is at most 2x the exact value. 0 when nothing was recorded
+    uint64_t Percentile(double p) const;
+
+    uint64_t bucket(int i) const { return buckets_[i]; }
+    uint64_t count() const { return count_; }
+    uint64_t sum() const { return sum_; }
+    uint64_t min() const { return count_ ? min_ : 0; }
+    uint64_t max() const { return max_; }
+
+    LatencyHistogram &operator+=(const LatencyHistogram &other);
+
+private:
+    uint64_t buckets_[kBuckets];
+    uint64_t count_;
+    uint64_t sum_;
+    uint64_t min_;
+    uint64_t max_;
+};
+
 class Statistics {
     enum CountType {
 #define COUNT_TYPE(t) k##t,
@@ -20,19 +108,121 @@ COUNTER_TYPE(COUNT_TYPE)
         kSize,
     };
 public:
+    // PassCount ::= the runs of one optimization pass, with the nodes of the
+    // trees it was given and of the trees it left, summed over the runs
+    struct PassCount {
+        std::string name;
+        std::size_t runs;
+        std::size_t nodes_before;
+        std::size_t nodes_after;
+    };
+
+    // enough for ASTNodeType::kNrType, checked in statistics.cc
+    static const int kMaxNodeTypes = 64;
+
     Statistics()
-        : counters_{0}
+        : counters_{0}, node_counts_{0}, node_bytes_{0}, timers_{ false }
     { }
 
 #define COUNTER_ACCESSOR(t) std::size_t &t() { return counters_[CountType::k##t]; }
 COUNTER_TYPE(COUNTER_ACCESSOR)
 #undef COUNTER_ACCESSOR
 
+    // a node of `type` taking `bytes` bytes was created
+    void CountNode(ASTNodeType type, std::size_t bytes)
+    {
+#ifndef DISABLE_COUNTERS
+        node_counts_[(int)type]++;
+        node_bytes_[(int)type] += bytes;
+#endif
+    }
+
+    std::size_t NodeCount(ASTNodeType type) const
+    {
+        return node_counts_[(int)type];
+    }
+
+    std::size_t NodeBytes(ASTNodeType type) const
+    {
+        return node_bytes_[(int)type];
+    }
+
+    // a run of the pass `name` took a tree of `before` nodes to `after`
+    void CountPass(const char *name, std::size_t before, std::size_t after);
+
+    // in the order the passes first ran
+    const std::vector<PassCount> &passes() const { return passes_; }
+
+    void SetTimersEnabled(bool enable) { timers_ = enable; }
+    bool timers_enabled() const { return timers_; }
+
+    const LatencyHistogram &histogram(Phase phase) const
+    {
+        return phases_[(int)phase];
+    }
+
+    LatencyHistogram &histogram(Phase phase) { return phases_[(int)phase]; }
+
+    // adds the counters and histograms of `other`, to aggregate many parses
+    Statistics &operator+=(const Statistics &other);
+
     void dump();
+
+    // one JSON object with the counters, the non empty phases (with their
+    // buckets), the node types that were created and the passes that ran
+    void DumpJSON(std::ostream &os) const;
+
+    // Prometheus text exposition format, every metric name starts with
+    // `prefix`_. phases are one histogram with a phase label, its buckets
+    // are in seconds
+    void DumpPrometheus(std::ostream &os,
+        const std::string &prefix = "jast") const;
+
 private:
     std::size_t counters_[CountType::kSize];
+    std::size_t node_counts_[kMaxNodeTypes];
+    std::size_t node_bytes_[kMaxNodeTypes];
+    LatencyHistogram phases_[(int)Phase::kNrPhase];
+    std::vector<PassCount> passes_;
+    bool timers_;
 };
 
+// PhaseTimer ::= records the time from its construction to its destruction
+// in the histogram of `phase`, when the timers of `stats` are enabled
+#ifndef DISABLE_COUNTERS
+class PhaseTimer {
+public:
+    PhaseTimer(Statistics &stats, Phase phase)
+        : histogram_{ stats.timers_enabled() ? &stats.histogram(phase)
+                                             : nullptr }
+    {
+        if (histogram_)
+            start_ = std::chrono::steady_clock::now();
+    }
+
+    ~PhaseTimer()
+    {
+        if (!histogram_)
+            return;
+        auto diff = std::chrono::steady_clock::now() - start_;
+        histogram_->Record(std::chrono::duration_cast<
+            std::chrono::nanoseconds>(diff).count());
+    }
+
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+private:
+    LatencyHistogram *histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+#else
+class PhaseTimer {
+public:
+    PhaseTimer(Statistics &, Phase) { }
+};
+#endif
+
 }
 
 #endif
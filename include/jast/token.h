@@ -2,6 +2,7 @@
 #define TOKEN_H_
 
 #include <string>
+#include <utility>
 #include "jast/tokens.h"
 namespace jast {
 
@@ -33,7 +34,7 @@ private:
 class Token {
 public:
     Token(std::string view, TokenType type, Position pos, size_t full_pos)
-        : view_{ view }, type_{ type }, pos_{pos}, full_pos_{ full_pos }
+        : view_{ std::move(view) }, type_{ type }, pos_{pos}, full_pos_{ full_pos }
     { }
 
     Token(int64_t num, TokenType type, Position pos, size_t full_pos)
@@ -21,6 +21,10 @@ public:
 
     void advance(bool divide_expected = false);
 
+    // the first character after the current token which is not white space
+    // or part of a comment, left in the input. EOF at its end
+    char peekChar();
+
     void reset(CharacterStream *stream);
 
     Token &currentToken();
@@ -0,0 +1,90 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace jast {
+
+// Tracer ::= opt-in recording of begin/end events, written out in the Chrome
+// Trace Event format which chrome://tracing and Perfetto open
+//
+// Every thread records into its own fixed size buffer, which only that
+// thread writes, so recording takes no lock. Write() may run while other
+// threads are tracing, it sees the events they had published.
+//
+// A full buffer drops new events, but always keeps room for the end events
+// of the scopes still open, so the trace stays balanced. The number of
+// dropped events is returned by dropped().
+//
+// While tracing is off a TraceScope costs one relaxed load and a branch.
+//
+// The events recorded by the library, by category: ParseProgram, statement
+// and function (parser), refill of a 16 KB chunk of the source (tokenizer),
+// the walks, clones and rewrites (visitor), ResolveScopes (scope), the
+// passes (pass), and the processing and grouping of CloneDetector (clones).
+class Tracer {
+public:
+    // starts recording, with room for `events` events per thread. events
+    // recorded by an earlier Start() are kept until Clear()
+    static void Start(size_t events = 1 << 20);
+    static void Stop();
+
+    static bool enabled()
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    // writes the events of all the threads as one JSON object
+    static void Write(std::ostream &os);
+
+    // drops the recorded events. must not race with threads still tracing
+    static void Clear();
+
+    static size_t dropped();
+
+    // names the calling thread in the trace
+    static void SetThreadName(const std::string &name);
+
+    // `name` and `category` must outlive the tracer, string literals are
+    // expected. `arg` is copied and truncated
+    static bool Begin(const char *name, const char *category);
+    static void End(const char *arg = nullptr);
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+// TraceScope ::= a begin event now and the matching end event when the scope
+// is left. an argument given with SetArg() is shown on the event
+class TraceScope {
+public:
+    TraceScope(const char *name, const char *category)
+        : recorded_{ Tracer::enabled() && Tracer::Begin(name, category) },
+          arg_{ nullptr }
+    { }
+
+    ~TraceScope()
+    {
+        if (recorded_)
+            Tracer::End(arg_);
+    }
+
+    // `arg` must live until the end of the scope
+    void SetArg(const char *arg) { arg_ = arg; }
+
+    bool recorded() const { return recorded_; }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    bool recorded_;
+    const char *arg_;
+};
+
+}
+
+#endif
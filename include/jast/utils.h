@@ -9,4 +9,27 @@ do { \
 
 #endif
 
+#include <cstdint>
+
+namespace jast {
+
+// finalizer of MurmurHash3, every input bit affects every output bit
+inline uint64_t HashMix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// order dependent, so (a, b) and (b, a) hash differently
+inline uint64_t HashCombine(uint64_t seed, uint64_t value)
+{
+    return HashMix(seed + 0x9e3779b97f4a7c15ULL + value);
+}
+
+}
+
 #endif
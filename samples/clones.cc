@@ -0,0 +1,114 @@
+#include "jast/clone-detector.h"
+#include "jast/trace.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// clones ::= reports duplicated code in a set of JavaScript files
+//
+//      clones [--min-nodes <n>] [--threads <n>] [--values] [--near-miss]
+//             [--similarity <s>] [--trace <file>] <files>...
+//
+// --values only reports clones with equal identifiers and literals. --trace
+// writes a Chrome trace of the run, one track per worker thread.
+// Timing and throughput go to stderr, the clone groups to stdout.
+using namespace jast;
+
+static void PrintFragment(const CloneDetector &detector,
+    const CloneFragment &fragment)
+{
+    std::cout << "  " << detector.name(fragment.file) << ":"
+        << fragment.begin.row() + 1 << ":" << fragment.begin.col() << "-"
+        << fragment.end.row() + 1 << ":" << fragment.end.col()
+        << " (" << fragment.size << " nodes)\n";
+}
+
+int main(int argc, char *argv[])
+{
+    CloneDetector::Options options;
+    std::vector<const char*> files;
+    const char *trace = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--min-nodes") && i + 1 < argc) {
+            options.min_nodes = std::atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            options.threads = std::atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--values")) {
+            options.sensitivity = HashSensitivity::kTypesAndValues;
+        } else if (!strcmp(argv[i], "--near-miss")) {
+            options.near_miss = true;
+        } else if (!strcmp(argv[i], "--similarity") && i + 1 < argc) {
+            options.similarity = std::atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            trace = argv[++i];
+        } else if (argv[i][0] != '-') {
+            files.push_back(argv[i]);
+        } else {
+            files.clear();
+            break;
+        }
+    }
+
+    if (files.empty()) {
+        std::cerr << "usage: " << argv[0]
+            << " [--min-nodes <n>] [--threads <n>] [--values] [--near-miss]"
+               " [--similarity <s>] [--trace <file>] <files>...\n";
+        return -1;
+    }
+
+    CloneDetector detector(options);
+    size_t bytes = 0;
+    for (auto file : files) {
+        std::ifstream in(file);
+        if (!in) {
+            std::cerr << file << ": unable to open\n";
+            return -1;
+        }
+
+        std::stringstream ss;
+        ss << in.rdbuf();
+        bytes += ss.str().size();
+        detector.AddFile(file, ss.str());
+    }
+
+    if (trace)
+        Tracer::Start();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto groups = detector.Run();
+    auto diff = std::chrono::high_resolution_clock::now() - start;
+    double ms = std::chrono::duration_cast<std::chrono::microseconds>(diff)
+        .count() / 1e3;
+
+    if (trace) {
+        Tracer::Stop();
+        std::ofstream out(trace);
+        Tracer::Write(out);
+    }
+
+    for (size_t i = 0; i < detector.size(); i++) {
+        if (!detector.error(i).empty())
+            std::cerr << detector.name(i) << ": " << detector.error(i) << "\n";
+    }
+
+    for (auto &group : groups) {
+        std::cout << (group.exact ? "exact" : "near miss") << " clone, "
+            << group.fragments.size() << " fragments";
+        if (!group.exact)
+            std::cout << ", similarity " << group.similarity;
+        std::cout << "\n";
+
+        for (auto &fragment : group.fragments)
+            PrintFragment(detector, fragment);
+    }
+
+    std::cerr << groups.size() << " clone groups in " << files.size()
+        << " files, " << ms << " ms, "
+        << (ms > 0 ? bytes / 1048576.0 / (ms / 1e3) : 0) << " MB/s\n";
+    return 0;
+}
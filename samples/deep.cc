@@ -0,0 +1,154 @@
+#include "jast/parser-builder.h"
+#include "jast/ast-children.h"
+#include "jast/ast-hash.h"
+#include "jast/ast-walker.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+// deep ::= benchmarks walking and freeing very deep trees
+//
+//      deep [--depth <n>] [--recursive]
+//
+// Three synthetic trees of depth n are used: the left deep chain of a parsed
+// `a + a + ... + a`, the right deep chain of a parsed `a = a = ... = a` and
+// an `if (a) a; else if (a) a; else ...` ladder built directly with the
+// factory, since parsing one recurses per level.
+//
+// For each tree the parse (chains only), ASTWalker, structural hashing and
+// teardown times are printed, the teardown frees the whole tree.
+// --recursive also walks the trees with a recursive ForEachChild, which is
+// what every ASTVisitor does, and is expected to overflow the stack for a
+// large n.
+using namespace jast;
+
+using Clock = std::chrono::high_resolution_clock;
+
+static double Since(Clock::time_point start)
+{
+    auto diff = Clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::microseconds>(diff)
+        .count() / 1e3;
+}
+
+class Counter : public ASTWalker {
+public:
+    size_t count = 0;
+
+protected:
+    bool Enter(Expression *expr) override
+    {
+        count++;
+        return true;
+    }
+};
+
+static size_t CountRecursive(Expression *expr)
+{
+    size_t count = 1;
+    ForEachChild(expr, [&count](Expression *child) {
+        count += CountRecursive(child);
+    });
+    return count;
+}
+
+static Handle<Expression> Chain(size_t depth, char op, double *parse_ms)
+{
+    std::string source = "a";
+    source.reserve(depth * 2 + 2);
+    for (size_t i = 0; i < depth; i++) {
+        source += op;
+        source += 'a';
+    }
+    source += ";";
+
+    std::istringstream is(source);
+    ParserBuilder builder(is);
+
+    auto start = Clock::now();
+    auto ast = ParseProgram(builder.Build());
+    *parse_ms = Since(start);
+    return ast;
+}
+
+static Handle<Expression> Ladder(size_t depth)
+{
+    auto factory = ASTFactory::GetFactoryInstance();
+    Position pos;
+
+    Handle<Expression> tail = factory->NewIdentifier(pos, nullptr, "a");
+    for (size_t i = 0; i < depth; i++) {
+        tail = factory->NewIfElseStatement(pos, nullptr,
+            factory->NewIdentifier(pos, nullptr, "a"),
+            factory->NewIdentifier(pos, nullptr, "a"), tail);
+    }
+    return tail;
+}
+
+static void Run(const char *name, Handle<Expression> &ast, bool recursive)
+{
+    auto start = Clock::now();
+    Counter counter;
+    counter.Walk(ast);
+    double walk = Since(start);
+
+    start = Clock::now();
+    StructuralHasher::Hash(ast, HashSensitivity::kTypes);
+    double hash = Since(start);
+
+    double rec = 0;
+    if (recursive) {
+        start = Clock::now();
+        CountRecursive(ast.GetPtr());
+        rec = Since(start);
+    }
+
+    start = Clock::now();
+    ast.clear();
+    double teardown = Since(start);
+
+    size_t n = counter.count;
+    std::cout << name << ": " << n << " nodes\n"
+        << "  walk      " << walk << " ms, " << walk * 1e6 / n << " ns/node\n"
+        << "  hash      " << hash << " ms, " << hash * 1e6 / n << " ns/node\n";
+    if (recursive) {
+        std::cout << "  recursive " << rec << " ms, " << rec * 1e6 / n
+            << " ns/node\n";
+    }
+    std::cout << "  teardown  " << teardown << " ms, "
+        << teardown * 1e6 / n << " ns/node\n";
+}
+
+int main(int argc, char *argv[])
+{
+    size_t depth = 1000000;
+    bool recursive = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--depth") && i + 1 < argc) {
+            depth = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--recursive")) {
+            recursive = true;
+        } else {
+            std::cerr << "usage: " << argv[0]
+                << " [--depth <n>] [--recursive]\n";
+            return -1;
+        }
+    }
+
+    double parse = 0;
+    auto chain = Chain(depth, '+', &parse);
+    std::cout << "chain parse " << parse << " ms\n";
+    Run("chain", chain, recursive);
+
+    auto assign = Chain(depth, '=', &parse);
+    std::cout << "assign parse " << parse << " ms\n";
+    Run("assign", assign, recursive);
+
+    auto ladder = Ladder(depth);
+    Run("ladder", ladder, recursive);
+    return 0;
+}
@@ -40,6 +40,18 @@ void DumpAST::Visit(ArrayLiteral *literal)
 
     os() << "ArrayLiteral {\n";
     tab()++;
+    // the elements of a packed array are dumped like their nodes
+    if (auto packed = literal->packed()) {
+        for (size_t i = 0; i < packed->size(); i++) {
+            if (packed->kind() == PackedArray::Kind::kNumber) {
+                os_tabbed() << "IntegralLiteral (" << packed->number(i)
+                    << ")\n";
+            } else {
+                os_tabbed() << "StringLiteral ('" << packed->string(i)
+                    << "')\n";
+            }
+        }
+    }
     for (auto &expr : arr) {
         os_tabbed();
         expr->Accept(this);
@@ -54,8 +66,20 @@ void DumpAST::Visit(ObjectLiteral *literal)
 
     os() << "ObjectLiteral {\n";
     tab()++;
-    for (auto &p : obj) {
-        os_tabbed() << "ObjectProperty (" << p.first << ") {\n";
+    for (size_t i = 0; i < obj.size(); i++) {
+        auto &p = obj[i];
+        switch (obj.kind(i)) {
+        case PropertyKind::kValue:
+            os_tabbed() << "ObjectProperty (";
+            break;
+        case PropertyKind::kGetter:
+            os_tabbed() << "ObjectGetter (";
+            break;
+        case PropertyKind::kSetter:
+            os_tabbed() << "ObjectSetter (";
+            break;
+        }
+        os() << p.first << ") {\n";
         tab()++;
         os_tabbed() << "PropertyValue {\n";
         tab()++;
@@ -346,6 +370,47 @@ void DumpAST::Visit(AssignExpression *expr)
     tab()++;
     os_tabbed();
     expr->lhs()->Accept(this);
+    os_tabbed() << "OP(";
+    switch (expr->op()) {
+    case AssignOperation::kAssign:
+        os() << "=";
+        break;
+    case AssignOperation::kAddition:
+        os() << "+=";
+        break;
+    case AssignOperation::kSubtraction:
+        os() << "-=";
+        break;
+    case AssignOperation::kMultiplication:
+        os() << "*=";
+        break;
+    case AssignOperation::kDivision:
+        os() << "/=";
+        break;
+    case AssignOperation::kMod:
+        os() << "%=";
+        break;
+    case AssignOperation::kShiftRight:
+        os() << ">>=";
+        break;
+    case AssignOperation::kShiftZeroRight:
+        os() << ">>>=";
+        break;
+    case AssignOperation::kShiftLeft:
+        os() << "<<=";
+        break;
+    case AssignOperation::kBitAnd:
+        os() << "&=";
+        break;
+    case AssignOperation::kBitOr:
+        os() << "|=";
+        break;
+    case AssignOperation::kBitXor:
+        os() << "^=";
+        break;
+    default: throw std::runtime_error("invalid assignment operation");
+    }
+    os() << ")\n";
     os_tabbed();
     expr->rhs()->Accept(this);
     tab()--;
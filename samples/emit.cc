@@ -0,0 +1,106 @@
+#include "jast/parser-builder.h"
+#include "jast/code-printer.h"
+#include "jast/source-map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// emit ::= parses JavaScript from stdin and prints it back
+//
+//      emit [--minify] [--names] [--source-map <file>] [--bench <iterations>]
+//
+// --names records identifier names in the source map.
+// With --bench nothing is printed, instead the AST is emitted `iterations`
+// times without and with a source map, alternating between the two. The best
+// time of each is reported.
+using namespace jast;
+
+static double Emit(Handle<Expression> ast, bool minify, bool names,
+    bool with_map, size_t *mappings)
+{
+    std::ostringstream os;
+    SourceMapGenerator map("out.js");
+    map.AddSource("STDIN");
+
+    auto start = std::chrono::high_resolution_clock::now();
+    {
+        CodePrinter printer(os, with_map ? &map : nullptr, minify);
+        printer.SetRecordNames(names);
+        printer.Print(ast);
+    }
+    auto diff = std::chrono::high_resolution_clock::now() - start;
+
+    *mappings = map.size();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(diff).count()
+        / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    bool minify = false;
+    bool names = false;
+    int iterations = 0;
+    const char *map_file = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--minify")) {
+            minify = true;
+        } else if (!strcmp(argv[i], "--names")) {
+            names = true;
+        } else if (!strcmp(argv[i], "--source-map") && i + 1 < argc) {
+            map_file = argv[++i];
+        } else if (!strcmp(argv[i], "--bench") && i + 1 < argc) {
+            iterations = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0]
+                << " [--minify] [--names] [--source-map <file>]"
+                   " [--bench <iterations>]\n";
+            return -1;
+        }
+    }
+
+    ParserBuilder builder(std::cin, "STDIN");
+    Handle<Expression> ast;
+
+    try {
+        ast = ParseProgram(builder.Build());
+    } catch (std::exception &) {
+        std::cout << "\x1b[33mError\x1b[0m" << std::endl;
+        return -1;
+    }
+
+    if (iterations > 0) {
+        size_t mappings = 0;
+        double plain = 1e9, mapped = 1e9;
+        for (int i = 0; i < iterations; i++) {
+            plain = std::min(plain, Emit(ast, minify, names, false, &mappings));
+            mapped = std::min(mapped, Emit(ast, minify, names, true, &mappings));
+        }
+
+        std::cout << "emit:             " << plain << "ms\n";
+        std::cout << "emit+source map:  " << mapped << "ms ("
+                  << mappings << " mappings)\n";
+        std::cout << "overhead:         "
+                  << (plain > 0 ? (mapped - plain) * 100 / plain : 0) << "%\n";
+        return 0;
+    }
+
+    SourceMapGenerator map("out.js");
+    map.AddSource("STDIN");
+
+    {
+        CodePrinter printer(std::cout, map_file ? &map : nullptr, minify);
+        printer.SetRecordNames(names);
+        printer.Print(ast);
+    }
+
+    if (map_file) {
+        std::ofstream out(map_file);
+        map.Write(out);
+    }
+    return 0;
+}
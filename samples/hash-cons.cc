@@ -0,0 +1,94 @@
+#include "jast/parser-builder.h"
+#include "jast/hash-cons.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// hash-cons ::= parses JavaScript from stdin with and without hash-consing
+// and reports the memory used by each AST
+//
+// The heap is measured with mallinfo2() on glibc, bytes still in use after
+// parsing minus the bytes in use before. Elsewhere only the node statistics
+// of the table are printed.
+using namespace jast;
+
+static size_t HeapInUse()
+{
+#ifdef __GLIBC__
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+struct Result {
+    size_t heap;
+    size_t created;
+    size_t canonical;
+    size_t hits;
+    size_t saved;
+    double ms;
+};
+
+static Result Parse(const std::string &source, bool hash_cons)
+{
+    std::istringstream is(source);
+    size_t before = HeapInUse();
+
+    auto builder = std::make_unique<ParserBuilder>(is, "STDIN");
+    builder->builder()->SetHashConsing(hash_cons);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Handle<Expression> ast = ParseProgram(builder->Build());
+    auto diff = std::chrono::high_resolution_clock::now() - start;
+
+    Result result{ 0, builder->context()->Counters().ASTNode(), 0, 0, 0, 0 };
+    result.ms = std::chrono::duration_cast<std::chrono::microseconds>(diff)
+        .count() / 1e3;
+    if (auto table = builder->builder()->hash_cons()) {
+        result.canonical = table->nodes();
+        result.hits = table->hits();
+        result.saved = table->saved_bytes();
+    }
+
+    // the parser and the table are gone, only the tree is left
+    builder.reset();
+    result.heap = HeapInUse() - before;
+    return result;
+}
+
+int main()
+{
+    std::stringstream ss;
+    ss << std::cin.rdbuf();
+    std::string source = ss.str();
+
+    Result plain, shared;
+    try {
+        plain = Parse(source, false);
+        shared = Parse(source, true);
+    } catch (std::exception &) {
+        std::cout << "\x1b[33mError\x1b[0m" << std::endl;
+        return -1;
+    }
+
+    std::cout << "source bytes     " << source.size() << "\n"
+              << "nodes created    " << plain.created << "\n"
+              << "canonical nodes  " << shared.canonical << "\n"
+              << "shared           " << shared.hits << " ("
+              << 100.0 * shared.hits / plain.created << "% of nodes)\n"
+              << "node bytes saved " << shared.saved << "\n"
+              << "parse ms         " << plain.ms << " -> " << shared.ms << "\n";
+#ifdef __GLIBC__
+    std::cout << "AST heap bytes   " << plain.heap << " -> " << shared.heap
+              << " (" << 100.0 * (1.0 - (double)shared.heap / plain.heap)
+              << "% smaller)\n";
+#endif
+    return 0;
+}
@@ -1,27 +1,114 @@
+#include "jast/allocation-profiler.h"
+#include "jast/dead-code.h"
 #include "jast/parser-builder.h"
+#include "jast/trace.h"
 #include "dump-ast.h"
 
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <sstream>
-int main()
+
+// parse ::= parses JavaScript from stdin and dumps the AST and the statistics
+//
+//      parse [--json | --prometheus] [--trace <file>] [--allocations]
+//            [--optimize]
+//
+// With --json or --prometheus the phases are timed and the statistics are
+// printed in that format after the AST. --trace writes a Chrome trace of the
+// parse and the dump to <file>, open it in chrome://tracing or Perfetto.
+// --allocations profiles the heap allocated for the AST and prints it by
+// node type, container and Parser function, with the bytes the AST retains.
+// --optimize folds constants while parsing and runs the dead code passes
+// before the dump, the statistics tell the nodes each pass removed.
+int main(int argc, char *argv[])
 {
     using namespace jast;
 
-    ParserBuilder builder(std::cin, "STDIN");
+    enum { kText, kJSON, kPrometheus } format = kText;
+    const char *trace = nullptr;
+    bool allocations = false;
+    bool optimize = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--json")) {
+            format = kJSON;
+        } else if (!strcmp(argv[i], "--prometheus")) {
+            format = kPrometheus;
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            trace = argv[++i];
+        } else if (!strcmp(argv[i], "--allocations")) {
+            allocations = true;
+        } else if (!strcmp(argv[i], "--optimize")) {
+            optimize = true;
+        } else {
+            std::cerr << "usage: " << argv[0]
+                << " [--json | --prometheus] [--trace <file>]"
+                   " [--allocations] [--optimize]\n";
+            return -1;
+        }
+    }
+
+    if (trace)
+        Tracer::Start();
+
+    std::istringstream source;
+    ParserBuilder builder(source, "STDIN");
+    Statistics &stats = builder.context()->Counters();
+    stats.SetTimersEnabled(format != kText);
+
+    {
+        PhaseTimer timer(stats, Phase::kRead);
+        std::stringstream ss;
+        ss << std::cin.rdbuf();
+        source.str(ss.str());
+    }
+
     Parser *parser = builder.Build();
+    builder.builder()->SetConstantFolding(optimize);
     Handle<Expression> ast;
+    AllocationProfiler profiler(&stats);
 
     try {
+        if (allocations)
+            profiler.Start();
         ast = ParseProgram(parser);
+        profiler.Stop();
     } catch (std::exception &) {
         std::cout << "\x1b[33mError\x1b[0m" << std::endl;
         return -1;
     }
     std::cout << "Parsed correctly" << std::endl;
 
-    printer::DumpAST p(std::cout, 1);
-    ast->Accept(&p);
+    if (optimize) {
+        PassManager passes(&stats);
+        AddDeadCodePasses(&passes);
+        passes.Run(ast);
+    }
+
+    {
+        PhaseTimer timer(stats, Phase::kVisit);
+        TraceScope scope("DumpAST", "visitor");
+        printer::DumpAST p(std::cout, 1);
+        ast->Accept(&p);
+    }
 
-    builder.context()->Counters().dump();
+    if (trace) {
+        Tracer::Stop();
+        std::ofstream out(trace);
+        Tracer::Write(out);
+    }
+
+    if (format == kJSON)
+        stats.DumpJSON(std::cout);
+    else if (format == kPrometheus)
+        stats.DumpPrometheus(std::cout);
+    else
+        stats.dump();
+
+    if (allocations) {
+        profiler.DumpJSON(std::cout);
+        std::cout << "retained bytes = "
+            << AllocationProfiler::RetainedBytes(ast.GetPtr()) << "\n";
+    }
     return 0;
 }
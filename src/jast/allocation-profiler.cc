@@ -0,0 +1,288 @@
+#include "jast/allocation-profiler.h"
+#include "jast/ast-walker.h"
+#include "jast/statement.h"
+#include "jast/statistics.h"
+
+#include <algorithm>
+#include <ostream>
+#include <unordered_set>
+
+namespace jast {
+
+static_assert((int)ASTNodeType::kNrType <= 64,
+    "AllocationProfiler::kMaxNodeTypes is too small for AST_NODE_LIST");
+
+namespace {
+
+const char *container_names[] = {
+#define CONTAINER_NAME(Container) #Container,
+ALLOCATION_CONTAINER_LIST(CONTAINER_NAME)
+#undef CONTAINER_NAME
+};
+
+const char *kNoSite = "(none)";
+
+std::size_t StringBytes(const std::string &str)
+{
+    return AllocationProfiler::StringBytes(str);
+}
+
+template <typename T>
+std::size_t VectorBytes(const std::vector<T> &vec)
+{
+    return vec.capacity() * sizeof(T);
+}
+
+std::size_t ListBytes(const Handle<ExpressionList> &list)
+{
+    return list ? sizeof(ExpressionList) + VectorBytes(list->raw_list()) : 0;
+}
+
+// what `expr` holds on the heap besides the node itself and its children
+std::size_t OwnedBytes(Expression *expr)
+{
+    switch (expr->type()) {
+    case ASTNodeType::kStringLiteral:
+        return StringBytes(expr->AsStringLiteral()->string());
+    case ASTNodeType::kTemplateLiteral:
+        return StringBytes(expr->AsTemplateLiteral()->template_string());
+    case ASTNodeType::kArrayLiteral: {
+        auto literal = expr->AsArrayLiteral();
+        if (auto packed = literal->packed())
+            return sizeof(PackedArray) + packed->OwnedBytes();
+        return VectorBytes(literal->exprs());
+    }
+    case ASTNodeType::kObjectLiteral: {
+        auto &proxy = expr->AsObjectLiteral()->proxy();
+        std::size_t bytes = proxy.capacity() * sizeof(ProxyObject::value_type)
+            + proxy.IndexBytes() + proxy.KindBytes();
+        for (auto &prop : proxy)
+            bytes += StringBytes(prop.first);
+        return bytes;
+    }
+    case ASTNodeType::kIdentifier:
+        return StringBytes(expr->AsIdentifier()->GetName());
+    case ASTNodeType::kRegExpLiteral:
+        return StringBytes(expr->AsRegExpLiteral()->regex())
+            + VectorBytes(expr->AsRegExpLiteral()->flags());
+    case ASTNodeType::kArgumentList:
+        return ListBytes(expr->AsArgumentList()->args());
+    case ASTNodeType::kCommaExpression:
+        return ListBytes(expr->AsCommaExpression()->exprs());
+    case ASTNodeType::kDeclaration:
+        return StringBytes(expr->AsDeclaration()->name());
+    case ASTNodeType::kDeclarationList:
+        return VectorBytes(expr->AsDeclarationList()->exprs());
+    case ASTNodeType::kBlockStatement:
+        return ListBytes(expr->AsBlockStatement()->statements());
+    case ASTNodeType::kSwitchStatement: {
+        auto clauses = expr->AsSwitchStatement()->clauses();
+        return clauses ? sizeof(ClausesList) + VectorBytes(*clauses->cases())
+                       : 0;
+    }
+    case ASTNodeType::kLabelledStatement:
+        return StringBytes(expr->AsLabelledStatement()->label());
+    case ASTNodeType::kFunctionPrototype: {
+        auto proto = expr->AsFunctionPrototype();
+        std::size_t bytes = StringBytes(proto->GetName())
+            + VectorBytes(proto->GetArgs());
+        for (auto &arg : proto->GetArgs())
+            bytes += StringBytes(arg);
+        return bytes;
+    }
+    default:
+        return 0;
+    }
+}
+
+class RetainedBytesWalker : public ASTWalker {
+public:
+    std::size_t bytes = 0;
+
+protected:
+    bool Enter(Expression *expr) override
+    {
+        if (!seen_.insert(expr).second)
+            return false;
+        bytes += SizeOfNode(expr->type()) + OwnedBytes(expr);
+        return true;
+    }
+
+private:
+    std::unordered_set<Expression*> seen_;
+};
+
+void PrintCount(std::ostream &os, const AllocationProfiler::Count &count)
+{
+    os << "{\"count\": " << count.count << ", \"bytes\": " << count.bytes
+       << "}";
+}
+
+}
+
+thread_local AllocationProfiler *AllocationProfiler::current_ = nullptr;
+
+AllocationProfiler::AllocationProfiler(Statistics *stats)
+    : stats_{ stats }, previous_{ nullptr }, running_{ false },
+      site_{ kNoSite }
+{
+    Clear();
+}
+
+AllocationProfiler::~AllocationProfiler()
+{
+    Stop();
+}
+
+void AllocationProfiler::Start()
+{
+    if (running_)
+        return;
+    previous_ = current_;
+    current_ = this;
+    running_ = true;
+}
+
+void AllocationProfiler::Stop()
+{
+    if (!running_)
+        return;
+    if (current_ == this)
+        current_ = previous_;
+    running_ = false;
+}
+
+void AllocationProfiler::Record(Count &count, std::size_t bytes)
+{
+    count.count++;
+    count.bytes += bytes;
+
+    auto &site = sites_[site_];
+    site.count++;
+    site.bytes += bytes;
+
+    total_.count++;
+    total_.bytes += bytes;
+#ifndef DISABLE_COUNTERS
+    if (stats_)
+        stats_->Allocations()++;
+#endif
+}
+
+void AllocationProfiler::RecordNode(ASTNodeType type, std::size_t bytes)
+{
+    Record(types_[(int)type], bytes);
+}
+
+void AllocationProfiler::RecordContainer(AllocationContainer container,
+    std::size_t bytes)
+{
+    Record(containers_[(int)container], bytes);
+}
+
+AllocationProfiler::Count AllocationProfiler::ByNodeType(ASTNodeType type) const
+{
+    return types_[(int)type];
+}
+
+AllocationProfiler::Count AllocationProfiler::ByContainer(
+    AllocationContainer container) const
+{
+    return containers_[(int)container];
+}
+
+AllocationProfiler::Count AllocationProfiler::BySite(
+    const std::string &site) const
+{
+    Count result{ 0, 0 };
+    for (auto &entry : sites_) {
+        if (site == entry.first) {
+            result.count += entry.second.count;
+            result.bytes += entry.second.bytes;
+        }
+    }
+    return result;
+}
+
+std::vector<std::pair<std::string, AllocationProfiler::Count>>
+AllocationProfiler::Sites() const
+{
+    // sites are keyed by pointer, the same name may come from two places
+    std::unordered_map<std::string, Count> merged;
+    for (auto &entry : sites_) {
+        auto &count = merged[entry.first];
+        count.count += entry.second.count;
+        count.bytes += entry.second.bytes;
+    }
+
+    std::vector<std::pair<std::string, Count>> result(merged.begin(),
+        merged.end());
+    std::sort(result.begin(), result.end(), [](const auto &a, const auto &b) {
+        return a.second.bytes != b.second.bytes
+            ? a.second.bytes > b.second.bytes : a.first < b.first;
+    });
+    return result;
+}
+
+void AllocationProfiler::Clear()
+{
+    total_ = Count{ 0, 0 };
+    std::fill(std::begin(types_), std::end(types_), Count{ 0, 0 });
+    std::fill(std::begin(containers_), std::end(containers_), Count{ 0, 0 });
+    sites_.clear();
+}
+
+void AllocationProfiler::DumpJSON(std::ostream &os) const
+{
+    os << "{\"total\": ";
+    PrintCount(os, total_);
+
+    os << ", \"nodes\": {";
+    const char *sep = "";
+    for (int i = 1; i < (int)ASTNodeType::kNrType; i++) {
+        if (!types_[i].count)
+            continue;
+        os << sep << "\"" << type_as_string[i] << "\": ";
+        PrintCount(os, types_[i]);
+        sep = ", ";
+    }
+
+    os << "}, \"containers\": {";
+    sep = "";
+    for (int i = 0; i < (int)AllocationContainer::kNrContainer; i++) {
+        if (!containers_[i].count)
+            continue;
+        os << sep << "\"" << container_names[i] << "\": ";
+        PrintCount(os, containers_[i]);
+        sep = ", ";
+    }
+
+    os << "}, \"sites\": {";
+    sep = "";
+    for (auto &site : Sites()) {
+        os << sep << "\"" << site.first << "\": ";
+        PrintCount(os, site.second);
+        sep = ", ";
+    }
+    os << "}}\n";
+}
+
+std::size_t AllocationProfiler::StringBytes(const std::string &str)
+{
+    const char *data = str.data();
+    const char *self = reinterpret_cast<const char*>(&str);
+    if (data >= self && data < self + sizeof(str))
+        return 0;
+    return str.capacity() + 1;
+}
+
+std::size_t AllocationProfiler::RetainedBytes(Expression *root)
+{
+    if (!root)
+        return 0;
+    RetainedBytesWalker walker;
+    walker.Walk(root);
+    return walker.bytes;
+}
+
+}
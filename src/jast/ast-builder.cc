@@ -8,6 +8,52 @@ namespace jast {
 #define COUNT()
 #endif
 
+void ASTBuilder::SetHashConsing(bool enable)
+{
+    if (!enable)
+        hash_cons_.reset();
+    else if (!hash_cons_)
+        hash_cons_ = std::make_unique<HashConsTable>();
+}
+
+void ASTBuilder::Reset()
+{
+    exprs_.clear();
+    if (hash_cons_)
+        hash_cons_->Clear();
+}
+
+Handle<Expression> ASTBuilder::intern(Handle<Expression> expr)
+{
+    if (!hash_cons_)
+        return save(expr);
+
+    auto canonical = hash_cons_->Intern(expr);
+    if (canonical == expr)
+        save(expr);
+    else
+        count(expr.GetPtr());
+    return canonical;
+}
+
+Handle<Expression> ASTBuilder::NewConstant(const Constant &value)
+{
+    switch (value.kind()) {
+    case Constant::Kind::kUndefined:
+        return NewUndefinedLiteral();
+    case Constant::Kind::kNull:
+        return NewNullLiteral();
+    case Constant::Kind::kBoolean:
+        return NewBooleanLiteral(value.boolean());
+    case Constant::Kind::kNumber:
+        return NewIntegralLiteral(value.number());
+    case Constant::Kind::kString:
+        return NewStringLiteral(value.string());
+    default:
+        return nullptr;
+    }
+}
+
 Handle<ExpressionList> ASTBuilder::NewExpressionList()
 {
     return (factory()->NewExpressionList());
@@ -16,133 +62,196 @@ Handle<ExpressionList> ASTBuilder::NewExpressionList()
 Handle<Expression> ASTBuilder::NewNullLiteral()
 {
     COUNT();
-    return save(factory()->NewNullLiteral(locator()->loc(), manager()->current()));
+    return intern(factory()->NewNullLiteral(locator()->loc(), manager()->current()));
 }
 
 Handle<Expression> ASTBuilder::NewUndefinedLiteral()
 {
     COUNT();
-    return save(factory()->NewUndefinedLiteral(locator()->loc(), manager()->current()));
+    return intern(factory()->NewUndefinedLiteral(locator()->loc(), manager()->current()));
 }
 
 Handle<Expression> ASTBuilder::NewThisHolder()
 {
     COUNT();
-    return save(factory()->NewThisHolder(locator()->loc(), manager()->current()));
+    return intern(factory()->NewThisHolder(locator()->loc(), manager()->current()));
 }
 
 Handle<Expression> ASTBuilder::NewIntegralLiteral(double value)
 {
     COUNT();
-    return save(factory()->NewIntegralLiteral(locator()->loc(), manager()->current(), value));
+    return intern(factory()->NewIntegralLiteral(locator()->loc(), manager()->current(), value));
 }
 
-Handle<Expression> ASTBuilder::NewStringLiteral(const std::string &str)
+Handle<Expression> ASTBuilder::NewStringLiteral(std::string str)
 {
     COUNT();
-    return save(factory()->NewStringLiteral(locator()->loc(), manager()->current(), str));
+    return intern(factory()->NewStringLiteral(locator()->loc(), manager()->current(), std::move(str)));
 }
 
 Handle<Expression> ASTBuilder::NewRegExpLiteral(const std::string &str, const std::vector<RegExpFlags> &flags)
 {
     COUNT();
-    return save(factory()->NewRegExpLiteral(locator()->loc(), manager()->current(), str, flags));
+    return intern(factory()->NewRegExpLiteral(locator()->loc(), manager()->current(), str, flags));
 }
 
-Handle<Expression> ASTBuilder::NewTemplateLiteral(const std::string &str)
+Handle<Expression> ASTBuilder::NewTemplateLiteral(std::string str)
 {
     COUNT();
-    return save(factory()->NewTemplateLiteral(locator()->loc(), manager()->current(), str));
+    return intern(factory()->NewTemplateLiteral(locator()->loc(), manager()->current(), std::move(str)));
 }
 
 Handle<Expression> ASTBuilder::NewArrayLiteral(ProxyArray arr)
 {
     COUNT();
-    return save(factory()->NewArrayLiteral(locator()->loc(), manager()->current(), std::move(arr)));
+    return intern(factory()->NewArrayLiteral(locator()->loc(), manager()->current(), std::move(arr)));
+}
+
+Handle<Expression> ASTBuilder::NewPackedArrayLiteral(PackedArray arr)
+{
+    COUNT();
+    return intern(factory()->NewPackedArrayLiteral(locator()->loc(), manager()->current(), std::move(arr)));
+}
+
+Handle<Expression> ASTBuilder::NewElementLiteral(const PackedArray &arr,
+    size_t i, Scope *scope)
+{
+    COUNT();
+    Position loc = arr.position(i);
+    if (arr.kind() == PackedArray::Kind::kNumber)
+        return intern(factory()->NewIntegralLiteral(loc, scope, arr.number(i)));
+    return intern(factory()->NewStringLiteral(loc, scope, arr.string(i)));
+}
+
+void ASTBuilder::UnpackArrayLiteral(ArrayLiteral *array)
+{
+    auto packed = array->packed();
+    if (!packed)
+        return;
+
+    ProxyArray exprs;
+    exprs.reserve(packed->size());
+    AllocationProfiler::OnContainer(AllocationContainer::kProxyArray,
+        exprs.capacity() * sizeof(Handle<Expression>));
+    for (size_t i = 0; i < packed->size(); i++)
+        exprs.push_back(NewElementLiteral(*packed, i, array->GetScope()));
+    array->Unpack(std::move(exprs));
 }
 
 Handle<Expression> ASTBuilder::NewObjectLiteral(ProxyObject obj)
 {
     COUNT();
-    return save(factory()->NewObjectLiteral(locator()->loc(), manager()->current(), std::move(obj)));
+    return intern(factory()->NewObjectLiteral(locator()->loc(), manager()->current(), std::move(obj)));
 }
 
 Handle<Expression> ASTBuilder::NewIdentifier(std::string name)
 {
     COUNT();
-    return save(factory()->NewIdentifier(locator()->loc(), manager()->current(), name));
+    return intern(factory()->NewIdentifier(locator()->loc(), manager()->current(), name));
 }
 
 Handle<Expression> ASTBuilder::NewBooleanLiteral(bool value)
 {
     COUNT();
-    return save(factory()->NewBooleanLiteral(locator()->loc(), manager()->current(), value));
+    return intern(factory()->NewBooleanLiteral(locator()->loc(), manager()->current(), value));
 }
 
 Handle<Expression> ASTBuilder::NewArgumentList(Handle<ExpressionList> args)
 {
     COUNT();
-    return save(factory()->NewArgumentList(locator()->loc(), manager()->current(), args));
+    return intern(factory()->NewArgumentList(locator()->loc(), manager()->current(), args));
 }
 
 Handle<Expression> ASTBuilder::NewCallExpression(MemberAccessKind kind,
     Handle<Expression> func, Handle<Expression> args)
 {
     COUNT();
-    return save(factory()->NewCallExpression(locator()->loc(), manager()->current(), kind, func, args));
+    return intern(factory()->NewCallExpression(locator()->loc(), manager()->current(), kind, func, args));
 }
 
 Handle<Expression> ASTBuilder::NewMemberExpression(MemberAccessKind kind,
     Handle<Expression> func, Handle<Expression> args)
 {
     COUNT();
-    return save(factory()->NewMemberExpression(locator()->loc(), manager()->current(), kind, func, args));
+    return intern(factory()->NewMemberExpression(locator()->loc(), manager()->current(), kind, func, args));
 }
 
 Handle<Expression> ASTBuilder::NewNewExpression(Handle<Expression> expr)
 {
     COUNT();
-    return save(factory()->NewNewExpression(locator()->loc(), manager()->current(), expr));
+    return intern(factory()->NewNewExpression(locator()->loc(), manager()->current(), expr));
 }
 
 Handle<Expression> ASTBuilder::NewPrefixExpression(PrefixOperation op,
     Handle<Expression> expr)
 {
+    if (folding_) {
+        auto value = ConstantFolder::Prefix(op,
+            ConstantFolder::Evaluate(expr.GetPtr()));
+        if (value)
+            return NewConstant(value);
+    }
+
     COUNT();
-    return save(factory()->NewPrefixExpression(locator()->loc(), manager()->current(), op, expr));
+    return intern(factory()->NewPrefixExpression(locator()->loc(), manager()->current(), op, expr));
 }
 
 Handle<Expression> ASTBuilder::NewPostfixExpression(PostfixOperation op,
     Handle<Expression> expr)
 {
     COUNT();
-    return save(factory()->NewPostfixExpression(locator()->loc(), manager()->current(), op, expr));
+    return intern(factory()->NewPostfixExpression(locator()->loc(), manager()->current(), op, expr));
 }
 
 Handle<Expression> ASTBuilder::NewBinaryExpression(BinaryOperation op,
     Handle<Expression> lhs, Handle<Expression> rhs)
 {
+    if (folding_) {
+        auto left = ConstantFolder::Evaluate(lhs.GetPtr());
+        bool truthy;
+        if ((op == BinaryOperation::kAnd || op == BinaryOperation::kOr)
+            && ConstantFolder::ToBoolean(left, &truthy)) {
+            // the value of the operand which decides, unless it is a
+            // reference, which the operator turns into a value
+            auto &operand = truthy == (op == BinaryOperation::kAnd) ? rhs : lhs;
+            if (!ConstantFolder::IsReference(operand.GetPtr()))
+                return operand;
+        }
+
+        auto value = ConstantFolder::Binary(op, left,
+            ConstantFolder::Evaluate(rhs.GetPtr()));
+        if (value)
+            return NewConstant(value);
+    }
+
     COUNT();
-    return save(factory()->NewBinaryExpression(locator()->loc(), manager()->current(), op, lhs, rhs));
+    return intern(factory()->NewBinaryExpression(locator()->loc(), manager()->current(), op, lhs, rhs));
 }
 
-Handle<Expression> ASTBuilder::NewAssignExpression(Handle<Expression> lhs, Handle<Expression> rhs)
+Handle<Expression> ASTBuilder::NewAssignExpression(AssignOperation op,
+    Handle<Expression> lhs, Handle<Expression> rhs)
 {
     COUNT();
-    return save(factory()->NewAssignExpression(locator()->loc(), manager()->current(), lhs, rhs));
+    return intern(factory()->NewAssignExpression(locator()->loc(), manager()->current(), op, lhs, rhs));
 }
 
 Handle<Expression> ASTBuilder::NewTernaryExpression(Handle<Expression> first,
     Handle<Expression> second, Handle<Expression> third)
 {
+    bool truthy;
+    if (folding_ && ConstantFolder::ToBoolean(
+            ConstantFolder::Evaluate(first.GetPtr()), &truthy)
+            && !ConstantFolder::IsReference((truthy ? second : third).GetPtr()))
+        return truthy ? second : third;
+
     COUNT();
-    return save(factory()->NewTernaryExpression(locator()->loc(), manager()->current(), first, second, third));
+    return intern(factory()->NewTernaryExpression(locator()->loc(), manager()->current(), first, second, third));
 }
 
 Handle<Expression> ASTBuilder::NewCommaExpression(Handle<ExpressionList> list)
 {
     COUNT();
-    return save(factory()->NewCommaExpression(locator()->loc(), manager()->current(), list));
+    return intern(factory()->NewCommaExpression(locator()->loc(), manager()->current(), list));
 }
 
 Handle<Expression> ASTBuilder::NewBlockStatement(Handle<ExpressionList> stmts)
@@ -0,0 +1,327 @@
+#include "jast/ast-cloner.h"
+#include "jast/ast-children.h"
+#include "jast/trace.h"
+
+#include <cassert>
+
+namespace jast {
+
+// the children of a node, null ones included, in the order of its slots
+struct ASTCloner::Collector {
+    std::vector<Expression*> *children;
+
+    template <typename T>
+    void Slot(Handle<T> &slot)
+    {
+        children->push_back(static_cast<Expression*>(slot.GetPtr()));
+    }
+
+    template <typename T>
+    void List(std::vector<Handle<T>> &list)
+    {
+        for (auto &slot : list)
+            Slot(slot);
+    }
+};
+
+// stores the copies of the children in the slots of a shell, in the order
+// they were collected. a copy has the type of the node it was made from, so
+// it fits the slot of that node
+struct ASTCloner::Filler {
+    Handle<Expression> *next;
+
+    template <typename T>
+    void Slot(Handle<T> &slot)
+    {
+        slot = Handle<T>(static_cast<T*>((next++)->GetPtr()));
+    }
+
+    template <typename T>
+    void List(std::vector<Handle<T>> &list)
+    {
+        for (auto &slot : list)
+            Slot(slot);
+    }
+};
+
+Handle<Expression> ASTCloner::Clone(Expression *root)
+{
+    if (!root)
+        return nullptr;
+
+    if (Tracer::enabled()) {
+        TraceScope trace("ASTCloner::Clone", "visitor");
+        Run(root);
+    } else {
+        Run(root);
+    }
+
+    Handle<Expression> result = results_.back();
+    results_.clear();
+    copies_.clear();
+    return result;
+}
+
+Handle<Expression> ASTCloner::Clone(NodeRef node)
+{
+    if (!node)
+        return nullptr;
+    // only read, see above
+    return Clone(const_cast<Expression*>(node.get()));
+}
+
+void ASTCloner::Run(Expression *root)
+{
+    stack_.push_back(Frame{ root, 0, false });
+
+    while (!stack_.empty()) {
+        Frame frame = stack_.back();
+        stack_.pop_back();
+
+        if (frame.leave) {
+            VisitSlots(results_[frame.results].GetPtr(),
+                Filler{ results_.data() + frame.results + 1 });
+            results_.resize(frame.results + 1);
+            continue;
+        }
+
+        if (!frame.node) {
+            results_.push_back(nullptr);
+            continue;
+        }
+
+        // the other places of a node are all entered after the first one
+        // was left
+        bool shared = frame.node->GetNumReferences() > 1;
+        if (shared) {
+            auto copy = copies_.find(frame.node);
+            if (copy != copies_.end()) {
+                results_.push_back(copy->second);
+                continue;
+            }
+        }
+
+        // made before the copies of the children, so that a factory which
+        // allocates one node after the other lays the copy out in preorder
+        size_t self = results_.size();
+        results_.push_back(Shell(frame.node));
+        if (shared)
+            copies_.emplace(frame.node, results_.back().GetPtr());
+
+        size_t first = children_.size();
+        VisitSlots(frame.node, Collector{ &children_ });
+        if (children_.size() == first)
+            continue;
+
+        // pushed in reverse, so that the first child is copied first
+        stack_.push_back(Frame{ frame.node, self, true });
+        for (size_t i = children_.size(); i > first; i--)
+            stack_.push_back(Frame{ children_[i - 1], 0, false });
+        children_.resize(first);
+    }
+}
+
+Handle<ExpressionList> ASTCloner::ShellList(ExpressionList *list)
+{
+    if (!list)
+        return nullptr;
+
+    Handle<ExpressionList> shell = factory_->NewExpressionList();
+    shell->Reserve(list->Size());
+    for (size_t i = 0; i < list->Size(); i++)
+        shell->Insert(nullptr);
+    return shell;
+}
+
+Handle<Expression> ASTCloner::Shell(Expression *node)
+{
+    Position loc = node->loc();
+    Scope *scope = node->GetScope();
+    Handle<Expression> shell;
+
+    switch (node->type()) {
+    case ASTNodeType::kNullLiteral:
+        shell = factory_->NewNullLiteral(loc, scope);
+        break;
+    case ASTNodeType::kUndefinedLiteral:
+        shell = factory_->NewUndefinedLiteral(loc, scope);
+        break;
+    case ASTNodeType::kThisHolder:
+        shell = factory_->NewThisHolder(loc, scope);
+        break;
+    case ASTNodeType::kIntegralLiteral:
+        shell = factory_->NewIntegralLiteral(loc, scope,
+            static_cast<IntegralLiteral*>(node)->value());
+        break;
+    case ASTNodeType::kStringLiteral:
+        shell = factory_->NewStringLiteral(loc, scope,
+            static_cast<StringLiteral*>(node)->string());
+        break;
+    case ASTNodeType::kTemplateLiteral:
+        shell = factory_->NewTemplateLiteral(loc, scope,
+            static_cast<TemplateLiteral*>(node)->template_string());
+        break;
+    case ASTNodeType::kArrayLiteral: {
+        auto literal = static_cast<ArrayLiteral*>(node);
+        if (auto packed = literal->packed()) {
+            shell = factory_->NewPackedArrayLiteral(loc, scope, *packed);
+            break;
+        }
+        shell = factory_->NewArrayLiteral(loc, scope,
+            ProxyArray(literal->exprs().size()));
+        break;
+    }
+    case ASTNodeType::kObjectLiteral: {
+        auto &proxy = static_cast<ObjectLiteral*>(node)->proxy();
+        ProxyObject props;
+        props.Reserve(proxy.size());
+        for (size_t i = 0; i < proxy.size(); i++)
+            props.Append(proxy[i].first, nullptr, proxy.kind(i));
+        shell = factory_->NewObjectLiteral(loc, scope, std::move(props));
+        break;
+    }
+    case ASTNodeType::kIdentifier: {
+        auto identifier = static_cast<Identifier*>(node);
+        shell = factory_->NewIdentifier(loc, scope, identifier->GetName());
+        static_cast<Identifier*>(shell.GetPtr())
+            ->SetBinding(identifier->binding());
+        break;
+    }
+    case ASTNodeType::kBooleanLiteral:
+        shell = factory_->NewBooleanLiteral(loc, scope,
+            static_cast<BooleanLiteral*>(node)->pred());
+        break;
+    case ASTNodeType::kRegExpLiteral: {
+        auto regex = static_cast<RegExpLiteral*>(node);
+        shell = factory_->NewRegExpLiteral(loc, scope, regex->regex(),
+            regex->flags());
+        break;
+    }
+    case ASTNodeType::kArgumentList:
+        shell = factory_->NewArgumentList(loc, scope,
+            ShellList(static_cast<ArgumentList*>(node)->args_.GetPtr()));
+        break;
+    case ASTNodeType::kCallExpression:
+        shell = factory_->NewCallExpression(loc, scope,
+            static_cast<CallExpression*>(node)->kind(), nullptr, nullptr);
+        break;
+    case ASTNodeType::kMemberExpression:
+        shell = factory_->NewMemberExpression(loc, scope,
+            static_cast<MemberExpression*>(node)->kind(), nullptr, nullptr);
+        break;
+    case ASTNodeType::kNewExpression:
+        shell = factory_->NewNewExpression(loc, scope, nullptr);
+        break;
+    case ASTNodeType::kPrefixExpression:
+        shell = factory_->NewPrefixExpression(loc, scope,
+            static_cast<PrefixExpression*>(node)->op(), nullptr);
+        break;
+    case ASTNodeType::kPostfixExpression:
+        shell = factory_->NewPostfixExpression(loc, scope,
+            static_cast<PostfixExpression*>(node)->op(), nullptr);
+        break;
+    case ASTNodeType::kBinaryExpression:
+        shell = factory_->NewBinaryExpression(loc, scope,
+            static_cast<BinaryExpression*>(node)->op(), nullptr, nullptr);
+        break;
+    case ASTNodeType::kAssignExpression:
+        shell = factory_->NewAssignExpression(loc, scope,
+            static_cast<AssignExpression*>(node)->op(), nullptr, nullptr);
+        break;
+    case ASTNodeType::kTernaryExpression:
+        shell = factory_->NewTernaryExpression(loc, scope, nullptr, nullptr,
+            nullptr);
+        break;
+    case ASTNodeType::kCommaExpression:
+        shell = factory_->NewCommaExpression(loc, scope,
+            ShellList(static_cast<CommaExpression*>(node)->exprs_.GetPtr()));
+        break;
+    case ASTNodeType::kDeclaration: {
+        auto decl = static_cast<Declaration*>(node);
+        auto copy = factory_->NewDeclaration(loc, scope, decl->name());
+        copy->SetBinding(decl->binding());
+        shell = Handle<Expression>(copy.GetPtr());
+        break;
+    }
+    case ASTNodeType::kDeclarationList:
+        shell = factory_->NewDeclarationList(loc, scope,
+            std::vector<Handle<Declaration>>(
+                static_cast<DeclarationList*>(node)->exprs().size()));
+        break;
+    case ASTNodeType::kIfStatement:
+        shell = factory_->NewIfStatement(loc, scope, nullptr, nullptr);
+        break;
+    case ASTNodeType::kIfElseStatement:
+        shell = factory_->NewIfElseStatement(loc, scope, nullptr, nullptr,
+            nullptr);
+        break;
+    case ASTNodeType::kForStatement:
+        shell = factory_->NewForStatement(loc, scope,
+            static_cast<ForStatement*>(node)->kind(), nullptr, nullptr,
+            nullptr, nullptr);
+        break;
+    case ASTNodeType::kWhileStatement:
+        shell = factory_->NewWhileStatement(loc, scope, nullptr, nullptr);
+        break;
+    case ASTNodeType::kLabelledStatement:
+        shell = factory_->NewLabelledStatement(loc, scope,
+            static_cast<LabelledStatement*>(node)->label(), nullptr);
+        break;
+    case ASTNodeType::kBreakStatement:
+        shell = factory_->NewBreakStatement(loc, scope);
+        break;
+    case ASTNodeType::kContinueStatement:
+        shell = factory_->NewContinueStatement(loc, scope);
+        break;
+    case ASTNodeType::kSwitchStatement: {
+        auto clauses = static_cast<SwitchStatement*>(node)->clauses_.GetPtr();
+        Handle<ClausesList> list;
+        if (clauses) {
+            list = factory_->NewClausesList();
+            for (size_t i = 0; i < clauses->Size(); i++)
+                list->PushCase(nullptr);
+        }
+        shell = factory_->NewSwitchStatement(loc, scope, nullptr, list);
+        break;
+    }
+    case ASTNodeType::kCaseClauseStatement:
+        shell = factory_->NewCaseClauseStatement(loc, scope, nullptr, nullptr);
+        break;
+    case ASTNodeType::kTryCatchStatement:
+        shell = factory_->NewTryCatchStatement(loc, scope, nullptr, nullptr,
+            nullptr, nullptr);
+        break;
+    case ASTNodeType::kThrowStatement:
+        shell = factory_->NewThrowStatement(loc, scope, nullptr);
+        break;
+    case ASTNodeType::kDoWhileStatement:
+        shell = factory_->NewDoWhileStatement(loc, scope, nullptr, nullptr);
+        break;
+    case ASTNodeType::kBlockStatement:
+        shell = factory_->NewBlockStatement(loc, scope,
+            ShellList(static_cast<BlockStatement*>(node)->stmts_.GetPtr()));
+        break;
+    case ASTNodeType::kFunctionPrototype: {
+        auto proto = static_cast<FunctionPrototype*>(node);
+        shell = factory_->NewFunctionPrototype(loc, scope, proto->GetName(),
+            proto->GetArgs());
+        static_cast<FunctionPrototype*>(shell.GetPtr())
+            ->SetBinding(proto->binding());
+        break;
+    }
+    case ASTNodeType::kFunctionStatement:
+        shell = factory_->NewFunctionStatement(loc, scope, nullptr, nullptr);
+        break;
+    case ASTNodeType::kReturnStatement:
+        shell = factory_->NewReturnStatement(loc, scope, nullptr);
+        break;
+    default:
+        assert(0 && "unknown node type");
+        return nullptr;
+    }
+
+    shell->SetHash(node->hash());
+    return shell;
+}
+
+}
@@ -0,0 +1,395 @@
+#include "jast/ast-hash.h"
+#include "jast/ast-walker.h"
+#include "jast/expression.h"
+#include "jast/statement.h"
+#include "jast/utils.h"
+
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+namespace jast {
+
+namespace {
+
+// low bit of a stored hash tells the sensitivity it was computed with
+const uint64_t kValuesTag = 1;
+
+// hash of a missing child
+const uint64_t kNullHash = 0x6a09e667f3bcc908ULL;
+
+inline uint64_t HashString(const std::string &str)
+{
+    return std::hash<std::string>()(str);
+}
+
+inline uint64_t HashNumber(double value)
+{
+    // 0 and -0 are equal for the matcher, so they must hash equal too
+    if (value == 0)
+        value = 0;
+
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// children are hashed before their parent by the walk, so HashNode() only
+// reads the cached hashes of the children and never recurses
+class Hasher : public ASTWalker {
+public:
+    Hasher(bool values)
+        : values_{ values }
+    { }
+
+    uint64_t Hash(Expression *expr);
+
+protected:
+    bool Enter(Expression *expr) override { return !Cached(expr); }
+    void Leave(Expression *expr) override;
+
+private:
+    uint64_t Hash(const Handle<Expression> &expr) { return Hash(expr.GetPtr()); }
+    bool Cached(Expression *expr) const
+    {
+        uint64_t hash = expr->hash();
+        return hash && (hash & kValuesTag) == (values_ ? kValuesTag : 0);
+    }
+    uint64_t HashList(uint64_t seed, ExpressionList *list);
+    uint64_t HashNode(Expression *expr);
+    // the hash the literal node of the element `i` would have
+    uint64_t HashElement(const PackedArray &packed, size_t i);
+
+    // the hash stored in a node, tagged with the sensitivity
+    uint64_t Finish(uint64_t hash)
+    {
+        hash = (hash & ~kValuesTag) | (values_ ? kValuesTag : 0);
+        // 0 means not computed
+        return hash ? hash : 2;
+    }
+
+    // values only count with kTypesAndValues
+    uint64_t Value(uint64_t seed, uint64_t value)
+    {
+        return values_ ? HashCombine(seed, value) : seed;
+    }
+
+    bool values_;
+};
+
+uint64_t Hasher::Hash(Expression *expr)
+{
+    if (!expr)
+        return kNullHash;
+
+    if (!Cached(expr))
+        Walk(expr);
+    return expr->hash();
+}
+
+void Hasher::Leave(Expression *expr)
+{
+    expr->SetHash(Finish(HashNode(expr)));
+}
+
+uint64_t Hasher::HashElement(const PackedArray &packed, size_t i)
+{
+    if (packed.kind() == PackedArray::Kind::kNumber) {
+        uint64_t h = HashMix((uint64_t)ASTNodeType::kIntegralLiteral + 1);
+        return Finish(Value(h, HashNumber(packed.number(i))));
+    }
+    uint64_t h = HashMix((uint64_t)ASTNodeType::kStringLiteral + 1);
+    return Finish(Value(h, HashString(packed.string(i))));
+}
+
+uint64_t Hasher::HashList(uint64_t seed, ExpressionList *list)
+{
+    if (!list)
+        return HashCombine(seed, kNullHash);
+
+    seed = HashCombine(seed, list->Size());
+    for (auto &expr : *list)
+        seed = HashCombine(seed, Hash(expr));
+    return seed;
+}
+
+uint64_t Hasher::HashNode(Expression *expr)
+{
+    uint64_t h = HashMix((uint64_t)expr->type() + 1);
+
+    switch (expr->type()) {
+    case ASTNodeType::kNullLiteral:
+    case ASTNodeType::kUndefinedLiteral:
+    case ASTNodeType::kThisHolder:
+        return h;
+
+    case ASTNodeType::kIntegralLiteral:
+        return Value(h, HashNumber(expr->AsIntegralLiteral()->value()));
+
+    case ASTNodeType::kStringLiteral:
+        return Value(h, HashString(expr->AsStringLiteral()->string()));
+
+    case ASTNodeType::kTemplateLiteral:
+        return Value(h,
+            HashString(expr->AsTemplateLiteral()->template_string()));
+
+    case ASTNodeType::kArrayLiteral: {
+        auto literal = expr->AsArrayLiteral();
+        h = HashCombine(h, literal->length());
+        // a packed array hashes like the same array unpacked
+        if (auto packed = literal->packed()) {
+            for (size_t i = 0; i < packed->size(); i++)
+                h = HashCombine(h, HashElement(*packed, i));
+            return h;
+        }
+        for (auto &e : literal->exprs())
+            h = HashCombine(h, Hash(e));
+        return h;
+    }
+
+    case ASTNodeType::kObjectLiteral: {
+        auto &props = expr->AsObjectLiteral()->proxy();
+        h = HashCombine(h, props.size());
+        for (size_t i = 0; i < props.size(); i++) {
+            h = Value(h, HashString(props[i].first));
+            h = HashCombine(h, (uint64_t)props.kind(i));
+            h = HashCombine(h, Hash(props[i].second));
+        }
+        return h;
+    }
+
+    case ASTNodeType::kIdentifier:
+        return Value(h, HashString(expr->AsIdentifier()->GetName()));
+
+    case ASTNodeType::kBooleanLiteral:
+        return Value(h, expr->AsBooleanLiteral()->pred());
+
+    case ASTNodeType::kRegExpLiteral: {
+        auto regex = expr->AsRegExpLiteral();
+        h = Value(h, HashString(regex->regex()));
+        for (auto flag : regex->flags())
+            h = Value(h, (uint64_t)flag);
+        return h;
+    }
+
+    case ASTNodeType::kArgumentList:
+        return HashList(h, expr->AsArgumentList()->args().GetPtr());
+
+    case ASTNodeType::kCallExpression: {
+        auto call = expr->AsCallExpression();
+        h = HashCombine(h, (uint64_t)call->kind());
+        h = HashCombine(h, Hash(call->expr()));
+        return HashCombine(h, Hash(call->member()));
+    }
+
+    case ASTNodeType::kMemberExpression: {
+        auto member = expr->AsMemberExpression();
+        h = HashCombine(h, (uint64_t)member->kind());
+        h = HashCombine(h, Hash(member->expr()));
+        return HashCombine(h, Hash(member->member()));
+    }
+
+    case ASTNodeType::kNewExpression:
+        return HashCombine(h, Hash(expr->AsNewExpression()->member()));
+
+    case ASTNodeType::kPrefixExpression: {
+        auto prefix = expr->AsPrefixExpression();
+        h = HashCombine(h, (uint64_t)prefix->op());
+        return HashCombine(h, Hash(prefix->expr()));
+    }
+
+    case ASTNodeType::kPostfixExpression: {
+        auto postfix = expr->AsPostfixExpression();
+        h = HashCombine(h, (uint64_t)postfix->op());
+        return HashCombine(h, Hash(postfix->expr()));
+    }
+
+    case ASTNodeType::kBinaryExpression: {
+        auto binary = expr->AsBinaryExpression();
+        h = HashCombine(h, (uint64_t)binary->op());
+        h = HashCombine(h, Hash(binary->lhs()));
+        return HashCombine(h, Hash(binary->rhs()));
+    }
+
+    case ASTNodeType::kAssignExpression: {
+        auto assign = expr->AsAssignExpression();
+        h = HashCombine(h, (uint64_t)assign->op());
+        h = HashCombine(h, Hash(assign->lhs()));
+        return HashCombine(h, Hash(assign->rhs()));
+    }
+
+    case ASTNodeType::kTernaryExpression: {
+        auto ternary = expr->AsTernaryExpression();
+        h = HashCombine(h, Hash(ternary->first()));
+        h = HashCombine(h, Hash(ternary->second()));
+        return HashCombine(h, Hash(ternary->third()));
+    }
+
+    case ASTNodeType::kCommaExpression:
+        return HashList(h, expr->AsCommaExpression()->exprs().GetPtr());
+
+    case ASTNodeType::kDeclaration: {
+        auto decl = expr->AsDeclaration();
+        h = Value(h, HashString(decl->name()));
+        return HashCombine(h, Hash(decl->expr()));
+    }
+
+    case ASTNodeType::kDeclarationList: {
+        auto &exprs = expr->AsDeclarationList()->exprs();
+        h = HashCombine(h, exprs.size());
+        for (auto &decl : exprs)
+            h = HashCombine(h, Hash(decl.GetPtr()));
+        return h;
+    }
+
+    case ASTNodeType::kIfStatement: {
+        auto stmt = expr->AsIfStatement();
+        h = HashCombine(h, Hash(stmt->condition()));
+        return HashCombine(h, Hash(stmt->body()));
+    }
+
+    case ASTNodeType::kIfElseStatement: {
+        auto stmt = expr->AsIfElseStatement();
+        h = HashCombine(h, Hash(stmt->condition()));
+        h = HashCombine(h, Hash(stmt->body()));
+        return HashCombine(h, Hash(stmt->els()));
+    }
+
+    case ASTNodeType::kForStatement: {
+        auto stmt = expr->AsForStatement();
+        h = HashCombine(h, (uint64_t)stmt->kind());
+        h = HashCombine(h, Hash(stmt->init()));
+        h = HashCombine(h, Hash(stmt->condition()));
+        h = HashCombine(h, Hash(stmt->update()));
+        return HashCombine(h, Hash(stmt->body()));
+    }
+
+    case ASTNodeType::kWhileStatement: {
+        auto stmt = expr->AsWhileStatement();
+        h = HashCombine(h, Hash(stmt->condition()));
+        return HashCombine(h, Hash(stmt->body()));
+    }
+
+    case ASTNodeType::kDoWhileStatement: {
+        auto stmt = expr->AsDoWhileStatement();
+        h = HashCombine(h, Hash(stmt->condition()));
+        return HashCombine(h, Hash(stmt->body()));
+    }
+
+    case ASTNodeType::kLabelledStatement: {
+        auto stmt = expr->AsLabelledStatement();
+        h = Value(h, HashString(stmt->label()));
+        return HashCombine(h, Hash(stmt->expr()));
+    }
+
+    case ASTNodeType::kBreakStatement:
+        return HashCombine(h, Hash(expr->AsBreakStatement()->label()));
+
+    case ASTNodeType::kContinueStatement:
+        return HashCombine(h, Hash(expr->AsContinueStatement()->label()));
+
+    case ASTNodeType::kSwitchStatement: {
+        auto stmt = expr->AsSwitchStatement();
+        auto clauses = stmt->clauses();
+        h = HashCombine(h, Hash(stmt->expr()));
+        h = HashCombine(h, clauses->Size());
+        for (auto &clause : *clauses)
+            h = HashCombine(h, Hash(clause.GetPtr()));
+        return HashCombine(h, Hash(clauses->def()));
+    }
+
+    case ASTNodeType::kCaseClauseStatement: {
+        auto stmt = expr->AsCaseClauseStatement();
+        h = HashCombine(h, Hash(stmt->clause()));
+        return HashCombine(h, Hash(stmt->stmt()));
+    }
+
+    case ASTNodeType::kTryCatchStatement: {
+        auto stmt = expr->AsTryCatchStatement();
+        h = HashCombine(h, Hash(stmt->try_block()));
+        h = HashCombine(h, Hash(stmt->catch_expr()));
+        h = HashCombine(h, Hash(stmt->catch_block()));
+        return HashCombine(h, Hash(stmt->finally()));
+    }
+
+    case ASTNodeType::kThrowStatement:
+        return HashCombine(h, Hash(expr->AsThrowStatement()->expr()));
+
+    case ASTNodeType::kBlockStatement:
+        return HashList(h, expr->AsBlockStatement()->statements().GetPtr());
+
+    case ASTNodeType::kFunctionPrototype: {
+        auto proto = expr->AsFunctionPrototype();
+        auto &args = proto->GetArgs();
+        h = Value(h, HashString(proto->GetName()));
+        h = HashCombine(h, args.size());
+        for (auto &arg : args)
+            h = Value(h, HashString(arg));
+        return h;
+    }
+
+    case ASTNodeType::kFunctionStatement: {
+        auto stmt = expr->AsFunctionStatement();
+        h = HashCombine(h, Hash(stmt->proto().GetPtr()));
+        return HashCombine(h, Hash(stmt->body()));
+    }
+
+    case ASTNodeType::kReturnStatement:
+        return HashCombine(h, Hash(expr->AsReturnStatement()->expr()));
+
+    default:
+        throw std::runtime_error("fatal: unknown type");
+    }
+}
+
+// resets the hashes of a whole subtree. every node is visited, a node
+// without a hash can still have hashed children when it was added to the
+// tree after hashing
+class Clearer : public ASTWalker {
+protected:
+    bool Enter(Expression *expr) override
+    {
+        expr->SetHash(0);
+        return true;
+    }
+};
+
+}
+
+uint64_t StructuralHasher::Hash(Handle<Expression> root,
+    HashSensitivity sensitivity)
+{
+    Hasher hasher(sensitivity == HashSensitivity::kTypesAndValues);
+    return hasher.Hash(root.GetPtr());
+}
+
+void StructuralHasher::Clear(Handle<Expression> root)
+{
+    Clearer clearer;
+    clearer.Walk(root);
+}
+
+uint64_t StructuralHasher::Get(Expression *expr, HashSensitivity sensitivity)
+{
+    uint64_t hash = expr ? expr->hash() : 0;
+    uint64_t tag = sensitivity == HashSensitivity::kTypesAndValues
+        ? kValuesTag : 0;
+    return hash && (hash & kValuesTag) == tag ? hash : 0;
+}
+
+bool StructuralHasher::Differ(Expression *a, Expression *b, bool values)
+{
+    uint64_t ha = a->hash(), hb = b->hash();
+    if (!ha || !hb || ha == hb)
+        return false;
+
+    // hashes of different sensitivity can't be compared
+    if ((ha & kValuesTag) != (hb & kValuesTag))
+        return false;
+
+    // different types only hashes mean different types, which no matcher
+    // accepts. different value hashes only matter when values are compared
+    return !(ha & kValuesTag) || values;
+}
+
+}
@@ -1,25 +1,75 @@
 #include "jast/ast-match.h"
+#include "jast/ast-hash.h"
 #include "jast/expression.h"
 #include "jast/statement.h"
 
 namespace jast {
 
-bool MatchExpressionList(Handle<ExpressionList> a, Handle<ExpressionList> b)
+// all matchers share the same code, `values` tells whether names and
+// literal values are compared besides the types
+static bool Match(Handle<Expression> a, Handle<Expression> b, bool values);
+
+static bool MatchExpressionList(Handle<ExpressionList> a,
+    Handle<ExpressionList> b, bool values)
 {
+    if (!a || !b)
+        return !a && !b;
+
     auto ait = a->begin();
     auto bit = b->begin();
 
     if (a->Size() != b->Size())
         return false;
     for (size_t i = 0; i < a->Size(); i++)
-        if (!FastASTMatcher::match(*(ait + i), *(bit + i)))
+        if (!Match(*(ait + i), *(bit + i), values))
             return false;
 
     return true;
 }
 
-bool MatchArrayLiteral(Handle<ArrayLiteral> a, Handle<ArrayLiteral> b)
+// the element `i` of a packed array against the element of another array,
+// packed or not
+static bool MatchElement(const PackedArray &a, size_t i, ArrayLiteral *b,
+    bool values)
+{
+    bool number = a.kind() == PackedArray::Kind::kNumber;
+    if (auto packed = b->packed()) {
+        if (packed->kind() != a.kind())
+            return false;
+        if (!values)
+            return true;
+        return number ? a.number(i) == packed->number(i)
+            : a.string(i) == packed->string(i);
+    }
+
+    auto &expr = b->exprs()[i];
+    if (!expr)
+        return false;
+    if (number) {
+        return expr->IsIntegralLiteral() && (!values
+            || a.number(i) == expr->AsIntegralLiteral()->value());
+    }
+    return expr->IsStringLiteral() && (!values
+        || a.string(i) == expr->AsStringLiteral()->string());
+}
+
+static bool MatchArrayLiteral(Handle<ArrayLiteral> a, Handle<ArrayLiteral> b,
+    bool values)
 {
+        // a packed array matches the same array unpacked, which is only
+        // read, never unpacked
+        if (b->packed() && !a->packed())
+            std::swap(a, b);
+        if (auto packed = a->packed()) {
+            if (packed->size() != b->length())
+                return false;
+            for (size_t i = 0; i < packed->size(); i++) {
+                if (!MatchElement(*packed, i, b.GetPtr(), values))
+                    return false;
+            }
+            return true;
+        }
+
         auto &a_exprs = a->exprs();
         auto &b_exprs = b->exprs();
 
@@ -27,14 +77,15 @@ bool MatchArrayLiteral(Handle<ArrayLiteral> a, Handle<ArrayLiteral> b)
             return false;
 
         for (decltype(a_exprs.size()) i = 0; i < a_exprs.size(); i++) {
-            if (!FastASTMatcher::match(a_exprs[i], b_exprs[i]))
+            if (!Match(a_exprs[i], b_exprs[i], values))
                 return false;
         }
 
         return true;
 }
 
-bool MatchObjectLiteral(Handle<ObjectLiteral> a, Handle<ObjectLiteral> b)
+static bool MatchObjectLiteral(Handle<ObjectLiteral> a,
+    Handle<ObjectLiteral> b, bool values)
 {
     auto &a_object = a->proxy();
     auto &b_object = b->proxy();
@@ -42,234 +93,273 @@ bool MatchObjectLiteral(Handle<ObjectLiteral> a, Handle<ObjectLiteral> b)
     if (a_object.size() != b_object.size())
         return false;
 
-    auto it = b_object.begin();
-    for (auto &p : a_object) {
-        if ((it = b_object.find(p.first)) != b_object.end()) {
-            if (!FastASTMatcher::match(it->second, p.second))
-                return false;
-        } else {
+    // properties are in source order, duplicates included. without values
+    // the names don't matter
+    for (size_t i = 0; i < a_object.size(); i++) {
+        auto &p = a_object[i];
+        auto &q = b_object[i];
+        if (values && p.first != q.first)
+            return false;
+        if (a_object.kind(i) != b_object.kind(i))
+            return false;
+        if (!Match(p.second, q.second, values))
             return false;
-        }
     }
 
     return true;
 }
 
-bool MatchIdentifier(Handle<Identifier> a, Handle<Identifier> b)
+static bool MatchIdentifier(Handle<Identifier> a, Handle<Identifier> b,
+    bool values)
 {
-    return a->GetName() == b->GetName();
+    return !values || a->GetName() == b->GetName();
 }
 
-bool MatchBooleanLiteral(Handle<BooleanLiteral> a, Handle<BooleanLiteral> b)
+static bool MatchBooleanLiteral(Handle<BooleanLiteral> a,
+    Handle<BooleanLiteral> b, bool values)
 {
-    return a->pred() == b->pred();
+    return !values || a->pred() == b->pred();
 }
 
-bool MatchRegExpLiteral(Handle<RegExpLiteral> a, Handle<RegExpLiteral> b)
+static bool MatchRegExpLiteral(Handle<RegExpLiteral> a,
+    Handle<RegExpLiteral> b, bool values)
 {
-    // TODO;
-    return false;
+    return !values
+        || (a->regex() == b->regex() && a->flags() == b->flags());
 }
 
-bool MatchArgumentList(Handle<ArgumentList> a, Handle<ArgumentList> b)
+static bool MatchArgumentList(Handle<ArgumentList> a, Handle<ArgumentList> b,
+    bool values)
 {
-    return MatchExpressionList(a->args(), b->args());
+    return MatchExpressionList(a->args(), b->args(), values);
 }
 
-bool MatchCallExpression(Handle<CallExpression> a, Handle<CallExpression> b)
+static bool MatchCallExpression(Handle<CallExpression> a,
+    Handle<CallExpression> b, bool values)
 {
-    return FastASTMatcher::match(a->member(), b->member())
-        && FastASTMatcher::match(a->expr(), b->expr());
+    return a->kind() == b->kind()
+        && Match(a->member(), b->member(), values)
+        && Match(a->expr(), b->expr(), values);
 }
 
-bool MatchMemberExpression(Handle<MemberExpression> a, Handle<MemberExpression> b)
+static bool MatchMemberExpression(Handle<MemberExpression> a,
+    Handle<MemberExpression> b, bool values)
 {
-    return FastASTMatcher::match(a->member(), b->member())
-        && FastASTMatcher::match(a->expr(), b->expr());
+    return a->kind() == b->kind()
+        && Match(a->member(), b->member(), values)
+        && Match(a->expr(), b->expr(), values);
 }
 
-bool MatchNewExpression(Handle<NewExpression> a, Handle<NewExpression> b)
+static bool MatchNewExpression(Handle<NewExpression> a,
+    Handle<NewExpression> b, bool values)
 {
-    return FastASTMatcher::match(a->member(), b->member());
+    return Match(a->member(), b->member(), values);
 }
 
-bool MatchPrefixExpression(Handle<PrefixExpression> a, Handle<PrefixExpression> b)
+static bool MatchPrefixExpression(Handle<PrefixExpression> a,
+    Handle<PrefixExpression> b, bool values)
 {
-    return (a->op() == b->op()) && (FastASTMatcher::match(a->expr(),
-        b->expr()));
+    return (a->op() == b->op()) && (Match(a->expr(), b->expr(), values));
 }
 
-bool MatchPostfixExpression(Handle<PostfixExpression> a, Handle<PostfixExpression> b)
+static bool MatchPostfixExpression(Handle<PostfixExpression> a,
+    Handle<PostfixExpression> b, bool values)
 {
-    return (a->op() == b->op()) && (FastASTMatcher::match(a->expr(),
-        b->expr()));
+    return (a->op() == b->op()) && (Match(a->expr(), b->expr(), values));
 }
 
-bool MatchBinaryExpression(Handle<BinaryExpression> a, Handle<BinaryExpression> b)
+static bool MatchBinaryExpression(Handle<BinaryExpression> a,
+    Handle<BinaryExpression> b, bool values)
 {
     return (a->op() == b->op())
-        && FastASTMatcher::match(a->lhs(), b->lhs())
-        && FastASTMatcher::match(a->rhs(), b->rhs());
+        && Match(a->lhs(), b->lhs(), values)
+        && Match(a->rhs(), b->rhs(), values);
 }
 
-bool MatchAssignExpression(Handle<AssignExpression> a, Handle<AssignExpression> b)
+static bool MatchAssignExpression(Handle<AssignExpression> a,
+    Handle<AssignExpression> b, bool values)
 {
-    return FastASTMatcher::match(a->lhs(), b->lhs())
-        && FastASTMatcher::match(a->rhs(), b->rhs());
+    return (a->op() == b->op())
+        && Match(a->lhs(), b->lhs(), values)
+        && Match(a->rhs(), b->rhs(), values);
 }
 
-bool MatchTernaryExpression(Handle<TernaryExpression> a, Handle<TernaryExpression> b)
+static bool MatchTernaryExpression(Handle<TernaryExpression> a,
+    Handle<TernaryExpression> b, bool values)
 {
-    return FastASTMatcher::match(a->first(), b->first())
-        && FastASTMatcher::match(a->second(), b->second())
-        && FastASTMatcher::match(a->third(), b->third());
+    return Match(a->first(), b->first(), values)
+        && Match(a->second(), b->second(), values)
+        && Match(a->third(), b->third(), values);
 }
 
-bool MatchCommaExpression(Handle<CommaExpression> a, Handle<CommaExpression> b)
+static bool MatchCommaExpression(Handle<CommaExpression> a,
+    Handle<CommaExpression> b, bool values)
 {
-    return MatchExpressionList(a->exprs(), b->exprs());
+    return MatchExpressionList(a->exprs(), b->exprs(), values);
 }
 
-bool MatchDeclaration(Handle<Declaration> a, Handle<Declaration> b)
+static bool MatchDeclaration(Handle<Declaration> a, Handle<Declaration> b,
+    bool values)
 {
-    return a->name() == b->name()
-        && FastASTMatcher::match(a->expr(), b->expr());
+    return (!values || a->name() == b->name())
+        && Match(a->expr(), b->expr(), values);
 }
 
-bool MatchDeclarationList(Handle<DeclarationList> a, Handle<DeclarationList> b)
+static bool MatchDeclarationList(Handle<DeclarationList> a,
+    Handle<DeclarationList> b, bool values)
 {
     auto &a_exprs = a->exprs();
     auto &b_exprs = b->exprs();
 
+    if (a_exprs.size() != b_exprs.size())
+        return false;
+
     for (decltype(a_exprs.size()) i = 0; i < a_exprs.size(); i++) {
-        if (!MatchDeclaration(a_exprs[i], b_exprs[i]))
+        if (!Match(a_exprs[i].GetPtr(), b_exprs[i].GetPtr(), values))
             return false;
     }
 
     return true;
 }
 
-bool MatchBlockStatement(Handle<BlockStatement> a, Handle<BlockStatement> b)
+static bool MatchBlockStatement(Handle<BlockStatement> a,
+    Handle<BlockStatement> b, bool values)
 {
-    return MatchExpressionList(a->statements(), b->statements());
+    return MatchExpressionList(a->statements(), b->statements(), values);
 }
 
-bool MatchForStatement(Handle<ForStatement> a, Handle<ForStatement> b)
+static bool MatchForStatement(Handle<ForStatement> a, Handle<ForStatement> b,
+    bool values)
 {
-    return FastASTMatcher::match(a->init(), b->init())
-        && FastASTMatcher::match(a->condition(), b->condition())
-        && FastASTMatcher::match(a->update(), b->update())
-        && FastASTMatcher::match(a->body(), b->body());
+    return a->kind() == b->kind()
+        && Match(a->init(), b->init(), values)
+        && Match(a->condition(), b->condition(), values)
+        && Match(a->update(), b->update(), values)
+        && Match(a->body(), b->body(), values);
 }
 
-bool MatchWhileStatement(Handle<WhileStatement> a, Handle<WhileStatement> b)
+static bool MatchWhileStatement(Handle<WhileStatement> a,
+    Handle<WhileStatement> b, bool values)
 {
-    return FastASTMatcher::match(a->condition(), b->condition())
-        && FastASTMatcher::match(a->body(), b->body());
+    return Match(a->condition(), b->condition(), values)
+        && Match(a->body(), b->body(), values);
 }
 
-bool MatchDoWhileStatement(Handle<DoWhileStatement> a, Handle<DoWhileStatement> b)
+static bool MatchDoWhileStatement(Handle<DoWhileStatement> a,
+    Handle<DoWhileStatement> b, bool values)
 {
-    return FastASTMatcher::match(a->condition(), b->condition())
-        && FastASTMatcher::match(a->body(), b->body());
+    return Match(a->condition(), b->condition(), values)
+        && Match(a->body(), b->body(), values);
 }
 
-bool MatchBreakStatement(Handle<BreakStatement> a, Handle<BreakStatement> b)
+static bool MatchBreakStatement(Handle<BreakStatement> a,
+    Handle<BreakStatement> b, bool values)
 {
-    return FastASTMatcher::match(a->label(), b->label());
+    return Match(a->label(), b->label(), values);
 }
 
-bool MatchContinueStatement(Handle<ContinueStatement> a, Handle<ContinueStatement> b)
+static bool MatchContinueStatement(Handle<ContinueStatement> a,
+    Handle<ContinueStatement> b, bool values)
 {
-    return FastASTMatcher::match(a->label(), b->label());
+    return Match(a->label(), b->label(), values);
 }
 
-bool MatchThrowStatement(Handle<ThrowStatement> a, Handle<ThrowStatement> b)
+static bool MatchThrowStatement(Handle<ThrowStatement> a,
+    Handle<ThrowStatement> b, bool values)
 {
-    return FastASTMatcher::match(a->expr(), b->expr());
+    return Match(a->expr(), b->expr(), values);
 }
 
-bool MatchTryStatement(Handle<TryCatchStatement> a, Handle<TryCatchStatement> b)
+static bool MatchTryStatement(Handle<TryCatchStatement> a,
+    Handle<TryCatchStatement> b, bool values)
 {
-    return FastASTMatcher::match(a->try_block(), b->try_block())
-        && FastASTMatcher::match(a->catch_expr(), b->catch_expr())
-        && FastASTMatcher::match(a->catch_block(), b->catch_block())
-        && FastASTMatcher::match(a->finally(), b->finally());
+    return Match(a->try_block(), b->try_block(), values)
+        && Match(a->catch_expr(), b->catch_expr(), values)
+        && Match(a->catch_block(), b->catch_block(), values)
+        && Match(a->finally(), b->finally(), values);
 }
 
-bool MatchLabelledStatement(Handle<LabelledStatement> a, Handle<LabelledStatement> b)
+static bool MatchLabelledStatement(Handle<LabelledStatement> a,
+    Handle<LabelledStatement> b, bool values)
 {
-    return a->label() == b->label() && FastASTMatcher::match(a->expr(),
-        b->expr());
+    return (!values || a->label() == b->label())
+        && Match(a->expr(), b->expr(), values);
 }
 
-bool MatchCaseClauseStatement(Handle<CaseClauseStatement> a, Handle<CaseClauseStatement> b)
+static bool MatchCaseClauseStatement(Handle<CaseClauseStatement> a,
+    Handle<CaseClauseStatement> b, bool values)
 {
-    return FastASTMatcher::match(a->clause(), b->clause())
-        && FastASTMatcher::match(a->stmt(), b->stmt());
+    return Match(a->clause(), b->clause(), values)
+        && Match(a->stmt(), b->stmt(), values);
 }
 
-bool MatchClausesList(Handle<ClausesList> a, Handle<ClausesList> b)
+static bool MatchClausesList(Handle<ClausesList> a, Handle<ClausesList> b,
+    bool values)
 {
-    if (!a->HasDefaultCase() || !b->HasDefaultCase()
+    if (a->HasDefaultCase() != b->HasDefaultCase()
         || a->Size() != b->Size())
         return false;
 
     for (decltype(a->Size()) i = 0; i < a->Size(); i++) {
-        if (!MatchCaseClauseStatement(*(a->begin() + i), *(b->begin() + i)))
+        if (!Match((a->begin() + i)->GetPtr(), (b->begin() + i)->GetPtr(),
+                values))
             return false;
     }
 
-    if (FastASTMatcher::match(a->def(), b->def()))
-        return false;
-
-    return true;
+    return Match(a->def(), b->def(), values);
 }
 
-bool MatchSwitchStatement(Handle<SwitchStatement> a, Handle<SwitchStatement> b)
+static bool MatchSwitchStatement(Handle<SwitchStatement> a,
+    Handle<SwitchStatement> b, bool values)
 {
-    return FastASTMatcher::match(a->expr(), b->expr())
-        && MatchClausesList(a->clauses(), b->clauses());
+    return Match(a->expr(), b->expr(), values)
+        && MatchClausesList(a->clauses(), b->clauses(), values);
 }
 
-bool MatchFunctionPrototype(Handle<FunctionPrototype> a, Handle<FunctionPrototype> b)
+static bool MatchFunctionPrototype(Handle<FunctionPrototype> a,
+    Handle<FunctionPrototype> b, bool values)
 {
+    if (!values)
+        return a->GetArgs().size() == b->GetArgs().size();
+
     return a->GetName() == b->GetName()
         && a->GetArgs() == b->GetArgs();
 }
 
-bool MatchFunctionStatement(Handle<FunctionStatement> a, Handle<FunctionStatement> b)
-{
-    return MatchFunctionPrototype(a->proto(), b->proto())
-        && FastASTMatcher::match(a->body(), b->body());
-}
-
-bool MatchIfStatement(Handle<IfStatement> a, Handle<IfStatement> b)
+static bool MatchFunctionStatement(Handle<FunctionStatement> a,
+    Handle<FunctionStatement> b, bool values)
 {
-    return FastASTMatcher::match(a->condition(), b->condition())
-        && FastASTMatcher::match(a->body(), b->body());
+    return Match(a->proto().GetPtr(), b->proto().GetPtr(), values)
+        && Match(a->body(), b->body(), values);
 }
 
-bool MatchIfElseStatement(Handle<IfElseStatement> a, Handle<IfElseStatement> b)
+static bool MatchIfStatement(Handle<IfStatement> a, Handle<IfStatement> b,
+    bool values)
 {
-    return FastASTMatcher::match(a->condition(), b->condition())
-        && FastASTMatcher::match(a->body(), b->body())
-        && FastASTMatcher::match(a->els(), b->els());
+    return Match(a->condition(), b->condition(), values)
+        && Match(a->body(), b->body(), values);
 }
 
-bool MatchIfElseStatement(Handle<ReturnStatement> a, Handle<ReturnStatement> b)
+static bool MatchIfElseStatement(Handle<IfElseStatement> a,
+    Handle<IfElseStatement> b, bool values)
 {
-    return FastASTMatcher::match(a->expr(), b->expr());
+    return Match(a->condition(), b->condition(), values)
+        && Match(a->body(), b->body(), values)
+        && Match(a->els(), b->els(), values);
 }
 
-bool FastASTMatcher::match(Handle<Expression> a, Handle<Expression> b)
+static bool Match(Handle<Expression> a, Handle<Expression> b, bool values)
 {
     if (!a && !b)
         return true;
     else if (!a || !b)
         return false;
+    else if (a.GetPtr() == b.GetPtr())
+        return true;
     else if (a->type() != b->type())
         return false;
+    else if (StructuralHasher::Differ(a.GetPtr(), b.GetPtr(), values))
+        return false;
     switch (a->type()) {
     case ASTNodeType::kNullLiteral:
     case ASTNodeType::kUndefinedLiteral:
@@ -277,105 +367,127 @@ bool FastASTMatcher::match(Handle<Expression> a, Handle<Expression> b)
         return true;
 
     case ASTNodeType::kIntegralLiteral:
-        return a->AsIntegralLiteral()->value() == b->AsIntegralLiteral()->value();
+        return !values
+            || a->AsIntegralLiteral()->value() == b->AsIntegralLiteral()->value();
 
     case ASTNodeType::kStringLiteral:
-        return a->AsStringLiteral()->string() == b->AsStringLiteral()->string();
+        return !values
+            || a->AsStringLiteral()->string() == b->AsStringLiteral()->string();
+
+    case ASTNodeType::kTemplateLiteral:
+        return !values || a->AsTemplateLiteral()->template_string()
+            == b->AsTemplateLiteral()->template_string();
 
     case ASTNodeType::kArrayLiteral:
-      return MatchArrayLiteral(a->AsArrayLiteral(), b->AsArrayLiteral());
+      return MatchArrayLiteral(a->AsArrayLiteral(), b->AsArrayLiteral(),
+                               values);
     case ASTNodeType::kObjectLiteral:
-      return MatchObjectLiteral(a->AsObjectLiteral(), b->AsObjectLiteral());
+      return MatchObjectLiteral(a->AsObjectLiteral(), b->AsObjectLiteral(),
+                                values);
     case ASTNodeType::kIdentifier:
-      return MatchIdentifier(a->AsIdentifier(), b->AsIdentifier());
+      return MatchIdentifier(a->AsIdentifier(), b->AsIdentifier(), values);
     case ASTNodeType::kBooleanLiteral:
-      return MatchBooleanLiteral(a->AsBooleanLiteral(), b->AsBooleanLiteral());
+      return MatchBooleanLiteral(a->AsBooleanLiteral(), b->AsBooleanLiteral(),
+                                 values);
     case ASTNodeType::kRegExpLiteral:
-      return MatchRegExpLiteral(a->AsRegExpLiteral(), b->AsRegExpLiteral());
+      return MatchRegExpLiteral(a->AsRegExpLiteral(), b->AsRegExpLiteral(),
+                                values);
     case ASTNodeType::kArgumentList:
-      return MatchArgumentList(a->AsArgumentList(), b->AsArgumentList());
+      return MatchArgumentList(a->AsArgumentList(), b->AsArgumentList(),
+                               values);
     case ASTNodeType::kCallExpression:
-      return MatchCallExpression(a->AsCallExpression(), b->AsCallExpression());
+      return MatchCallExpression(a->AsCallExpression(), b->AsCallExpression(),
+                                 values);
     case ASTNodeType::kMemberExpression:
       return MatchMemberExpression(a->AsMemberExpression(),
-                                   b->AsMemberExpression());
+                                   b->AsMemberExpression(), values);
     case ASTNodeType::kNewExpression:
-      return MatchNewExpression(a->AsNewExpression(), b->AsNewExpression());
+      return MatchNewExpression(a->AsNewExpression(), b->AsNewExpression(),
+                                values);
     case ASTNodeType::kPrefixExpression:
       return MatchPrefixExpression(a->AsPrefixExpression(),
-                                   b->AsPrefixExpression());
+                                   b->AsPrefixExpression(), values);
     case ASTNodeType::kPostfixExpression:
       return MatchPostfixExpression(a->AsPostfixExpression(),
-                                    b->AsPostfixExpression());
+                                    b->AsPostfixExpression(), values);
     case ASTNodeType::kBinaryExpression:
       return MatchBinaryExpression(a->AsBinaryExpression(),
-                                   b->AsBinaryExpression());
+                                   b->AsBinaryExpression(), values);
     case ASTNodeType::kAssignExpression:
       return MatchAssignExpression(a->AsAssignExpression(),
-                                   b->AsAssignExpression());
+                                   b->AsAssignExpression(), values);
     case ASTNodeType::kTernaryExpression:
       return MatchTernaryExpression(a->AsTernaryExpression(),
-                                    b->AsTernaryExpression());
+                                    b->AsTernaryExpression(), values);
     case ASTNodeType::kCommaExpression:
       return MatchCommaExpression(a->AsCommaExpression(),
-                                  b->AsCommaExpression());
+                                  b->AsCommaExpression(), values);
     case ASTNodeType::kDeclaration:
-      return MatchDeclaration(a->AsDeclaration(), b->AsDeclaration());
+      return MatchDeclaration(a->AsDeclaration(), b->AsDeclaration(), values);
     case ASTNodeType::kDeclarationList:
       return MatchDeclarationList(a->AsDeclarationList(),
-                                  b->AsDeclarationList());
+                                  b->AsDeclarationList(), values);
     case ASTNodeType::kIfStatement:
-      return MatchIfStatement(a->AsIfStatement(), b->AsIfStatement());
+      return MatchIfStatement(a->AsIfStatement(), b->AsIfStatement(), values);
     case ASTNodeType::kIfElseStatement:
       return MatchIfElseStatement(a->AsIfElseStatement(),
-                                  b->AsIfElseStatement());
+                                  b->AsIfElseStatement(), values);
     case ASTNodeType::kForStatement:
-      return MatchForStatement(a->AsForStatement(), b->AsForStatement());
+      return MatchForStatement(a->AsForStatement(), b->AsForStatement(),
+                               values);
     case ASTNodeType::kWhileStatement:
-      return MatchWhileStatement(a->AsWhileStatement(), b->AsWhileStatement());
+      return MatchWhileStatement(a->AsWhileStatement(), b->AsWhileStatement(),
+                                 values);
     case ASTNodeType::kDoWhileStatement:
       return MatchDoWhileStatement(a->AsDoWhileStatement(),
-                                   b->AsDoWhileStatement());
+                                   b->AsDoWhileStatement(), values);
     case ASTNodeType::kLabelledStatement:
       return MatchLabelledStatement(a->AsLabelledStatement(),
-                                    b->AsLabelledStatement());
+                                    b->AsLabelledStatement(), values);
     case ASTNodeType::kBreakStatement:
-      return MatchBreakStatement(a->AsBreakStatement(), b->AsBreakStatement());
+      return MatchBreakStatement(a->AsBreakStatement(), b->AsBreakStatement(),
+                                 values);
     case ASTNodeType::kContinueStatement:
       return MatchContinueStatement(a->AsContinueStatement(),
-                                    b->AsContinueStatement());
+                                    b->AsContinueStatement(), values);
     case ASTNodeType::kSwitchStatement:
       return MatchSwitchStatement(a->AsSwitchStatement(),
-                                  b->AsSwitchStatement());
+                                  b->AsSwitchStatement(), values);
     case ASTNodeType::kCaseClauseStatement:
       return MatchCaseClauseStatement(a->AsCaseClauseStatement(),
-                                      b->AsCaseClauseStatement());
+                                      b->AsCaseClauseStatement(), values);
     case ASTNodeType::kTryCatchStatement:
       return MatchTryStatement(a->AsTryCatchStatement(),
-                               b->AsTryCatchStatement());
+                               b->AsTryCatchStatement(), values);
     case ASTNodeType::kThrowStatement:
-      return MatchThrowStatement(a->AsThrowStatement(), b->AsThrowStatement());
+      return MatchThrowStatement(a->AsThrowStatement(), b->AsThrowStatement(),
+                                 values);
     case ASTNodeType::kBlockStatement:
-      return MatchBlockStatement(a->AsBlockStatement(), b->AsBlockStatement());
+      return MatchBlockStatement(a->AsBlockStatement(), b->AsBlockStatement(),
+                                 values);
     case ASTNodeType::kFunctionPrototype:
       return MatchFunctionPrototype(a->AsFunctionPrototype(),
-                                    b->AsFunctionPrototype());
+                                    b->AsFunctionPrototype(), values);
     case ASTNodeType::kFunctionStatement:
       return MatchFunctionStatement(a->AsFunctionStatement(),
-                                    b->AsFunctionStatement());
+                                    b->AsFunctionStatement(), values);
     case ASTNodeType::kReturnStatement:
-      return FastASTMatcher::match(a->AsReturnStatement()->expr(),
-                                   b->AsReturnStatement()->expr());
+      return Match(a->AsReturnStatement()->expr(),
+                   b->AsReturnStatement()->expr(), values);
     default:
         throw std::runtime_error("fatal: unknown type");
     }
     return false;
 }
 
+bool FastASTMatcher::match(Handle<Expression> a, Handle<Expression> b)
+{
+    return Match(a, b, false);
+}
+
 bool LazyASTMatcher::match(Handle<Expression> a, Handle<Expression> b)
 {
-    // TODO := write code here...
-    return false;
+    return Match(a, b, true);
 }
 
 }
@@ -0,0 +1,205 @@
+#include "jast/ast-pass.h"
+#include "jast/ast-walker.h"
+#include "jast/astfactory.h"
+#include "jast/statement.h"
+#include "jast/trace.h"
+
+namespace jast {
+
+namespace {
+
+class NodeCounter : public ASTWalker {
+public:
+    size_t count = 0;
+
+protected:
+    bool Enter(Expression *expr) override
+    {
+        count++;
+        return true;
+    }
+};
+
+// the statement left in a slot, or after a label, when `stmt` is removed
+Handle<Expression> EmptyStatement(Expression *stmt)
+{
+    Position loc = stmt->loc();
+    return ASTFactory::GetFactoryInstance()->NewUndefinedLiteral(loc,
+        stmt->GetScope());
+}
+
+}
+
+size_t CountNodes(Expression *root)
+{
+    NodeCounter counter;
+    counter.Walk(root);
+    return counter.count;
+}
+
+class StatementPass::Rewriter : public ASTWalker {
+public:
+    explicit Rewriter(StatementPass *pass)
+        : pass_{ pass }
+    { }
+
+protected:
+    bool Enter(Expression *expr) override
+    {
+        path_.push_back(expr);
+        return true;
+    }
+
+    void Leave(Expression *expr) override
+    {
+        path_.pop_back();
+        bool changed = pass_->changed_;
+        pass_->changed_ = false;
+        Rewrite(expr);
+        if (pass_->changed_) {
+            // the structural hashes of `expr` and of the nodes above it are
+            // those of the old statements
+            expr->SetHash(0);
+            for (auto parent : path_)
+                parent->SetHash(0);
+        }
+        pass_->changed_ |= changed;
+    }
+
+private:
+    void Rewrite(Expression *expr)
+    {
+        switch (expr->type()) {
+        case ASTNodeType::kBlockStatement:
+            RewriteBlock(static_cast<BlockStatement*>(expr));
+            return;
+        case ASTNodeType::kIfStatement: {
+            auto stmt = static_cast<IfStatement*>(expr);
+            stmt->SetBody(pass_->RewriteSlot(stmt->body()));
+            return;
+        }
+        case ASTNodeType::kIfElseStatement: {
+            auto stmt = static_cast<IfElseStatement*>(expr);
+            stmt->SetBody(pass_->RewriteSlot(stmt->body()));
+            stmt->SetElse(pass_->RewriteSlot(stmt->els()));
+            return;
+        }
+        case ASTNodeType::kForStatement: {
+            auto stmt = static_cast<ForStatement*>(expr);
+            stmt->SetBody(pass_->RewriteSlot(stmt->body()));
+            return;
+        }
+        case ASTNodeType::kWhileStatement: {
+            auto stmt = static_cast<WhileStatement*>(expr);
+            stmt->SetBody(pass_->RewriteSlot(stmt->body()));
+            return;
+        }
+        case ASTNodeType::kDoWhileStatement: {
+            auto stmt = static_cast<DoWhileStatement*>(expr);
+            stmt->SetBody(pass_->RewriteSlot(stmt->body()));
+            return;
+        }
+        default:
+            return;
+        }
+    }
+
+    void RewriteBlock(BlockStatement *block)
+    {
+        auto list = block->statements();
+        if (!list)
+            return;
+
+        auto &stmts = list->raw_list();
+        size_t kept = 0;
+        for (size_t i = 0; i < stmts.size(); i++) {
+            Handle<Expression> stmt = stmts[i];
+            if (stmt) {
+                Handle<Expression> result = pass_->RewriteStatement(stmt);
+                if (result.GetPtr() != stmt.GetPtr())
+                    pass_->changed_ = true;
+
+                // a label has to be followed by its statement
+                if (!result && kept && stmts[kept - 1]
+                        && stmts[kept - 1]->IsLabelledStatement())
+                    result = EmptyStatement(stmt.GetPtr());
+                if (!result)
+                    continue;
+                stmt = result;
+            }
+            stmts[kept++] = stmt;
+        }
+        stmts.resize(kept);
+
+        if (pass_->RewriteBlock(stmts))
+            pass_->changed_ = true;
+    }
+
+    StatementPass *pass_;
+    // the nodes entered and not left yet
+    std::vector<Expression*> path_;
+};
+
+Handle<Expression> StatementPass::RewriteSlot(Handle<Expression> stmt)
+{
+    if (!stmt)
+        return stmt;
+
+    Handle<Expression> result = RewriteStatement(stmt);
+    if (result.GetPtr() == stmt.GetPtr())
+        return stmt;
+    changed_ = true;
+    return result ? result : EmptyStatement(stmt.GetPtr());
+}
+
+bool StatementPass::Run(Handle<Expression> &root)
+{
+    changed_ = false;
+    Rewriter rewriter(this);
+    rewriter.Walk(root);
+    return changed_;
+}
+
+void PassManager::Add(std::unique_ptr<ASTPass> pass)
+{
+    passes_.push_back(std::move(pass));
+}
+
+bool PassManager::RunPass(ASTPass *pass, Handle<Expression> &root)
+{
+    TraceScope trace(pass->name(), "pass");
+    if (!stats_)
+        return pass->Run(root);
+
+    size_t before = CountNodes(root.GetPtr());
+    bool changed = pass->Run(root);
+    stats_->CountPass(pass->name(), before,
+        changed ? CountNodes(root.GetPtr()) : before);
+    return changed;
+}
+
+bool PassManager::Run(Handle<Expression> &root, int rounds)
+{
+    TraceScope trace("PassManager::Run", "pass");
+    if (stats_) {
+        PhaseTimer timer(*stats_, Phase::kOptimize);
+        return RunRounds(root, rounds);
+    }
+    return RunRounds(root, rounds);
+}
+
+bool PassManager::RunRounds(Handle<Expression> &root, int rounds)
+{
+    bool changed = false;
+    for (int round = 0; round < rounds; round++) {
+        bool again = false;
+        for (auto &pass : passes_)
+            again |= RunPass(pass.get(), root);
+        if (!again)
+            break;
+        changed = true;
+    }
+    return changed;
+}
+
+}
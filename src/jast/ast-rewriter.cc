@@ -0,0 +1,204 @@
+#include "jast/ast-rewriter.h"
+#include "jast/ast-children.h"
+#include "jast/trace.h"
+
+#include <cassert>
+#include <cstdint>
+
+namespace jast {
+
+namespace {
+
+const size_t kNone = SIZE_MAX;
+
+template <typename T>
+T *SlotCast(Expression *node)
+{
+    T *result = dynamic_cast<T*>(node);
+    assert((result || !node) && "the slot doesn't take a node of this type");
+    return result;
+}
+
+template <>
+Expression *SlotCast<Expression>(Expression *node)
+{
+    return node;
+}
+
+}
+
+// stores the groups of the children of a node in its slots, in the order
+// they were walked
+struct ASTRewriter::Applier {
+    ASTRewriter *rewriter;
+    size_t next;
+
+    Expression *Self(const Group &group)
+    {
+        return group.self == kNone ? nullptr : rewriter->results_[group.self];
+    }
+
+    template <typename T>
+    void Slot(Handle<T> &slot)
+    {
+        // null slots had no child to walk
+        if (!slot)
+            return;
+
+        Expression *self = Self(rewriter->groups_[next++]);
+        if (self != slot.GetPtr())
+            slot = Handle<T>(SlotCast<T>(self));
+    }
+
+    template <typename T>
+    void List(std::vector<Handle<T>> &list)
+    {
+        size_t first = next;
+        bool same = true;
+        for (auto &slot : list) {
+            if (!slot)
+                continue;
+            const Group &group = rewriter->groups_[next++];
+            same = same && group.end - group.begin == 1
+                && Self(group) == slot.GetPtr();
+        }
+        if (same)
+            return;
+
+        std::vector<Handle<T>> rewritten;
+        rewritten.reserve(list.size());
+        next = first;
+        for (auto &slot : list) {
+            if (!slot) {
+                rewritten.push_back(slot);
+                continue;
+            }
+            const Group &group = rewriter->groups_[next++];
+            for (size_t i = group.begin; i < group.end; i++) {
+                T *node = SlotCast<T>(rewriter->results_[i]);
+                if (node)
+                    rewritten.push_back(Handle<T>(node));
+            }
+        }
+        list.swap(rewritten);
+    }
+};
+
+Handle<Expression> ASTRewriter::Rewrite(Handle<Expression> root)
+{
+    if (!root)
+        return root;
+
+    if (Tracer::enabled()) {
+        TraceScope trace("ASTRewriter::Rewrite", "visitor");
+        Run(root.GetPtr());
+    } else {
+        Run(root.GetPtr());
+    }
+
+    const Group &group = groups_.back();
+    Handle<Expression> result(group.self == kNone ? nullptr
+                                                  : results_[group.self]);
+    groups_.clear();
+    results_.clear();
+    owned_.clear();
+    return result;
+}
+
+void ASTRewriter::InsertBefore(Handle<Expression> node)
+{
+    before_.push_back(node);
+}
+
+void ASTRewriter::InsertAfter(Handle<Expression> node)
+{
+    after_.push_back(node);
+}
+
+void ASTRewriter::Run(Expression *root)
+{
+    stack_.push_back(Frame{ root, kNone, 0, false, false, false });
+
+    while (!stack_.empty()) {
+        Frame frame = stack_.back();
+        stack_.pop_back();
+
+        if (frame.leave) {
+            LeaveNode(frame);
+            continue;
+        }
+
+        if (!Enter(frame.node)) {
+            size_t index = results_.size();
+            results_.push_back(frame.node);
+            groups_.push_back(Group{ index, index + 1, index });
+            continue;
+        }
+
+        size_t self = stack_.size();
+        stack_.push_back(Frame{ frame.node, frame.parent, groups_.size(),
+            true, false, false });
+
+        // pushed in reverse, so that the first child is on top
+        size_t first = children_.size();
+        ForEachChild(frame.node, [this](Expression *child) {
+            children_.push_back(child);
+        });
+        for (size_t i = children_.size(); i > first; i--)
+            stack_.push_back(Frame{ children_[i - 1], self, 0, false, false,
+                false });
+        children_.resize(first);
+    }
+}
+
+void ASTRewriter::LeaveNode(Frame &frame)
+{
+    Expression *node = frame.node;
+    if (frame.changed)
+        Apply(node, frame.groups);
+    // the structural hash of a node covers its subtree (see ast-hash.h)
+    if (frame.changed || frame.stale)
+        node->SetHash(0);
+    if (frame.groups < groups_.size()) {
+        results_.resize(groups_[frame.groups].begin);
+        groups_.resize(frame.groups);
+    }
+
+    Handle<Expression> result = Leave(Handle<Expression>(node));
+
+    Group group{ results_.size(), 0, kNone };
+    for (auto &before : before_) {
+        results_.push_back(before.GetPtr());
+        owned_.push_back(before);
+    }
+    if (result) {
+        group.self = results_.size();
+        results_.push_back(result.GetPtr());
+        if (result.GetPtr() != node)
+            owned_.push_back(result);
+    }
+    for (auto &after : after_) {
+        results_.push_back(after.GetPtr());
+        owned_.push_back(after);
+    }
+    group.end = results_.size();
+    before_.clear();
+    after_.clear();
+
+    bool changed = group.self == kNone || results_[group.self] != node
+        || group.end - group.begin != 1;
+    groups_.push_back(group);
+    if (frame.parent != kNone) {
+        if (changed)
+            stack_[frame.parent].changed = true;
+        else if (frame.changed || frame.stale)
+            stack_[frame.parent].stale = true;
+    }
+}
+
+void ASTRewriter::Apply(Expression *node, size_t first)
+{
+    VisitSlots(node, Applier{ this, first });
+}
+
+}
@@ -0,0 +1,52 @@
+#include "jast/ast-walker.h"
+#include "jast/ast-children.h"
+#include "jast/trace.h"
+
+namespace jast {
+
+void ASTWalker::Walk(Expression *root)
+{
+    if (!root)
+        return;
+
+    // walks started from Enter() or Leave() are part of the outer event
+    if (stack_.empty() && Tracer::enabled()) {
+        TraceScope trace("ASTWalker::Walk", "visitor");
+        Run(root);
+    } else {
+        Run(root);
+    }
+}
+
+void ASTWalker::Run(Expression *root)
+{
+    // Enter() and Leave() may start a walk of their own, which works on top
+    // of the frames of this one
+    size_t base = stack_.size();
+    stack_.push_back(Frame{ root, false });
+
+    while (stack_.size() > base) {
+        Frame frame = stack_.back();
+        stack_.pop_back();
+
+        if (frame.leave) {
+            Leave(frame.node);
+            continue;
+        }
+
+        if (!Enter(frame.node))
+            continue;
+        stack_.push_back(Frame{ frame.node, true });
+
+        // pushed in reverse, so that the first child is on top
+        size_t first = children_.size();
+        ForEachChild(frame.node, [this](Expression *child) {
+            children_.push_back(child);
+        });
+        for (size_t i = children_.size(); i > first; i--)
+            stack_.push_back(Frame{ children_[i - 1], false });
+        children_.resize(first);
+    }
+}
+
+}
@@ -0,0 +1,436 @@
+#include "jast/clone-detector.h"
+#include "jast/ast-walker.h"
+#include "jast/ast-match.h"
+#include "jast/parser-builder.h"
+#include "jast/trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+namespace jast {
+
+namespace {
+
+inline bool Before(const Position &a, const Position &b)
+{
+    return a.row() < b.row() || (a.row() == b.row() && a.col() < b.col());
+}
+
+// the i-th MinHash function. node hashes are well mixed already, so xor with
+// a seed and a multiplication are enough to get independent permutations
+inline uint64_t MinHash(int i, uint64_t hash)
+{
+    static const uint64_t kGolden = 0x9e3779b97f4a7c15ULL;
+    return (hash ^ (kGolden * (i + 1))) * (kGolden | 1) * (2 * i + 1);
+}
+
+// computes size, preorder index, extent and MinHash signature of every
+// subtree in one walk. the frames of the nodes being walked are kept on a
+// stack, a node merges its frame into the one of its parent when it's left
+class Walker : public ASTWalker {
+public:
+    using Found = std::function<void(Expression*, size_t, size_t,
+        const Position&, const Position&, const uint64_t*)>;
+
+    Walker(const CloneDetector::Options &options, size_t signature_size,
+        Found found)
+        : options_{ options }, signature_size_{ signature_size },
+          found_{ std::move(found) }, index_{ 0 }
+    { }
+
+protected:
+    bool Enter(Expression *expr) override;
+    void Leave(Expression *expr) override;
+
+private:
+    struct Frame {
+        size_t index;
+        size_t size;
+        Position begin;
+        Position end;
+    };
+
+    const CloneDetector::Options &options_;
+    size_t signature_size_;
+    Found found_;
+    size_t index_;
+
+    std::vector<Frame> frames_;
+
+    // signature of the i-th frame starts at i * signature_size_
+    std::vector<uint64_t> signatures_;
+};
+
+bool Walker::Enter(Expression *expr)
+{
+    frames_.push_back(Frame{ index_++, 1, expr->loc(), expr->loc() });
+
+    uint64_t hash = expr->hash();
+    for (size_t i = 0; i < signature_size_; i++)
+        signatures_.push_back(MinHash(i, hash));
+    return true;
+}
+
+void Walker::Leave(Expression *expr)
+{
+    Frame frame = frames_.back();
+    frames_.pop_back();
+
+    const uint64_t *signature = signature_size_
+        ? &signatures_[frames_.size() * signature_size_] : nullptr;
+    if (frame.size >= options_.min_nodes)
+        found_(expr, frame.size, frame.index, frame.begin, frame.end,
+            signature);
+
+    if (!frames_.empty()) {
+        Frame &parent = frames_.back();
+        parent.size += frame.size;
+        if (Before(frame.begin, parent.begin))
+            parent.begin = frame.begin;
+        if (Before(parent.end, frame.end))
+            parent.end = frame.end;
+
+        // MinHash of the union of two sets is the minimum of both
+        uint64_t *into = signature_size_
+            ? &signatures_[(frames_.size() - 1) * signature_size_] : nullptr;
+        for (size_t i = 0; i < signature_size_; i++)
+            into[i] = std::min(into[i], signature[i]);
+    }
+    signatures_.resize(frames_.size() * signature_size_);
+}
+
+// UnionFind ::= groups near miss candidates
+class UnionFind {
+public:
+    UnionFind(size_t size)
+        : parent_(size)
+    {
+        std::iota(parent_.begin(), parent_.end(), 0);
+    }
+
+    size_t Find(size_t i)
+    {
+        while (parent_[i] != i)
+            i = parent_[i] = parent_[parent_[i]];
+        return i;
+    }
+
+    void Union(size_t a, size_t b) { parent_[Find(a)] = Find(b); }
+
+private:
+    std::vector<size_t> parent_;
+};
+
+}
+
+CloneDetector::CloneDetector()
+    : CloneDetector(Options())
+{ }
+
+CloneDetector::CloneDetector(const Options &options)
+    : options_{ options }
+{
+    if (options_.min_nodes < 1)
+        options_.min_nodes = 1;
+}
+
+CloneDetector::~CloneDetector()
+{ }
+
+size_t CloneDetector::AddFile(const std::string &name,
+    const std::string &source)
+{
+    files_.push_back(File{ name, source, "", nullptr, { } });
+    return files_.size() - 1;
+}
+
+void CloneDetector::Process(File &file)
+{
+    TraceScope trace("CloneDetector::Process", "clones");
+    trace.SetArg(file.name.c_str());
+    std::istringstream is(file.source);
+    ParserBuilder builder(is, file.name);
+
+    try {
+        file.ast = ParseProgram(builder.Build());
+    } catch (std::exception &e) {
+        file.error = e.what();
+        return;
+    }
+
+    StructuralHasher::Hash(file.ast, options_.sensitivity);
+
+    size_t signature_size = options_.near_miss ? kSignatureSize : 0;
+    Walker walker(options_, signature_size, [&](Expression *node, size_t size,
+            size_t index, const Position &begin, const Position &end,
+            const uint64_t *signature) {
+        Candidate candidate{ node, node->hash(), size, index, begin, end, { } };
+        if (signature)
+            candidate.signature.assign(signature, signature + signature_size);
+        file.candidates.push_back(std::move(candidate));
+    });
+
+    walker.Walk(file.ast);
+}
+
+static CloneFragment MakeFragment(size_t file, const Position &begin,
+    const Position &end, size_t size, Expression *node)
+{
+    return CloneFragment{ file, begin, end, size, node };
+}
+
+void CloneDetector::FindExactClones(std::vector<CloneGroup> &groups)
+{
+    using Ref = std::pair<size_t, size_t>;   // (file, candidate)
+    std::unordered_map<uint64_t, std::vector<Ref>> index;
+
+    for (size_t f = 0; f < files_.size(); f++) {
+        auto &candidates = files_[f].candidates;
+        for (size_t c = 0; c < candidates.size(); c++)
+            index[candidates[c].hash].push_back(Ref(f, c));
+    }
+
+    bool values = options_.sensitivity == HashSensitivity::kTypesAndValues;
+    for (auto &bucket : index) {
+        auto &refs = bucket.second;
+        if (refs.size() < 2)
+            continue;
+
+        // equal hashes are only candidates, the matcher decides. every
+        // class is represented by its first member
+        std::vector<std::vector<Ref>> classes;
+        for (auto &ref : refs) {
+            Expression *node = files_[ref.first].candidates[ref.second].node;
+            bool placed = false;
+
+            for (auto &cls : classes) {
+                Expression *repr =
+                    files_[cls[0].first].candidates[cls[0].second].node;
+                bool match = values ? LazyASTMatcher::match(repr, node)
+                                    : FastASTMatcher::match(repr, node);
+                if (match) {
+                    cls.push_back(ref);
+                    placed = true;
+                    break;
+                }
+            }
+            if (!placed)
+                classes.push_back({ ref });
+        }
+
+        for (auto &cls : classes) {
+            if (cls.size() < 2)
+                continue;
+
+            CloneGroup group{ { }, true, 1.0 };
+            for (auto &ref : cls) {
+                auto &c = files_[ref.first].candidates[ref.second];
+                group.fragments.push_back(MakeFragment(ref.first, c.begin,
+                    c.end, c.size, c.node));
+            }
+            groups.push_back(std::move(group));
+        }
+    }
+}
+
+void CloneDetector::FindNearMissClones(std::vector<CloneGroup> &groups)
+{
+    const int rows = kSignatureSize / kBands;
+
+    // all candidates get a global id
+    std::vector<std::pair<size_t, size_t>> ids;
+    for (size_t f = 0; f < files_.size(); f++) {
+        for (size_t c = 0; c < files_[f].candidates.size(); c++)
+            ids.push_back({ f, c });
+    }
+    auto candidate = [&](size_t id) -> Candidate& {
+        return files_[ids[id].first].candidates[ids[id].second];
+    };
+
+    auto similarity = [&](size_t a, size_t b) {
+        auto &sa = candidate(a).signature;
+        auto &sb = candidate(b).signature;
+        int equal = 0;
+        for (int i = 0; i < kSignatureSize; i++)
+            equal += sa[i] == sb[i];
+        return (double)equal / kSignatureSize;
+    };
+
+    // a fragment is always similar to its own big children
+    auto nested = [&](size_t a, size_t b) {
+        if (ids[a].first != ids[b].first)
+            return false;
+        auto &ca = candidate(a);
+        auto &cb = candidate(b);
+        return (ca.index <= cb.index && cb.index < ca.index + ca.size)
+            || (cb.index <= ca.index && ca.index < cb.index + cb.size);
+    };
+
+    UnionFind sets(ids.size());
+
+    for (int band = 0; band < kBands; band++) {
+        std::unordered_map<uint64_t, std::vector<size_t>> buckets;
+
+        for (size_t id = 0; id < ids.size(); id++) {
+            auto &signature = candidate(id).signature;
+            uint64_t key = band;
+            for (int i = band * rows; i < (band + 1) * rows; i++)
+                key = (key ^ signature[i]) * 0x100000001b3ULL;
+
+            // only the last kBucketCompare members of a bucket are compared,
+            // which keeps the work linear when a bucket gets large. exact
+            // clones of each other are already grouped
+            auto &bucket = buckets[key];
+            size_t first = bucket.size() > kBucketCompare
+                ? bucket.size() - kBucketCompare : 0;
+            for (size_t i = first; i < bucket.size(); i++) {
+                size_t other = bucket[i];
+                if (candidate(other).hash == candidate(id).hash
+                    || nested(other, id) || sets.Find(other) == sets.Find(id))
+                    continue;
+
+                if (similarity(other, id) >= options_.similarity)
+                    sets.Union(other, id);
+            }
+            bucket.push_back(id);
+        }
+    }
+
+    std::map<size_t, std::vector<size_t>> components;
+    for (size_t id = 0; id < ids.size(); id++)
+        components[sets.Find(id)].push_back(id);
+
+    for (auto &component : components) {
+        auto members = component.second;
+
+        // similar trees chain their ancestors into the same component, only
+        // the outermost fragments are kept
+        std::sort(members.begin(), members.end(), [&](size_t a, size_t b) {
+            if (ids[a].first != ids[b].first)
+                return ids[a].first < ids[b].first;
+            return candidate(a).index < candidate(b).index;
+        });
+        size_t kept = 0;
+        for (size_t i = 0; i < members.size(); i++) {
+            if (kept && nested(members[kept - 1], members[i]))
+                continue;
+            members[kept++] = members[i];
+        }
+        members.resize(kept);
+        if (members.size() < 2)
+            continue;
+
+        // all of them are structurally equal, those are exact clones
+        bool same = true;
+        double s = 1.0;
+        for (auto id : members) {
+            same = same && candidate(id).hash == candidate(members[0]).hash;
+            s = std::min(s, similarity(members[0], id));
+        }
+        if (same)
+            continue;
+
+        CloneGroup group{ { }, false, s };
+        for (auto id : members) {
+            auto &c = candidate(id);
+            group.fragments.push_back(MakeFragment(ids[id].first, c.begin,
+                c.end, c.size, c.node));
+        }
+        groups.push_back(std::move(group));
+    }
+}
+
+static size_t GroupSize(const CloneGroup &group)
+{
+    size_t size = 0;
+    for (auto &fragment : group.fragments)
+        size = std::max(size, fragment.size);
+    return size;
+}
+
+std::vector<CloneGroup> CloneDetector::RemoveNested(
+    std::vector<CloneGroup> groups)
+{
+    // bigger clones first, so that their parts are covered when they come
+    std::stable_sort(groups.begin(), groups.end(),
+        [](const CloneGroup &a, const CloneGroup &b) {
+            size_t sa = GroupSize(a), sb = GroupSize(b);
+            return sa != sb ? sa > sb : a.exact > b.exact;
+        });
+
+    // disjoint [begin, end) preorder ranges of reported fragments per file
+    std::vector<std::map<size_t, size_t>> covered(files_.size());
+    std::unordered_map<Expression*, size_t> indices;
+    for (auto &file : files_) {
+        for (auto &c : file.candidates)
+            indices[c.node] = c.index;
+    }
+
+    std::vector<CloneGroup> result;
+    for (auto &group : groups) {
+        std::vector<const CloneFragment*> uncovered;
+        for (auto &fragment : group.fragments) {
+            size_t begin = indices[fragment.node];
+            auto &ranges = covered[fragment.file];
+
+            auto range = ranges.upper_bound(begin);
+            if (range != ranges.begin()
+                && begin + fragment.size <= (--range)->second)
+                continue;
+            uncovered.push_back(&fragment);
+        }
+
+        if (uncovered.empty())
+            continue;
+
+        for (auto fragment : uncovered) {
+            size_t begin = indices[fragment->node];
+            covered[fragment->file][begin] = begin + fragment->size;
+        }
+        result.push_back(std::move(group));
+    }
+    return result;
+}
+
+std::vector<CloneGroup> CloneDetector::Run()
+{
+    unsigned threads = options_.threads;
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min<size_t>(threads, std::max<size_t>(1, files_.size()));
+
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&](unsigned id) {
+        if (Tracer::enabled())
+            Tracer::SetThreadName("clones worker " + std::to_string(id));
+        size_t i;
+        while ((i = next++) < files_.size()) {
+            auto &file = files_[i];
+            file.candidates.clear();
+            file.error.clear();
+            Process(file);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; i++)
+        pool.emplace_back(worker, i);
+    worker(0);
+    for (auto &thread : pool)
+        thread.join();
+
+    TraceScope trace("CloneDetector::Group", "clones");
+    std::vector<CloneGroup> groups;
+    FindExactClones(groups);
+    if (options_.near_miss)
+        FindNearMissClones(groups);
+    return RemoveNested(std::move(groups));
+}
+
+}
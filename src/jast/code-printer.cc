@@ -0,0 +1,1249 @@
+#include "jast/code-printer.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+
+namespace jast {
+
+// operator precedence levels, the binary levels are the same as tokens.inc
+enum Precedence {
+    kComma = 1,
+    kAssign = 2,
+    kConditional = 3,
+    kLogicalOr = 4,
+    kLogicalAnd = 5,
+    kBitOrLevel = 6,
+    kBitXorLevel = 7,
+    kBitAndLevel = 8,
+    kEquality = 9,
+    kRelational = 10,
+    kShift = 11,
+    kAdditive = 12,
+    kMultiplicative = 13,
+    kUnary = 15,
+    kPostfix = 16,
+    kNew = 17,
+    kMember = 18,
+    kPrimary = 20,
+    kForceParens = 21
+};
+
+static const size_t kFlushThreshold = 1 << 16;
+
+static int BinaryPrecedence(BinaryOperation op)
+{
+    switch (op) {
+    case BinaryOperation::kOr:              return kLogicalOr;
+    case BinaryOperation::kAnd:             return kLogicalAnd;
+    case BinaryOperation::kBitOr:           return kBitOrLevel;
+    case BinaryOperation::kBitXor:          return kBitXorLevel;
+    case BinaryOperation::kBitAnd:          return kBitAndLevel;
+    case BinaryOperation::kEqual:
+    case BinaryOperation::kNotEqual:
+    case BinaryOperation::kStrictEqual:
+    case BinaryOperation::kStrictNotEqual:  return kEquality;
+    case BinaryOperation::kLessThan:
+    case BinaryOperation::kGreaterThan:
+    case BinaryOperation::kLessThanEqual:
+    case BinaryOperation::kGreaterThanEqual:
+    case BinaryOperation::kInstanceOf:
+    case BinaryOperation::kIn:              return kRelational;
+    case BinaryOperation::kShiftRight:
+    case BinaryOperation::kShiftLeft:
+    case BinaryOperation::kShiftZeroRight:  return kShift;
+    case BinaryOperation::kAddition:
+    case BinaryOperation::kSubtraction:     return kAdditive;
+    case BinaryOperation::kMultiplication:
+    case BinaryOperation::kDivision:
+    case BinaryOperation::kMod:             return kMultiplicative;
+    }
+    return kComma;
+}
+
+static const char *BinaryOperatorString(BinaryOperation op)
+{
+    switch (op) {
+    case BinaryOperation::kAddition:        return "+";
+    case BinaryOperation::kSubtraction:     return "-";
+    case BinaryOperation::kMultiplication:  return "*";
+    case BinaryOperation::kDivision:        return "/";
+    case BinaryOperation::kMod:             return "%";
+    case BinaryOperation::kShiftRight:      return ">>";
+    case BinaryOperation::kShiftLeft:       return "<<";
+    case BinaryOperation::kShiftZeroRight:  return ">>>";
+    case BinaryOperation::kLessThan:        return "<";
+    case BinaryOperation::kGreaterThan:     return ">";
+    case BinaryOperation::kLessThanEqual:   return "<=";
+    case BinaryOperation::kGreaterThanEqual: return ">=";
+    case BinaryOperation::kEqual:           return "==";
+    case BinaryOperation::kNotEqual:        return "!=";
+    case BinaryOperation::kStrictEqual:     return "===";
+    case BinaryOperation::kStrictNotEqual:  return "!==";
+    case BinaryOperation::kAnd:             return "&&";
+    case BinaryOperation::kOr:              return "||";
+    case BinaryOperation::kBitAnd:          return "&";
+    case BinaryOperation::kBitOr:           return "|";
+    case BinaryOperation::kBitXor:          return "^";
+    case BinaryOperation::kInstanceOf:      return "instanceof";
+    case BinaryOperation::kIn:              return "in";
+    }
+    return "";
+}
+
+static const char *AssignOperatorString(AssignOperation op)
+{
+    switch (op) {
+    case AssignOperation::kAssign:          return "=";
+    case AssignOperation::kAddition:        return "+=";
+    case AssignOperation::kSubtraction:     return "-=";
+    case AssignOperation::kMultiplication:  return "*=";
+    case AssignOperation::kDivision:        return "/=";
+    case AssignOperation::kMod:             return "%=";
+    case AssignOperation::kShiftRight:      return ">>=";
+    case AssignOperation::kShiftLeft:       return "<<=";
+    case AssignOperation::kShiftZeroRight:  return ">>>=";
+    case AssignOperation::kBitAnd:          return "&=";
+    case AssignOperation::kBitOr:           return "|=";
+    case AssignOperation::kBitXor:          return "^=";
+    }
+    return "";
+}
+
+// The parser turns `+x` into `x * 1` and `-x` into `x * -1`. Printing those
+// back in unary form reproduces the same tree when the output is parsed again.
+static bool IsUnaryPlusOrMinus(BinaryExpression *expr, bool *negate)
+{
+    if (expr->op() != BinaryOperation::kMultiplication)
+        return false;
+    auto rhs = expr->rhs();
+    if (!rhs || !expr->lhs() || !rhs->IsIntegralLiteral())
+        return false;
+
+    double value = static_cast<IntegralLiteral*>(rhs.GetPtr())->value();
+    if (value != 1.0 && value != -1.0)
+        return false;
+    *negate = value < 0;
+    return true;
+}
+
+static bool IsIdentifierChar(char ch)
+{
+    return std::isalnum((unsigned char)ch) || ch == '_' || ch == '$'
+        || (unsigned char)ch >= 0x80;
+}
+
+static bool NeedsSeparator(char last, char first)
+{
+    if (IsIdentifierChar(last) && IsIdentifierChar(first))
+        return true;
+    // a + +b, a - -b, a / /re/
+    if ((last == '+' || last == '-') && first == last)
+        return true;
+    return last == '/' && (first == '/' || first == '*');
+}
+
+static bool IsIdentifierName(const std::string &name)
+{
+    if (name.empty() || std::isdigit((unsigned char)name[0]))
+        return false;
+    for (char ch : name) {
+        if (!IsIdentifierChar(ch))
+            return false;
+    }
+    return true;
+}
+
+static bool IsNumericName(const std::string &name)
+{
+    if (name.empty())
+        return false;
+    for (char ch : name) {
+        if (!std::isdigit((unsigned char)ch))
+            return false;
+    }
+    return name.length() == 1 || name[0] != '0';
+}
+
+// true if `expr` is printed as a single token. the location of a node is
+// where the parser was when it built it, which is the start of the token
+// only for these; a compound node ends there
+static bool IsToken(Expression *expr)
+{
+    switch (expr->type()) {
+    case ASTNodeType::kIdentifier:
+    case ASTNodeType::kNullLiteral:
+    case ASTNodeType::kThisHolder:
+    case ASTNodeType::kIntegralLiteral:
+    case ASTNodeType::kStringLiteral:
+    case ASTNodeType::kTemplateLiteral:
+    case ASTNodeType::kRegExpLiteral:
+    case ASTNodeType::kBooleanLiteral:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// true if printing `expr` at the start of a statement would begin with '{'
+// or 'function' and be taken for a block or a declaration
+static bool StartsWithBraceOrFunction(Expression *expr)
+{
+    bool negate;
+    while (expr) {
+        switch (expr->type()) {
+        case ASTNodeType::kObjectLiteral:
+        case ASTNodeType::kFunctionStatement:
+            return true;
+        case ASTNodeType::kMemberExpression:
+            expr = static_cast<MemberExpression*>(expr)->expr().GetPtr();
+            break;
+        case ASTNodeType::kCallExpression:
+            expr = static_cast<CallExpression*>(expr)->expr().GetPtr();
+            break;
+        case ASTNodeType::kBinaryExpression: {
+            auto binary = static_cast<BinaryExpression*>(expr);
+            if (IsUnaryPlusOrMinus(binary, &negate))
+                return false;
+            expr = binary->lhs().GetPtr();
+            break;
+        }
+        case ASTNodeType::kAssignExpression:
+            expr = static_cast<AssignExpression*>(expr)->lhs().GetPtr();
+            break;
+        case ASTNodeType::kTernaryExpression:
+            expr = static_cast<TernaryExpression*>(expr)->first().GetPtr();
+            break;
+        case ASTNodeType::kPostfixExpression:
+            expr = static_cast<PostfixExpression*>(expr)->expr().GetPtr();
+            break;
+        case ASTNodeType::kCommaExpression: {
+            auto list = static_cast<CommaExpression*>(expr)->exprs();
+            if (!list || !list->Size())
+                return false;
+            expr = list->begin()->GetPtr();
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return false;
+}
+
+// true if `stmt` ends with an `if` without `else`, which would steal the
+// `else` of an enclosing if statement
+static bool EndsWithIf(Expression *stmt)
+{
+    while (stmt) {
+        switch (stmt->type()) {
+        case ASTNodeType::kIfStatement:
+            return true;
+        case ASTNodeType::kIfElseStatement:
+            stmt = static_cast<IfElseStatement*>(stmt)->els().GetPtr();
+            break;
+        case ASTNodeType::kForStatement:
+            stmt = static_cast<ForStatement*>(stmt)->body().GetPtr();
+            break;
+        case ASTNodeType::kWhileStatement:
+            stmt = static_cast<WhileStatement*>(stmt)->body().GetPtr();
+            break;
+        default:
+            return false;
+        }
+    }
+    return false;
+}
+
+CodePrinter::CodePrinter(std::ostream &os, SourceMapGenerator *map, bool minify)
+    : os_{ os }, map_{ map }, minify_{ minify }, source_index_{ 0 },
+      record_names_{ false }, last_{ '\n' }, indent_{ 0 }, line_{ 0 }, column_{ 0 }, pending_{ nullptr }
+{
+    buffer_.reserve(kFlushThreshold + 1024);
+}
+
+CodePrinter::~CodePrinter()
+{
+    Flush();
+}
+
+void CodePrinter::Flush()
+{
+    os_.write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+}
+
+void CodePrinter::Print(Handle<Expression> program)
+{
+    if (program && program->IsBlockStatement()) {
+        auto list = static_cast<BlockStatement*>(program.GetPtr())->statements();
+        PrintStatementList(list.GetPtr());
+    } else {
+        PrintStatement(program);
+    }
+
+    if (!minify_) {
+        buffer_.push_back('\n');
+        line_++;
+        column_ = 0;
+        last_ = '\n';
+    }
+    Flush();
+}
+
+int CodePrinter::Precedence(Expression *expr)
+{
+    bool negate;
+    switch (expr->type()) {
+    case ASTNodeType::kCommaExpression:
+        return kComma;
+    case ASTNodeType::kAssignExpression:
+        return kAssign;
+    case ASTNodeType::kTernaryExpression:
+        return kConditional;
+    case ASTNodeType::kBinaryExpression: {
+        auto binary = static_cast<BinaryExpression*>(expr);
+        if (IsUnaryPlusOrMinus(binary, &negate))
+            return kUnary;
+        return BinaryPrecedence(binary->op());
+    }
+    case ASTNodeType::kPrefixExpression:
+        return kUnary;
+    case ASTNodeType::kPostfixExpression:
+        return kPostfix;
+    case ASTNodeType::kNewExpression:
+        return kNew;
+    case ASTNodeType::kCallExpression:
+    case ASTNodeType::kMemberExpression:
+        return kMember;
+    case ASTNodeType::kIntegralLiteral:
+        return std::signbit(static_cast<IntegralLiteral*>(expr)->value())
+            ? kUnary : kPrimary;
+    default:
+        return kPrimary;
+    }
+}
+
+void CodePrinter::AddPendingMapping(const std::string *name)
+{
+    const Position &pos = pending_->loc();
+    map_->AddMapping(line_, column_, pos.row(), pos.col() ? pos.col() - 1 : 0,
+        source_index_, name ? map_->AddName(*name) : -1);
+    pending_ = nullptr;
+}
+
+void CodePrinter::Emit(const char *str, size_t len, const std::string *name)
+{
+    if (!len)
+        return;
+
+    if (NeedsSeparator(last_, str[0])) {
+        buffer_.push_back(' ');
+        column_++;
+    }
+
+    if (pending_)
+        AddPendingMapping(name);
+
+    buffer_.append(str, len);
+    last_ = str[len - 1];
+
+    const char *end = str + len;
+    const char *nl = (const char*)memchr(str, '\n', len);
+    if (!nl) {
+        column_ += len;
+    } else {
+        // template literals and line continuations can span lines
+        const char *last;
+        do {
+            line_++;
+            last = nl;
+            nl = (const char*)memchr(nl + 1, '\n', end - nl - 1);
+        } while (nl);
+        column_ = end - last - 1;
+    }
+
+    if (buffer_.size() > kFlushThreshold)
+        Flush();
+}
+
+void CodePrinter::Emit(const char *str)
+{
+    Emit(str, strlen(str));
+}
+
+void CodePrinter::EmitStringLiteral(const std::string &str, char quote)
+{
+    // the tokenizer keeps escape sequences as they were written, only an
+    // unescaped quote character needs escaping for the new delimiter
+    std::string literal;
+    literal.reserve(str.length() + 2);
+    literal.push_back(quote);
+    for (size_t i = 0; i < str.length(); i++) {
+        char ch = str[i];
+        if (ch == '\\' && i + 1 < str.length()) {
+            literal.push_back(ch);
+            literal.push_back(str[++i]);
+        } else if (ch == quote) {
+            literal.push_back('\\');
+            literal.push_back(ch);
+        } else if (ch == '\n') {
+            literal.append("\\n");
+        } else {
+            literal.push_back(ch);
+        }
+    }
+    literal.push_back(quote);
+    Emit(literal);
+}
+
+void CodePrinter::EmitNumber(double value)
+{
+    char buf[32];
+
+    if (std::isnan(value)) {
+        Emit("NaN");
+        return;
+    }
+
+    if (std::signbit(value)) {
+        Emit("-");
+        value = -value;
+    }
+
+    if (std::isinf(value)) {
+        Emit("Infinity");
+        return;
+    }
+
+    if (value == std::floor(value) && value < 1e21) {
+        snprintf(buf, sizeof(buf), "%.0f", value);
+    } else {
+        // shortest representation that reads back as the same double
+        for (int precision = 1; precision <= 17; precision++) {
+            snprintf(buf, sizeof(buf), "%.*g", precision, value);
+            if (strtod(buf, nullptr) == value)
+                break;
+        }
+    }
+    Emit(buf);
+}
+
+void CodePrinter::EmitProperty(const std::string &name)
+{
+    if (IsIdentifierName(name) || IsNumericName(name))
+        Emit(name);
+    else
+        EmitStringLiteral(name, '"');
+}
+
+void CodePrinter::Space()
+{
+    if (minify_)
+        return;
+    buffer_.push_back(' ');
+    column_++;
+    last_ = ' ';
+}
+
+void CodePrinter::Newline()
+{
+    if (minify_)
+        return;
+    buffer_.push_back('\n');
+    buffer_.append(indent_ * 4, ' ');
+    line_++;
+    column_ = indent_ * 4;
+    last_ = '\n';
+}
+
+void CodePrinter::PrintExpression(Expression *expr, int precedence)
+{
+    if (!expr)
+        return;
+
+    bool parens = Precedence(expr) < precedence;
+    if (parens)
+        Emit("(", 1);
+    if (IsToken(expr))
+        Mark(expr);
+    expr->Accept(this);
+    if (parens)
+        Emit(")", 1);
+}
+
+void CodePrinter::PrintStatement(Expression *stmt)
+{
+    if (!stmt) {
+        Emit(";", 1);
+        return;
+    }
+
+    switch (stmt->type()) {
+    case ASTNodeType::kBlockStatement:
+    case ASTNodeType::kIfStatement:
+    case ASTNodeType::kIfElseStatement:
+    case ASTNodeType::kForStatement:
+    case ASTNodeType::kWhileStatement:
+    case ASTNodeType::kDoWhileStatement:
+    case ASTNodeType::kSwitchStatement:
+    case ASTNodeType::kCaseClauseStatement:
+    case ASTNodeType::kTryCatchStatement:
+    case ASTNodeType::kThrowStatement:
+    case ASTNodeType::kReturnStatement:
+    case ASTNodeType::kBreakStatement:
+    case ASTNodeType::kContinueStatement:
+    case ASTNodeType::kLabelledStatement:
+    case ASTNodeType::kFunctionStatement:
+        stmt->Accept(this);
+        return;
+
+    case ASTNodeType::kUndefinedLiteral:
+        // empty statement
+        Emit(";", 1);
+        return;
+
+    case ASTNodeType::kDeclarationList:
+        stmt->Accept(this);
+        Emit(";", 1);
+        return;
+
+    default:
+        PrintExpression(stmt, StartsWithBraceOrFunction(stmt)
+                                ? kForceParens : kComma);
+        Emit(";", 1);
+    }
+}
+
+// statements which are parsed without their terminating ';', either
+// themselves or as their last substatement
+static bool LeavesSemicolon(Expression *stmt)
+{
+    if (!stmt)
+        return false;
+
+    switch (stmt->type()) {
+    case ASTNodeType::kBreakStatement:
+    case ASTNodeType::kContinueStatement:
+    case ASTNodeType::kThrowStatement:
+        return true;
+    case ASTNodeType::kReturnStatement:
+        return !stmt->AsReturnStatement()->expr();
+    case ASTNodeType::kIfStatement:
+        return LeavesSemicolon(stmt->AsIfStatement()->body().GetPtr());
+    case ASTNodeType::kIfElseStatement:
+        return LeavesSemicolon(stmt->AsIfElseStatement()->els().GetPtr());
+    case ASTNodeType::kWhileStatement:
+        return LeavesSemicolon(stmt->AsWhileStatement()->body().GetPtr());
+    case ASTNodeType::kForStatement:
+        return LeavesSemicolon(stmt->AsForStatement()->body().GetPtr());
+    default:
+        return false;
+    }
+}
+
+void CodePrinter::PrintStatementList(ExpressionList *list)
+{
+    if (!list)
+        return;
+
+    for (auto it = list->begin(); it != list->end(); ++it) {
+        auto &stmt = *it;
+        if (it != list->begin())
+            Newline();
+        PrintStatement(stmt);
+
+        // the parser leaves the ';' of break, continue, throw and an empty
+        // return to an empty statement after them. it is printed with them,
+        // on the same line
+        auto next = std::next(it);
+        if (LeavesSemicolon(stmt.GetPtr()) && next != list->end() && *next
+                && (*next)->IsUndefinedLiteral()) {
+            it = next;
+            continue;
+        }
+
+        // a label needs a statement following it
+        if (next == list->end() && stmt && stmt->IsLabelledStatement())
+            Emit(";", 1);
+    }
+}
+
+void CodePrinter::PrintBlockBody(Expression *stmt)
+{
+    if (stmt && stmt->IsBlockStatement()) {
+        Space();
+        PrintStatement(stmt);
+        return;
+    }
+
+    indent_++;
+    Newline();
+    PrintStatement(stmt);
+    indent_--;
+}
+
+void CodePrinter::PrintExpressionList(ExpressionList *list)
+{
+    if (!list)
+        return;
+
+    bool first = true;
+    for (auto &expr : *list) {
+        if (!first) {
+            Emit(",", 1);
+            Space();
+        }
+        first = false;
+        PrintExpression(expr, kAssign);
+    }
+}
+
+void CodePrinter::Visit(NullLiteral *literal)
+{
+    Emit("null", 4);
+}
+
+void CodePrinter::Visit(UndefinedLiteral *literal)
+{
+    Emit("void 0", 6);
+}
+
+void CodePrinter::Visit(ThisHolder *holder)
+{
+    Emit("this", 4);
+}
+
+void CodePrinter::Visit(IntegralLiteral *literal)
+{
+    EmitNumber(literal->value());
+}
+
+void CodePrinter::Visit(StringLiteral *literal)
+{
+    EmitStringLiteral(literal->string(), '"');
+}
+
+void CodePrinter::Visit(TemplateLiteral *literal)
+{
+    std::string str;
+    str.reserve(literal->template_string().length() + 2);
+    str.push_back('`');
+    str += literal->template_string();
+    str.push_back('`');
+    Emit(str);
+}
+
+void CodePrinter::Visit(ArrayLiteral *literal)
+{
+    Emit("[", 1);
+    bool first = true;
+    if (auto packed = literal->packed()) {
+        for (size_t i = 0; i < packed->size(); i++) {
+            if (i) {
+                Emit(",", 1);
+                Space();
+            }
+            if (packed->kind() == PackedArray::Kind::kNumber)
+                EmitNumber(packed->number(i));
+            else
+                EmitStringLiteral(packed->string(i), '"');
+        }
+        Emit("]", 1);
+        return;
+    }
+    for (auto &expr : literal->exprs()) {
+        if (!first) {
+            Emit(",", 1);
+            Space();
+        }
+        first = false;
+        PrintExpression(expr, kAssign);
+    }
+    Emit("]", 1);
+}
+
+void CodePrinter::Visit(ObjectLiteral *literal)
+{
+    auto &proxy = literal->proxy();
+    Emit("{", 1);
+    for (size_t i = 0; i < proxy.size(); i++) {
+        auto &prop = proxy[i];
+        if (i) {
+            Emit(",", 1);
+            Space();
+        }
+
+        auto kind = proxy.kind(i);
+        if (kind == PropertyKind::kValue) {
+            EmitProperty(prop.first);
+            Emit(":", 1);
+            Space();
+            PrintExpression(prop.second, kAssign);
+            continue;
+        }
+
+        // an accessor prints as `get name(args) { body }`
+        auto value = prop.second.GetPtr();
+        if (!value || value->type() != ASTNodeType::kFunctionStatement
+                || !static_cast<FunctionStatement*>(value)->proto())
+            throw std::runtime_error("the accessor " + prop.first
+                + " is not a function");
+        auto function = static_cast<FunctionStatement*>(value);
+        Emit(kind == PropertyKind::kGetter ? "get" : "set", 3);
+        EmitProperty(prop.first);
+        PrintParameters(function->proto().GetPtr());
+        Space();
+        PrintFunctionBody(function);
+    }
+    Emit("}", 1);
+}
+
+void CodePrinter::Visit(Identifier *id)
+{
+    // only an identifier which is mapped itself gets its name recorded
+    const std::string &name = id->GetName();
+    Emit(name.data(), name.length(),
+        record_names_ && pending_ == id ? &name : nullptr);
+}
+
+void CodePrinter::Visit(BooleanLiteral *literal)
+{
+    if (literal->pred())
+        Emit("true", 4);
+    else
+        Emit("false", 5);
+}
+
+void CodePrinter::Visit(RegExpLiteral *reg)
+{
+    std::string str;
+    str.reserve(reg->regex().length() + 8);
+    str.push_back('/');
+    str += reg->regex();
+    str.push_back('/');
+    for (auto flag : reg->flags()) {
+        switch (flag) {
+        case RegExpFlags::kGlobal:      str.push_back('g'); break;
+        case RegExpFlags::kUnicode:     str.push_back('u'); break;
+        case RegExpFlags::kIgnoreCase:  str.push_back('i'); break;
+        case RegExpFlags::kMultiline:   str.push_back('m'); break;
+        case RegExpFlags::kSticky:      str.push_back('y'); break;
+        }
+    }
+    Emit(str);
+}
+
+void CodePrinter::Visit(ArgumentList *args)
+{
+    Emit("(", 1);
+    PrintExpressionList(args->args().GetPtr());
+    Emit(")", 1);
+}
+
+void CodePrinter::Visit(CallExpression *expr)
+{
+    auto object = expr->expr();
+    auto member = expr->member();
+
+    if (object && object->IsIntegralLiteral())
+        PrintExpression(object, kForceParens);
+    else
+        PrintExpression(object, kMember);
+
+    switch (expr->kind()) {
+    case MemberAccessKind::kDot:
+        Emit(".", 1);
+        PrintExpression(member, kPrimary);
+        break;
+    case MemberAccessKind::kIndex:
+        Emit("[", 1);
+        PrintExpression(member, kComma);
+        Emit("]", 1);
+        break;
+    default:
+        if (member && member->IsArgumentList()) {
+            member->Accept(this);
+        } else {
+            Emit("(", 1);
+            PrintExpression(member, kAssign);
+            Emit(")", 1);
+        }
+    }
+}
+
+void CodePrinter::Visit(MemberExpression *expr)
+{
+    auto object = expr->expr();
+    auto member = expr->member();
+
+    if (object && object->IsIntegralLiteral())
+        PrintExpression(object, kForceParens);
+    else
+        PrintExpression(object, kMember);
+
+    switch (expr->kind()) {
+    case MemberAccessKind::kDot:
+        Emit(".", 1);
+        PrintExpression(member, kPrimary);
+        break;
+    case MemberAccessKind::kIndex:
+        Emit("[", 1);
+        PrintExpression(member, kComma);
+        Emit("]", 1);
+        break;
+    default:
+        if (member && member->IsArgumentList()) {
+            member->Accept(this);
+        } else {
+            Emit("(", 1);
+            PrintExpression(member, kAssign);
+            Emit(")", 1);
+        }
+    }
+}
+
+void CodePrinter::Visit(NewExpression *expr)
+{
+    Emit("new", 3);
+    Space();
+    auto member = expr->member();
+
+    // `new (f())` must keep its parentheses or the call becomes the arguments
+    if (member && member->IsCallExpression())
+        PrintExpression(member, kForceParens);
+    else
+        PrintExpression(member, kMember);
+}
+
+void CodePrinter::Visit(PrefixExpression *expr)
+{
+    switch (expr->op()) {
+    case PrefixOperation::kIncrement:   Emit("++", 2); break;
+    case PrefixOperation::kDecrement:   Emit("--", 2); break;
+    case PrefixOperation::kTypeOf:      Emit("typeof", 6); Space(); break;
+    case PrefixOperation::kDelete:      Emit("delete", 6); Space(); break;
+    case PrefixOperation::kVoid:        Emit("void", 4); Space(); break;
+    case PrefixOperation::kBitNot:      Emit("~", 1); break;
+    case PrefixOperation::kNot:         Emit("!", 1); break;
+    }
+    PrintExpression(expr->expr(), kUnary);
+}
+
+void CodePrinter::Visit(PostfixExpression *expr)
+{
+    PrintExpression(expr->expr(), kNew);
+    if (expr->op() == PostfixOperation::kIncrement)
+        Emit("++", 2);
+    else
+        Emit("--", 2);
+}
+
+void CodePrinter::Visit(BinaryExpression *expr)
+{
+    bool negate;
+    if (IsUnaryPlusOrMinus(expr, &negate)) {
+        Emit(negate ? "-" : "+", 1);
+        PrintExpression(expr->lhs(), kUnary);
+        return;
+    }
+
+    int precedence = BinaryPrecedence(expr->op());
+    PrintExpression(expr->lhs(), precedence);
+    Space();
+    Emit(BinaryOperatorString(expr->op()));
+    Space();
+    PrintExpression(expr->rhs(), precedence + 1);
+}
+
+void CodePrinter::Visit(AssignExpression *expr)
+{
+    PrintExpression(expr->lhs(), kNew);
+    Space();
+    Emit(AssignOperatorString(expr->op()));
+    Space();
+    PrintExpression(expr->rhs(), kAssign);
+}
+
+void CodePrinter::Visit(TernaryExpression *expr)
+{
+    PrintExpression(expr->first(), kLogicalOr);
+    Space();
+    Emit("?", 1);
+    Space();
+    PrintExpression(expr->second(), kAssign);
+    Space();
+    Emit(":", 1);
+    Space();
+    PrintExpression(expr->third(), kAssign);
+}
+
+void CodePrinter::Visit(CommaExpression *expr)
+{
+    PrintExpressionList(expr->exprs().GetPtr());
+}
+
+void CodePrinter::Visit(Declaration *decl)
+{
+    Emit(decl->name());
+    if (decl->expr()) {
+        Space();
+        Emit("=", 1);
+        Space();
+        PrintExpression(decl->expr(), kAssign);
+    }
+}
+
+void CodePrinter::Visit(DeclarationList *decl_list)
+{
+    Emit("var", 3);
+    Space();
+    bool first = true;
+    for (auto &decl : decl_list->exprs()) {
+        if (!first) {
+            Emit(",", 1);
+            Space();
+        }
+        first = false;
+        decl->Accept(this);
+    }
+}
+
+void CodePrinter::Visit(BlockStatement *stmt)
+{
+    auto list = stmt->statements();
+    Emit("{", 1);
+    if (list && list->Size()) {
+        indent_++;
+        Newline();
+        PrintStatementList(list.GetPtr());
+        indent_--;
+        Newline();
+    }
+    Emit("}", 1);
+}
+
+void CodePrinter::Visit(ForStatement *stmt)
+{
+    Emit("for", 3);
+    Space();
+    Emit("(", 1);
+
+    auto init = stmt->init();
+    if (stmt->kind() == ForKind::kForIn) {
+        if (init && init->IsBinaryExpression()) {
+            auto in = static_cast<BinaryExpression*>(init.GetPtr());
+            auto lhs = in->lhs();
+            if (lhs && lhs->IsDeclarationList()) {
+                lhs->Accept(this);
+            } else {
+                PrintExpression(lhs, kNew);
+            }
+            Space();
+            Emit("in", 2);
+            Space();
+            PrintExpression(in->rhs(), kComma);
+        } else {
+            PrintExpression(init, kComma);
+        }
+        Emit(")", 1);
+        PrintBlockBody(stmt->body().GetPtr());
+        return;
+    }
+
+    if (init && init->IsDeclarationList()) {
+        init->Accept(this);
+    } else if (init && !init->IsUndefinedLiteral()) {
+        PrintExpression(init, kComma);
+    }
+    Emit(";", 1);
+
+    if (stmt->condition()) {
+        Space();
+        PrintExpression(stmt->condition(), kComma);
+    }
+    Emit(";", 1);
+
+    auto update = stmt->update();
+    if (update && !update->IsUndefinedLiteral()) {
+        Space();
+        PrintExpression(update, kComma);
+    }
+    Emit(")", 1);
+    PrintBlockBody(stmt->body().GetPtr());
+}
+
+void CodePrinter::Visit(WhileStatement *stmt)
+{
+    Emit("while", 5);
+    Space();
+    Emit("(", 1);
+    PrintExpression(stmt->condition(), kComma);
+    Emit(")", 1);
+    PrintBlockBody(stmt->body().GetPtr());
+}
+
+void CodePrinter::Visit(DoWhileStatement *stmt)
+{
+    Emit("do", 2);
+    PrintBlockBody(stmt->body().GetPtr());
+    if (stmt->body() && stmt->body()->IsBlockStatement())
+        Space();
+    else
+        Newline();
+    Emit("while", 5);
+    Space();
+    Emit("(", 1);
+    PrintExpression(stmt->condition(), kComma);
+    Emit(")", 1);
+    Emit(";", 1);
+}
+
+void CodePrinter::Visit(BreakStatement *stmt)
+{
+    Emit("break", 5);
+    if (stmt->label()) {
+        Space();
+        PrintExpression(stmt->label(), kPrimary);
+    }
+    Emit(";", 1);
+}
+
+void CodePrinter::Visit(ContinueStatement *stmt)
+{
+    Emit("continue", 8);
+    if (stmt->label()) {
+        Space();
+        PrintExpression(stmt->label(), kPrimary);
+    }
+    Emit(";", 1);
+}
+
+void CodePrinter::Visit(ThrowStatement *stmt)
+{
+    Emit("throw", 5);
+    Space();
+    PrintExpression(stmt->expr(), kComma);
+    Emit(";", 1);
+}
+
+void CodePrinter::Visit(TryCatchStatement *stmt)
+{
+    Emit("try", 3);
+    Space();
+    PrintStatement(stmt->try_block());
+
+    if (stmt->catch_expr()) {
+        Space();
+        Emit("catch", 5);
+        Space();
+        Emit("(", 1);
+        PrintExpression(stmt->catch_expr(), kComma);
+        Emit(")", 1);
+        Space();
+        PrintStatement(stmt->catch_block());
+    }
+
+    if (stmt->finally()) {
+        Space();
+        Emit("finally", 7);
+        Space();
+        PrintStatement(stmt->finally());
+    }
+}
+
+void CodePrinter::Visit(LabelledStatement *stmt)
+{
+    Emit(stmt->label());
+    Emit(":", 1);
+}
+
+void CodePrinter::Visit(CaseClauseStatement *stmt)
+{
+    Emit("case", 4);
+    Space();
+    PrintExpression(stmt->clause(), kComma);
+    Emit(":", 1);
+
+    auto body = stmt->stmt();
+    indent_++;
+    if (body && body->IsBlockStatement()) {
+        auto list = static_cast<BlockStatement*>(body.GetPtr())->statements();
+        if (list && list->Size()) {
+            Newline();
+            PrintStatementList(list.GetPtr());
+        }
+    } else if (body) {
+        Newline();
+        PrintStatement(body);
+    }
+    indent_--;
+}
+
+void CodePrinter::Visit(SwitchStatement *stmt)
+{
+    Emit("switch", 6);
+    Space();
+    Emit("(", 1);
+    PrintExpression(stmt->expr(), kComma);
+    Emit(")", 1);
+    Space();
+    Emit("{", 1);
+    indent_++;
+
+    // case clauses sharing one body were written as `case a: case b: body`
+    auto clauses = stmt->clauses();
+    if (clauses) {
+        auto begin = clauses->begin(), end = clauses->end();
+        for (auto it = begin; it != end; ++it) {
+            auto &clause = *it;
+            auto next = it + 1;
+            bool shares_body = next != end
+                && (*next)->stmt().GetPtr() == clause->stmt().GetPtr();
+
+            Newline();
+            if (shares_body) {
+                Emit("case", 4);
+                Space();
+                PrintExpression(clause->clause(), kComma);
+                Emit(":", 1);
+            } else {
+                clause->Accept(this);
+            }
+        }
+    }
+
+    if (stmt->default_clause()) {
+        Newline();
+        Emit("default", 7);
+        Emit(":", 1);
+        auto def = stmt->default_clause();
+        indent_++;
+        if (def->IsBlockStatement()) {
+            auto list = static_cast<BlockStatement*>(def.GetPtr())->statements();
+            if (list && list->Size()) {
+                Newline();
+                PrintStatementList(list.GetPtr());
+            }
+        } else {
+            Newline();
+            PrintStatement(def);
+        }
+        indent_--;
+    }
+
+    indent_--;
+    Newline();
+    Emit("}", 1);
+}
+
+void CodePrinter::Visit(FunctionPrototype *proto)
+{
+    Emit("function", 8);
+    if (!proto->GetName().empty()) {
+        Space();
+        Emit(proto->GetName());
+    }
+    PrintParameters(proto);
+}
+
+void CodePrinter::PrintParameters(FunctionPrototype *proto)
+{
+    Emit("(", 1);
+    bool first = true;
+    for (auto &arg : proto->GetArgs()) {
+        if (!first) {
+            Emit(",", 1);
+            Space();
+        }
+        first = false;
+        Emit(arg);
+    }
+    Emit(")", 1);
+}
+
+void CodePrinter::Visit(FunctionStatement *stmt)
+{
+    auto proto = stmt->proto();
+    if (proto) {
+        proto->Accept(this);
+    } else {
+        Emit("function", 8);
+        Emit("(", 1);
+        Emit(")", 1);
+    }
+
+    Space();
+    PrintFunctionBody(stmt);
+}
+
+void CodePrinter::PrintFunctionBody(FunctionStatement *stmt)
+{
+    auto body = stmt->body();
+    if (body && body->IsBlockStatement()) {
+        PrintStatement(body);
+    } else {
+        Emit("{", 1);
+        PrintStatement(body);
+        Emit("}", 1);
+    }
+}
+
+void CodePrinter::Visit(IfStatement *stmt)
+{
+    Emit("if", 2);
+    Space();
+    Emit("(", 1);
+    PrintExpression(stmt->condition(), kComma);
+    Emit(")", 1);
+    PrintBlockBody(stmt->body().GetPtr());
+}
+
+void CodePrinter::Visit(IfElseStatement *stmt)
+{
+    Emit("if", 2);
+    Space();
+    Emit("(", 1);
+    PrintExpression(stmt->condition(), kComma);
+    Emit(")", 1);
+
+    auto body = stmt->body();
+    if (EndsWithIf(body.GetPtr())) {
+        Space();
+        Emit("{", 1);
+        PrintStatement(body);
+        Emit("}", 1);
+    } else {
+        PrintBlockBody(body.GetPtr());
+    }
+
+    if (body && (body->IsBlockStatement() || EndsWithIf(body.GetPtr())))
+        Space();
+    else
+        Newline();
+    Emit("else", 4);
+
+    auto els = stmt->els();
+    if (els && (els->IsIfStatement() || els->IsIfElseStatement())) {
+        Space();
+        PrintStatement(els);
+    } else {
+        PrintBlockBody(els.GetPtr());
+    }
+}
+
+void CodePrinter::Visit(ReturnStatement *stmt)
+{
+    Emit("return", 6);
+    if (stmt->expr()) {
+        Space();
+        PrintExpression(stmt->expr(), kComma);
+    }
+    Emit(";", 1);
+}
+
+}
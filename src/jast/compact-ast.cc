@@ -0,0 +1,116 @@
+#include "jast/compact-ast.h"
+#include "jast/ast-children.h"
+#include "jast/ast-cloner.h"
+#include "jast/ast-walker.h"
+
+#include <cassert>
+#include <cstdint>
+
+namespace jast {
+
+namespace {
+
+size_t Align(size_t size, size_t align)
+{
+    return (size + align - 1) & ~(align - 1);
+}
+
+// the alignment BlockSize() counts with, enough for every node and list
+const size_t kMaxAlign = alignof(std::max_align_t);
+
+// lets go of the children of a node, so that it holds no other node
+struct SlotClearer {
+    template <typename T>
+    void Slot(Handle<T> &slot) { slot = nullptr; }
+
+    template <typename T>
+    void List(std::vector<Handle<T>> &list) { list.clear(); }
+};
+
+class BlockSizeWalker : public ASTWalker {
+public:
+    size_t size = 0;
+
+protected:
+    bool Enter(Expression *expr) override
+    {
+        size += Align(SizeOfNode(expr->type()), kMaxAlign);
+        switch (expr->type()) {
+        case ASTNodeType::kArgumentList:
+        case ASTNodeType::kCommaExpression:
+        case ASTNodeType::kBlockStatement:
+            size += Align(sizeof(ExpressionList), kMaxAlign);
+            break;
+        case ASTNodeType::kSwitchStatement:
+            size += Align(sizeof(ClausesList), kMaxAlign);
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+};
+
+class ArenaFactory : public ASTFactory {
+public:
+    explicit ArenaFactory(NodeArena *arena)
+        : ASTFactory(arena)
+    { }
+};
+
+}
+
+NodeArena::NodeArena(size_t capacity)
+    : block_{ new char[capacity ? capacity : 1] }, capacity_{ capacity },
+      used_{ 0 }
+{ }
+
+NodeArena::~NodeArena()
+{
+    // the nodes first let go of their children, which may be on the heap,
+    // then nothing in the block holds anything but the lists of the nodes
+    for (auto &object : objects_) {
+        if (object.node)
+            VisitSlots(object.node, SlotClearer{});
+    }
+    for (auto &object : objects_) {
+        if (!object.node)
+            continue;
+        assert(object.node->GetNumReferences() == 1
+            && "a handle to a node of the arena outlives it");
+        object.node->~Expression();
+    }
+    for (auto &object : objects_) {
+        if (!object.node)
+            object.object->~RefCountObject();
+    }
+}
+
+void *NodeArena::Allocate(size_t size, size_t align)
+{
+    size_t offset = Align(used_, align);
+    if (offset + size > capacity_)
+        return nullptr;
+    used_ = offset + size;
+    return block_.get() + offset;
+}
+
+CompactAST::CompactAST(Handle<Expression> root)
+    : arena_{ BlockSize(root.GetPtr()) }
+{
+    ArenaFactory factory(&arena_);
+    root_ = ASTCloner(&factory).Clone(root.GetPtr());
+}
+
+// static
+size_t CompactAST::BlockSize(Expression *root)
+{
+    if (!root)
+        return 0;
+
+    BlockSizeWalker walker;
+    walker.Walk(root);
+    return walker.size;
+}
+
+}
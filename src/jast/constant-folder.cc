@@ -0,0 +1,698 @@
+#include "jast/constant-folder.h"
+#include "jast/ast-rewriter.h"
+#include "jast/astfactory.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace jast {
+
+namespace {
+
+using Kind = Constant::Kind;
+
+// an answer which may not be known
+enum class Tri {
+    kFalse,
+    kTrue,
+    kUnknown,
+};
+
+Tri Known(bool value)
+{
+    return value ? Tri::kTrue : Tri::kFalse;
+}
+
+// no escape sequence and ASCII only, the raw text is the value
+bool IsPlain(const std::string &raw)
+{
+    for (unsigned char ch : raw) {
+        if (ch == '\\' || ch >= 0x80)
+            return false;
+    }
+    return true;
+}
+
+// the ASCII ones of WhiteSpace and LineTerminator
+bool IsWhiteSpace(char ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\v'
+        || ch == '\f' || ch == '\r';
+}
+
+bool IsDigit(char ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+int DigitValue(char ch)
+{
+    if (IsDigit(ch))
+        return ch - '0';
+    if (ch >= 'a' && ch <= 'f')
+        return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F')
+        return ch - 'A' + 10;
+    return -1;
+}
+
+// StringToNumber, NaN where StringNumericLiteral doesn't match. false for
+// strings which need unescaping or may hold non-ASCII white space
+bool StringToNumber(const std::string &raw, double *result)
+{
+    if (!IsPlain(raw))
+        return false;
+
+    size_t begin = 0, end = raw.size();
+    while (begin < end && IsWhiteSpace(raw[begin]))
+        begin++;
+    while (end > begin && IsWhiteSpace(raw[end - 1]))
+        end--;
+    std::string str = raw.substr(begin, end - begin);
+    if (str.empty()) {
+        *result = 0;
+        return true;
+    }
+    *result = NAN;
+
+    if (str.size() > 2 && str[0] == '0') {
+        int base = 0;
+        switch (str[1]) {
+        case 'x': case 'X': base = 16; break;
+        case 'o': case 'O': base = 8; break;
+        case 'b': case 'B': base = 2; break;
+        }
+        if (base) {
+            double value = 0;
+            for (size_t i = 2; i < str.size(); i++) {
+                int digit = DigitValue(str[i]);
+                if (digit < 0 || digit >= base)
+                    return true;
+                value = value * base + digit;
+
+                // past 2^53 the sum isn't exact any more
+                if (value > 9007199254740992.0)
+                    return false;
+            }
+            *result = value;
+            return true;
+        }
+    }
+
+    size_t i = 0, n = str.size();
+    bool negative = false;
+    if (str[i] == '+' || str[i] == '-')
+        negative = str[i++] == '-';
+    if (str.compare(i, std::string::npos, "Infinity") == 0) {
+        *result = negative ? -INFINITY : INFINITY;
+        return true;
+    }
+
+    size_t digits = 0;
+    for (; i < n && IsDigit(str[i]); i++)
+        digits++;
+    if (i < n && str[i] == '.') {
+        for (i++; i < n && IsDigit(str[i]); i++)
+            digits++;
+    }
+    if (!digits)
+        return true;
+    if (i < n && (str[i] == 'e' || str[i] == 'E')) {
+        i++;
+        if (i < n && (str[i] == '+' || str[i] == '-'))
+            i++;
+        size_t exponent = 0;
+        for (; i < n && IsDigit(str[i]); i++)
+            exponent++;
+        if (!exponent)
+            return true;
+    }
+    if (i != n)
+        return true;
+
+    // the literal is validated, strtod rounds it correctly
+    *result = strtod(str.c_str(), nullptr);
+    return true;
+}
+
+uint32_t ToUint32(double value)
+{
+    if (!std::isfinite(value))
+        return 0;
+    double modulo = std::fmod(std::trunc(value), 4294967296.0);
+    if (modulo < 0)
+        modulo += 4294967296.0;
+    return (uint32_t)modulo;
+}
+
+int32_t ToInt32(double value)
+{
+    return (int32_t)ToUint32(value);
+}
+
+std::string ToString(const Constant &value)
+{
+    switch (value.kind()) {
+    case Kind::kUndefined:
+        return "undefined";
+    case Kind::kNull:
+        return "null";
+    case Kind::kBoolean:
+        return value.boolean() ? "true" : "false";
+    case Kind::kNumber:
+        return ConstantFolder::NumberToString(value.number());
+    default:
+        return value.string();
+    }
+}
+
+// the raw text of `lhs + rhs` is the two raw texts one after the other,
+// unless an escape at the end of `lhs` would take in the start of `rhs`:
+// "\1" + "2" isn't "\12", nor is "\<CR>" + "<LF>" one line continuation
+bool CanConcatenate(const std::string &lhs, const std::string &rhs)
+{
+    if (rhs.empty())
+        return true;
+
+    size_t i = 0;
+    while (i < lhs.size()) {
+        if (lhs[i++] != '\\')
+            continue;
+        if (i == lhs.size())
+            return false;
+
+        char ch = lhs[i];
+        if (ch >= '0' && ch <= '7') {
+            size_t start = i, longest = ch <= '3' ? 3 : 2;
+            while (i < lhs.size() && i - start < longest
+                && lhs[i] >= '0' && lhs[i] <= '7')
+                i++;
+            if (i == lhs.size() && i - start < longest)
+                return rhs[0] < '0' || rhs[0] > '7';
+        } else if (ch == '\r') {
+            if (++i == lhs.size())
+                return rhs[0] != '\n';
+        } else {
+            i++;
+        }
+    }
+    return true;
+}
+
+Tri StrictEquals(const Constant &lhs, const Constant &rhs)
+{
+    if (lhs.kind() != rhs.kind())
+        return Tri::kFalse;
+
+    switch (lhs.kind()) {
+    case Kind::kUndefined:
+    case Kind::kNull:
+        return Tri::kTrue;
+    case Kind::kBoolean:
+        return Known(lhs.boolean() == rhs.boolean());
+    case Kind::kNumber:
+        return Known(lhs.number() == rhs.number());
+    case Kind::kString:
+        // "\x41" is "A", different raw texts only differ if they are plain
+        if (lhs.string() == rhs.string())
+            return Tri::kTrue;
+        if (IsPlain(lhs.string()) && IsPlain(rhs.string()))
+            return Tri::kFalse;
+        return Tri::kUnknown;
+    default:
+        return Tri::kUnknown;
+    }
+}
+
+bool IsNullish(const Constant &value)
+{
+    return value.kind() == Kind::kUndefined || value.kind() == Kind::kNull;
+}
+
+Tri LooseEquals(const Constant &lhs, const Constant &rhs)
+{
+    if (lhs.kind() == rhs.kind())
+        return StrictEquals(lhs, rhs);
+    if (IsNullish(lhs) || IsNullish(rhs))
+        return Known(IsNullish(lhs) && IsNullish(rhs));
+
+    // booleans, numbers and strings of different types compare as numbers
+    double x, y;
+    if (!ConstantFolder::ToNumber(lhs, &x)
+        || !ConstantFolder::ToNumber(rhs, &y))
+        return Tri::kUnknown;
+    return Known(x == y);
+}
+
+// the Abstract Relational Comparison `lhs < rhs`, with NaN giving false as
+// `undefined` would. `undefined` is also returned in *nan, since `<=` and
+// `>=` are false for it instead of true
+Tri LessThan(const Constant &lhs, const Constant &rhs, bool *nan)
+{
+    *nan = false;
+    if (lhs.kind() == Kind::kString && rhs.kind() == Kind::kString) {
+        // code unit order is byte order for ASCII
+        if (!IsPlain(lhs.string()) || !IsPlain(rhs.string()))
+            return Tri::kUnknown;
+        return Known(lhs.string() < rhs.string());
+    }
+
+    double x, y;
+    if (!ConstantFolder::ToNumber(lhs, &x)
+        || !ConstantFolder::ToNumber(rhs, &y))
+        return Tri::kUnknown;
+    *nan = std::isnan(x) || std::isnan(y);
+    return Known(x < y);
+}
+
+Constant Comparison(BinaryOperation op, const Constant &lhs,
+    const Constant &rhs)
+{
+    bool nan;
+    Tri result;
+    switch (op) {
+    case BinaryOperation::kLessThan:
+        result = LessThan(lhs, rhs, &nan);
+        break;
+    case BinaryOperation::kGreaterThan:
+        result = LessThan(rhs, lhs, &nan);
+        break;
+    case BinaryOperation::kLessThanEqual:
+        result = LessThan(rhs, lhs, &nan);
+        if (result != Tri::kUnknown)
+            result = Known(result == Tri::kFalse && !nan);
+        break;
+    default:
+        result = LessThan(lhs, rhs, &nan);
+        if (result != Tri::kUnknown)
+            result = Known(result == Tri::kFalse && !nan);
+        break;
+    }
+    if (result == Tri::kUnknown)
+        return Constant();
+    return Constant::Boolean(result == Tri::kTrue);
+}
+
+Constant Equality(BinaryOperation op, const Constant &lhs,
+    const Constant &rhs)
+{
+    bool strict = op == BinaryOperation::kStrictEqual
+        || op == BinaryOperation::kStrictNotEqual;
+    bool negate = op == BinaryOperation::kNotEqual
+        || op == BinaryOperation::kStrictNotEqual;
+
+    Tri result = strict ? StrictEquals(lhs, rhs) : LooseEquals(lhs, rhs);
+    if (result == Tri::kUnknown)
+        return Constant();
+    return Constant::Boolean((result == Tri::kTrue) != negate);
+}
+
+Constant Arithmetic(BinaryOperation op, double x, double y)
+{
+    double result;
+    switch (op) {
+    case BinaryOperation::kAddition:
+        result = x + y;
+        break;
+    case BinaryOperation::kSubtraction:
+        result = x - y;
+        break;
+    case BinaryOperation::kMultiplication:
+        result = x * y;
+        break;
+    case BinaryOperation::kDivision:
+        result = x / y;
+        break;
+    case BinaryOperation::kMod:
+        // both take the sign of the dividend, -1 % 1 is -0
+        result = std::fmod(x, y);
+        break;
+    case BinaryOperation::kShiftLeft:
+        result = (int32_t)((uint32_t)ToInt32(x) << (ToUint32(y) & 31));
+        break;
+    case BinaryOperation::kShiftRight:
+        result = ToInt32(x) >> (ToUint32(y) & 31);
+        break;
+    case BinaryOperation::kShiftZeroRight:
+        result = ToUint32(x) >> (ToUint32(y) & 31);
+        break;
+    case BinaryOperation::kBitAnd:
+        result = ToInt32(x) & ToInt32(y);
+        break;
+    case BinaryOperation::kBitOr:
+        result = ToInt32(x) | ToInt32(y);
+        break;
+    default:
+        result = ToInt32(x) ^ ToInt32(y);
+        break;
+    }
+    return Constant::Number(result);
+}
+
+}
+
+Constant Constant::Boolean(bool value)
+{
+    Constant constant(Kind::kBoolean);
+    constant.boolean_ = value;
+    return constant;
+}
+
+Constant Constant::Number(double value)
+{
+    // NaN and the infinities have no literal
+    if (!std::isfinite(value))
+        return Constant();
+    Constant constant(Kind::kNumber);
+    constant.number_ = value;
+    return constant;
+}
+
+Constant Constant::String(std::string value)
+{
+    Constant constant(Kind::kString);
+    constant.string_ = std::move(value);
+    return constant;
+}
+
+// static
+Constant ConstantFolder::Evaluate(Expression *expr)
+{
+    if (!expr)
+        return Constant();
+
+    switch (expr->type()) {
+    case ASTNodeType::kUndefinedLiteral:
+        return Constant::Undefined();
+    case ASTNodeType::kNullLiteral:
+        return Constant::Null();
+    case ASTNodeType::kBooleanLiteral:
+        return Constant::Boolean(static_cast<BooleanLiteral*>(expr)->pred());
+    case ASTNodeType::kIntegralLiteral:
+        return Constant::Number(static_cast<IntegralLiteral*>(expr)->value());
+    case ASTNodeType::kStringLiteral:
+        return Constant::String(static_cast<StringLiteral*>(expr)->string());
+    default:
+        return Constant();
+    }
+}
+
+// static
+bool ConstantFolder::IsReference(Expression *expr)
+{
+    if (!expr)
+        return false;
+
+    // a call is a member or call expression of kind kCall
+    MemberAccessKind kind;
+    switch (expr->type()) {
+    case ASTNodeType::kIdentifier:
+        return true;
+    case ASTNodeType::kMemberExpression:
+        kind = static_cast<MemberExpression*>(expr)->kind();
+        break;
+    case ASTNodeType::kCallExpression:
+        kind = static_cast<CallExpression*>(expr)->kind();
+        break;
+    default:
+        return false;
+    }
+    return kind == MemberAccessKind::kDot || kind == MemberAccessKind::kIndex;
+}
+
+// static
+bool ConstantFolder::ToBoolean(const Constant &value, bool *result)
+{
+    switch (value.kind()) {
+    case Kind::kUndefined:
+    case Kind::kNull:
+        *result = false;
+        return true;
+    case Kind::kBoolean:
+        *result = value.boolean();
+        return true;
+    case Kind::kNumber:
+        *result = value.number() != 0 && !std::isnan(value.number());
+        return true;
+    case Kind::kString:
+        // only a line continuation, "\<LF>", is an escape standing for
+        // nothing. any other character makes the string non-empty
+        for (unsigned char ch : value.string()) {
+            if (ch != '\\' && ch != '\r' && ch != '\n' && ch < 0x80) {
+                *result = true;
+                return true;
+            }
+        }
+        *result = false;
+        return value.string().empty();
+    default:
+        return false;
+    }
+}
+
+// static
+bool ConstantFolder::ToNumber(const Constant &value, double *result)
+{
+    switch (value.kind()) {
+    case Kind::kUndefined:
+        *result = NAN;
+        return true;
+    case Kind::kNull:
+        *result = 0;
+        return true;
+    case Kind::kBoolean:
+        *result = value.boolean() ? 1 : 0;
+        return true;
+    case Kind::kNumber:
+        *result = value.number();
+        return true;
+    case Kind::kString:
+        return StringToNumber(value.string(), result);
+    default:
+        return false;
+    }
+}
+
+// static
+std::string ConstantFolder::NumberToString(double value)
+{
+    if (std::isnan(value))
+        return "NaN";
+    if (value == 0)
+        return "0";
+    if (std::isinf(value))
+        return value < 0 ? "-Infinity" : "Infinity";
+    if (value < 0)
+        return "-" + NumberToString(-value);
+
+    // the shortest d.ddde±x which reads back as `value`, 17 digits always do
+    char buf[32];
+    for (int precision = 1; precision <= 17; precision++) {
+        snprintf(buf, sizeof(buf), "%.*e", precision - 1, value);
+        if (strtod(buf, nullptr) == value)
+            break;
+    }
+
+    std::string digits;
+    const char *p = buf;
+    for (; *p != 'e'; p++) {
+        if (IsDigit(*p))
+            digits.push_back(*p);
+    }
+    while (digits.size() > 1 && digits.back() == '0')
+        digits.pop_back();
+
+    // value is 0.digits * 10^n, k digits
+    int n = atoi(p + 1) + 1;
+    int k = (int)digits.size();
+    if (k <= n && n <= 21)
+        return digits + std::string(n - k, '0');
+    if (0 < n && n <= 21)
+        return digits.substr(0, n) + "." + digits.substr(n);
+    if (-6 < n && n <= 0)
+        return "0." + std::string(-n, '0') + digits;
+
+    std::string exponent = n - 1 < 0 ? "e-" : "e+";
+    exponent += std::to_string(std::abs(n - 1));
+    if (k == 1)
+        return digits + exponent;
+    return digits.substr(0, 1) + "." + digits.substr(1) + exponent;
+}
+
+// static
+Constant ConstantFolder::Binary(BinaryOperation op, const Constant &lhs,
+    const Constant &rhs)
+{
+    if (!lhs || !rhs)
+        return Constant();
+
+    switch (op) {
+    case BinaryOperation::kAnd:
+    case BinaryOperation::kOr: {
+        bool truthy;
+        if (!ToBoolean(lhs, &truthy))
+            return Constant();
+        return truthy == (op == BinaryOperation::kAnd) ? rhs : lhs;
+    }
+    case BinaryOperation::kLessThan:
+    case BinaryOperation::kGreaterThan:
+    case BinaryOperation::kLessThanEqual:
+    case BinaryOperation::kGreaterThanEqual:
+        return Comparison(op, lhs, rhs);
+    case BinaryOperation::kEqual:
+    case BinaryOperation::kNotEqual:
+    case BinaryOperation::kStrictEqual:
+    case BinaryOperation::kStrictNotEqual:
+        return Equality(op, lhs, rhs);
+    case BinaryOperation::kInstanceOf:
+    case BinaryOperation::kIn:
+        // a TypeError on primitives
+        return Constant();
+    case BinaryOperation::kAddition:
+        if (lhs.kind() == Kind::kString || rhs.kind() == Kind::kString) {
+            auto x = ToString(lhs), y = ToString(rhs);
+            if (!CanConcatenate(x, y))
+                return Constant();
+            return Constant::String(x + y);
+        }
+        break;
+    default:
+        break;
+    }
+
+    double x, y;
+    if (!ToNumber(lhs, &x) || !ToNumber(rhs, &y))
+        return Constant();
+    return Arithmetic(op, x, y);
+}
+
+// static
+Constant ConstantFolder::Prefix(PrefixOperation op, const Constant &operand)
+{
+    if (!operand)
+        return Constant();
+
+    switch (op) {
+    case PrefixOperation::kTypeOf:
+        switch (operand.kind()) {
+        case Kind::kUndefined:
+            return Constant::String("undefined");
+        case Kind::kNull:
+            return Constant::String("object");
+        case Kind::kBoolean:
+            return Constant::String("boolean");
+        case Kind::kNumber:
+            return Constant::String("number");
+        default:
+            return Constant::String("string");
+        }
+    case PrefixOperation::kVoid:
+        return Constant::Undefined();
+    case PrefixOperation::kNot: {
+        bool truthy;
+        if (!ToBoolean(operand, &truthy))
+            return Constant();
+        return Constant::Boolean(!truthy);
+    }
+    case PrefixOperation::kBitNot: {
+        double value;
+        if (!ToNumber(operand, &value))
+            return Constant();
+        return Constant::Number(~ToInt32(value));
+    }
+    default:
+        // ++, -- and delete need a reference
+        return Constant();
+    }
+}
+
+namespace {
+
+class Folder : public ASTRewriter {
+public:
+    bool changed = false;
+
+protected:
+    Handle<Expression> Leave(Handle<Expression> expr) override
+    {
+        Handle<Expression> result = Fold(expr);
+        if (result.GetPtr() != expr.GetPtr())
+            changed = true;
+        return result;
+    }
+
+private:
+    Handle<Expression> Fold(Handle<Expression> expr)
+    {
+        bool truthy;
+        switch (expr->type()) {
+        case ASTNodeType::kPrefixExpression: {
+            auto prefix = static_cast<PrefixExpression*>(expr.GetPtr());
+            return NewConstant(expr, ConstantFolder::Prefix(prefix->op(),
+                ConstantFolder::Evaluate(prefix->expr().GetPtr())));
+        }
+        case ASTNodeType::kBinaryExpression: {
+            auto binary = static_cast<BinaryExpression*>(expr.GetPtr());
+            auto op = binary->op();
+            auto lhs = ConstantFolder::Evaluate(binary->lhs().GetPtr());
+            if ((op == BinaryOperation::kAnd || op == BinaryOperation::kOr)
+                    && ConstantFolder::ToBoolean(lhs, &truthy)) {
+                // as in ASTBuilder::NewBinaryExpression()
+                auto operand = truthy == (op == BinaryOperation::kAnd)
+                    ? binary->rhs() : binary->lhs();
+                return ConstantFolder::IsReference(operand.GetPtr())
+                    ? expr : operand;
+            }
+            return NewConstant(expr, ConstantFolder::Binary(op, lhs,
+                ConstantFolder::Evaluate(binary->rhs().GetPtr())));
+        }
+        case ASTNodeType::kTernaryExpression: {
+            auto ternary = static_cast<TernaryExpression*>(expr.GetPtr());
+            if (!ConstantFolder::ToBoolean(
+                    ConstantFolder::Evaluate(ternary->first().GetPtr()),
+                    &truthy))
+                return expr;
+            auto operand = truthy ? ternary->second() : ternary->third();
+            return ConstantFolder::IsReference(operand.GetPtr())
+                ? expr : operand;
+        }
+        default:
+            return expr;
+        }
+    }
+
+    // the literal of `value` in place of `expr`, `expr` if there is none
+    Handle<Expression> NewConstant(Handle<Expression> expr,
+        const Constant &value)
+    {
+        auto factory = ASTFactory::GetFactoryInstance();
+        Position loc = expr->loc();
+        Scope *scope = expr->GetScope();
+        switch (value.kind()) {
+        case Kind::kUndefined:
+            return factory->NewUndefinedLiteral(loc, scope);
+        case Kind::kNull:
+            return factory->NewNullLiteral(loc, scope);
+        case Kind::kBoolean:
+            return factory->NewBooleanLiteral(loc, scope, value.boolean());
+        case Kind::kNumber:
+            return factory->NewIntegralLiteral(loc, scope, value.number());
+        case Kind::kString:
+            return factory->NewStringLiteral(loc, scope, value.string());
+        default:
+            return expr;
+        }
+    }
+};
+
+}
+
+bool ConstantFoldingPass::Run(Handle<Expression> &root)
+{
+    Folder folder;
+    root = folder.Rewrite(root);
+    return folder.changed;
+}
+
+}
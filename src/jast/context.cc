@@ -2,18 +2,69 @@
 #include "jast/scope.h"
 
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
 
 namespace jast {
 
+namespace {
+
+// ScopePool ::= scopes in chunks of kChunkSize, handed out in order and all
+// destroyed at once. the chunks stay for the scopes of the next input
+class ScopePool {
+public:
+    static const size_t kChunkSize = 64;
+
+    ScopePool()
+        : used_{ 0 }
+    { }
+
+    ~ScopePool()
+    {
+        Clear();
+    }
+
+    Scope *New(Expression *root, Scope *parent, Scope::Kind kind)
+    {
+        if (used_ == chunks_.size() * kChunkSize)
+            chunks_.push_back(std::make_unique<Storage[]>(kChunkSize));
+        void *memory = &chunks_[used_ / kChunkSize][used_ % kChunkSize];
+        used_++;
+        return new (memory) Scope(root, parent, kind);
+    }
+
+    void Clear()
+    {
+        for (size_t i = 0; i < used_; i++) {
+            auto &memory = chunks_[i / kChunkSize][i % kChunkSize];
+            reinterpret_cast<Scope*>(&memory)->~Scope();
+        }
+        used_ = 0;
+    }
+
+private:
+    using Storage = std::aligned_storage<sizeof(Scope), alignof(Scope)>::type;
+
+    std::vector<std::unique_ptr<Storage[]>> chunks_;
+    size_t used_;
+};
+
+}
+
 class ParserContextImpl {
 public:
     ParserContextImpl()
-        : global_scope_{ std::make_unique<Scope>(nullptr, nullptr) }
+        : global_scope_{ std::make_unique<Scope>(nullptr, nullptr,
+            Scope::Kind::kGlobal) }
     { }
 
     Scope *global_scope() { return global_scope_.get(); }
+
+    ScopePool &scopes() { return scopes_; }
 private:
     std::unique_ptr<Scope> global_scope_;
+    ScopePool scopes_;
 };
 
 ParserContext::ParserContext()
@@ -29,6 +80,17 @@ Scope *ParserContext::GetGlobalScope() {
     return impl_->global_scope();
 }
 
+Scope *ParserContext::NewScope(Expression *root, Scope *parent,
+    Scope::Kind kind)
+{
+    return impl_->scopes().New(root, parent, kind);
+}
+
+void ParserContext::ReleaseScopes()
+{
+    impl_->scopes().Clear();
+}
+
 Statistics &ParserContext::Counters() {
     return statistics_;
 }
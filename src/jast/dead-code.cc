@@ -0,0 +1,289 @@
+#include "jast/dead-code.h"
+#include "jast/ast-walker.h"
+#include "jast/astfactory.h"
+#include "jast/constant-folder.h"
+#include "jast/statement.h"
+
+namespace jast {
+
+namespace {
+
+// finds the declarations hoisted out of a statement, not those of the
+// functions in it
+class DeclarationFinder : public ASTWalker {
+public:
+    bool found = false;
+
+protected:
+    bool Enter(Expression *expr) override
+    {
+        if (found)
+            return false;
+
+        switch (expr->type()) {
+        case ASTNodeType::kDeclarationList:
+            found = true;
+            return false;
+        case ASTNodeType::kFunctionStatement:
+            // a named function expression is taken for a declaration too
+            found = !static_cast<FunctionStatement*>(expr)->proto()
+                ->GetName().empty();
+            return false;
+        default:
+            return true;
+        }
+    }
+};
+
+bool Declares(Expression *stmt)
+{
+    DeclarationFinder finder;
+    finder.Walk(stmt);
+    return finder.found;
+}
+
+// operators nested deeper than this aren't evaluated, tests are short
+const int kMaxDepth = 32;
+
+Constant Evaluate(Expression *expr, int depth = 0)
+{
+    if (!expr || depth > kMaxDepth)
+        return Constant();
+
+    switch (expr->type()) {
+    case ASTNodeType::kPrefixExpression: {
+        auto prefix = static_cast<PrefixExpression*>(expr);
+        return ConstantFolder::Prefix(prefix->op(),
+            Evaluate(prefix->expr().GetPtr(), depth + 1));
+    }
+    case ASTNodeType::kBinaryExpression: {
+        auto binary = static_cast<BinaryExpression*>(expr);
+        auto op = binary->op();
+        Constant lhs = Evaluate(binary->lhs().GetPtr(), depth + 1);
+        if (op != BinaryOperation::kAnd && op != BinaryOperation::kOr) {
+            return ConstantFolder::Binary(op, lhs,
+                Evaluate(binary->rhs().GetPtr(), depth + 1));
+        }
+
+        // the rhs doesn't have to be a constant when it isn't evaluated
+        bool truthy;
+        if (!ConstantFolder::ToBoolean(lhs, &truthy))
+            return Constant();
+        if (truthy != (op == BinaryOperation::kAnd))
+            return lhs;
+        return Evaluate(binary->rhs().GetPtr(), depth + 1);
+    }
+    case ASTNodeType::kTernaryExpression: {
+        auto ternary = static_cast<TernaryExpression*>(expr);
+        bool truthy;
+        if (!ConstantFolder::ToBoolean(
+                Evaluate(ternary->first().GetPtr(), depth + 1), &truthy))
+            return Constant();
+        return Evaluate(truthy ? ternary->second().GetPtr()
+                               : ternary->third().GetPtr(), depth + 1);
+    }
+    default:
+        return ConstantFolder::Evaluate(expr);
+    }
+}
+
+// the truth of a constant test, false if it isn't one
+bool Test(Handle<Expression> condition, bool *result)
+{
+    return ConstantFolder::ToBoolean(Evaluate(condition.GetPtr()), result);
+}
+
+bool IsEmpty(Expression *stmt)
+{
+    if (!stmt)
+        return false;
+    if (stmt->IsUndefinedLiteral())
+        return true;
+    if (!stmt->IsBlockStatement())
+        return false;
+
+    auto list = static_cast<BlockStatement*>(stmt)->statements();
+    return !list || !list->Size();
+}
+
+// a block whose braces can go when it is in another block, it declares
+// nothing which would move to the outer one
+bool IsNestedBlock(Expression *stmt)
+{
+    if (!stmt || !stmt->IsBlockStatement())
+        return false;
+
+    auto list = static_cast<BlockStatement*>(stmt)->statements();
+    if (!list)
+        return false;
+    for (auto &inner : *list) {
+        if (inner && (inner->IsDeclarationList()
+                || inner->IsFunctionStatement()))
+            return false;
+    }
+    return true;
+}
+
+bool FollowsLabel(const std::vector<Handle<Expression>> &stmts, size_t i)
+{
+    return i && stmts[i - 1] && stmts[i - 1]->IsLabelledStatement();
+}
+
+// true if `stmt` never completes normally. a statement after a label can,
+// by breaking to the label
+bool Ends(Expression *stmt)
+{
+    if (!stmt)
+        return false;
+
+    switch (stmt->type()) {
+    case ASTNodeType::kReturnStatement:
+    case ASTNodeType::kThrowStatement:
+    case ASTNodeType::kBreakStatement:
+    case ASTNodeType::kContinueStatement:
+        return true;
+    case ASTNodeType::kIfElseStatement: {
+        auto branch = static_cast<IfElseStatement*>(stmt);
+        return Ends(branch->body().GetPtr()) && Ends(branch->els().GetPtr());
+    }
+    case ASTNodeType::kBlockStatement: {
+        auto list = static_cast<BlockStatement*>(stmt)->statements();
+        if (!list)
+            return false;
+        auto &stmts = list->raw_list();
+        for (size_t i = 0; i < stmts.size(); i++) {
+            if (!FollowsLabel(stmts, i) && Ends(stmts[i].GetPtr()))
+                return true;
+        }
+        return false;
+    }
+    default:
+        return false;
+    }
+}
+
+}
+
+Handle<Expression> DeadBranchElimination::RewriteStatement(
+    Handle<Expression> stmt)
+{
+    bool taken;
+    switch (stmt->type()) {
+    case ASTNodeType::kIfStatement: {
+        auto branch = static_cast<IfStatement*>(stmt.GetPtr());
+        if (!Test(branch->condition(), &taken))
+            return stmt;
+        if (taken)
+            return branch->body();
+        return Declares(branch->body().GetPtr()) ? stmt : nullptr;
+    }
+    case ASTNodeType::kIfElseStatement: {
+        auto branch = static_cast<IfElseStatement*>(stmt.GetPtr());
+        if (!Test(branch->condition(), &taken))
+            return stmt;
+        auto dead = taken ? branch->els() : branch->body();
+        if (Declares(dead.GetPtr()))
+            return stmt;
+        return taken ? branch->body() : branch->els();
+    }
+    default:
+        return stmt;
+    }
+}
+
+bool UnreachableCodeElimination::RewriteBlock(
+    std::vector<Handle<Expression>> &stmts)
+{
+    size_t end = 0;
+    while (end < stmts.size()
+            && (FollowsLabel(stmts, end) || !Ends(stmts[end].GetPtr())))
+        end++;
+    if (end + 1 >= stmts.size())
+        return false;
+
+    size_t kept = end + 1;
+    for (size_t i = end + 1; i < stmts.size(); i++) {
+        if (stmts[i] && Declares(stmts[i].GetPtr()))
+            stmts[kept++] = stmts[i];
+    }
+    if (kept == stmts.size())
+        return false;
+    stmts.resize(kept);
+    return true;
+}
+
+Handle<Expression> EmptyBlockElimination::RewriteStatement(
+    Handle<Expression> stmt)
+{
+    if (!stmt->IsIfElseStatement())
+        return stmt;
+
+    auto branch = static_cast<IfElseStatement*>(stmt.GetPtr());
+    if (!IsEmpty(branch->els().GetPtr()))
+        return stmt;
+
+    Position loc = stmt->loc();
+    return ASTFactory::GetFactoryInstance()->NewIfStatement(loc,
+        stmt->GetScope(), branch->condition(), branch->body());
+}
+
+bool EmptyBlockElimination::RewriteBlock(
+    std::vector<Handle<Expression>> &stmts)
+{
+    bool nested = false;
+    size_t kept = 0;
+    for (size_t i = 0; i < stmts.size(); i++) {
+        // a label has to be followed by its statement
+        if (FollowsLabel(stmts, i)) {
+            stmts[kept++] = stmts[i];
+            continue;
+        }
+        if (IsEmpty(stmts[i].GetPtr()))
+            continue;
+        nested |= IsNestedBlock(stmts[i].GetPtr());
+        stmts[kept++] = stmts[i];
+    }
+    bool changed = kept != stmts.size();
+    stmts.resize(kept);
+    if (!nested)
+        return changed;
+
+    // bottom up, so the nested block has no block to open in it
+    std::vector<Handle<Expression>> flat;
+    flat.reserve(stmts.size());
+    for (size_t i = 0; i < stmts.size(); i++) {
+        if (FollowsLabel(stmts, i) || !IsNestedBlock(stmts[i].GetPtr())) {
+            flat.push_back(stmts[i]);
+            continue;
+        }
+        auto list = static_cast<BlockStatement*>(stmts[i].GetPtr())
+            ->statements();
+        flat.insert(flat.end(), list->begin(), list->end());
+    }
+    stmts.swap(flat);
+    return true;
+}
+
+Handle<Expression> DeadLoopElimination::RewriteStatement(
+    Handle<Expression> stmt)
+{
+    if (!stmt->IsWhileStatement())
+        return stmt;
+
+    auto loop = static_cast<WhileStatement*>(stmt.GetPtr());
+    bool taken;
+    if (!Test(loop->condition(), &taken) || taken
+            || Declares(loop->body().GetPtr()))
+        return stmt;
+    return nullptr;
+}
+
+void AddDeadCodePasses(PassManager *manager)
+{
+    manager->Add<DeadLoopElimination>();
+    manager->Add<DeadBranchElimination>();
+    manager->Add<UnreachableCodeElimination>();
+    manager->Add<EmptyBlockElimination>();
+}
+
+}
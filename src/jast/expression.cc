@@ -1,8 +1,163 @@
 #include "jast/expression.h"
 #include "jast/astvisitor.h"
+#include "jast/statement.h"
+
+#include <cstring>
+#include <functional>
 
 namespace jast {
 
+namespace {
+
+int HexDigit(char ch)
+{
+    if (ch >= '0' && ch <= '9')
+        return ch - '0';
+    if (ch >= 'a' && ch <= 'f')
+        return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F')
+        return ch - 'A' + 10;
+    return -1;
+}
+
+// the value of the `count` hex digits at `i`, -1 if they aren't
+long ReadHex(const std::string &raw, size_t i, size_t count)
+{
+    if (i + count > raw.size())
+        return -1;
+    long value = 0;
+    for (size_t k = i; k < i + count; k++) {
+        int digit = HexDigit(raw[k]);
+        if (digit < 0)
+            return -1;
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+void AppendUtf8(std::string &out, unsigned long cp)
+{
+    if (cp < 0x80) {
+        out.push_back((char)cp);
+    } else if (cp < 0x800) {
+        out.push_back((char)(0xc0 | (cp >> 6)));
+        out.push_back((char)(0x80 | (cp & 0x3f)));
+    } else if (cp < 0x10000) {
+        out.push_back((char)(0xe0 | (cp >> 12)));
+        out.push_back((char)(0x80 | ((cp >> 6) & 0x3f)));
+        out.push_back((char)(0x80 | (cp & 0x3f)));
+    } else {
+        out.push_back((char)(0xf0 | (cp >> 18)));
+        out.push_back((char)(0x80 | ((cp >> 12) & 0x3f)));
+        out.push_back((char)(0x80 | ((cp >> 6) & 0x3f)));
+        out.push_back((char)(0x80 | (cp & 0x3f)));
+    }
+}
+
+// the code unit of the \u escape at `i`, which is past the `u`, and the
+// index after it. -1 if it isn't one
+long ReadUnicodeEscape(const std::string &raw, size_t &i)
+{
+    if (i < raw.size() && raw[i] == '{') {
+        size_t end = raw.find('}', i);
+        if (end == std::string::npos || end == i + 1 || end - i - 1 > 6)
+            return -1;
+        long cp = ReadHex(raw, i + 1, end - i - 1);
+        if (cp < 0 || cp > 0x10ffff)
+            return -1;
+        i = end + 1;
+        return cp;
+    }
+    long unit = ReadHex(raw, i, 4);
+    if (unit >= 0)
+        i += 4;
+    return unit;
+}
+
+// the string the raw text of a string literal stands for, as UTF-8. a
+// malformed escape is kept as it was written
+std::string Unescape(const std::string &raw)
+{
+    std::string out;
+    out.reserve(raw.size());
+    size_t i = 0;
+    while (i < raw.size()) {
+        size_t escape = raw.find('\\', i);
+        if (escape == std::string::npos || escape + 1 == raw.size()) {
+            out.append(raw, i, std::string::npos);
+            break;
+        }
+        out.append(raw, i, escape - i);
+        i = escape + 2;
+
+        char ch = raw[escape + 1];
+        switch (ch) {
+        case 'n': out.push_back('\n'); break;
+        case 't': out.push_back('\t'); break;
+        case 'r': out.push_back('\r'); break;
+        case 'b': out.push_back('\b'); break;
+        case 'f': out.push_back('\f'); break;
+        case 'v': out.push_back('\v'); break;
+        case '\r':
+            // a line continuation is nothing
+            if (i < raw.size() && raw[i] == '\n')
+                i++;
+            break;
+        case '\n':
+            break;
+        case 'x': {
+            long value = ReadHex(raw, i, 2);
+            if (value < 0) {
+                out.append(raw, escape, 2);
+                break;
+            }
+            AppendUtf8(out, value);
+            i += 2;
+            break;
+        }
+        case 'u': {
+            long unit = ReadUnicodeEscape(raw, i);
+            if (unit < 0) {
+                out.append(raw, escape, 2);
+                break;
+            }
+            // a surrogate pair is one code point
+            if (unit >= 0xd800 && unit < 0xdc00 && i + 1 < raw.size()
+                    && raw[i] == '\\' && raw[i + 1] == 'u') {
+                size_t next = i + 2;
+                long low = ReadUnicodeEscape(raw, next);
+                if (low >= 0xdc00 && low < 0xe000) {
+                    unit = 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00);
+                    i = next;
+                }
+            }
+            AppendUtf8(out, unit);
+            break;
+        }
+        default:
+            if (ch == '\xe2' && i + 1 < raw.size() && raw[i] == '\x80'
+                    && (raw[i + 1] == '\xa8' || raw[i + 1] == '\xa9')) {
+                // a line continuation with U+2028 or U+2029 is nothing too
+                i += 2;
+            } else if (ch >= '0' && ch <= '7') {
+                // \0, and the legacy octal escapes up to \377
+                unsigned value = ch - '0';
+                size_t max = ch <= '3' ? 2 : 1;
+                for (size_t k = 0; k < max && i < raw.size()
+                        && raw[i] >= '0' && raw[i] <= '7'; k++)
+                    value = value * 8 + (raw[i++] - '0');
+                AppendUtf8(out, value);
+            } else {
+                out.push_back(ch);
+            }
+            break;
+        }
+    }
+    return out;
+}
+
+}
+
 #define DEFINE_ACCEPT(type) \
 void type::Accept(ASTVisitor *v)    \
 {   \
@@ -19,4 +174,180 @@ AST_NODE_LIST(AS_STRING)
 #undef AS_STRING
 };
 
-} // namespace jast
\ No newline at end of file
+size_t SizeOfNode(ASTNodeType type)
+{
+    switch (type) {
+#define SIZE_OF(Type) case ASTNodeType::k##Type: return sizeof(Type);
+AST_NODE_LIST(SIZE_OF)
+#undef SIZE_OF
+    default:
+        return 0;
+    }
+}
+
+void ProxyObject::Append(std::string name, Handle<Expression> value,
+    PropertyKind kind)
+{
+    auto capacity = props_.capacity();
+    auto kinds_capacity = kinds_.capacity();
+    size_t bytes = AllocationProfiler::StringBytes(name);
+    props_.emplace_back(std::move(name), value);
+    if (props_.capacity() != capacity)
+        bytes += props_.capacity() * sizeof(value_type);
+
+    if (kind != PropertyKind::kValue && kinds_.empty())
+        kinds_.resize(props_.size() - 1, PropertyKind::kValue);
+    if (!kinds_.empty() || kind != PropertyKind::kValue)
+        kinds_.push_back(kind);
+    if (kinds_.capacity() != kinds_capacity)
+        bytes += kinds_.capacity() * sizeof(PropertyKind);
+    if (bytes)
+        AllocationProfiler::OnContainer(AllocationContainer::kProxyObject, bytes);
+
+    if (!index_.empty())
+        Index(static_cast<uint32_t>(props_.size() - 1));
+}
+
+void ProxyObject::Reserve(size_t size)
+{
+    if (size <= props_.capacity())
+        return;
+    props_.reserve(size);
+    AllocationProfiler::OnContainer(AllocationContainer::kProxyObject,
+        props_.capacity() * sizeof(value_type));
+}
+
+ProxyObject::value_type *ProxyObject::Find(const std::string &name)
+{
+    if (props_.size() < kIndexedSize) {
+        for (size_t i = props_.size(); i > 0; i--) {
+            if (props_[i - 1].first == name)
+                return &props_[i - 1];
+        }
+        return nullptr;
+    }
+
+    if (index_.empty())
+        BuildIndex();
+    uint32_t position = *Bucket(name);
+    return position ? &props_[position - 1] : nullptr;
+}
+
+uint32_t *ProxyObject::Bucket(const std::string &name)
+{
+    size_t mask = index_.size() - 1;
+    size_t i = std::hash<std::string>()(name) & mask;
+    while (index_[i] && props_[index_[i] - 1].first != name)
+        i = (i + 1) & mask;
+    return &index_[i];
+}
+
+void ProxyObject::Index(uint32_t position)
+{
+    // at most half full
+    if (2 * props_.size() > index_.size()) {
+        BuildIndex();
+        return;
+    }
+    // a later property of the same name takes the bucket
+    *Bucket(props_[position].first) = position + 1;
+}
+
+void ProxyObject::BuildIndex()
+{
+    size_t buckets = 2 * kIndexedSize;
+    while (buckets < 2 * props_.size())
+        buckets *= 2;
+    index_.assign(buckets, 0);
+    for (uint32_t i = 0; i < props_.size(); i++)
+        *Bucket(props_[i].first) = i + 1;
+}
+
+void PackedArray::Append(double value, const Position &loc)
+{
+    AppendPosition(loc);
+    assert(kind_ == Kind::kNumber);
+    auto capacity = numbers_.capacity();
+    numbers_.push_back(value);
+    if (numbers_.capacity() != capacity) {
+        AllocationProfiler::OnContainer(AllocationContainer::kPackedArray,
+            numbers_.capacity() * sizeof(double));
+    }
+}
+
+void PackedArray::Append(const std::string &value, const Position &loc)
+{
+    AppendPosition(loc);
+    assert(kind_ == Kind::kString);
+    auto capacity = ends_.capacity();
+    auto bytes = strings_.capacity();
+    strings_ += value;
+    ends_.push_back(static_cast<uint32_t>(strings_.size()));
+
+    size_t grown = 0;
+    if (ends_.capacity() != capacity)
+        grown += ends_.capacity() * sizeof(uint32_t);
+    if (strings_.capacity() != bytes)
+        grown += AllocationProfiler::StringBytes(strings_);
+    if (grown)
+        AllocationProfiler::OnContainer(AllocationContainer::kPackedArray, grown);
+}
+
+void PackedArray::AppendPosition(const Position &loc)
+{
+    auto capacity = locs_.capacity();
+    locs_.push_back(Loc{ static_cast<uint32_t>(loc.col()),
+        static_cast<uint32_t>(loc.row()) });
+    if (locs_.capacity() != capacity) {
+        AllocationProfiler::OnContainer(AllocationContainer::kPackedArray,
+            locs_.capacity() * sizeof(Loc));
+    }
+}
+
+size_t PackedArray::OwnedBytes() const
+{
+    return numbers_.capacity() * sizeof(double)
+        + AllocationProfiler::StringBytes(strings_)
+        + ends_.capacity() * sizeof(uint32_t)
+        + locs_.capacity() * sizeof(Loc);
+}
+
+bool PackedArray::operator==(const PackedArray &other) const
+{
+    if (kind_ != other.kind_)
+        return false;
+    if (kind_ == Kind::kString)
+        return ends_ == other.ends_ && strings_ == other.strings_;
+    return numbers_.size() == other.numbers_.size()
+        && (numbers_.empty() || !memcmp(numbers_.data(),
+            other.numbers_.data(), numbers_.size() * sizeof(double)));
+}
+
+const std::string &StringLiteral::value() const
+{
+    auto value = value_.load(std::memory_order_acquire);
+    if (value)
+        return *value;
+
+    if (str_.find('\\') == std::string::npos) {
+        value_.store(&str_, std::memory_order_release);
+        return str_;
+    }
+
+    std::unique_ptr<std::string> decoded(new std::string(Unescape(str_)));
+    if (!value_.compare_exchange_strong(value, decoded.get(),
+            std::memory_order_acq_rel, std::memory_order_acquire)) {
+        // another thread was first
+        return *value;
+    }
+    decoded_ = std::move(decoded);
+    return *decoded_;
+}
+
+void StringLiteral::ResetValue()
+{
+    value_.store(nullptr, std::memory_order_relaxed);
+    decoded_.reset();
+}
+
+} // namespace jast
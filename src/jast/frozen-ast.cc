@@ -0,0 +1,60 @@
+#include "jast/frozen-ast.h"
+#include "jast/ast-children.h"
+
+namespace jast {
+
+// static
+std::shared_ptr<const FrozenAST> FrozenAST::Freeze(Handle<Expression> root)
+{
+    return std::make_shared<const FrozenAST>(root);
+}
+
+FrozenAST::FrozenAST(Handle<Expression> root)
+    : root_{ root }
+{
+    if (!root_)
+        return;
+
+    // preorder with an explicit stack, the children are pushed last to first
+    struct Pending {
+        Expression *node;
+        uint32_t parent;
+    };
+    std::vector<Pending> stack{ Pending{ root_.GetPtr(), NodeRef::kNone } };
+    std::vector<Expression*> children;
+
+    while (!stack.empty()) {
+        Pending pending = stack.back();
+        stack.pop_back();
+
+        uint32_t index = (uint32_t)entries_.size();
+        entries_.push_back(Entry{ pending.node, pending.parent, 1, 0, 0 });
+        if (pending.parent != NodeRef::kNone)
+            entries_[pending.parent].children++;
+
+        children.clear();
+        ForEachChild(pending.node, [&children](Expression *child) {
+            children.push_back(child);
+        });
+        for (auto it = children.rbegin(); it != children.rend(); ++it)
+            stack.push_back(Pending{ *it, index });
+    }
+
+    // the children of a node come after it and in source order, so they are
+    // found in order by a single pass. subtree sizes add up from the end
+    uint32_t offset = 0;
+    for (auto &entry : entries_) {
+        entry.first_child = offset;
+        offset += entry.children;
+        entry.children = 0;
+    }
+    children_.resize(offset);
+    for (uint32_t i = 1; i < entries_.size(); i++) {
+        auto &parent = entries_[entries_[i].parent];
+        children_[parent.first_child + parent.children++] = i;
+    }
+    for (uint32_t i = (uint32_t)entries_.size() - 1; i > 0; i--)
+        entries_[entries_[i].parent].subtree_size += entries_[i].subtree_size;
+}
+
+}
@@ -0,0 +1,364 @@
+#include "jast/hash-cons.h"
+#include "jast/statement.h"
+#include "jast/utils.h"
+
+#include <cstring>
+#include <functional>
+
+namespace jast {
+
+namespace {
+
+inline uint64_t HashString(const std::string &str)
+{
+    return std::hash<std::string>()(str);
+}
+
+// bitwise, 0 and -0 are different literals
+inline uint64_t HashNumber(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline uint64_t HashChild(const Handle<Expression> &child)
+{
+    return (uint64_t)(uintptr_t)child.GetPtr();
+}
+
+inline uint64_t HashList(uint64_t seed, ExpressionList *list)
+{
+    if (!list)
+        return HashCombine(seed, 0);
+
+    seed = HashCombine(seed, list->Size() + 1);
+    for (auto &expr : *list)
+        seed = HashCombine(seed, HashChild(expr));
+    return seed;
+}
+
+inline bool EqualList(ExpressionList *a, ExpressionList *b)
+{
+    if (!a || !b)
+        return a == b;
+    return a->raw_list() == b->raw_list();
+}
+
+}
+
+HashConsTable::HashConsTable()
+    : nodes_{ 0 }, hits_{ 0 }, saved_bytes_{ 0 }
+{ }
+
+HashConsTable::~HashConsTable()
+{ }
+
+bool HashConsTable::IsShareable(ASTNodeType type)
+{
+    switch (type) {
+    case ASTNodeType::kNullLiteral:
+    case ASTNodeType::kUndefinedLiteral:
+    case ASTNodeType::kThisHolder:
+    case ASTNodeType::kIntegralLiteral:
+    case ASTNodeType::kStringLiteral:
+    case ASTNodeType::kTemplateLiteral:
+    case ASTNodeType::kArrayLiteral:
+    case ASTNodeType::kObjectLiteral:
+    case ASTNodeType::kIdentifier:
+    case ASTNodeType::kBooleanLiteral:
+    case ASTNodeType::kRegExpLiteral:
+    case ASTNodeType::kArgumentList:
+    case ASTNodeType::kCallExpression:
+    case ASTNodeType::kMemberExpression:
+    case ASTNodeType::kNewExpression:
+    case ASTNodeType::kPrefixExpression:
+    case ASTNodeType::kPostfixExpression:
+    case ASTNodeType::kBinaryExpression:
+    case ASTNodeType::kAssignExpression:
+    case ASTNodeType::kTernaryExpression:
+    case ASTNodeType::kCommaExpression:
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint64_t HashConsTable::HashNode(Expression *expr) const
+{
+    uint64_t h = HashMix((uint64_t)expr->type() + 1);
+    h = HashCombine(h, (uint64_t)(uintptr_t)expr->GetScope());
+
+    switch (expr->type()) {
+    case ASTNodeType::kIntegralLiteral:
+        return HashCombine(h, HashNumber(expr->AsIntegralLiteral()->value()));
+
+    case ASTNodeType::kStringLiteral:
+        return HashCombine(h, HashString(expr->AsStringLiteral()->string()));
+
+    case ASTNodeType::kTemplateLiteral:
+        return HashCombine(h,
+            HashString(expr->AsTemplateLiteral()->template_string()));
+
+    case ASTNodeType::kArrayLiteral: {
+        auto literal = expr->AsArrayLiteral();
+        if (auto packed = literal->packed()) {
+            for (size_t i = 0; i < packed->size(); i++) {
+                h = HashCombine(h,
+                    packed->kind() == PackedArray::Kind::kNumber
+                    ? HashNumber(packed->number(i))
+                    : HashString(packed->string(i)));
+            }
+            return h;
+        }
+        for (auto &e : literal->exprs())
+            h = HashCombine(h, HashChild(e));
+        return h;
+    }
+
+    case ASTNodeType::kObjectLiteral: {
+        auto &props = expr->AsObjectLiteral()->proxy();
+        for (size_t i = 0; i < props.size(); i++) {
+            h = HashCombine(h, HashString(props[i].first));
+            h = HashCombine(h, (uint64_t)props.kind(i));
+            h = HashCombine(h, HashChild(props[i].second));
+        }
+        return h;
+    }
+
+    case ASTNodeType::kIdentifier:
+        return HashCombine(h, HashString(expr->AsIdentifier()->GetName()));
+
+    case ASTNodeType::kBooleanLiteral:
+        return HashCombine(h, expr->AsBooleanLiteral()->pred());
+
+    case ASTNodeType::kRegExpLiteral: {
+        auto regex = expr->AsRegExpLiteral();
+        h = HashCombine(h, HashString(regex->regex()));
+        for (auto flag : regex->flags())
+            h = HashCombine(h, (uint64_t)flag);
+        return h;
+    }
+
+    case ASTNodeType::kArgumentList:
+        return HashList(h, expr->AsArgumentList()->args().GetPtr());
+
+    case ASTNodeType::kCallExpression: {
+        auto call = expr->AsCallExpression();
+        h = HashCombine(h, (uint64_t)call->kind());
+        h = HashCombine(h, HashChild(call->expr()));
+        return HashCombine(h, HashChild(call->member()));
+    }
+
+    case ASTNodeType::kMemberExpression: {
+        auto member = expr->AsMemberExpression();
+        h = HashCombine(h, (uint64_t)member->kind());
+        h = HashCombine(h, HashChild(member->expr()));
+        return HashCombine(h, HashChild(member->member()));
+    }
+
+    case ASTNodeType::kNewExpression:
+        return HashCombine(h, HashChild(expr->AsNewExpression()->member()));
+
+    case ASTNodeType::kPrefixExpression: {
+        auto prefix = expr->AsPrefixExpression();
+        h = HashCombine(h, (uint64_t)prefix->op());
+        return HashCombine(h, HashChild(prefix->expr()));
+    }
+
+    case ASTNodeType::kPostfixExpression: {
+        auto postfix = expr->AsPostfixExpression();
+        h = HashCombine(h, (uint64_t)postfix->op());
+        return HashCombine(h, HashChild(postfix->expr()));
+    }
+
+    case ASTNodeType::kBinaryExpression: {
+        auto binary = expr->AsBinaryExpression();
+        h = HashCombine(h, (uint64_t)binary->op());
+        h = HashCombine(h, HashChild(binary->lhs()));
+        return HashCombine(h, HashChild(binary->rhs()));
+    }
+
+    case ASTNodeType::kAssignExpression: {
+        auto assign = expr->AsAssignExpression();
+        h = HashCombine(h, (uint64_t)assign->op());
+        h = HashCombine(h, HashChild(assign->lhs()));
+        return HashCombine(h, HashChild(assign->rhs()));
+    }
+
+    case ASTNodeType::kTernaryExpression: {
+        auto ternary = expr->AsTernaryExpression();
+        h = HashCombine(h, HashChild(ternary->first()));
+        h = HashCombine(h, HashChild(ternary->second()));
+        return HashCombine(h, HashChild(ternary->third()));
+    }
+
+    case ASTNodeType::kCommaExpression:
+        return HashList(h, expr->AsCommaExpression()->exprs().GetPtr());
+
+    default:
+        return h;
+    }
+}
+
+bool HashConsTable::Equal(Expression *a, Expression *b) const
+{
+    if (a->type() != b->type() || a->GetScope() != b->GetScope())
+        return false;
+
+    switch (a->type()) {
+    case ASTNodeType::kNullLiteral:
+    case ASTNodeType::kUndefinedLiteral:
+    case ASTNodeType::kThisHolder:
+        return true;
+
+    case ASTNodeType::kIntegralLiteral:
+        return HashNumber(a->AsIntegralLiteral()->value())
+            == HashNumber(b->AsIntegralLiteral()->value());
+
+    case ASTNodeType::kStringLiteral:
+        return a->AsStringLiteral()->string() == b->AsStringLiteral()->string();
+
+    case ASTNodeType::kTemplateLiteral:
+        return a->AsTemplateLiteral()->template_string()
+            == b->AsTemplateLiteral()->template_string();
+
+    case ASTNodeType::kArrayLiteral: {
+        auto x = a->AsArrayLiteral(), y = b->AsArrayLiteral();
+        if (x->packed() || y->packed()) {
+            return x->packed() && y->packed()
+                && *x->packed() == *y->packed();
+        }
+        return x->exprs() == y->exprs();
+    }
+
+    case ASTNodeType::kObjectLiteral:
+        return a->AsObjectLiteral()->proxy() == b->AsObjectLiteral()->proxy();
+
+    case ASTNodeType::kIdentifier:
+        return a->AsIdentifier()->GetName() == b->AsIdentifier()->GetName();
+
+    case ASTNodeType::kBooleanLiteral:
+        return a->AsBooleanLiteral()->pred() == b->AsBooleanLiteral()->pred();
+
+    case ASTNodeType::kRegExpLiteral:
+        return a->AsRegExpLiteral()->regex() == b->AsRegExpLiteral()->regex()
+            && a->AsRegExpLiteral()->flags() == b->AsRegExpLiteral()->flags();
+
+    case ASTNodeType::kArgumentList:
+        return EqualList(a->AsArgumentList()->args().GetPtr(),
+            b->AsArgumentList()->args().GetPtr());
+
+    case ASTNodeType::kCallExpression: {
+        auto x = a->AsCallExpression(), y = b->AsCallExpression();
+        return x->kind() == y->kind() && x->expr() == y->expr()
+            && x->member() == y->member();
+    }
+
+    case ASTNodeType::kMemberExpression: {
+        auto x = a->AsMemberExpression(), y = b->AsMemberExpression();
+        return x->kind() == y->kind() && x->expr() == y->expr()
+            && x->member() == y->member();
+    }
+
+    case ASTNodeType::kNewExpression:
+        return a->AsNewExpression()->member() == b->AsNewExpression()->member();
+
+    case ASTNodeType::kPrefixExpression: {
+        auto x = a->AsPrefixExpression(), y = b->AsPrefixExpression();
+        return x->op() == y->op() && x->expr() == y->expr();
+    }
+
+    case ASTNodeType::kPostfixExpression: {
+        auto x = a->AsPostfixExpression(), y = b->AsPostfixExpression();
+        return x->op() == y->op() && x->expr() == y->expr();
+    }
+
+    case ASTNodeType::kBinaryExpression: {
+        auto x = a->AsBinaryExpression(), y = b->AsBinaryExpression();
+        return x->op() == y->op() && x->lhs() == y->lhs()
+            && x->rhs() == y->rhs();
+    }
+
+    case ASTNodeType::kAssignExpression: {
+        auto x = a->AsAssignExpression(), y = b->AsAssignExpression();
+        return x->op() == y->op() && x->lhs() == y->lhs()
+            && x->rhs() == y->rhs();
+    }
+
+    case ASTNodeType::kTernaryExpression: {
+        auto x = a->AsTernaryExpression(), y = b->AsTernaryExpression();
+        return x->first() == y->first() && x->second() == y->second()
+            && x->third() == y->third();
+    }
+
+    case ASTNodeType::kCommaExpression:
+        return EqualList(a->AsCommaExpression()->exprs().GetPtr(),
+            b->AsCommaExpression()->exprs().GetPtr());
+
+    default:
+        return false;
+    }
+}
+
+Handle<Expression> HashConsTable::Intern(Handle<Expression> expr)
+{
+    if (!expr || !IsShareable(expr->type()))
+        return expr;
+
+    uint64_t hash = HashNode(expr.GetPtr());
+    auto range = table_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (!Equal(it->second.GetPtr(), expr.GetPtr()))
+            continue;
+
+        auto &positions = positions_[it->second.GetPtr()];
+        positions.push_back(expr->loc());
+        hits_++;
+        saved_bytes_ += SizeOfNode(expr->type());
+        return it->second;
+    }
+
+    table_.emplace(hash, expr);
+    nodes_++;
+    return expr;
+}
+
+std::vector<Position> HashConsTable::positions(Expression *expr) const
+{
+    std::vector<Position> result;
+    if (!occurrences(expr))
+        return result;
+
+    result.push_back(expr->loc());
+    auto it = positions_.find(expr);
+    if (it != positions_.end())
+        result.insert(result.end(), it->second.begin(), it->second.end());
+    return result;
+}
+
+size_t HashConsTable::occurrences(Expression *expr) const
+{
+    if (!expr || !IsShareable(expr->type()))
+        return 0;
+
+    auto range = table_.equal_range(HashNode(expr));
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.GetPtr() != expr)
+            continue;
+
+        auto positions = positions_.find(expr);
+        return 1 + (positions != positions_.end()
+            ? positions->second.size() : 0);
+    }
+    return 0;
+}
+
+void HashConsTable::Clear()
+{
+    table_.clear();
+    positions_.clear();
+    nodes_ = hits_ = saved_bytes_ = 0;
+}
+
+}
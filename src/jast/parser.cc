@@ -1,7 +1,10 @@
 #include "jast/parser.h"
+#include "jast/allocation-profiler.h"
 #include "jast/ast-builder.h"
 #include "jast/token.h"
+#include "jast/trace.h"
 
+#include <cstdio>
 #include <sstream>
 
 namespace jast {
@@ -14,25 +17,9 @@ namespace jast {
         advance();  \
     } while (0)
 
-class NewScope {
-public:
-    NewScope(Parser *parser)
-        : parser_{parser}
-    {
-        Setup();
-    }
-
-    ~NewScope() {
-        parser_->scope_manager()->PopScope();
-    }
-
-    void Setup() {
-        // parser_->scope_manager()->NewScope()
-    }
-
-private:
-    Parser *parser_;
-};
+// the allocations made by a Parse function are attributed to it, until it
+// calls the next one
+#define ALLOCATION_SITE() AllocationSite allocation_site_(__func__)
 
 class ForInLoopParsingEnvironment {
 public:
@@ -57,6 +44,20 @@ bool IsAssign(TokenType tok)
     return tok >= ASSIGN && tok <= ASSIGN_MOD;
 }
 
+namespace {
+
+void Append(ProxyArray &arr, Handle<Expression> expr)
+{
+    auto capacity = arr.capacity();
+    arr.push_back(expr);
+    if (arr.capacity() != capacity) {
+        AllocationProfiler::OnContainer(AllocationContainer::kProxyArray,
+            arr.capacity() * sizeof(Handle<Expression>));
+    }
+}
+
+}
+
 Parser::Parser(ParserContext *context, ASTBuilder *builder, Tokenizer *lex, ScopeManager *manager)
  : ctx_{ context }, builder_{ builder }, lex_{ lex }, manager_{ manager }
 {
@@ -66,6 +67,14 @@ Parser::~Parser()
 {
 }
 
+void Parser::Reset()
+{
+    flags_ = ParserFlags();
+    operands_.clear();
+    operators_.clear();
+    properties_.clear();
+}
+
 String Parser::GetStringLiteral()
 {
     return lex()->currentToken().view();
@@ -98,6 +107,7 @@ void Parser::advance(bool not_regex)
 
 Handle<Expression> Parser::ParseArrayLiteral()
 {
+    ALLOCATION_SITE();
     ProxyArray exprs;
     // eat '['
     advance();
@@ -105,11 +115,24 @@ Handle<Expression> Parser::ParseArrayLiteral()
 
     if (tok == RBRACK) {
         // done
-        return builder()->NewArrayLiteral(exprs);
+        return builder()->NewArrayLiteral(std::move(exprs));
     }
+
+    // the elements are packed while they are all numbers or all strings,
+    // the first other one unpacks them and the rest is parsed as usual
+    PackedArray packed(tok == STRING ? PackedArray::Kind::kString
+        : PackedArray::Kind::kNumber);
+    bool packing = builder()->array_packing()
+        && (tok == NUMBER || tok == STRING);
     while (true) {
-        auto one = ParseAssignExpression();
-        exprs.push_back(Handle<Expression>(one));
+        if (packing && !ParsePackedElement(packed)) {
+            UnpackElements(packed, exprs);
+            packing = false;
+        }
+        if (!packing) {
+            auto one = ParseAssignExpression();
+            Append(exprs, one);
+        }
 
         tok = peek();
         
@@ -118,11 +141,45 @@ Handle<Expression> Parser::ParseArrayLiteral()
         EXPECT(COMMA); 
     }
 
-    return builder()->NewArrayLiteral(exprs);
+    if (packing && packed.size() >= PackedArray::kMinSize)
+        return builder()->NewPackedArrayLiteral(std::move(packed));
+    if (packing)
+        UnpackElements(packed, exprs);
+    return builder()->NewArrayLiteral(std::move(exprs));
+}
+
+bool Parser::ParsePackedElement(PackedArray &packed)
+{
+    auto tok = peek();
+    bool number = packed.kind() == PackedArray::Kind::kNumber;
+    if (tok != (number ? NUMBER : STRING))
+        return false;
+
+    // `1 + x` or `'a'.length` is an expression, `1,` and `1]` are not
+    auto next = lex()->peekChar();
+    if (next != ',' && next != ']')
+        return false;
+
+    auto &token = lex()->currentToken();
+    if (number)
+        packed.Append(ParseNumber(token), token.position());
+    else
+        packed.Append(token.view(), token.position());
+    advance(true);
+    return true;
+}
+
+void Parser::UnpackElements(PackedArray &packed, ProxyArray &exprs)
+{
+    for (size_t i = 0; i < packed.size(); i++)
+        Append(exprs, builder()->NewElementLiteral(packed, i,
+            scope_manager()->current()));
+    packed = PackedArray(packed.kind());
 }
 
 Handle<Expression> Parser::ParseObjectMethod(const std::string &name)
 {
+    ALLOCATION_SITE();
     auto args = ParseParameterList();
     auto body = ParseBlockStatement();
     auto proto = builder()->NewFunctionPrototype(name, args);
@@ -131,6 +188,7 @@ Handle<Expression> Parser::ParseObjectMethod(const std::string &name)
 
 Handle<Expression> Parser::ParseObjectLiteral()
 {
+    ALLOCATION_SITE();
     ProxyObject proxy;
 
     // eat the left brace '{'
@@ -139,9 +197,10 @@ Handle<Expression> Parser::ParseObjectLiteral()
 
     // if next tok is '}' then nothing to be done
     if (tok == RBRACE) {
-        return builder()->NewObjectLiteral(proxy);
+        return builder()->NewObjectLiteral(std::move(proxy));
     }
 
+    size_t base = properties_.size();
     std::string name;
     Handle<Expression> prop;
     while (true) {
@@ -157,22 +216,21 @@ Handle<Expression> Parser::ParseObjectLiteral()
 
         advance();
 
+        auto kind = PropertyKind::kValue;
         if (peek() == COLON) {
             advance();
             prop = ParseAssignExpression();
         }
         else if (peek() == LPAREN) {
             prop = ParseObjectMethod(name);
-        } else 
-        // TODO: create a getter list in the ProxyObject class that will keep track of getters
-        // and setters
-        if (peek() == IDENTIFIER && (name == "get" || name == "set")) {
+        } else if (peek() == IDENTIFIER && (name == "get" || name == "set")) {
+            kind = name == "get" ? PropertyKind::kGetter : PropertyKind::kSetter;
             name = lex()->currentToken().view();
             advance();
             prop = ParseObjectMethod(name);
         }
 
-        proxy[name] = Handle<Expression>(prop);
+        properties_.push_back(PropertyFrame{ std::move(name), prop, kind });
         // next token should be a ',' or '}'
         tok = peek();
         if (tok == RBRACE)
@@ -182,11 +240,18 @@ Handle<Expression> Parser::ParseObjectLiteral()
         advance();
     }
 
-    return builder()->NewObjectLiteral(proxy);
+    proxy.Reserve(properties_.size() - base);
+    for (size_t i = base; i < properties_.size(); i++) {
+        auto &property = properties_[i];
+        proxy.Append(std::move(property.name), property.value, property.kind);
+    }
+    properties_.resize(base);
+    return builder()->NewObjectLiteral(std::move(proxy));
 }
 
 Handle<Expression> Parser::ParsePrimary()
 {
+    ALLOCATION_SITE();
     auto tok = peek();
     Handle<Expression> result;
 
@@ -196,7 +261,9 @@ Handle<Expression> Parser::ParsePrimary()
         result = builder()->NewIntegralLiteral(
                                         ParseNumber(lex()->currentToken()));
     } else if (tok == TEMPLATE) {
-        result = builder()->NewTemplateLiteral(lex()->currentToken().view());
+        // the text of the token moves into the node, the token is done with
+        result = builder()->NewTemplateLiteral(
+            std::move(lex()->currentToken().view()));
     } else if (tok == REGEX) {
         std::string regex = lex()->currentToken().view();
         auto pos = regex.rfind("$");
@@ -217,7 +284,8 @@ Handle<Expression> Parser::ParsePrimary()
         }
         result = builder()->NewRegExpLiteral(regex.substr(0, pos), fs);
     } else if (tok == STRING) {
-        result = builder()->NewStringLiteral(lex()->currentToken().view());
+        result = builder()->NewStringLiteral(
+            std::move(lex()->currentToken().view()));
     } else if (tok == IDENTIFIER) {
         result = builder()->NewIdentifier(lex()->currentToken().view());
     } else if (tok == TRUE_LITERAL) {
@@ -250,6 +318,7 @@ Handle<Expression> Parser::ParsePrimary()
 
 Handle<Expression> Parser::ParseDotExpression()
 {
+    ALLOCATION_SITE();
     // eat the '.'
     advance();
 
@@ -267,6 +336,7 @@ Handle<Expression> Parser::ParseDotExpression()
 
 Handle<Expression> Parser::ParseIndexExpression()
 {
+    ALLOCATION_SITE();
     // eat the '['
     advance();
     auto expr = ParseAssignExpression();
@@ -296,6 +366,7 @@ Handle<Expression> Parser::ParseIndexExpression()
 // new new foo().bar().baz means (new (new foo()).bar()).baz
 Handle<Expression> Parser::ParseMemberExpression()
 {
+    ALLOCATION_SITE();
     Handle<Expression> primary = nullptr;
     if (peek() == TokenType::NEW) {
         advance();
@@ -333,6 +404,7 @@ Handle<Expression> Parser::ParseMemberExpression()
 
 Handle<ExpressionList> Parser::ParseArgumentList()
 {
+    ALLOCATION_SITE();
     Handle<ExpressionList> exprs = builder()->NewExpressionList();
 
     auto tok = peek();
@@ -367,6 +439,7 @@ Handle<ExpressionList> Parser::ParseArgumentList()
 //      CallExpression . IdentifierName
 Handle<Expression> Parser::ParseCallExpression()
 {
+    ALLOCATION_SITE();
     auto func = ParseMemberExpression();
     auto tok = peek();
 
@@ -401,6 +474,7 @@ Handle<Expression> Parser::ParseCallExpression()
 //      new NewExpression
 Handle<Expression> Parser::ParseNewExpression()
 {
+    ALLOCATION_SITE();
     if (peek() != NEW) {
         return ParseMemberExpression();
     }
@@ -414,6 +488,7 @@ Handle<Expression> Parser::ParseNewExpression()
 //      CallExpression
 Handle<Expression> Parser::ParseLeftHandSideExpression()
 {
+    ALLOCATION_SITE();
     if (peek() == NEW) {
         return ParseNewExpression();
     } else {
@@ -437,6 +512,7 @@ PrefixOperation MapTokenWithPrefixOperator(Token &tok)
 
 Handle<Expression> Parser::ParseUnaryExpression()
 {
+    ALLOCATION_SITE();
     // UnaryExpression :
     //     PostfixExpression
     //     delete UnaryExpression
@@ -448,35 +524,57 @@ Handle<Expression> Parser::ParseUnaryExpression()
     //     - UnaryExpression
     //     ~ UnaryExpression
     //     ! UnaryExpression
+    //
+    // the prefix operators are collected first and applied to the operand
+    // from the innermost one out, so `!!!...x` doesn't recurse
+    std::vector<Token> prefixes;
     auto tok = peek();
 
-    if (tok == ADD) {
-        advance();
-        // convert + (Expr) to Expr * 1
-        return builder()->NewBinaryExpression(BinaryOperation::kMultiplication,
-            ParseUnaryExpression(), builder()->NewIntegralLiteral(1.0));
-    } else if (tok == SUB) {
-        advance();
-
-        // similarly for `-Expr` to `Expr * -1` 
-        return builder()->NewBinaryExpression(BinaryOperation::kMultiplication,
-            ParseUnaryExpression(), builder()->NewIntegralLiteral(-1.0));
-    } else if (tok == INC || tok == DEC || tok == NOT || tok == BIT_NOT
-        || tok == TYPEOF || tok == DELETE || tok == VOID) {
-        auto token = lex()->currentToken();
-        lex()->advance();
+    while (true) {
+        if (tok == ADD || tok == SUB) {
+            prefixes.push_back(lex()->currentToken());
+            advance();
+        } else if (tok == INC || tok == DEC || tok == NOT || tok == BIT_NOT
+            || tok == TYPEOF || tok == DELETE || tok == VOID) {
+            prefixes.push_back(lex()->currentToken());
+            lex()->advance();
+        } else {
+            break;
+        }
+        tok = peek();
+    }
 
-        return builder()->NewPrefixExpression(MapTokenWithPrefixOperator(token),
-                                              ParseUnaryExpression());
+    auto expr = ParsePostfixExpression();
+
+    for (auto it = prefixes.rbegin(); it != prefixes.rend(); ++it) {
+        if (it->type() == ADD) {
+            // convert + (Expr) to Expr * 1
+            expr = builder()->NewBinaryExpression(
+                BinaryOperation::kMultiplication, expr,
+                builder()->NewIntegralLiteral(1.0));
+        } else if (it->type() == SUB) {
+            // similarly for `-Expr` to `Expr * -1`
+            expr = builder()->NewBinaryExpression(
+                BinaryOperation::kMultiplication, expr,
+                builder()->NewIntegralLiteral(-1.0));
+        } else {
+            expr = builder()->NewPrefixExpression(
+                MapTokenWithPrefixOperator(*it), expr);
+        }
     }
+    return expr;
+}
 
+Handle<Expression> Parser::ParsePostfixExpression()
+{
+    ALLOCATION_SITE();
     // PostfixExpression :
     //      LeftHandSideExpression
     //      LeftHandSideExpression [no LineTerminator here] ++
     //      LeftHandSideExpression [no LineTerminator here] --
     auto left = ParseLeftHandSideExpression();
 
-    tok = peek();
+    auto tok = peek();
     if (tok == INC) {
         advance();
         return builder()->NewPostfixExpression(PostfixOperation::kIncrement,
@@ -521,86 +619,210 @@ BinaryOperation MapBinaryOperator(Token &tok)
     }
 }
 
-/// reference for this function ::= llvm/examples/Kaleidoscope/chapter3/toy.cpp
-/// if you are unable to understand the function just imagine you are 
-/// parsing 2 + 3 * 5 - 6 / 7, (I too used that as a reference)
-Handle<Expression> Parser::ParseBinaryExpressionRhs(int prec, Handle<Expression> lhs)
+AssignOperation MapAssignOperator(Token &tok)
 {
-    while (true) {
-        int tokprec = Token::precedence(peek());
-
-        if (tokprec < prec) {
-            return lhs;
-        }
+    switch(tok.type()) {
+        case ASSIGN:            return AssignOperation::kAssign;
+        case ASSIGN_ADD:        return AssignOperation::kAddition;
+        case ASSIGN_SUB:        return AssignOperation::kSubtraction;
+        case ASSIGN_MUL:        return AssignOperation::kMultiplication;
+        case ASSIGN_DIV:        return AssignOperation::kDivision;
+        case ASSIGN_MOD:        return AssignOperation::kMod;
+        case ASSIGN_SHL:        return AssignOperation::kShiftLeft;
+        case ASSIGN_SAR:        return AssignOperation::kShiftRight;
+        case ASSIGN_SHR:        return AssignOperation::kShiftZeroRight;
+        case ASSIGN_BIT_AND:    return AssignOperation::kBitAnd;
+        case ASSIGN_BIT_OR:     return AssignOperation::kBitOr;
+        case ASSIGN_BIT_XOR:    return AssignOperation::kBitXor;
+        default:       throw SyntaxError(tok,
+                                    "unexpected token as assignment operator");
+    }
+}
 
-        // now we definitely have a binary operator
-        auto op =  MapBinaryOperator(lex()->currentToken());
-        advance();
+namespace {
 
-        auto rhs = ParseUnaryExpression();
+// binding power of every token as a binary operator, straight from the
+// precedences in tokens.inc. tokens below kMinBinaryPower (`,`, `?` and the
+// assignments) are handled by the engine itself
+constexpr int kBindingPower[NUM_TOKENS] = {
+#define O(t, s, p) p,
+#define K(t, s, p) p,
+#define T(t, s, p) p,
+#include "jast/tokens.inc"
+};
 
-        auto nextprec = Token::precedence(peek());
-        if (tokprec < nextprec) {
-            rhs = ParseBinaryExpressionRhs(tokprec + 1, rhs);
-        }
+constexpr int kMinBinaryPower = 3;
 
+static_assert(kBindingPower[MUL] > kBindingPower[ADD]
+    && kBindingPower[ADD] > kBindingPower[LT]
+    && kBindingPower[OR] >= kMinBinaryPower
+    && kBindingPower[CONDITIONAL] < kMinBinaryPower
+    && kBindingPower[ASSIGN] < kMinBinaryPower,
+    "unexpected binding powers in tokens.inc");
 
-        // merge lhs and rhs
-        lhs = builder()->NewBinaryExpression(op, lhs, rhs);
-    }
 }
 
 Handle<Expression> Parser::ParseBinaryExpression()
 {
-    auto lhs = ParseUnaryExpression();
+    ALLOCATION_SITE();
+    return ParseOperators(OperatorLevel::kBinary, kMinBinaryPower, nullptr);
+}
 
-    // parse the rhs, if any
-    return ParseBinaryExpressionRhs(3, lhs);
+Handle<Expression> Parser::ParseBinaryExpressionRhs(int prec, Handle<Expression> lhs)
+{
+    ALLOCATION_SITE();
+    return ParseOperators(OperatorLevel::kBinary, prec, lhs);
 }
 
-Handle<Expression> Parser::ParseAssignExpression()
+Handle<Expression> Parser::ParseTernaryExpression()
 {
-    auto lhs = ParseTernaryExpression();
-    auto tok = peek();
+    ALLOCATION_SITE();
+    return ParseOperators(OperatorLevel::kTernary, kMinBinaryPower, nullptr);
+}
 
-    if (!IsAssign(tok))
-        return lhs;
+Handle<Expression> Parser::ParseAssignExpression()
+{
+    ALLOCATION_SITE();
+    return ParseOperators(OperatorLevel::kAssign, kMinBinaryPower, nullptr);
+}
 
-    // TODO: information about what kind of assignment is done here should
-    //  be stored here. (in the AST?)
-    advance();
-    auto rhs = ParseAssignExpression();
-    return builder()->NewAssignExpression((lhs), (rhs));
+// merges the binary operators of the innermost context which bind at least
+// as strong as `power`
+void Parser::ReduceBinary(size_t base, int power)
+{
+    while (operators_.size() > base
+        && operators_.back().kind == OperatorFrame::kBinary
+        && operators_.back().power >= power) {
+        auto op = operators_.back().op;
+        operators_.pop_back();
+
+        auto rhs = operands_.back();
+        operands_.pop_back();
+        operands_.back() = builder()->NewBinaryExpression(op,
+            operands_.back(), rhs);
+    }
 }
 
-Handle<Expression> Parser::ParseTernaryExpression()
+// The grammar handled here is
+//
+//      AssignExpression  := TernaryExpression [AssignOp AssignExpression]
+//      TernaryExpression := BinaryExpression
+//                           [? AssignExpression : AssignExpression]
+//      BinaryExpression  := UnaryExpression (BinaryOp UnaryExpression)*
+//
+// with an explicit stack of operands and pending operators instead of a
+// recursive call for every operator and every operand. `?`, `:` and the
+// assignments open a new AssignExpression context on the stack; the frames
+// above the innermost of them are binary operators of strictly increasing
+// binding power. Binary operators are left associative, so an operator
+// first reduces the frames binding at least as strong as itself. A token
+// which continues nothing closes the contexts from the innermost one out,
+// until a `?` is waiting for its `:` or all of them are closed.
+//
+// The nodes are built in the same order and with the same positions as by
+// the recursive descent parser this replaced.
+Handle<Expression> Parser::ParseOperators(OperatorLevel level, int power,
+    Handle<Expression> lhs)
 {
-    auto first = ParseBinaryExpression();
+    ALLOCATION_SITE();
+    size_t operand_base = operands_.size();
+    size_t operator_base = operators_.size();
 
-    auto tok = peek();
-    if (tok != CONDITIONAL) {
-        return first;
-    }
+    try {
+        operands_.push_back(lhs ? lhs : ParseUnaryExpression());
+
+        while (true) {
+            auto tok = peek();
+            int binding = kBindingPower[tok];
+
+            // markers sit below all the binary operators, the innermost
+            // context is the one we started with when there is no marker
+            bool at_base = operators_.size() == operator_base
+                || operators_[operator_base].kind == OperatorFrame::kBinary;
+
+            if (binding >= kMinBinaryPower && (!at_base || binding >= power)) {
+                ReduceBinary(operator_base, binding);
+                operators_.push_back(OperatorFrame{ OperatorFrame::kBinary,
+                    MapBinaryOperator(lex()->currentToken()), binding });
+                advance();
+                operands_.push_back(ParseUnaryExpression());
+                continue;
+            }
 
-    // now we're parsing conditional expression
-    // eat '?'
-    advance();
-    auto second = ParseAssignExpression();
+            // the binary expression of the innermost context is complete
+            ReduceBinary(operator_base, 0);
 
-    tok = peek();
-    if (tok != COLON) {
-        throw SyntaxError(lex()->currentToken(), "expected a ':'");
-    }
+            if (tok == CONDITIONAL
+                && (!at_base || level != OperatorLevel::kBinary)) {
+                operators_.push_back(OperatorFrame{ OperatorFrame::kQuestion,
+                    BinaryOperation::kAddition, 0 });
+                advance();
+                operands_.push_back(ParseUnaryExpression());
+                continue;
+            }
 
-    // eat ':'
-    advance();
-    auto third = ParseAssignExpression();
+            if (IsAssign(tok) && (!at_base || level == OperatorLevel::kAssign)) {
+                operators_.push_back(OperatorFrame{ OperatorFrame::kAssign,
+                    BinaryOperation::kAddition, 0,
+                    MapAssignOperator(lex()->currentToken()) });
+                advance();
+                operands_.push_back(ParseUnaryExpression());
+                continue;
+            }
 
-    return builder()->NewTernaryExpression(first, second, third);
+            // close the contexts, nothing can follow a closed ternary or
+            // assignment in the context around it
+            bool reopened = false;
+            while (operators_.size() > operator_base) {
+                auto &frame = operators_.back();
+
+                if (frame.kind == OperatorFrame::kQuestion) {
+                    if (tok != COLON)
+                        throw SyntaxError(lex()->currentToken(),
+                            "expected a ':'");
+                    frame.kind = OperatorFrame::kColon;
+                    advance();
+                    operands_.push_back(ParseUnaryExpression());
+                    reopened = true;
+                    break;
+                }
+
+                auto kind = frame.kind;
+                auto assign = frame.assign;
+                operators_.pop_back();
+
+                if (kind == OperatorFrame::kAssign) {
+                    auto rhs = operands_.back();
+                    operands_.pop_back();
+                    operands_.back() = builder()->NewAssignExpression(
+                        assign, operands_.back(), rhs);
+                } else {
+                    auto third = operands_.back();
+                    operands_.pop_back();
+                    auto second = operands_.back();
+                    operands_.pop_back();
+                    operands_.back() = builder()->NewTernaryExpression(
+                        operands_.back(), second, third);
+                }
+            }
+
+            if (!reopened)
+                break;
+        }
+    } catch (...) {
+        operands_.resize(operand_base);
+        operators_.resize(operator_base);
+        throw;
+    }
+
+    auto result = operands_.back();
+    operands_.pop_back();
+    return result;
 }
 
 Handle<Expression> Parser::ParseCommaExpression()
 {
+    ALLOCATION_SITE();
     auto one = ParseAssignExpression();
     auto tok = lex()->peek();
 
@@ -628,11 +850,13 @@ Handle<Expression> Parser::ParseCommaExpression()
 
 Handle<Expression> Parser::ParseExpression()
 {
+    ALLOCATION_SITE();
     return ParseCommaExpression();
 }
 
 Handle<Expression> Parser::ParseExpressionOptional()
 {
+    ALLOCATION_SITE();
     auto tok = peek();
 
     if (tok == SEMICOLON) {
@@ -644,6 +868,7 @@ Handle<Expression> Parser::ParseExpressionOptional()
 
 Handle<Expression> Parser::ParseElseBranch()
 {
+    ALLOCATION_SITE();
     // eat 'else'
     advance();
     return ParseStatement();
@@ -651,6 +876,7 @@ Handle<Expression> Parser::ParseElseBranch()
 
 Handle<Expression> Parser::ParseIfStatement()
 {
+    ALLOCATION_SITE();
     Handle<Expression> result;
 
     // eat 'if'
@@ -679,6 +905,7 @@ Handle<Expression> Parser::ParseIfStatement()
 
 Handle<Expression> Parser::ParseForInStatement(Handle<Expression> inexpr)
 {
+    ALLOCATION_SITE();
     EXPECT(RPAREN);
 
         // parse 'for (x = 10; x < 100; x = x + 1) >>rest<<...' part
@@ -689,6 +916,7 @@ Handle<Expression> Parser::ParseForInStatement(Handle<Expression> inexpr)
 
 Handle<Expression> Parser::ParseForStatement()
 {
+    ALLOCATION_SITE();
     // eat 'for'
     advance();
     auto tok = peek();
@@ -762,6 +990,7 @@ Handle<Expression> Parser::ParseForStatement()
 
 Handle<Expression> Parser::ParseWhileStatement()
 {
+    ALLOCATION_SITE();
     advance(); // eat 'while'
 
     auto tok = peek();
@@ -784,6 +1013,7 @@ Handle<Expression> Parser::ParseWhileStatement()
 
 Handle<Expression> Parser::ParseDoWhileStatement()
 {
+    ALLOCATION_SITE();
     advance(); // eat 'do'
     auto body = ParseStatement();
 
@@ -815,6 +1045,7 @@ Handle<Expression> Parser::ParseDoWhileStatement()
 
 std::vector<std::string> Parser::ParseParameterList()
 {
+    ALLOCATION_SITE();
     auto tok = peek();
     auto result = std::vector<std::string>();
 
@@ -854,6 +1085,7 @@ std::vector<std::string> Parser::ParseParameterList()
 
 Handle<FunctionPrototype> Parser::ParseFunctionPrototype()
 {
+    ALLOCATION_SITE();
     // eat 'function'   
     advance();
     auto tok = peek();
@@ -873,7 +1105,11 @@ Handle<FunctionPrototype> Parser::ParseFunctionPrototype()
 
 Handle<Expression> Parser::ParseFunctionStatement()
 {
+    ALLOCATION_SITE();
+    TraceScope trace("function", "parser");
     auto proto = ParseFunctionPrototype();
+    trace.SetArg(proto->GetName().empty() ? "(anonymous)"
+                                          : proto->GetName().c_str());
     auto body = ParseStatement();
 
     return builder()->NewFunctionStatement(proto, body);
@@ -881,6 +1117,7 @@ Handle<Expression> Parser::ParseFunctionStatement()
 
 Handle<Expression> Parser::ParseBlockStatement()
 {
+    ALLOCATION_SITE();
     Handle<ExpressionList> stmts = builder()->NewExpressionList();
     advance(); // eat '{'
 
@@ -899,6 +1136,7 @@ Handle<Expression> Parser::ParseBlockStatement()
 
 Handle<Expression> Parser::ParseReturnStatement()
 {
+    ALLOCATION_SITE();
     advance(); // eat 'return'
     auto tok = peek();
 
@@ -917,6 +1155,7 @@ Handle<Expression> Parser::ParseReturnStatement()
 
 Handle<Declaration> Parser::ParseDeclaration()
 {
+    ALLOCATION_SITE();
     auto tok = peek();
     if (tok != IDENTIFIER) {
         throw SyntaxError(lex()->currentToken(), "expected an identifier");
@@ -937,6 +1176,7 @@ Handle<Declaration> Parser::ParseDeclaration()
 }
 
 Handle<Expression> Parser::ParseVariableOrExpressionOptional() {
+    ALLOCATION_SITE();
     auto tok = peek();
     if (tok == VAR || tok == LET || tok == CONST) {
         return ParseVariableStatement();
@@ -947,6 +1187,7 @@ Handle<Expression> Parser::ParseVariableOrExpressionOptional() {
 
 Handle<Expression> Parser::ParseVariableStatement()
 {
+    ALLOCATION_SITE();
     advance();    // eat 'var'
 
     std::vector<Handle<Declaration>> decl_list;
@@ -970,6 +1211,7 @@ Handle<Expression> Parser::ParseVariableStatement()
 
 Handle<ExpressionList> Parser::ParseCaseBlock()
 {
+    ALLOCATION_SITE();
     advance();
 
     // TODO ::= make it more abstract. use ParseExpression
@@ -1004,6 +1246,7 @@ Handle<ExpressionList> Parser::ParseCaseBlock()
 
 Handle<Expression> Parser::ParseDefaultClause()
 {
+    ALLOCATION_SITE();
     advance();
 
     EXPECT(COLON);
@@ -1019,6 +1262,7 @@ Handle<Expression> Parser::ParseDefaultClause()
 
 Handle<Expression> Parser::ParseSwitchStatement()
 {
+    ALLOCATION_SITE();
     advance();
     EXPECT(LPAREN);
 
@@ -1057,11 +1301,13 @@ Handle<Expression> Parser::ParseSwitchStatement()
 
 Handle<Expression> Parser::ParseBreakStatement()
 {
+    ALLOCATION_SITE();
     advance();
     Handle<Expression> label = nullptr;
 
     if (peek() == IDENTIFIER) {
         label = builder()->NewIdentifier(GetIdentifierName());
+        advance();
     }
 
     return builder()->NewBreakStatement(label);
@@ -1069,12 +1315,14 @@ Handle<Expression> Parser::ParseBreakStatement()
 
 Handle<Expression> Parser::ParseContinueStatement()
 {
+    ALLOCATION_SITE();
 
     advance();
     Handle<Expression> label = nullptr;
 
     if (peek() == IDENTIFIER) {
         label = builder()->NewIdentifier(GetIdentifierName());
+        advance();
     }
 
     return builder()->NewContinueStatement(label);
@@ -1082,6 +1330,7 @@ Handle<Expression> Parser::ParseContinueStatement()
 
 Handle<Expression> Parser::ParseTryCatchStatement()
 {
+    ALLOCATION_SITE();
     Handle<Expression> try_block = nullptr;
     Handle<Expression> catch_expr = nullptr;
     Handle<Expression> catch_block = nullptr;
@@ -1109,6 +1358,7 @@ Handle<Expression> Parser::ParseTryCatchStatement()
 //      throw [no line terminator] Expression ;
 Handle<Expression> Parser::ParseThrowStatement()
 {
+    ALLOCATION_SITE();
     EXPECT(THROW);
 
     Handle<Expression> expr = ParseExpression();
@@ -1118,6 +1368,7 @@ Handle<Expression> Parser::ParseThrowStatement()
 
 Handle<Expression> Parser::ParseStatement()
 {
+    ALLOCATION_SITE();
     auto tok = peek();
 
     switch (tok) {
@@ -1204,9 +1455,19 @@ std::string CreateLLVMLikePointer(size_t pos, size_t len)
 
 Handle<Expression> Parser::ParseProgram()
 {
+    ALLOCATION_SITE();
+    PhaseTimer timer(context()->Counters(), Phase::kParse);
+    TraceScope trace("ParseProgram", "parser");
     Handle<ExpressionList> exprs = builder()->NewExpressionList();
     try {
         while (peek() != END_OF_FILE) {
+            TraceScope statement("statement", "parser");
+            char line[24];
+            if (statement.recorded()) {
+                snprintf(line, sizeof(line), "line %lu", (unsigned long)
+                    lex()->currentToken().position().row() + 1);
+                statement.SetArg(line);
+            }
             exprs->Insert(ParseStatement());
         }
     } catch (std::exception &e) {
@@ -1223,11 +1484,6 @@ Handle<Expression> Parser::ParseProgram()
     return builder()->NewBlockStatement(exprs);
 }
 
-Handle<Expression> Parser::ParsePostfixExpression() {
-
-    return nullptr;
-}
-
 Handle<Expression> ParseProgram(Parser *parser)
 {
     // parse program and return AST
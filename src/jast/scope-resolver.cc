@@ -0,0 +1,198 @@
+#include "jast/scope-resolver.h"
+#include "jast/ast-walker.h"
+#include "jast/context.h"
+#include "jast/statement.h"
+#include "jast/trace.h"
+
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
+namespace jast {
+
+namespace {
+
+// names after a '.' and labels are identifiers too, but not variables
+bool IsVariable(Expression *ident, Expression *parent)
+{
+    if (!parent)
+        return true;
+
+    switch (parent->type()) {
+    case ASTNodeType::kMemberExpression: {
+        auto member = parent->AsMemberExpression();
+        return member->kind() != MemberAccessKind::kDot
+            || member->member().GetPtr() != ident;
+    }
+    case ASTNodeType::kCallExpression: {
+        auto call = parent->AsCallExpression();
+        return call->kind() != MemberAccessKind::kDot
+            || call->member().GetPtr() != ident;
+    }
+    case ASTNodeType::kBreakStatement:
+    case ASTNodeType::kContinueStatement:
+    case ASTNodeType::kLabelledStatement:
+        return false;
+    default:
+        return true;
+    }
+}
+
+// opens the scopes, declares what they hold and collects the variables to
+// look up once everything is declared
+class Declarer : public ASTWalker {
+public:
+    Declarer(ScopeManager *manager)
+        : manager_{ manager }
+    { }
+
+    std::vector<Identifier*> &variables() { return variables_; }
+
+protected:
+    bool Enter(Expression *expr) override;
+    void Leave(Expression *expr) override;
+
+private:
+    Binding Declare(Scope *scope, const std::string &name, Expression *value)
+    {
+        auto slot = scope->symbol_table()->Push(manager_->Intern(name), value);
+        return Binding(scope->depth(), slot);
+    }
+
+    void EnterFunction(FunctionStatement *func, Expression *parent);
+    bool EnterCatchParameter(Expression *expr, Expression *parent);
+
+    ScopeManager *manager_;
+    std::vector<Expression*> parents_;
+    std::vector<Identifier*> variables_;
+    // the statements shared by case clauses falling through to them, which
+    // are walked once
+    std::unordered_set<Expression*> case_bodies_;
+    // every identifier walked, one reached twice is shared
+    std::unordered_set<Identifier*> identifiers_;
+};
+
+bool Declarer::Enter(Expression *expr)
+{
+    Expression *parent = parents_.empty() ? nullptr : parents_.back();
+    if (parent && parent->type() == ASTNodeType::kCaseClauseStatement
+            && parent->AsCaseClauseStatement()->stmt().GetPtr() == expr
+            && !case_bodies_.insert(expr).second)
+        return false;
+    if (expr->type() == ASTNodeType::kIdentifier
+            && !identifiers_.insert(static_cast<Identifier*>(expr)).second)
+        throw std::runtime_error("the identifier " + expr->AsIdentifier()
+            ->GetName() + " is shared, a hash-consed tree can't be resolved");
+    parents_.push_back(expr);
+    expr->SetScope(manager_->current());
+    bool catch_parameter = EnterCatchParameter(expr, parent);
+
+    switch (expr->type()) {
+    case ASTNodeType::kFunctionStatement:
+        EnterFunction(expr->AsFunctionStatement().GetPtr(), parent);
+        break;
+    case ASTNodeType::kDeclaration: {
+        auto decl = expr->AsDeclaration();
+        decl->SetBinding(Declare(manager_->current()->VarScope(),
+            decl->name(), expr));
+        break;
+    }
+    case ASTNodeType::kIdentifier:
+        if (!catch_parameter && IsVariable(expr, parent))
+            variables_.push_back(expr->AsIdentifier().GetPtr());
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+void Declarer::Leave(Expression *expr)
+{
+    parents_.pop_back();
+
+    // the function itself, or the block of a catch clause
+    if (manager_->current()->root() == expr)
+        manager_->PopScope();
+}
+
+void Declarer::EnterFunction(FunctionStatement *func, Expression *parent)
+{
+    auto proto = func->proto();
+    auto &name = proto->GetName();
+
+    // a function in a statement list is a declaration, anywhere else it is
+    // an expression, whose name is only seen from inside
+    bool declaration = !parent || parent->IsBlockStatement();
+    if (declaration && !name.empty()) {
+        proto->SetBinding(Declare(manager_->current()->VarScope(), name,
+            func));
+    }
+
+    Scope *scope = manager_->NewScope(func, Scope::Kind::kFunction);
+    for (auto &arg : proto->GetArgs())
+        Declare(scope, arg, proto.GetPtr());
+    if (!declaration && !name.empty())
+        proto->SetBinding(Declare(scope, name, func));
+}
+
+// opens the scope of a catch clause at its parameter, it lasts until the
+// catch block is left. true if `expr` is the parameter
+bool Declarer::EnterCatchParameter(Expression *expr, Expression *parent)
+{
+    if (!parent || parent->type() != ASTNodeType::kTryCatchStatement)
+        return false;
+
+    auto stmt = parent->AsTryCatchStatement();
+    if (stmt->catch_expr().GetPtr() != expr)
+        return false;
+
+    Scope *scope = manager_->NewScope(stmt->catch_block().GetPtr(),
+        Scope::Kind::kCatch);
+    expr->SetScope(scope);
+    if (expr->IsIdentifier()) {
+        auto ident = expr->AsIdentifier();
+        ident->SetBinding(Declare(scope, ident->GetName(), expr));
+    }
+    return true;
+}
+
+}
+
+ScopeResolver::ScopeResolver(ScopeManager *manager)
+    : manager_{ manager }
+{ }
+
+void ScopeResolver::Resolve(Handle<Expression> root)
+{
+    if (!root)
+        return;
+
+    PhaseTimer timer(manager_->context()->Counters(), Phase::kScope);
+    TraceScope trace("ResolveScopes", "scope");
+
+    Declarer declarer(manager_);
+    declarer.Walk(root);
+
+    SymT::Name arguments = manager_->Intern("arguments");
+    for (auto ident : declarer.variables()) {
+        SymT::Name name = manager_->Intern(ident->GetName());
+        Binding binding = Binding::Global();
+
+        for (Scope *scope = ident->GetScope(); scope; scope = scope->parent()) {
+            auto table = scope->symbol_table();
+            if (auto entry = table->Lookup(name)) {
+                binding = Binding(scope->depth(), entry->slot);
+                break;
+            }
+            if (name == arguments && scope->kind() == Scope::Kind::kFunction) {
+                binding = Binding(scope->depth(),
+                    table->Push(name, scope->root()));
+                break;
+            }
+        }
+        ident->SetBinding(binding);
+    }
+}
+
+}
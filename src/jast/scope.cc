@@ -4,47 +4,120 @@
 
 namespace jast {
 
-Scope::Scope(Value *root, Scope *parent)
-    : root_{root}, parent_{parent}
+namespace {
+
+size_t Hash(SymT::Name name)
+{
+    // interned names are heap pointers, their low bits are always the same
+    return (size_t)(((uint64_t)(uintptr_t)name * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+}
+
+Scope::Scope(Value *root, Scope *parent, Kind kind)
+    : root_{root}, symbol_table_{this}, parent_{parent}, kind_{kind},
+      depth_{parent ? parent->depth() + 1 : 0}
 {
     // in case of global scope the root is empty
     if (root_)
         root_->SetScope(this);
-    symbol_table_ = new SymT(this);
 }
 
-// when scope is deleted, then so is symbol table
-Scope::~Scope() {
-    delete symbol_table_;
+SymT *Scope::symbol_table() {
+    return &symbol_table_;
 }
 
-SymT *Scope::symbol_table() {
-    return symbol_table_;
+Scope *Scope::VarScope() {
+    Scope *scope = this;
+    while (scope->kind() == Kind::kCatch)
+        scope = scope->parent();
+    return scope;
 }
 
 SymT::SymT(Scope *scope)
-    : scope_{scope}
+    : capacity_{0}, size_{0}, scope_{scope}
 { }
 
-void SymT::Push(const Name &name, Value *value) {
-    entries_[name] = value;
+uint32_t SymT::Push(Name name, Value *value) {
+    if (!table_) {
+        for (uint32_t i = 0; i < size_; i++) {
+            if (inline_names_[i] == name)
+                return inline_entries_[i].slot;
+        }
+        if (size_ < kInlineEntries) {
+            inline_names_[size_] = name;
+            inline_entries_[size_] = Entry{ value, size_ };
+            return size_++;
+        }
+        Grow();
+    }
+
+    Bucket *bucket = Find(name);
+    if (bucket->name)
+        return bucket->entry.slot;
+    if ((size_ + 1) * 2 > capacity_) {
+        Grow();
+        bucket = Find(name);
+    }
+    *bucket = Bucket{ name, Entry{ value, size_ } };
+    return size_++;
+}
+
+SymT::Bucket *SymT::Find(Name name) const {
+    uint32_t mask = capacity_ - 1;
+    for (uint32_t i = Hash(name) & mask; ; i = (i + 1) & mask) {
+        Bucket *bucket = &table_[i];
+        if (bucket->name == name || !bucket->name)
+            return bucket;
+    }
+}
+
+// the first call moves the inline entries out, the next ones double the table
+void SymT::Grow() {
+    auto old = std::move(table_);
+    uint32_t old_capacity = capacity_;
+
+    capacity_ = capacity_ ? capacity_ * 2 : kInlineEntries * 4;
+    table_.reset(new Bucket[capacity_]());
+    if (!old) {
+        for (uint32_t i = 0; i < size_; i++) {
+            Name name = inline_names_[i];
+            *Find(name) = Bucket{ name, inline_entries_[i] };
+        }
+        return;
+    }
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        if (old[i].name)
+            *Find(old[i].name) = old[i];
+    }
 }
 
-bool SymT::Exists(const Name &name) const {
-    return !!entries_.count(name);
+void SymT::Clear() {
+    size_ = 0;
+    for (uint32_t i = 0; i < capacity_; i++)
+        table_[i].name = nullptr;
 }
 
 Scope *SymT::scope() {
     return scope_;
 }
 
-SymT::Value *SymT::Get(const Name &name) {
-    auto it = entries_.find(name);
-    if (it == entries_.end()) {
+SymT::Value *SymT::Get(Name name) {
+    auto entry = Lookup(name);
+    return entry ? entry->value : nullptr;
+}
+
+const SymT::Entry *SymT::Lookup(Name name) const {
+    if (!table_) {
+        for (uint32_t i = 0; i < size_; i++) {
+            if (inline_names_[i] == name)
+                return &inline_entries_[i];
+        }
         return nullptr;
     }
 
-    return (*it).second;
+    Bucket *bucket = Find(name);
+    return bucket->name ? &bucket->entry : nullptr;
 }
 
 ScopeManager::ScopeManager(ParserContext *context)
@@ -55,12 +128,24 @@ void ScopeManager::PushScope(Scope *scope) {
     scope_stack_.push_back(scope);
 }
 
-Scope *ScopeManager::NewScope(SymT::Value *value) {
-    Scope *scope = new Scope(value, current_);
+Scope *ScopeManager::NewScope(SymT::Value *value, Scope::Kind kind) {
+    Scope *scope = context_->NewScope(value, current_, kind);
     PushScope(current_);
     return (current_ = scope);
 }
 
+SymT::Name ScopeManager::Intern(const std::string &name) {
+    return &*names_.insert(name).first;
+}
+
+void ScopeManager::Reset() {
+    current_ = global_scope_;
+    scope_stack_.clear();
+    context_->ReleaseScopes();
+    names_.clear();
+    global_scope_->symbol_table()->Clear();
+}
+
 Scope *ScopeManager::PopScope() {
     Scope *scope = current_;
     current_ = scope_stack_.back();
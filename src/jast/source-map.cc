@@ -0,0 +1,250 @@
+#include "jast/source-map.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <sstream>
+
+namespace jast {
+
+static const char kBase64Chars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int Base64Value(char ch)
+{
+    if (ch >= 'A' && ch <= 'Z')
+        return ch - 'A';
+    if (ch >= 'a' && ch <= 'z')
+        return ch - 'a' + 26;
+    if (ch >= '0' && ch <= '9')
+        return ch - '0' + 52;
+    if (ch == '+')
+        return 62;
+    if (ch == '/')
+        return 63;
+    return -1;
+}
+
+// an encoded 64 bit value takes at most 13 digits
+static const int kMaxVLQLength = 13;
+
+// VLQ implementation
+// -------------------
+
+static inline char *EncodeVLQ(char *out, int64_t value)
+{
+    // most deltas fit into a single digit
+    if (value > -16 && value < 16) {
+        *out++ = kBase64Chars[value < 0 ? (-value << 1) | 1 : value << 1];
+        return out;
+    }
+
+    // sign goes into the least significant bit
+    uint64_t vlq = value < 0 ? ((uint64_t)(-value) << 1) | 1
+                             : ((uint64_t)value << 1);
+    do {
+        int digit = vlq & 31;
+        vlq >>= 5;
+        if (vlq)
+            digit |= 32;    // continuation bit
+        *out++ = kBase64Chars[digit];
+    } while (vlq);
+    return out;
+}
+
+void VLQ::Encode(std::string &out, int64_t value)
+{
+    char buffer[kMaxVLQLength];
+    out.append(buffer, EncodeVLQ(buffer, value) - buffer);
+}
+
+bool VLQ::Decode(const std::string &in, size_t &pos, int64_t &value)
+{
+    uint64_t result = 0;
+    int shift = 0;
+    int digit;
+
+    do {
+        if (pos >= in.length() || shift > 60)
+            return false;
+        digit = Base64Value(in[pos++]);
+        if (digit < 0)
+            return false;
+        result |= (uint64_t)(digit & 31) << shift;
+        shift += 5;
+    } while (digit & 32);
+
+    value = (result & 1) ? -(int64_t)(result >> 1) : (int64_t)(result >> 1);
+    return true;
+}
+
+// SourceMapGenerator implementation
+// -----------------------------------
+
+SourceMapGenerator::SourceMapGenerator(const std::string &file)
+    : file_{ file }, length_{ 0 }, count_{ 0 }, gen_line_{ 0 }, gen_col_{ 0 },
+      source_{ 0 }, src_line_{ 0 }, src_col_{ 0 }, name_{ 0 },
+      line_has_segment_{ false }
+{ }
+
+inline char *SourceMapGenerator::Reserve(size_t length)
+{
+    if (mappings_.size() - length_ < length)
+        mappings_.resize(std::max(mappings_.size() * 2, length_ + length + 4096));
+    return mappings_.data() + length_;
+}
+
+int SourceMapGenerator::AddSource(const std::string &name,
+    const std::string &content)
+{
+    sources_.push_back(name);
+    contents_.push_back(content);
+    return (int)sources_.size() - 1;
+}
+
+int SourceMapGenerator::AddName(const std::string &name)
+{
+    // keep the load factor under 1/2
+    if ((names_.size() + 1) * 2 > name_slots_.size()) {
+        std::vector<NameSlot> slots(name_slots_.empty()
+            ? 64 : name_slots_.size() * 2, NameSlot{ 0, 0 });
+        size_t mask = slots.size() - 1;
+        for (auto &slot : name_slots_) {
+            if (!slot.index)
+                continue;
+            size_t i = slot.hash & mask;
+            while (slots[i].index)
+                i = (i + 1) & mask;
+            slots[i] = slot;
+        }
+        name_slots_.swap(slots);
+    }
+
+    size_t hash = std::hash<std::string>()(name);
+    size_t mask = name_slots_.size() - 1;
+    size_t i = hash & mask;
+    for (; name_slots_[i].index; i = (i + 1) & mask) {
+        const NameSlot &slot = name_slots_[i];
+        if (slot.hash == hash && names_[slot.index - 1] == name)
+            return slot.index - 1;
+    }
+
+    names_.push_back(name);
+    name_slots_[i] = NameSlot{ hash, (int)names_.size() };
+    return (int)names_.size() - 1;
+}
+
+void SourceMapGenerator::AddMapping(size_t gen_line, size_t gen_col,
+    size_t src_line, size_t src_col, int source, int name)
+{
+    // a new generated line resets the column delta, every skipped line
+    // still needs its own ';'
+    if (gen_line != gen_line_) {
+        size_t lines = gen_line - gen_line_;
+        memset(Reserve(lines), ';', lines);
+        length_ += lines;
+        gen_line_ = gen_line;
+        gen_col_ = 0;
+        line_has_segment_ = false;
+    } else if (line_has_segment_) {
+        // nothing to add if the segment maps to the same original position
+        // as the previous one
+        if (source == source_ && (int64_t)src_line == src_line_
+            && (int64_t)src_col == src_col_ && (name < 0 || name == name_))
+            return;
+    }
+
+    // separator and five fields
+    char *out = Reserve(1 + 5 * kMaxVLQLength);
+    char *begin = out;
+    if (line_has_segment_)
+        *out++ = ',';
+
+    out = EncodeVLQ(out, (int64_t)gen_col - gen_col_);
+    out = EncodeVLQ(out, (int64_t)source - source_);
+    out = EncodeVLQ(out, (int64_t)src_line - src_line_);
+    out = EncodeVLQ(out, (int64_t)src_col - src_col_);
+    if (name >= 0) {
+        out = EncodeVLQ(out, (int64_t)name - name_);
+        name_ = name;
+    }
+    length_ += out - begin;
+
+    gen_col_ = gen_col;
+    source_ = source;
+    src_line_ = src_line;
+    src_col_ = src_col;
+    line_has_segment_ = true;
+    count_++;
+}
+
+static void WriteJSONString(std::ostream &os, const std::string &str)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    os << '"';
+    for (char ch : str) {
+        switch (ch) {
+        case '"':   os << "\\\""; break;
+        case '\\':  os << "\\\\"; break;
+        case '\n':  os << "\\n"; break;
+        case '\r':  os << "\\r"; break;
+        case '\t':  os << "\\t"; break;
+        default:
+            if ((unsigned char)ch < 0x20) {
+                os << "\\u00" << hex[(ch >> 4) & 0xf] << hex[ch & 0xf];
+            } else {
+                os << ch;
+            }
+        }
+    }
+    os << '"';
+}
+
+static void WriteJSONArray(std::ostream &os, const std::vector<std::string> &arr)
+{
+    os << '[';
+    for (size_t i = 0; i < arr.size(); i++) {
+        if (i)
+            os << ',';
+        WriteJSONString(os, arr[i]);
+    }
+    os << ']';
+}
+
+void SourceMapGenerator::Write(std::ostream &os) const
+{
+    os << "{\"version\":3,";
+    if (!file_.empty()) {
+        os << "\"file\":";
+        WriteJSONString(os, file_);
+        os << ',';
+    }
+
+    os << "\"sources\":";
+    WriteJSONArray(os, sources_);
+
+    bool has_content = false;
+    for (auto &content : contents_)
+        has_content = has_content || !content.empty();
+    if (has_content) {
+        os << ",\"sourcesContent\":";
+        WriteJSONArray(os, contents_);
+    }
+
+    os << ",\"names\":";
+    WriteJSONArray(os, names_);
+    os << ",\"mappings\":\"";
+    os.write(mappings_.data(), length_);
+    os << "\"}";
+}
+
+std::string SourceMapGenerator::ToString() const
+{
+    std::ostringstream os;
+    Write(os);
+    return os.str();
+}
+
+}
@@ -1,15 +1,272 @@
 #include "jast/statistics.h"
+#include "jast/expression.h"
+
+#include <algorithm>
 #include <iostream>
 
 namespace jast {
 
+static_assert((int)ASTNodeType::kNrType <= Statistics::kMaxNodeTypes,
+    "Statistics::kMaxNodeTypes is too small for AST_NODE_LIST");
+
+namespace {
+
+const char *phase_names[] = {
+#define PHASE_NAME(Phase, name) name,
+STATISTICS_PHASE_LIST(PHASE_NAME)
+#undef PHASE_NAME
+};
+
+// ASTNode -> ast_node, for prometheus metric names
+std::string SnakeCase(const char *name)
+{
+    std::string result;
+    for (const char *p = name; *p; p++) {
+        bool upper = std::isupper((unsigned char)*p);
+        if (upper && p != name
+                && (std::islower((unsigned char)p[-1])
+                    || (p[1] && std::islower((unsigned char)p[1]))))
+            result += '_';
+        result += (char)std::tolower((unsigned char)*p);
+    }
+    return result;
+}
+
+void PrintPhase(std::ostream &os, const LatencyHistogram &h)
+{
+    os << "{\"count\": " << h.count() << ", \"total_ns\": " << h.sum()
+       << ", \"min_ns\": " << h.min() << ", \"max_ns\": " << h.max()
+       << ", \"p50_ns\": " << h.Percentile(50)
+       << ", \"p90_ns\": " << h.Percentile(90)
+       << ", \"p99_ns\": " << h.Percentile(99) << ", \"buckets\": [";
+
+    // [exclusive upper bound, count] pairs of the non empty buckets
+    const char *sep = "";
+    for (int i = 0; i < LatencyHistogram::kBuckets; i++) {
+        if (!h.bucket(i))
+            continue;
+        os << sep << "[" << LatencyHistogram::UpperBound(i) << ", "
+           << h.bucket(i) << "]";
+        sep = ", ";
+    }
+    os << "]}";
+}
+
+}
+
+uint64_t LatencyHistogram::Percentile(double p) const
+{
+    if (!count_)
+        return 0;
+
+    uint64_t rank = (uint64_t)(p / 100.0 * count_ + 0.5);
+    if (rank < 1)
+        rank = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; i++) {
+        seen += buckets_[i];
+        if (seen >= rank)
+            return std::min(UpperBound(i), max_);
+    }
+    return max_;
+}
+
+LatencyHistogram &LatencyHistogram::operator+=(const LatencyHistogram &other)
+{
+    for (int i = 0; i < kBuckets; i++)
+        buckets_[i] += other.buckets_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    return *this;
+}
+
+void Statistics::CountPass(const char *name, std::size_t before,
+    std::size_t after)
+{
+#ifndef DISABLE_COUNTERS
+    auto pass = std::find_if(passes_.begin(), passes_.end(),
+        [name](const PassCount &count) { return count.name == name; });
+    if (pass == passes_.end())
+        pass = passes_.insert(passes_.end(), PassCount{ name, 0, 0, 0 });
+    pass->runs++;
+    pass->nodes_before += before;
+    pass->nodes_after += after;
+#endif
+}
+
+Statistics &Statistics::operator+=(const Statistics &other)
+{
+    for (int i = 0; i < kSize; i++)
+        counters_[i] += other.counters_[i];
+    for (int i = 0; i < kMaxNodeTypes; i++) {
+        node_counts_[i] += other.node_counts_[i];
+        node_bytes_[i] += other.node_bytes_[i];
+    }
+    for (int i = 0; i < (int)Phase::kNrPhase; i++)
+        phases_[i] += other.phases_[i];
+    for (auto &pass : other.passes_) {
+        auto mine = std::find_if(passes_.begin(), passes_.end(),
+            [&pass](const PassCount &count) { return count.name == pass.name; });
+        if (mine == passes_.end()) {
+            passes_.push_back(pass);
+            continue;
+        }
+        mine->runs += pass.runs;
+        mine->nodes_before += pass.nodes_before;
+        mine->nodes_after += pass.nodes_after;
+    }
+    return *this;
+}
+
 void Statistics::dump() {
     std::cout << "-- Statistics\n";
 #define PRINT_COUNTER(C) std::cout << #C << " = " << counters_[CountType::k##C] << "\n";
     COUNTER_TYPE(PRINT_COUNTER)
 #undef PRINT_COUNTER
 
+    for (int i = 0; i < (int)Phase::kNrPhase; i++) {
+        auto &h = phases_[i];
+        if (!h.count())
+            continue;
+        std::cout << phase_names[i] << " = " << h.sum() / 1e6 << " ms ("
+            << h.count() << " times, p50 " << h.Percentile(50) << " ns, p99 "
+            << h.Percentile(99) << " ns)\n";
+    }
+
+    for (auto &pass : passes_) {
+        std::cout << "pass " << pass.name << " = " << pass.nodes_before
+            << " -> " << pass.nodes_after << " nodes (" << pass.runs
+            << " runs)\n";
+    }
+}
+
+void Statistics::DumpJSON(std::ostream &os) const
+{
+    os << "{\"counters\": {";
+    const char *sep = "";
+#define JSON_COUNTER(C) \
+    os << sep << "\"" #C "\": " << counters_[CountType::k##C]; sep = ", ";
+    COUNTER_TYPE(JSON_COUNTER)
+#undef JSON_COUNTER
+
+    os << "}, \"phases\": {";
+    sep = "";
+    for (int i = 0; i < (int)Phase::kNrPhase; i++) {
+        if (!phases_[i].count())
+            continue;
+        os << sep << "\"" << phase_names[i] << "\": ";
+        PrintPhase(os, phases_[i]);
+        sep = ", ";
+    }
+
+    os << "}, \"nodes\": {";
+    sep = "";
+    for (int i = 1; i < (int)ASTNodeType::kNrType; i++) {
+        if (!node_counts_[i])
+            continue;
+        os << sep << "\"" << type_as_string[i] << "\": {\"count\": "
+           << node_counts_[i] << ", \"bytes\": " << node_bytes_[i] << "}";
+        sep = ", ";
+    }
+
+    os << "}, \"passes\": {";
+    sep = "";
+    for (auto &pass : passes_) {
+        os << sep << "\"" << pass.name << "\": {\"runs\": " << pass.runs
+           << ", \"nodes_before\": " << pass.nodes_before
+           << ", \"nodes_after\": " << pass.nodes_after << "}";
+        sep = ", ";
+    }
+    os << "}}\n";
 }
 
+void Statistics::DumpPrometheus(std::ostream &os,
+    const std::string &prefix) const
+{
+#define PROMETHEUS_COUNTER(C) { \
+        auto name = prefix + "_" + SnakeCase(#C) + "_total"; \
+        os << "# TYPE " << name << " counter\n" \
+           << name << " " << counters_[CountType::k##C] << "\n"; \
+    }
+    COUNTER_TYPE(PROMETHEUS_COUNTER)
+#undef PROMETHEUS_COUNTER
+
+    auto nodes = prefix + "_ast_nodes_by_type_total";
+    auto bytes = prefix + "_ast_node_bytes_total";
+    os << "# HELP " << nodes << " AST nodes created, by node type\n"
+       << "# TYPE " << nodes << " counter\n";
+    for (int i = 1; i < (int)ASTNodeType::kNrType; i++) {
+        if (node_counts_[i]) {
+            os << nodes << "{type=\"" << type_as_string[i] << "\"} "
+               << node_counts_[i] << "\n";
+        }
+    }
+    os << "# HELP " << bytes << " sizeof() of the AST nodes created, by node "
+          "type\n"
+       << "# TYPE " << bytes << " counter\n";
+    for (int i = 1; i < (int)ASTNodeType::kNrType; i++) {
+        if (node_counts_[i]) {
+            os << bytes << "{type=\"" << type_as_string[i] << "\"} "
+               << node_bytes_[i] << "\n";
+        }
+    }
+
+    if (!passes_.empty()) {
+        auto runs = prefix + "_pass_runs_total";
+        auto before = prefix + "_pass_nodes_before_total";
+        auto after = prefix + "_pass_nodes_after_total";
+        os << "# HELP " << runs << " runs of each optimization pass\n"
+           << "# TYPE " << runs << " counter\n";
+        for (auto &pass : passes_) {
+            os << runs << "{pass=\"" << pass.name << "\"} " << pass.runs
+               << "\n";
+        }
+        os << "# HELP " << before << " AST nodes given to each pass\n"
+           << "# TYPE " << before << " counter\n";
+        for (auto &pass : passes_) {
+            os << before << "{pass=\"" << pass.name << "\"} "
+               << pass.nodes_before << "\n";
+        }
+        os << "# HELP " << after << " AST nodes left by each pass\n"
+           << "# TYPE " << after << " counter\n";
+        for (auto &pass : passes_) {
+            os << after << "{pass=\"" << pass.name << "\"} "
+               << pass.nodes_after << "\n";
+        }
+    }
+
+    auto precision = os.precision(9);
+    auto phase = prefix + "_phase_duration_seconds";
+    os << "# HELP " << phase << " time spent in each phase of parsing\n"
+       << "# TYPE " << phase << " histogram\n";
+    for (int i = 0; i < (int)Phase::kNrPhase; i++) {
+        auto &h = phases_[i];
+        if (!h.count())
+            continue;
+
+        std::string label = std::string("phase=\"") + phase_names[i] + "\"";
+
+        // a fixed set of bounds, 256 ns to ~69 s, so the series don't change
+        // from one scrape to the next. durations are whole ns, so bucket b
+        // holds at most 2^b - 1 ns
+        uint64_t cumulative = 0;
+        int b = 0;
+        for (int bound = 8; bound <= 36; bound += 2) {
+            for (; b <= bound; b++)
+                cumulative += h.bucket(b);
+            os << phase << "_bucket{" << label << ",le=\""
+               << (LatencyHistogram::UpperBound(bound) - 1) / 1e9 << "\"} "
+               << cumulative << "\n";
+        }
+        os << phase << "_bucket{" << label << ",le=\"+Inf\"} " << h.count()
+           << "\n"
+           << phase << "_sum{" << label << "} " << h.sum() / 1e9 << "\n"
+           << phase << "_count{" << label << "} " << h.count() << "\n";
+    }
+    os.precision(precision);
 }
 
+}
@@ -11,6 +11,12 @@
 
 namespace jast {
 
+#ifndef DISABLE_COUNTERS
+#define COUNT(counter) context()->Counters().counter
+#else
+#define COUNT(counter)
+#endif
+
 
 // TokenizerState implementation
 // -------------------------------
@@ -37,6 +43,8 @@ public:
         seek_ = 0;
         last_col_length_ = 0;
         position_ = Position();
+        token_ = Token();
+        last_token_ = Token();
     }
 
     inline size_type &seek() {
@@ -56,8 +64,8 @@ public:
     }
 
     inline void setToken(Token token) {
-        last_token_ = token_;
-        token_ = token;
+        last_token_ = std::move(token_);
+        token_ = std::move(token);
     }
 
     inline void setPosition(int col, int row) {
@@ -71,11 +79,11 @@ public:
 
     inline char_type readchar() {
         char ch = scanner_->readchar();
-        context()->Counters().InputCharacter()++;
+        COUNT(InputCharacter()++);
         if (ch == '\n') {
             position_.row()++;
 
-            context()->Counters().Line()++;
+            COUNT(Line()++);
             // save the last column position
             last_col_length_ = position_.col();
             position_.col() = 0;
@@ -91,6 +99,16 @@ public:
         return ch;
     }
 
+    // readchar() until `a`, `b` or `c`, which is left in the input, in one
+    // go. none of them is a newline, so the characters are on one row
+    inline void readuntil(std::string &str, char_type a, char_type b,
+        char_type c) {
+        auto count = scanner_->readuntil(str, a, b, c);
+        COUNT(InputCharacter() += count);
+        position_.col() += count;
+        seek_ += count;
+    }
+
     inline void putback(char_type ch) {
         seek_--;
         if (ch == EOF)
@@ -100,13 +118,13 @@ public:
             // FIXME: we can only go back to last line correctly
             position_.col() = last_col_length_;
             position_.row()--;
-            context()->Counters().Line()--;
+            COUNT(Line()--);
         } else {
             assert(position_.col() != 0);
             position_.col()--;
         }
         scanner_->putback(ch);
-        context()->Counters().InputCharacter()++;
+        COUNT(InputCharacter()++);
     }
 
 private:
@@ -299,8 +317,9 @@ void Tokenizer::reset(CharacterStream *stream) {
 }
 
 void Tokenizer::advance(bool divide_expected) {
+    PhaseTimer timer(context()->Counters(), Phase::kTokenize);
     _ setToken(advance_internal(divide_expected));
-    context()->Counters().Token()++;
+    COUNT(Token()++);
 }
 
 TokenType Tokenizer::peek() {
@@ -309,6 +328,49 @@ TokenType Tokenizer::peek() {
     return _ token().type();
 }
 
+char Tokenizer::peekChar() {
+    // read from the stream itself, the position only moves when the
+    // characters are read again for the next token
+    auto scanner = _ scanner_;
+    std::string skipped;
+    auto read = [scanner, &skipped]() {
+        char ch = scanner->readchar();
+        if (ch != EOF)
+            skipped.push_back(ch);
+        return ch;
+    };
+
+    char ch = read();
+    while (true) {
+        while (ch != EOF && IsSpace(ch))
+            ch = read();
+        if (ch != '/')
+            break;
+
+        char next = read();
+        if (next == '/') {
+            while (ch != EOF && ch != '\n')
+                ch = read();
+        } else if (next == '*') {
+            char last = 0;
+            ch = read();
+            while (ch != EOF && (last != '*' || ch != '/')) {
+                last = ch;
+                ch = read();
+            }
+            if (ch != EOF)
+                ch = read();
+        } else {
+            break;
+        }
+    }
+
+    // the stream gives back the last character put back first
+    for (auto it = skipped.rbegin(); it != skipped.rend(); ++it)
+        scanner->putback(*it);
+    return ch;
+}
+
 Token &Tokenizer::currentToken() {
     return _ token();
 }
@@ -543,8 +605,15 @@ Token Tokenizer::parseString(char delim) {
 
     auto seek = _ seek();
     auto position = _ position();
-    char ch = _ readchar();
-    while (ch != EOF && ch != delim) {
+    char ch;
+    while (true) {
+        // the plain characters in one go, then the one which stopped them
+        // one by one, as newlines move the position to the next row
+        _ readuntil(buffer, delim, '\\', '\n');
+        ch = _ readchar();
+        if (ch == EOF || ch == delim)
+            break;
+
         // escape characters
         if (ch == '\\') {
             buffer.push_back(ch);
@@ -554,7 +623,6 @@ Token Tokenizer::parseString(char delim) {
             }
         }
         buffer.push_back(ch);
-        ch = _ readchar();
     }
 
     if (ch == EOF) {
@@ -563,7 +631,7 @@ Token Tokenizer::parseString(char delim) {
 
     TokenType type = delim == '`' ? TokenType::TEMPLATE : TokenType::STRING;
 
-    return Token(buffer, type, position, seek);
+    return Token(std::move(buffer), type, position, seek);
 }
 
 Token Tokenizer::parseNumber(char start) {
@@ -611,13 +679,24 @@ Token Tokenizer::parseNumber(char start) {
             isdouble = true;
         }
 
-        if (ch != EOF)
+        // only a character which goes on with the number is a part of it,
+        // `2:` is the number 2 and a colon
+        if (tolower(ch) == 'e') {
+            had_exp = true;
+            isdouble = true;
+        }
+        bool taken = isdigit(ch) || tolower(ch) == 'e' || ch == '.';
+        if (taken)
             buffer.push_back(ch);
 
-        while (isdigit(ch) || (tolower(ch) == 'e') || ch == '.') {
+        while (taken) {
+            char last = ch;
             ch = _ readchar();
 
-            if (ch == '.') {
+            if ((ch == '+' || ch == '-') && tolower(last) == 'e') {
+                // the sign of the exponent, as in 1e+21
+                buffer.push_back(ch);
+            } else if (ch == '.') {
                 if (!seen_dot) {
                     seen_dot = true;
                     isdouble = true;
@@ -0,0 +1,231 @@
+#include "jast/trace.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace jast {
+
+namespace {
+
+struct Event {
+    const char *name;
+    const char *category;
+    uint64_t ts;
+    char phase;
+    char arg[39];
+};
+
+// written by its thread only, `size` is published with release so that
+// Write() can read the events below it from another thread
+struct ThreadBuffer {
+    ThreadBuffer(size_t capacity, uint32_t tid)
+        : events{ new Event[capacity] }, capacity{ capacity }, size{ 0 },
+          depth{ 0 }, tid{ tid }
+    { }
+
+    std::unique_ptr<Event[]> events;
+    size_t capacity;
+    std::atomic<size_t> size;
+    size_t depth;
+    uint32_t tid;
+    std::string name;
+};
+
+struct Registry {
+    std::mutex lock;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    size_t capacity = 1 << 20;
+
+    // bumped by Clear(), so threads drop their stale buffer pointers
+    std::atomic<uint64_t> generation{ 1 };
+    std::atomic<size_t> dropped{ 0 };
+    std::chrono::steady_clock::time_point origin
+        = std::chrono::steady_clock::now();
+};
+
+Registry &registry()
+{
+    static Registry registry;
+    return registry;
+}
+
+thread_local ThreadBuffer *current = nullptr;
+thread_local uint64_t current_generation = 0;
+
+ThreadBuffer *Buffer()
+{
+    auto &r = registry();
+    uint64_t generation = r.generation.load(std::memory_order_acquire);
+    if (current && current_generation == generation)
+        return current;
+
+    std::lock_guard<std::mutex> lock(r.lock);
+    r.buffers.push_back(std::make_unique<ThreadBuffer>(r.capacity,
+        (uint32_t)r.buffers.size() + 1));
+    current = r.buffers.back().get();
+    current_generation = generation;
+    return current;
+}
+
+uint64_t Now()
+{
+    auto diff = std::chrono::steady_clock::now() - registry().origin;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(diff).count();
+}
+
+void Record(ThreadBuffer *buffer, const char *name, const char *category,
+    char phase, const char *arg)
+{
+    size_t size = buffer->size.load(std::memory_order_relaxed);
+    Event &event = buffer->events[size];
+    event.name = name;
+    event.category = category;
+    event.ts = Now();
+    event.phase = phase;
+    event.arg[0] = '\0';
+    if (arg) {
+        strncpy(event.arg, arg, sizeof(event.arg) - 1);
+        event.arg[sizeof(event.arg) - 1] = '\0';
+    }
+    buffer->size.store(size + 1, std::memory_order_release);
+}
+
+void WriteString(std::ostream &os, const char *str)
+{
+    os << '"';
+    for (const char *p = str; *p; p++) {
+        unsigned char ch = *p;
+        if (ch == '"' || ch == '\\') {
+            os << '\\' << ch;
+        } else if (ch < 0x20) {
+            const char *hex = "0123456789abcdef";
+            os << "\\u00" << hex[ch >> 4] << hex[ch & 15];
+        } else {
+            os << ch;
+        }
+    }
+    os << '"';
+}
+
+}
+
+std::atomic<bool> Tracer::enabled_{ false };
+
+void Tracer::Start(size_t events)
+{
+    auto &r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.lock);
+        r.capacity = events < 2 ? 2 : events;
+    }
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::Stop()
+{
+    enabled_.store(false, std::memory_order_relaxed);
+}
+
+bool Tracer::Begin(const char *name, const char *category)
+{
+    ThreadBuffer *buffer = Buffer();
+
+    // keep room for this event, its end and the ends of the open scopes
+    size_t size = buffer->size.load(std::memory_order_relaxed);
+    if (size + buffer->depth + 2 > buffer->capacity) {
+        registry().dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Record(buffer, name, category, 'B', nullptr);
+    buffer->depth++;
+    return true;
+}
+
+void Tracer::End(const char *arg)
+{
+    ThreadBuffer *buffer = Buffer();
+
+    // the buffers were cleared while the scope was open
+    if (!buffer->depth)
+        return;
+
+    buffer->depth--;
+    Record(buffer, nullptr, nullptr, 'E', arg);
+}
+
+void Tracer::SetThreadName(const std::string &name)
+{
+    ThreadBuffer *buffer = Buffer();
+    std::lock_guard<std::mutex> lock(registry().lock);
+    buffer->name = name;
+}
+
+size_t Tracer::dropped()
+{
+    return registry().dropped.load(std::memory_order_relaxed);
+}
+
+void Tracer::Clear()
+{
+    auto &r = registry();
+    std::lock_guard<std::mutex> lock(r.lock);
+    r.buffers.clear();
+    r.dropped.store(0, std::memory_order_relaxed);
+    r.generation.fetch_add(1, std::memory_order_release);
+}
+
+void Tracer::Write(std::ostream &os)
+{
+    auto &r = registry();
+    std::lock_guard<std::mutex> lock(r.lock);
+    int pid = getpid();
+    const char *sep = "\n";
+
+    os << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    for (auto &buffer : r.buffers) {
+        if (!buffer->name.empty()) {
+            os << sep << "{\"name\": \"thread_name\", \"ph\": \"M\", "
+               << "\"pid\": " << pid << ", \"tid\": " << buffer->tid
+               << ", \"args\": {\"name\": ";
+            WriteString(os, buffer->name.c_str());
+            os << "}}";
+            sep = ",\n";
+        }
+
+        size_t size = buffer->size.load(std::memory_order_acquire);
+        for (size_t i = 0; i < size; i++) {
+            const Event &event = buffer->events[i];
+            os << sep << "{\"ph\": \"" << event.phase << "\", ";
+            if (event.name) {
+                os << "\"name\": ";
+                WriteString(os, event.name);
+                os << ", \"cat\": ";
+                WriteString(os, event.category);
+                os << ", ";
+            }
+
+            // microseconds, with the ns as the fraction
+            os << "\"ts\": " << event.ts / 1000 << "." << (char)('0'
+                + event.ts / 100 % 10) << (char)('0' + event.ts / 10 % 10)
+               << (char)('0' + event.ts % 10) << ", \"pid\": " << pid
+               << ", \"tid\": " << buffer->tid;
+            if (event.arg[0]) {
+                os << ", \"args\": {\"name\": ";
+                WriteString(os, event.arg);
+                os << "}";
+            }
+            os << "}";
+            sep = ",\n";
+        }
+    }
+    os << "\n]}\n";
+}
+
+}
@@ -0,0 +1,156 @@
+#include <jast/allocation-profiler.h>
+#include <jast/astfactory.h>
+#include <jast/parser-builder.h>
+
+#include <gtest/gtest.h>
+
+#include "../test-helpers.h"
+
+#include <string>
+#include <sstream>
+
+using namespace jast;
+using namespace jast::test;
+
+namespace {
+
+const char *kSource =
+    "var a = [1, 2, 3];\n"
+    "var o = { x: 1, 'a property name too long to be inline': 2 };\n";
+
+TEST(AllocationProfilerTest, Disabled) {
+    AllocationProfiler profiler;
+    Parse(kSource);
+    EXPECT_EQ(nullptr, AllocationProfiler::current());
+    EXPECT_EQ(0u, profiler.total().count);
+    EXPECT_TRUE(profiler.Sites().empty());
+}
+
+TEST(AllocationProfilerTest, Attribution) {
+    SKIP_WITHOUT_COUNTERS();
+    std::istringstream is(kSource);
+    ParserBuilder builder(is);
+    builder.builder()->SetArrayPacking(true);
+    Parser *parser = builder.Build();
+    Statistics &stats = builder.context()->Counters();
+
+    AllocationProfiler profiler(&stats);
+    profiler.Start();
+    ParseProgram(parser);
+    profiler.Stop();
+
+    auto array = profiler.ByNodeType(ASTNodeType::kArrayLiteral);
+    EXPECT_EQ(1u, array.count);
+    EXPECT_EQ(sizeof(ArrayLiteral), array.bytes);
+    EXPECT_EQ(5u, profiler.ByNodeType(ASTNodeType::kIntegralLiteral).count);
+    EXPECT_EQ(0u, profiler.ByNodeType(ASTNodeType::kCallExpression).count);
+
+    // every growth of the array, and the properties reserved at once with
+    // the name which isn't inline
+    auto proxy = profiler.ByContainer(AllocationContainer::kProxyArray);
+    EXPECT_LE(1u, proxy.count);
+    EXPECT_LE(3 * sizeof(Handle<Expression>), proxy.bytes);
+    auto object = profiler.ByContainer(AllocationContainer::kProxyObject);
+    EXPECT_EQ(2u, object.count);
+    EXPECT_EQ(2 * sizeof(ProxyObject::value_type)
+        + AllocationProfiler::StringBytes(
+            "a property name too long to be inline"), object.bytes);
+
+    // the array node, its buffers and the numbers of it are made by
+    // ParseArrayLiteral, which packs the numbers first and makes nodes of
+    // them as the array is too short to stay packed. the numbers of the
+    // object are made by ParsePrimary
+    auto packed = profiler.ByContainer(AllocationContainer::kPackedArray);
+    EXPECT_LE(1u, packed.count);
+    auto site = profiler.BySite("ParseArrayLiteral");
+    EXPECT_EQ(4 + proxy.count + packed.count, site.count);
+    EXPECT_EQ(sizeof(ArrayLiteral) + 3 * sizeof(IntegralLiteral) + proxy.bytes
+        + packed.bytes, site.bytes);
+    EXPECT_EQ(2u, profiler.BySite("ParsePrimary").count);
+    EXPECT_EQ(0u, profiler.BySite("(none)").count);
+
+    size_t count = 0, bytes = 0;
+    auto sites = profiler.Sites();
+    for (auto &entry : sites) {
+        count += entry.second.count;
+        bytes += entry.second.bytes;
+    }
+    EXPECT_EQ(profiler.total().count, count);
+    EXPECT_EQ(profiler.total().bytes, bytes);
+    for (size_t i = 1; i < sites.size(); i++)
+        EXPECT_GE(sites[i - 1].second.bytes, sites[i].second.bytes);
+
+    EXPECT_EQ(profiler.total().count, stats.Allocations());
+
+    std::ostringstream os;
+    profiler.DumpJSON(os);
+    EXPECT_NE(std::string::npos, os.str().find("\"ArrayLiteral\": {\"count\": 1"));
+    EXPECT_NE(std::string::npos, os.str().find("\"ProxyObject\": {\"count\": 2"));
+    EXPECT_NE(std::string::npos, os.str().find("\"ParseObjectLiteral\""));
+
+    profiler.Clear();
+    EXPECT_EQ(0u, profiler.total().count);
+}
+
+TEST(AllocationProfilerTest, Nesting) {
+    SKIP_WITHOUT_COUNTERS();
+    AllocationProfiler outer, inner;
+    outer.Start();
+    EXPECT_EQ(&outer, AllocationProfiler::current());
+    inner.Start();
+    EXPECT_EQ(&inner, AllocationProfiler::current());
+
+    Parse("x;");
+    inner.Stop();
+    EXPECT_EQ(&outer, AllocationProfiler::current());
+    EXPECT_EQ(0u, outer.total().count);
+    EXPECT_LT(0u, inner.total().count);
+
+    {
+        AllocationSite site("Test");
+        ASTFactory::GetFactoryInstance()->NewExpressionList();
+    }
+    ASTFactory::GetFactoryInstance()->NewExpressionList();
+    outer.Stop();
+    EXPECT_EQ(nullptr, AllocationProfiler::current());
+
+    EXPECT_EQ(2u, outer.ByContainer(AllocationContainer::kExpressionList).count);
+    EXPECT_EQ(1u, outer.BySite("Test").count);
+    EXPECT_EQ(1u, outer.BySite("(none)").count);
+}
+
+TEST(AllocationProfilerTest, RetainedBytes) {
+    auto factory = ASTFactory::GetFactoryInstance();
+    Position pos;
+
+    EXPECT_EQ(0u, AllocationProfiler::StringBytes("short"));
+    std::string name(100, 'x');
+    EXPECT_LE(101u, AllocationProfiler::StringBytes(name));
+
+    auto one = factory->NewIntegralLiteral(pos, nullptr, 1);
+    auto id = factory->NewIdentifier(pos, nullptr, name);
+    ProxyArray elements{ one, id, one };
+    auto array = factory->NewArrayLiteral(pos, nullptr, elements);
+
+    // `one` is shared and counted once
+    size_t expected = sizeof(ArrayLiteral)
+        + array->AsArrayLiteral()->exprs().capacity() * sizeof(Handle<Expression>)
+        + sizeof(IntegralLiteral) + sizeof(Identifier)
+        + AllocationProfiler::StringBytes(name);
+    EXPECT_EQ(expected, AllocationProfiler::RetainedBytes(array.GetPtr()));
+    EXPECT_EQ(sizeof(IntegralLiteral),
+        AllocationProfiler::RetainedBytes(one.GetPtr()));
+    EXPECT_EQ(0u, AllocationProfiler::RetainedBytes(nullptr));
+
+    // a whole program holds at least its nodes
+    Statistics stats;
+    ParseOptions options;
+    options.stats = &stats;
+    auto ast = Parse(kSource, options);
+    size_t nodes = 0;
+    for (int i = 1; i < (int)ASTNodeType::kNrType; i++)
+        nodes += stats.NodeBytes((ASTNodeType)i);
+    EXPECT_LE(nodes, AllocationProfiler::RetainedBytes(ast.GetPtr()));
+}
+
+}
@@ -80,7 +80,7 @@ bool AstBuilderTest::run() {
         NewBinaryExpression(BinaryOperation::kAddition, nullptr, nullptr));
 
     TEST_AST_BUILDER_FOR(AssignExpression,
-                         NewAssignExpression(nullptr, nullptr));
+        NewAssignExpression(AssignOperation::kAssign, nullptr, nullptr));
     TEST_AST_BUILDER_FOR(TernaryExpression,
                          NewTernaryExpression(nullptr, nullptr, nullptr));
 
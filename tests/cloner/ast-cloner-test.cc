@@ -0,0 +1,211 @@
+#include <jast/parser-builder.h>
+#include <jast/ast-children.h>
+#include <jast/ast-cloner.h>
+#include <jast/ast-hash.h>
+#include <jast/code-printer.h>
+#include <jast/dead-code.h>
+#include <jast/frozen-ast.h>
+
+#include <gtest/gtest.h>
+
+#include "../test-helpers.h"
+
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace jast;
+using namespace jast::test;
+
+namespace {
+
+void Preorder(Expression *node, std::vector<Expression*> &out)
+{
+    out.push_back(node);
+    ForEachChild(node, [&out](Expression *child) { Preorder(child, out); });
+}
+
+// the copy has the nodes of the original in the same places, with the same
+// data, and none of them
+void ExpectCopy(Expression *original, Expression *copy)
+{
+    std::vector<Expression*> expected, actual;
+    Preorder(original, expected);
+    Preorder(copy, actual);
+    ASSERT_EQ(expected.size(), actual.size());
+
+    std::set<Expression*> originals(expected.begin(), expected.end());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_EQ(expected[i]->type(), actual[i]->type());
+        EXPECT_EQ(expected[i]->loc().row(), actual[i]->loc().row());
+        EXPECT_EQ(expected[i]->loc().col(), actual[i]->loc().col());
+        EXPECT_EQ(expected[i]->GetScope(), actual[i]->GetScope());
+        EXPECT_EQ(expected[i]->hash(), actual[i]->hash());
+        EXPECT_EQ(0u, originals.count(actual[i]));
+    }
+    EXPECT_EQ(Print(original), Print(copy));
+}
+
+// counts the nodes and lists it makes
+class CountingFactory : public ASTFactory {
+public:
+    size_t lists = 0;
+    size_t identifiers = 0;
+
+    Handle<ExpressionList> NewExpressionList() override
+    {
+        lists++;
+        return ASTFactory::NewExpressionList();
+    }
+
+    Handle<Expression> NewIdentifier(Position &loc, Scope *scope,
+        std::string name) override
+    {
+        identifiers++;
+        return ASTFactory::NewIdentifier(loc, scope, name);
+    }
+};
+
+TEST(ASTClonerTest, Copy) {
+    auto ast = Parse(kProgram);
+    StructuralHasher::Hash(ast);
+
+    auto copy = ASTCloner().Clone(ast.GetPtr());
+    ASSERT_TRUE(copy);
+    ExpectCopy(ast.GetPtr(), copy.GetPtr());
+
+    EXPECT_FALSE(ASTCloner().Clone(nullptr));
+}
+
+// a packed array is copied packed
+TEST(ASTClonerTest, Packed) {
+    std::string source = "t = [";
+    for (int i = 0; i < 100; i++)
+        source += "'" + std::to_string(i) + "', ";
+    auto ast = Parse(source + "'100'];", ParseOptions::Packing());
+    StructuralHasher::Hash(ast);
+
+    auto copy = ASTCloner().Clone(ast.GetPtr());
+    ExpectCopy(ast.GetPtr(), copy.GetPtr());
+    auto assign = Statement(copy);
+    auto array = assign->AsAssignExpression()->rhs()->AsArrayLiteral();
+    ASSERT_TRUE(array->packed());
+    EXPECT_EQ(101u, array->packed()->size());
+}
+
+// the bindings of the ScopeResolver are kept
+TEST(ASTClonerTest, Bindings) {
+    auto ast = Parse(kProgram, ParseOptions::Resolved());
+
+    auto copy = ASTCloner().Clone(ast.GetPtr());
+    std::vector<Expression*> expected, actual;
+    Preorder(ast.GetPtr(), expected);
+    Preorder(copy.GetPtr(), actual);
+    ASSERT_EQ(expected.size(), actual.size());
+
+    size_t resolved = 0;
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (!expected[i]->IsIdentifier())
+            continue;
+        auto binding = static_cast<Identifier*>(expected[i])->binding();
+        EXPECT_EQ(binding, static_cast<Identifier*>(actual[i])->binding());
+        resolved += binding.resolved();
+    }
+    EXPECT_LT(0u, resolved);
+}
+
+TEST(ASTClonerTest, Subtree) {
+    auto ast = Parse(kProgram);
+
+    ASTCloner cloner;
+    for (auto &stmt : *ast->AsBlockStatement()->statements()) {
+        auto copy = cloner.Clone(stmt.GetPtr());
+        ExpectCopy(stmt.GetPtr(), copy.GetPtr());
+    }
+}
+
+// rewriting the copy leaves the original as it was
+TEST(ASTClonerTest, Private) {
+    auto ast = Parse(
+        "if (0) { f(); } else { g(); } while (false) h(); return; k();");
+    std::string original = Print(ast);
+
+    auto copy = ASTCloner().Clone(ast.GetPtr());
+    PassManager manager;
+    AddDeadCodePasses(&manager);
+    EXPECT_TRUE(manager.Run(copy));
+
+    EXPECT_EQ("g();return;", Print(copy));
+    EXPECT_EQ(original, Print(ast));
+}
+
+TEST(ASTClonerTest, Deep) {
+    std::string source = "x = a";
+    for (int i = 0; i < 100000; i++)
+        source += " + a";
+    source += ";";
+    auto ast = Parse(source);
+
+    auto copy = ASTCloner().Clone(ast.GetPtr());
+    EXPECT_EQ(CountNodes(ast.GetPtr()), CountNodes(copy.GetPtr()));
+}
+
+// the nodes come from the factory given
+TEST(ASTClonerTest, Factory) {
+    auto ast = Parse(kProgram);
+
+    // the body of `case 1: case 2:` is in the tree twice, made once
+    std::vector<Expression*> nodes;
+    Preorder(ast.GetPtr(), nodes);
+    std::set<Expression*> identifiers;
+    for (auto node : nodes) {
+        if (node->IsIdentifier())
+            identifiers.insert(node);
+    }
+
+    CountingFactory factory;
+    auto copy = ASTCloner(&factory).Clone(ast.GetPtr());
+    ExpectCopy(ast.GetPtr(), copy.GetPtr());
+    EXPECT_EQ(identifiers.size(), factory.identifiers);
+    EXPECT_LT(0u, factory.lists);
+}
+
+// threads copy one frozen tree at once, and the nodes shared by a
+// hash-consed tree are shared by the copies
+TEST(ASTClonerTest, Frozen) {
+    auto ast = Parse(kProgram, ParseOptions::HashConsing());
+    std::string expected = Print(ast);
+    auto frozen = FrozenAST::Freeze(ast);
+    ast = nullptr;
+
+    const int kThreads = 4;
+    std::vector<Handle<Expression>> copies(kThreads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; i++) {
+        threads.emplace_back([&frozen, &copies, i] {
+            copies[i] = ASTCloner().Clone(frozen->root());
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    for (auto &copy : copies) {
+        EXPECT_EQ(expected, Print(copy));
+        std::vector<Expression*> nodes;
+        Preorder(copy.GetPtr(), nodes);
+        ASSERT_EQ(frozen->size(), nodes.size());
+        for (size_t i = 0; i < nodes.size(); i++)
+            EXPECT_EQ(frozen->node(i).type(), nodes[i]->type());
+        std::set<const Expression*> unique, copied;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            unique.insert(frozen->node(i).get());
+            copied.insert(nodes[i]);
+        }
+        EXPECT_LT(unique.size(), nodes.size());
+        EXPECT_EQ(unique.size(), copied.size());
+    }
+    EXPECT_FALSE(ASTCloner().Clone(NodeRef()));
+}
+
+}
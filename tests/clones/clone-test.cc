@@ -0,0 +1,147 @@
+#include <jast/clone-detector.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace jast;
+
+namespace {
+
+const char *kFirst =
+    "function sum(list) {\n"
+    "    var total = 0;\n"
+    "    for (var i = 0; i < list.length; i++) {\n"
+    "        if (list[i] > 0) total = total + list[i];\n"
+    "    }\n"
+    "    return total;\n"
+    "}\n";
+
+// kFirst with renamed variables
+const char *kRenamed =
+    "x = 1;\n"
+    "function add(items) {\n"
+    "    var acc = 0;\n"
+    "    for (var j = 0; j < items.length; j++) {\n"
+    "        if (items[j] > 0) acc = acc + items[j];\n"
+    "    }\n"
+    "    return acc;\n"
+    "}\n";
+
+const char *kLarge =
+    "function stats(list) {\n"
+    "    var total = 0, min = list[0], max = list[0];\n"
+    "    for (var i = 0; i < list.length; i++) {\n"
+    "        if (list[i] < min) min = list[i];\n"
+    "        if (list[i] > max) max = list[i];\n"
+    "        total = total + list[i];\n"
+    "    }\n"
+    "    var mean = total / list.length;\n"
+    "    log('mean', mean, 'min', min, 'max', max);\n"
+    "    return { total: total, mean: mean, min: min, max: max };\n"
+    "}\n";
+
+// kLarge with an extra statement at the end of the loop
+const char *kExtended =
+    "function stats(list) {\n"
+    "    var total = 0, min = list[0], max = list[0];\n"
+    "    for (var i = 0; i < list.length; i++) {\n"
+    "        if (list[i] < min) min = list[i];\n"
+    "        if (list[i] > max) max = list[i];\n"
+    "        total = total + list[i];\n"
+    "        count = count + 1;\n"
+    "    }\n"
+    "    var mean = total / list.length;\n"
+    "    log('mean', mean, 'min', min, 'max', max);\n"
+    "    return { total: total, mean: mean, min: min, max: max };\n"
+    "}\n";
+
+CloneDetector::Options MakeOptions(size_t min_nodes)
+{
+    CloneDetector::Options options;
+    options.min_nodes = min_nodes;
+    options.threads = 2;
+    return options;
+}
+
+TEST(CloneDetectorTest, FindsRenamedClones) {
+    CloneDetector detector(MakeOptions(20));
+    detector.AddFile("a.js", kFirst);
+    detector.AddFile("b.js", kRenamed);
+
+    auto groups = detector.Run();
+    ASSERT_TRUE(detector.error(0).empty());
+    ASSERT_TRUE(detector.error(1).empty());
+
+    // the functions are reported, not the loops inside them
+    ASSERT_EQ(1u, groups.size());
+    ASSERT_TRUE(groups[0].exact);
+    ASSERT_EQ(2u, groups[0].fragments.size());
+    ASSERT_NE(groups[0].fragments[0].file, groups[0].fragments[1].file);
+    ASSERT_TRUE(groups[0].fragments[0].node->IsFunctionStatement());
+    ASSERT_EQ(groups[0].fragments[0].size, groups[0].fragments[1].size);
+}
+
+TEST(CloneDetectorTest, ValuesSensitivity) {
+    auto options = MakeOptions(20);
+    options.sensitivity = HashSensitivity::kTypesAndValues;
+
+    CloneDetector detector(options);
+    detector.AddFile("a.js", kFirst);
+    detector.AddFile("b.js", kRenamed);
+    ASSERT_TRUE(detector.Run().empty());
+
+    CloneDetector same(options);
+    same.AddFile("a.js", kFirst);
+    same.AddFile("b.js", kFirst);
+    ASSERT_EQ(1u, same.Run().size());
+}
+
+TEST(CloneDetectorTest, SmallTreesAreIgnored) {
+    CloneDetector detector(MakeOptions(1000));
+    detector.AddFile("a.js", kFirst);
+    detector.AddFile("b.js", kFirst);
+    ASSERT_TRUE(detector.Run().empty());
+}
+
+TEST(CloneDetectorTest, NearMiss) {
+    auto options = MakeOptions(30);
+    options.near_miss = true;
+    options.similarity = 0.6;
+
+    CloneDetector detector(options);
+    detector.AddFile("a.js", kLarge);
+    detector.AddFile("b.js", kExtended);
+
+    // the programs are the outermost similar trees, nothing nested in them
+    // is reported
+    auto groups = detector.Run();
+    ASSERT_EQ(1u, groups.size());
+    ASSERT_FALSE(groups[0].exact);
+    ASSERT_GE(groups[0].similarity, 0.6);
+    ASSERT_LT(groups[0].similarity, 1.0);
+    ASSERT_EQ(2u, groups[0].fragments.size());
+    ASSERT_TRUE(groups[0].fragments[0].node->IsBlockStatement());
+    ASSERT_TRUE(groups[0].fragments[1].node->IsBlockStatement());
+    ASSERT_EQ(0u, groups[0].fragments[0].file);
+    ASSERT_EQ(1u, groups[0].fragments[1].file);
+
+    options.near_miss = false;
+    CloneDetector exact(options);
+    exact.AddFile("a.js", kLarge);
+    exact.AddFile("b.js", kExtended);
+    for (auto &group : exact.Run())
+        ASSERT_TRUE(group.exact);
+}
+
+TEST(CloneDetectorTest, ParseErrors) {
+    CloneDetector detector(MakeOptions(20));
+    detector.AddFile("a.js", kFirst);
+    detector.AddFile("bad.js", "function (");
+    detector.Run();
+    ASSERT_TRUE(detector.error(0).empty());
+    ASSERT_FALSE(detector.error(1).empty());
+    ASSERT_EQ("bad.js", detector.name(1));
+}
+
+}
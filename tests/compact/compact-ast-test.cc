@@ -0,0 +1,97 @@
+#include <jast/parser-builder.h>
+#include <jast/ast-children.h>
+#include <jast/ast-pass.h>
+#include <jast/code-printer.h>
+#include <jast/compact-ast.h>
+#include <jast/dead-code.h>
+
+#include <gtest/gtest.h>
+
+#include "../test-helpers.h"
+
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace jast;
+using namespace jast::test;
+
+namespace {
+
+void Preorder(Expression *node, std::vector<Expression*> &out)
+{
+    out.push_back(node);
+    ForEachChild(node, [&out](Expression *child) { Preorder(child, out); });
+}
+
+// every node is in the block, after the one before it in preorder
+TEST(CompactASTTest, Preorder) {
+    auto ast = Parse(kProgram);
+    std::string expected = Print(ast);
+    size_t size = CompactAST::BlockSize(ast.GetPtr());
+
+    CompactAST compact(ast);
+    ast = nullptr;
+    EXPECT_EQ(size, compact.arena().capacity());
+    EXPECT_LE(compact.arena().used(), size);
+    EXPECT_EQ(expected, Print(compact.root()));
+
+    std::vector<Expression*> nodes;
+    Preorder(compact.root().GetPtr(), nodes);
+    std::set<Expression*> seen;
+    Expression *last = nullptr;
+    for (auto node : nodes) {
+        EXPECT_TRUE(compact.arena().Contains(node));
+        // the second place of the body of `case 1: case 2:`
+        if (!seen.insert(node).second)
+            continue;
+        EXPECT_LT(last, node);
+        last = node;
+    }
+}
+
+// the compact tree is rewritten like any other, nodes taken out of it stay
+// in the block and new ones are on the heap
+TEST(CompactASTTest, Rewrite) {
+    CompactAST compact(Parse(
+        "if (1) { f(); } else { g(); } while (false) h(); return; k();"));
+
+    auto root = compact.root();
+    PassManager manager;
+    AddDeadCodePasses(&manager);
+    EXPECT_TRUE(manager.Run(root));
+    EXPECT_EQ("f();return;", Print(root));
+}
+
+TEST(CompactASTTest, Deep) {
+    std::string source = "x = a";
+    for (int i = 0; i < 100000; i++)
+        source += " + a";
+    auto ast = Parse(source + ";");
+    size_t nodes = CountNodes(ast.GetPtr());
+
+    CompactAST compact(ast);
+    ast = nullptr;
+    EXPECT_EQ(nodes, CountNodes(compact.root().GetPtr()));
+}
+
+// what doesn't fit in the block is made on the heap
+TEST(CompactASTTest, Full) {
+    NodeArena arena(2 * sizeof(ExpressionList));
+    auto first = arena.New<ExpressionList>();
+    auto second = arena.New<ExpressionList>();
+    auto third = arena.New<ExpressionList>();
+    EXPECT_TRUE(arena.Contains(first));
+    EXPECT_TRUE(arena.Contains(second));
+    EXPECT_FALSE(arena.Contains(third));
+    delete third;
+}
+
+TEST(CompactASTTest, Empty) {
+    CompactAST compact(nullptr);
+    EXPECT_FALSE(compact.root());
+    EXPECT_EQ(0u, compact.arena().used());
+}
+
+}
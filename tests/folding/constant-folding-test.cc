@@ -0,0 +1,124 @@
+#include <jast/parser-builder.h>
+#include <jast/code-printer.h>
+#include <jast/constant-folder.h>
+
+#include <gtest/gtest.h>
+
+#include "../test-helpers.h"
+
+#include <sstream>
+#include <string>
+
+using namespace jast;
+using namespace jast::test;
+
+namespace {
+
+std::string Fold(const std::string &source)
+{
+    return Print(Parse(source, ParseOptions::Folding()));
+}
+
+// folded by a ConstantFoldingPass after parsing
+std::string FoldPass(const std::string &source)
+{
+    auto ast = Parse(source);
+    ConstantFoldingPass().Run(ast);
+    return Print(ast);
+}
+
+TEST(ConstantFoldingTest, Off) {
+    EXPECT_EQ("1+2*3;", Print(Parse("1 + 2 * 3;")));
+}
+
+TEST(ConstantFoldingTest, Arithmetic) {
+    EXPECT_EQ("7;", Fold("1 + 2 * 3;"));
+    EXPECT_EQ("a*3;", Fold("a * (1 + 2);"));
+    EXPECT_EQ("x+1+2;", Fold("x + 1 + 2;"));
+    EXPECT_EQ("0.30000000000000004;", Fold("0.1 + 0.2;"));
+    EXPECT_EQ("2;-2;-0;", Fold("5 % -3; -5 % 3; -1 % 1;"));
+    EXPECT_EQ("-0;-3;", Fold("-0; -(1 + 2);"));
+    EXPECT_EQ("2;1;+NaN;", Fold("true + 1; null + 1; NaN * 1;"));
+
+    // NaN and Infinity have no literal
+    EXPECT_EQ("1/0;0/0;void 0+1;", Fold("1 / 0; 0 / 0; void 0 + 1;"));
+}
+
+TEST(ConstantFoldingTest, Bitwise) {
+    EXPECT_EQ("-2147483648;4294967295;-1;", Fold("1 << 31; -1 >>> 0; -1 >> 4;"));
+    EXPECT_EQ("1;7;6;", Fold("5 & 3; 5 | 3; 5 ^ 3;"));
+    EXPECT_EQ("0;1;", Fold("4294967296 | 0; 1 << 32;"));
+    EXPECT_EQ("-1;-4;", Fold("~'abc'; ~3.5;"));
+}
+
+TEST(ConstantFoldingTest, Strings) {
+    EXPECT_EQ("\"ab1\";\"33\";", Fold("'a' + 'b' + 1; 1 + 2 + '3';"));
+    EXPECT_EQ("\"anull\";\"trueundefined\";", Fold("'a' + null; true + ('' + void 0);"));
+    EXPECT_EQ("\"\\na\";", Fold("'\\n' + 'a';"));
+
+    // an octal escape would run into the next digit
+    EXPECT_EQ("\"\\1\"+\"2\";\"\\1a\";", Fold("'\\1' + '2'; '\\1' + 'a';"));
+
+    EXPECT_EQ("12;16;12;1000;0;", Fold("'3' * '4'; '0x10' * 1; ' 12 ' - 0;"
+                                       " '1e3' - 0; '' * 1;"));
+    EXPECT_EQ("3;", Fold("+'3';"));
+    EXPECT_EQ("+\"\\x31\\x32\";+\"x\";", Fold("'\\x31\\x32' * 1; 'x' * 1;"));
+}
+
+TEST(ConstantFoldingTest, NumberToString) {
+    EXPECT_EQ("\"1e+21\";\"1e-7\";\"1.23e-18\";\"100\";\"16\";",
+        Fold("1e21 + ''; 0.0000001 + ''; 0.00000000000000000123 + '';"
+             " 100 + ''; 0x10 + '';"));
+
+    EXPECT_EQ("123456789012345680000",
+        ConstantFolder::NumberToString(123456789012345678901.0));
+    EXPECT_EQ("0.000001", ConstantFolder::NumberToString(0.000001));
+    EXPECT_EQ("1.5e-7", ConstantFolder::NumberToString(1.5e-7));
+    EXPECT_EQ("-1.5", ConstantFolder::NumberToString(-1.5));
+    EXPECT_EQ("0", ConstantFolder::NumberToString(-0.0));
+    EXPECT_EQ("5e-324", ConstantFolder::NumberToString(5e-324));
+    EXPECT_EQ("1.7976931348623157e+308",
+        ConstantFolder::NumberToString(1.7976931348623157e308));
+}
+
+TEST(ConstantFoldingTest, Comparison) {
+    EXPECT_EQ("false;true;false;true;", Fold("'b' < 'a'; '10' < '9';"
+                                             " '10' < 9; null >= 0;"));
+    EXPECT_EQ("false;false;false;", Fold("void 0 >= 0; 'x' <= 1; 'x' > 1;"));
+    EXPECT_EQ("true;false;true;true;false;", Fold("1 == '1'; 1 === '1';"
+        " '1' == true; void 0 == null; null == 0;"));
+    EXPECT_EQ("true;false;", Fold("'a' !== 'b'; 'a' != 'a';"));
+
+    // "\x41" is "A", but that needs unescaping
+    EXPECT_EQ("\"\\x41\"==\"A\";true;", Fold("'\\x41' == 'A'; '\\x41' == '\\x41';"));
+}
+
+TEST(ConstantFoldingTest, Unary) {
+    EXPECT_EQ("\"number\";\"string\";\"object\";\"boolean\";",
+        Fold("typeof 1; typeof 's'; typeof null; typeof !0;"));
+    EXPECT_EQ("true;false;true;x=void 0;", Fold("!''; !'0'; !0; x = void 1;"));
+    EXPECT_EQ("typeof x;!x;", Fold("typeof x; !x;"));
+}
+
+TEST(ConstantFoldingTest, Logical) {
+    EXPECT_EQ("a();b();0;\"s\";", Fold("true ? a() : b; 0 ? a : b(); 0 && e();"
+                                       " 's' || f();"));
+    EXPECT_EQ("x&&1;x?1:2;", Fold("x && 1; x ? 1 : 2;"));
+    EXPECT_EQ("3;", Fold("1 < 2 ? 1 + 2 : f();"));
+}
+
+// a name or a property isn't the value of the operator which picks it
+TEST(ConstantFoldingTest, References) {
+    for (auto fold : { Fold, FoldPass }) {
+        EXPECT_EQ("(true&&o.m)();", fold("(true && o.m)();"));
+        EXPECT_EQ("(1?o.m:x)();", fold("(1 ? o.m : x)();"));
+        EXPECT_EQ("typeof(true&&undeclaredVar);",
+            fold("typeof (true && undeclaredVar);"));
+        EXPECT_EQ("delete(1&&x);", fold("delete (1 && x);"));
+        EXPECT_EQ("\"\"||c;1&&d[0];f()(0?a:b);", fold("'' || c; 1 && d[0];"
+                                                    " f()(0 ? a : b);"));
+        EXPECT_EQ("f();g();", fold("true ? f() : x; 0 || g();"));
+    }
+}
+
+}
@@ -0,0 +1,183 @@
+#include <jast/parser-builder.h>
+#include <jast/ast-children.h>
+#include <jast/frozen-ast.h>
+
+#include <gtest/gtest.h>
+
+#include "../test-helpers.h"
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace jast;
+using namespace jast::test;
+
+namespace {
+
+const char *kSource =
+    "var a = [1, 2, 3], b = { x: a, 'y': function (z) { return z * 2; } };\n"
+    "for (;;) { if (a) break; }\n"
+    "switch (x) { case 1: y = f(a, b); break; default: y = !x; }\n";
+
+struct Occurrence {
+    Expression *node;
+    Expression *parent;
+};
+
+void Preorder(Expression *node, Expression *parent,
+    std::vector<Occurrence> &out)
+{
+    out.push_back(Occurrence{ node, parent });
+    ForEachChild(node, [node, &out](Expression *child) {
+        Preorder(child, node, out);
+    });
+}
+
+// the index holds every node in preorder, with the children ForEachChild
+// gives and the parents it came from
+TEST(FrozenASTTest, Structure) {
+    auto ast = Parse(kSource);
+    std::vector<Occurrence> expected;
+    Preorder(ast.GetPtr(), nullptr, expected);
+
+    auto frozen = FrozenAST::Freeze(ast);
+    ASSERT_EQ(expected.size(), frozen->size());
+    EXPECT_EQ(ast.GetPtr(), frozen->root().get());
+    EXPECT_FALSE(frozen->root().parent());
+    EXPECT_EQ(frozen->size(), frozen->root().subtree_size());
+    EXPECT_FALSE(frozen->node(frozen->size()));
+
+    for (size_t i = 0; i < frozen->size(); i++) {
+        NodeRef node = frozen->node(i);
+        EXPECT_EQ(i, node.index());
+        EXPECT_EQ(expected[i].node, node.get());
+        EXPECT_EQ(expected[i].node->type(), node.type());
+        if (i) {
+            EXPECT_EQ(expected[i].parent, node.parent().get());
+        }
+
+        // the subtree is the run of nodes right after this one
+        uint32_t next = node.index() + 1;
+        for (NodeRef child : node) {
+            EXPECT_EQ(node, child.parent());
+            EXPECT_EQ(next, child.index());
+            next += child.subtree_size();
+        }
+        EXPECT_EQ(node.index() + node.subtree_size(), next);
+    }
+
+    size_t i = 0;
+    while (frozen->node(i).type() != ASTNodeType::kIdentifier)
+        i++;
+    auto identifier = frozen->node(i).As<Identifier>();
+    ASSERT_NE(nullptr, identifier);
+    EXPECT_EQ("a", identifier->GetName());
+    EXPECT_EQ(nullptr, frozen->node(i).As<BinaryExpression>());
+}
+
+// a node shared by hash consing is indexed once for every place it occurs
+TEST(FrozenASTTest, HashConsed) {
+    auto ast = Parse("f(a + 1); g(a + 1);", ParseOptions::HashConsing());
+    auto frozen = FrozenAST::Freeze(ast);
+
+    std::vector<NodeRef> sums;
+    for (size_t i = 0; i < frozen->size(); i++) {
+        if (frozen->node(i).type() == ASTNodeType::kBinaryExpression)
+            sums.push_back(frozen->node(i));
+    }
+    ASSERT_EQ(2u, sums.size());
+    EXPECT_EQ(sums[0].get(), sums[1].get());
+    EXPECT_NE(sums[0].parent(), sums[1].parent());
+    EXPECT_EQ(sums[0].subtree_size(), sums[1].subtree_size());
+}
+
+int CountIdentifiers(NodeRef node)
+{
+    int count = node.type() == ASTNodeType::kIdentifier;
+    for (NodeRef child : node)
+        count += CountIdentifiers(child);
+    return count;
+}
+
+// readers share the tree without touching its reference counts, which is
+// what makes this safe without ATOMIC_REFCOUNT
+TEST(FrozenASTTest, SharedReads) {
+    auto frozen = FrozenAST::Freeze(Parse(kSource));
+    std::vector<int> references;
+    for (size_t i = 0; i < frozen->size(); i++)
+        references.push_back(frozen->node(i)->GetNumReferences());
+    int expected = CountIdentifiers(frozen->root());
+    ASSERT_LT(0, expected);
+
+    std::atomic<int> mismatches{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&mismatches, frozen, expected]() {
+            for (int round = 0; round < 100; round++) {
+                if (CountIdentifiers(frozen->root()) != expected)
+                    mismatches++;
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    EXPECT_EQ(0, mismatches.load());
+
+    for (size_t i = 0; i < frozen->size(); i++)
+        EXPECT_EQ(references[i], frozen->node(i)->GetNumReferences());
+}
+
+// the strings are decoded through the const nodes, by whichever thread asks
+// first, the others read the same value
+TEST(FrozenASTTest, StringValues) {
+    auto frozen = FrozenAST::Freeze(Parse(
+        "a = ['tab\\there', 'plain', '\\u00e9\\x41', 'x\\'y'];"));
+    std::vector<const StringLiteral*> strings;
+    for (size_t i = 0; i < frozen->size(); i++) {
+        if (auto str = frozen->node(i).As<StringLiteral>())
+            strings.push_back(str);
+    }
+    ASSERT_EQ(4u, strings.size());
+    const char *expected[] = { "tab\there", "plain", "\xc3\xa9" "A", "x'y" };
+
+    std::atomic<int> mismatches{ 0 };
+    std::vector<const std::string*> values[8];
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&, t]() {
+            for (size_t i = 0; i < strings.size(); i++) {
+                values[t].push_back(&strings[i]->value());
+                if (strings[i]->value() != expected[i])
+                    mismatches++;
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    EXPECT_EQ(0, mismatches.load());
+    for (int t = 1; t < 8; t++)
+        EXPECT_EQ(values[0], values[t]);
+    EXPECT_EQ(&strings[1]->string(), values[0][1]);
+}
+
+// the FrozenAST owns the tree until the last reference to it is gone
+TEST(FrozenASTTest, Release) {
+    auto ast = Parse("a = b + c;");
+    int references = ast->GetNumReferences();
+
+    auto frozen = FrozenAST::Freeze(ast);
+    auto copy = frozen;
+    EXPECT_EQ(references + 1, ast->GetNumReferences());
+    frozen.reset();
+    EXPECT_EQ(references + 1, ast->GetNumReferences());
+    copy.reset();
+    EXPECT_EQ(references, ast->GetNumReferences());
+
+    auto empty = FrozenAST::Freeze(Handle<Expression>());
+    EXPECT_EQ(0u, empty->size());
+    EXPECT_FALSE(empty->root());
+}
+
+}
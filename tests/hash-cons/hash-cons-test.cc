@@ -0,0 +1,99 @@
+#include <jast/parser-builder.h>
+#include <jast/ast-match.h>
+#include <jast/code-printer.h>
+#include <jast/hash-cons.h>
+
+#include <gtest/gtest.h>
+
+#include "../test-helpers.h"
+
+#include <string>
+#include <sstream>
+
+using namespace jast;
+using namespace jast::test;
+
+namespace {
+
+const char *kSource =
+    "Object.defineProperty(exports, \"__esModule\", { value: true });\n"
+    "x = a.b(1, 'str');\n"
+    "Object.defineProperty(exports, \"__esModule\", { value: true });\n"
+    "if (x) { y = a.b(1, 'str'); }\n";
+
+TEST(HashConsTest, OffByDefault) {
+    std::istringstream is(kSource);
+    ParserBuilder builder(is);
+    auto ast = ParseProgram(builder.Build());
+
+    ASSERT_EQ(nullptr, builder.builder()->hash_cons());
+    ASSERT_NE(Statement(ast, 0).GetPtr(), Statement(ast, 2).GetPtr());
+}
+
+TEST(HashConsTest, SharesIdenticalExpressions) {
+    std::istringstream is(kSource);
+    ParserBuilder builder(is);
+    builder.builder()->SetHashConsing(true);
+    auto ast = ParseProgram(builder.Build());
+    auto table = builder.builder()->hash_cons();
+
+    auto first = Statement(ast, 0);
+    auto second = Statement(ast, 2);
+    ASSERT_EQ(first.GetPtr(), second.GetPtr());
+    ASSERT_GT(table->hits(), 0u);
+    ASSERT_GT(table->saved_bytes(), 0u);
+
+    // one position for each occurrence, in source order
+    auto positions = table->positions(first.GetPtr());
+    ASSERT_EQ(2u, positions.size());
+    ASSERT_EQ(2u, table->occurrences(first.GetPtr()));
+    ASSERT_EQ(0u, positions[0].row());
+    ASSERT_EQ(2u, positions[1].row());
+
+    // a.b(1, 'str') is shared between the two assignments
+    auto lhs = Statement(ast, 1)->AsAssignExpression()->rhs();
+    auto body = Statement(ast, 3)->AsIfStatement()->body();
+    auto rhs = Statement(body)
+        ->AsAssignExpression()->rhs();
+    ASSERT_EQ(lhs.GetPtr(), rhs.GetPtr());
+    ASSERT_NE(Statement(ast, 1).GetPtr(),
+        Statement(body).GetPtr());
+}
+
+TEST(HashConsTest, StatementsAreNotShared) {
+    std::istringstream is("function f() { return 1; }\n"
+                          "function f() { return 1; }\n");
+    ParserBuilder builder(is);
+    builder.builder()->SetHashConsing(true);
+    auto ast = ParseProgram(builder.Build());
+
+    ASSERT_NE(Statement(ast, 0).GetPtr(), Statement(ast, 1).GetPtr());
+    ASSERT_EQ(0u, builder.builder()->hash_cons()->occurrences(
+        Statement(ast, 0).GetPtr()));
+}
+
+TEST(HashConsTest, DifferentValuesAreNotShared) {
+    std::istringstream is("a(1); a(2); a('1'); b(1); a(true); a(1);");
+    ParserBuilder builder(is);
+    builder.builder()->SetHashConsing(true);
+    auto ast = ParseProgram(builder.Build());
+
+    for (size_t i = 0; i < 5; i++) {
+        for (size_t j = i + 1; j < 5; j++)
+            ASSERT_NE(Statement(ast, i).GetPtr(), Statement(ast, j).GetPtr());
+    }
+    ASSERT_EQ(Statement(ast, 0).GetPtr(), Statement(ast, 5).GetPtr());
+}
+
+TEST(HashConsTest, SameTreeAsWithout) {
+    std::istringstream a(kSource), b(kSource);
+    ParserBuilder plain(a), shared(b);
+    shared.builder()->SetHashConsing(true);
+
+    auto expected = ParseProgram(plain.Build());
+    auto ast = ParseProgram(shared.Build());
+    ASSERT_TRUE(LazyASTMatcher::match(expected, ast));
+    ASSERT_EQ(Print(expected), Print(ast));
+}
+
+}
@@ -0,0 +1,177 @@
+#include <jast/parser-builder.h>
+#include <jast/ast-match.h>
+#include <jast/ast-hash.h>
+
+#include <gtest/gtest.h>
+
+#include "../test-helpers.h"
+
+#include <string>
+#include <sstream>
+#include <vector>
+
+using namespace jast;
+using namespace jast::test;
+
+namespace {
+
+uint64_t TypesHash(Handle<Expression> ast)
+{
+    return StructuralHasher::Hash(ast, HashSensitivity::kTypes);
+}
+
+uint64_t ValuesHash(Handle<Expression> ast)
+{
+    return StructuralHasher::Hash(ast, HashSensitivity::kTypesAndValues);
+}
+
+const char *kSources[] = {
+    "a = b + 1;",
+    "x = y + 2;",
+    "a = b - 1;",
+    "a += b + 1;",
+    "a = b + 1; c();",
+    "var a = 1, b = 'x';",
+    "var c = 2, d = 'y';",
+    "var c = 2;",
+    "if (a) b(); else c();",
+    "if (a) b();",
+    "switch (a) { case 1: b(); default: c(); }",
+    "switch (a) { case 1: b(); }",
+    "switch (x) { case 2: y(); default: z(); }",
+    "function f(a, b) { return a.b[c](d); }",
+    "function g(c, d) { return c.d[e](f); }",
+    "function g(c) { return c.d[e](f); }",
+    "o = {a: 1, b: [1, 2]};",
+    "o = {c: 2, d: [3, 4]};",
+    "r = /ab+c/g;",
+    "r = /ab+c/i;",
+    "l: for (;;) { break l; }",
+    "m: for (;;) { break m; }",
+    "for (k in o) x();",
+    // packed in the hashed trees
+    "t = [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15];",
+    "t = [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 16];",
+    "t = ['0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '10', '11', '12', '13', '14', '15'];",
+};
+
+TEST(ASTMatcherTest, FastIgnoresValues) {
+    ASSERT_TRUE(FastASTMatcher::match(Parse("a = b + 1;"), Parse("x = y + 2;")));
+    ASSERT_FALSE(FastASTMatcher::match(Parse("a = b + 1;"), Parse("a = b - 1;")));
+    ASSERT_FALSE(FastASTMatcher::match(Parse("a = b + 1;"), Parse("a -= b + 1;")));
+    ASSERT_FALSE(FastASTMatcher::match(Parse("a = b + 1;"), Parse("a = b + c;")));
+    ASSERT_TRUE(FastASTMatcher::match(Parse("var a = 1, b;"), Parse("var c = 2, d;")));
+    ASSERT_FALSE(FastASTMatcher::match(Parse("var a = 1, b;"), Parse("var a = 1;")));
+    ASSERT_FALSE(FastASTMatcher::match(Parse("a.b;"), Parse("a[b];")));
+}
+
+TEST(ASTMatcherTest, LazyComparesValues) {
+    ASSERT_TRUE(LazyASTMatcher::match(Parse("a = b + 1;"), Parse("a = b + 1;")));
+    ASSERT_FALSE(LazyASTMatcher::match(Parse("a = b + 1;"), Parse("x = y + 2;")));
+    ASSERT_FALSE(LazyASTMatcher::match(Parse("a = b + 1;"), Parse("a = b + 2;")));
+    ASSERT_FALSE(LazyASTMatcher::match(Parse("o = {a: 1};"), Parse("o = {b: 1};")));
+    ASSERT_TRUE(LazyASTMatcher::match(Parse("r = /a/g;"), Parse("r = /a/g;")));
+    ASSERT_FALSE(LazyASTMatcher::match(Parse("r = /a/g;"), Parse("r = /a/i;")));
+}
+
+TEST(ASTMatcherTest, Switch) {
+    auto with_default = "switch (a) { case 1: b(); default: c(); }";
+    auto without_default = "switch (a) { case 1: b(); }";
+    ASSERT_TRUE(LazyASTMatcher::match(Parse(with_default), Parse(with_default)));
+    ASSERT_TRUE(LazyASTMatcher::match(Parse(without_default),
+        Parse(without_default)));
+    ASSERT_FALSE(FastASTMatcher::match(Parse(with_default),
+        Parse(without_default)));
+}
+
+// a packed array matches and hashes like the same array unpacked
+TEST(ASTMatcherTest, PackedArray) {
+    std::string source = "t = [";
+    for (int i = 0; i < 100; i++)
+        source += std::to_string(i) + ", ";
+    auto packed = Parse(source + "100];", ParseOptions::Packing());
+    auto other = Parse(source + "101];", ParseOptions::Packing());
+    std::istringstream is(source + "100];");
+    ParserBuilder builder(is);
+    builder.builder()->SetArrayPacking(true);
+    auto unpacked = ParseProgram(builder.Build());
+    auto assign = Statement(unpacked);
+    auto array = assign->AsAssignExpression()->rhs()->AsArrayLiteral();
+    ASSERT_TRUE(array->packed());
+    builder.builder()->UnpackArrayLiteral(array.GetPtr());
+    ASSERT_EQ(101u, array->exprs().size());
+    ASSERT_FALSE(array->packed());
+
+    EXPECT_TRUE(LazyASTMatcher::match(packed, unpacked));
+    EXPECT_TRUE(LazyASTMatcher::match(unpacked, packed));
+    EXPECT_FALSE(LazyASTMatcher::match(packed, other));
+    EXPECT_TRUE(FastASTMatcher::match(other, unpacked));
+    EXPECT_EQ(ValuesHash(packed), ValuesHash(unpacked));
+    EXPECT_NE(ValuesHash(packed), ValuesHash(other));
+    EXPECT_EQ(TypesHash(other), TypesHash(unpacked));
+    EXPECT_TRUE(LazyASTMatcher::match(packed, Parse(source + "100];")));
+
+    // matching reads the packed arrays, it doesn't unpack them
+    assign = Statement(packed);
+    EXPECT_TRUE(assign->AsAssignExpression()->rhs()->AsArrayLiteral()->packed());
+}
+
+TEST(StructuralHashTest, Sensitivity) {
+    ASSERT_EQ(TypesHash(Parse("a = b + 1;")), TypesHash(Parse("x = y + 2;")));
+    ASSERT_NE(TypesHash(Parse("a = b + 1;")), TypesHash(Parse("a = b - 1;")));
+    ASSERT_NE(TypesHash(Parse("a(b);")), TypesHash(Parse("a(b, c);")));
+    ASSERT_NE(ValuesHash(Parse("a = b + 1;")), ValuesHash(Parse("x = y + 2;")));
+    ASSERT_EQ(ValuesHash(Parse("a = b + 1;")), ValuesHash(Parse("a = b + 1;")));
+    ASSERT_EQ(ValuesHash(Parse("a = 0;")), ValuesHash(Parse("a = 0.0;")));
+}
+
+TEST(StructuralHashTest, AgreesWithMatchers) {
+    std::vector<Handle<Expression>> trees, hashed;
+    for (auto source : kSources) {
+        trees.push_back(Parse(source));
+        hashed.push_back(Parse(source, ParseOptions::Packing()));
+    }
+
+    for (int values = 0; values < 2; values++) {
+        auto sensitivity = values ? HashSensitivity::kTypesAndValues
+                                  : HashSensitivity::kTypes;
+        for (auto &tree : hashed)
+            StructuralHasher::Hash(tree, sensitivity);
+
+        for (size_t i = 0; i < trees.size(); i++) {
+            for (size_t j = 0; j < trees.size(); j++) {
+                bool expected = values
+                    ? LazyASTMatcher::match(trees[i], trees[j])
+                    : FastASTMatcher::match(trees[i], trees[j]);
+                bool same_hash = StructuralHasher::Get(hashed[i].GetPtr(),
+                    sensitivity) == StructuralHasher::Get(hashed[j].GetPtr(),
+                    sensitivity);
+
+                // hashes never reject a match and the hashed trees match the
+                // same way as the plain ones
+                ASSERT_TRUE(!expected || same_hash) << kSources[i] << " "
+                    << kSources[j];
+                ASSERT_EQ(expected, values
+                    ? LazyASTMatcher::match(hashed[i], hashed[j])
+                    : FastASTMatcher::match(hashed[i], hashed[j]));
+            }
+        }
+    }
+}
+
+TEST(StructuralHashTest, Clear) {
+    auto ast = Parse("a = b + 1;");
+    ASSERT_EQ(StructuralHasher::Get(ast.GetPtr(), HashSensitivity::kTypes), 0u);
+
+    uint64_t hash = TypesHash(ast);
+    ASSERT_NE(hash, 0u);
+    ASSERT_EQ(StructuralHasher::Get(ast.GetPtr(), HashSensitivity::kTypes), hash);
+    ASSERT_EQ(StructuralHasher::Get(ast.GetPtr(),
+        HashSensitivity::kTypesAndValues), 0u);
+
+    StructuralHasher::Clear(ast);
+    ASSERT_EQ(StructuralHasher::Get(ast.GetPtr(), HashSensitivity::kTypes), 0u);
+    ASSERT_EQ(TypesHash(ast), hash);
+}
+
+}
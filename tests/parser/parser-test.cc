@@ -0,0 +1,343 @@
+#include <jast/parser-builder.h>
+#include <jast/ast-match.h>
+#include <jast/ast-walker.h>
+
+#include <gtest/gtest.h>
+
+#include "../test-helpers.h"
+
+#include <string>
+#include <sstream>
+#include <type_traits>
+
+using namespace jast;
+using namespace jast::test;
+
+namespace {
+
+// parentheses don't show up in the AST, so an expression must give the same
+// tree as its fully parenthesized form
+#define EXPECT_SAME_AST(a, b) \
+    EXPECT_TRUE(LazyASTMatcher::match(Parse(a), Parse(b))) << a << " vs " << b
+
+#define EXPECT_DIFFERENT_AST(a, b) \
+    EXPECT_FALSE(LazyASTMatcher::match(Parse(a), Parse(b))) << a << " vs " << b
+
+class Depth : public ASTWalker {
+public:
+    size_t max = 0;
+
+protected:
+    bool Enter(Expression *expr) override
+    {
+        max = std::max(max, ++depth_);
+        return true;
+    }
+
+    void Leave(Expression *expr) override { depth_--; }
+
+private:
+    size_t depth_ = 0;
+};
+
+TEST(ParserTest, BinaryPrecedence) {
+    EXPECT_SAME_AST("a + b * c;", "a + (b * c);");
+    EXPECT_SAME_AST("a * b + c;", "(a * b) + c;");
+    EXPECT_SAME_AST("a - b + c;", "(a - b) + c;");
+    EXPECT_SAME_AST("a / b * c % d;", "((a / b) * c) % d;");
+    EXPECT_SAME_AST("a == b + c * d < e;", "a == ((b + (c * d)) < e);");
+    EXPECT_SAME_AST("a || b && c | d ^ e & f;",
+                    "a || (b && (c | (d ^ (e & f))));");
+    EXPECT_SAME_AST("a << b + c >>> d;", "(a << (b + c)) >>> d;");
+    EXPECT_SAME_AST("a in b instanceof c;", "(a in b) instanceof c;");
+    EXPECT_DIFFERENT_AST("a + b * c;", "(a + b) * c;");
+    EXPECT_DIFFERENT_AST("a - b - c;", "a - (b - c);");
+}
+
+TEST(ParserTest, Unary) {
+    EXPECT_SAME_AST("-a * b;", "(-a) * b;");
+    EXPECT_SAME_AST("+a;", "a * 1;");
+    EXPECT_SAME_AST("- -a + b;", "(-(-a)) + b;");
+    EXPECT_SAME_AST("!typeof a + b;", "(!(typeof a)) + b;");
+    EXPECT_SAME_AST("!a++ + b;", "(!(a++)) + b;");
+}
+
+TEST(ParserTest, AssignAndTernary) {
+    EXPECT_SAME_AST("a = b = c;", "a = (b = c);");
+    EXPECT_SAME_AST("a += b -= c;", "a += (b -= c);");
+    EXPECT_DIFFERENT_AST("a += b -= c;", "a = (b = c);");
+    EXPECT_SAME_AST("a = b + c;", "a = (b + c);");
+    EXPECT_SAME_AST("a ? b : c ? d : e;", "a ? b : (c ? d : e);");
+    EXPECT_SAME_AST("a ? b ? c : d : e;", "a ? (b ? c : d) : e;");
+    EXPECT_SAME_AST("a || b ? c : d;", "(a || b) ? c : d;");
+    EXPECT_SAME_AST("x = a ? b : c;", "x = (a ? b : c);");
+    EXPECT_SAME_AST("a ? b = c : d = e;", "a ? (b = c) : (d = e);");
+    EXPECT_SAME_AST("f(a ? b : c, d = e);", "f((a ? b : c), (d = e));");
+    EXPECT_SAME_AST("a = b, c ? d : e;", "(a = b), (c ? d : e);");
+}
+
+// properties stay in source order, duplicates included, and a name finds
+// the last of them
+TEST(ParserTest, ObjectLiteral) {
+    auto ast = Parse("x = { b: 1, a: 2, 'b': 3, c: 4 };");
+    auto assign = Statement(ast);
+    auto object = assign->AsAssignExpression()->rhs()->AsObjectLiteral();
+    auto &props = object->proxy();
+    ASSERT_EQ(4u, props.size());
+    const char *names[] = { "b", "a", "b", "c" };
+    for (size_t i = 0; i < props.size(); i++)
+        EXPECT_EQ(names[i], props[i].first);
+    EXPECT_EQ(&props[2], props.Find("b"));
+    EXPECT_EQ(&props[1], props.Find("a"));
+    EXPECT_EQ(nullptr, props.Find("d"));
+
+    // the properties of nested objects stay with their own object
+    EXPECT_EQ("x={a:{b:1,c:{d:2}},e:3};",
+        Print(Parse("x = { a: { b: 1, c: { d: 2 } }, e: 3 };")));
+    EXPECT_DIFFERENT_AST("({ a: 1, b: 2 });", "({ b: 2, a: 1 });");
+    EXPECT_DIFFERENT_AST("({ a: 1 });", "({ a: 1, a: 1 });");
+
+    // past kIndexedSize the names are found through the index
+    std::string source = "x = {";
+    for (int i = 0; i < 1000; i++)
+        source += " p" + std::to_string(i) + ": " + std::to_string(i) + ",";
+    source += " p7: 'again' };";
+    ast = Parse(source);
+    assign = Statement(ast);
+    object = assign->AsAssignExpression()->rhs()->AsObjectLiteral();
+    auto &many = object->proxy();
+    ASSERT_EQ(1001u, many.size());
+    // sized once by the parser, growing would copy the names
+    EXPECT_EQ(many.size(), many.capacity());
+    for (size_t i = 0; i < 1000; i++) {
+        auto name = "p" + std::to_string(i);
+        EXPECT_EQ(i == 7 ? &many[1000] : &many[i], many.Find(name)) << name;
+    }
+    EXPECT_EQ(nullptr, many.Find("p1000"));
+    many.Append("p1000", nullptr);
+    EXPECT_EQ(&many[1001], many.Find("p1000"));
+
+    // the index stays right, as only the values can be changed in place
+    static_assert(std::is_const<ProxyObject::value_type::first_type>::value,
+        "the names of the properties must be const");
+    for (auto &prop : many)
+        prop.second = nullptr;
+    EXPECT_EQ(&many[3], many.Find("p3"));
+}
+
+TEST(ParserTest, Accessors) {
+    auto ast = Parse("x = { a: 1, get b() { return 1; }, set b(v) {},"
+        " get: 2 };");
+    auto assign = Statement(ast);
+    auto &props = assign->AsAssignExpression()->rhs()->AsObjectLiteral()
+        ->proxy();
+    ASSERT_EQ(4u, props.size());
+    const char *names[] = { "a", "b", "b", "get" };
+    const PropertyKind kinds[] = { PropertyKind::kValue, PropertyKind::kGetter,
+        PropertyKind::kSetter, PropertyKind::kValue };
+    for (size_t i = 0; i < props.size(); i++) {
+        EXPECT_EQ(names[i], props[i].first);
+        EXPECT_EQ(kinds[i], props.kind(i));
+    }
+
+    EXPECT_DIFFERENT_AST("({ get b() {} });", "({ b() {} });");
+    EXPECT_DIFFERENT_AST("({ get b() {} });", "({ set b() {} });");
+}
+
+Handle<ArrayLiteral> ParseArray(const std::string &source,
+    const ParseOptions &options = ParseOptions::Packing())
+{
+    auto ast = Parse("x = " + source + ";", options);
+    auto assign = Statement(ast);
+    return assign->AsAssignExpression()->rhs()->AsArrayLiteral();
+}
+
+std::string Elements(size_t n, const char *quote = "")
+{
+    std::string elements;
+    for (size_t i = 0; i < n; i++)
+        elements += (i ? ", " : "") + (quote + std::to_string(i) + quote);
+    return elements;
+}
+
+TEST(ParserTest, PackedArray) {
+    // only with packing on
+    auto nodes = ParseArray("[" + Elements(1000) + " ]", ParseOptions());
+    EXPECT_FALSE(nodes->packed());
+    ASSERT_EQ(1000u, nodes->exprs().size());
+    EXPECT_EQ(999, nodes->exprs()[999]->AsIntegralLiteral()->value());
+
+    auto array = ParseArray("[" + Elements(1000) + " ]");
+    auto packed = array->packed();
+    ASSERT_TRUE(packed);
+    EXPECT_EQ(PackedArray::Kind::kNumber, packed->kind());
+    ASSERT_EQ(1000u, array->length());
+    for (size_t i = 0; i < 1000; i++)
+        EXPECT_EQ(i, packed->number(i));
+
+    array = ParseArray("[" + Elements(20, "'") + "]");
+    packed = array->packed();
+    ASSERT_TRUE(packed);
+    EXPECT_EQ(PackedArray::Kind::kString, packed->kind());
+    ASSERT_EQ(20u, packed->size());
+    EXPECT_EQ("0", packed->string(0));
+    EXPECT_EQ("19", packed->string(19));
+
+    // a table over several lines, with comments
+    std::string table = "[\n";
+    for (int row = 0; row < 8; row++) {
+        table += "  " + std::to_string(2 * row) + ", " + std::to_string(2 * row + 1)
+            + (row < 7 ? ",  // row\n" : " /* last */\n");
+    }
+    array = ParseArray(table + "]");
+    packed = array->packed();
+    ASSERT_TRUE(packed);
+    ASSERT_EQ(16u, packed->size());
+    EXPECT_EQ(14, packed->number(14));
+    EXPECT_EQ(15, packed->number(15));
+    EXPECT_FALSE(ParseArray(table + "/ 2]")->packed());
+
+    // short, mixed or with an expression for an element, they are nodes
+    EXPECT_FALSE(ParseArray("[" + Elements(15) + "]")->packed());
+    EXPECT_FALSE(ParseArray("[" + Elements(20) + ", 'a']")->packed());
+    EXPECT_FALSE(ParseArray("[" + Elements(20) + ", 1 + 2]")->packed());
+    EXPECT_FALSE(ParseArray("['a'.length, " + Elements(20) + "]")->packed());
+
+    // which have the positions of their tokens
+    array = ParseArray("[" + Elements(20) + ", a]");
+    auto &exprs = array->exprs();
+    ASSERT_EQ(21u, exprs.size());
+    EXPECT_TRUE(exprs[19]->IsIntegralLiteral());
+    EXPECT_LT(exprs[0]->loc().col(), exprs[19]->loc().col());
+    EXPECT_TRUE(exprs[20]->IsIdentifier());
+
+    // reading a packed array leaves it packed, the builder makes the nodes
+    // of its elements, where they were written
+    std::string source = "x = [" + Elements(19) + ",\n 19];";
+    std::istringstream is(source);
+    ParserBuilder builder(is);
+    builder.builder()->SetArrayPacking(true);
+    auto ast = ParseProgram(builder.Build());
+    auto assign = Statement(ast);
+    array = assign->AsAssignExpression()->rhs()->AsArrayLiteral();
+    ASSERT_TRUE(array->packed());
+    EXPECT_TRUE(array->exprs().empty());
+
+    builder.builder()->UnpackArrayLiteral(array.GetPtr());
+    EXPECT_FALSE(array->packed());
+    ASSERT_EQ(20u, array->exprs().size());
+    auto &first = array->exprs()[0];
+    auto &last = array->exprs()[19];
+    EXPECT_EQ(19, last->AsIntegralLiteral()->value());
+    EXPECT_EQ(array->GetScope(), last->GetScope());
+    EXPECT_EQ(0u, first->loc().row());
+    EXPECT_EQ(source.find('0') + 1, first->loc().col());
+    EXPECT_EQ(1u, last->loc().row());
+    EXPECT_EQ(2u, last->loc().col());
+
+    EXPECT_THROW(Parse("x = [" + Elements(20) + ",];"), std::exception);
+    EXPECT_THROW(Parse("x = [" + Elements(20) + " 1];"), std::exception);
+}
+
+Handle<StringLiteral> ParseString(const std::string &source)
+{
+    auto ast = Parse("x = " + source + ";");
+    auto assign = Statement(ast);
+    return assign->AsAssignExpression()->rhs()->AsStringLiteral();
+}
+
+TEST(ParserTest, StringValue) {
+    // without escapes the value is the text of the literal
+    auto str = ParseString("'plain text'");
+    EXPECT_EQ(&str->string(), &str->value());
+
+    str = ParseString(R"('it\'s\n\ta \\ \"b\"')");
+    EXPECT_EQ(R"(it\'s\n\ta \\ \"b\")", str->string());
+    EXPECT_EQ("it's\n\ta \\ \"b\"", str->value());
+    EXPECT_EQ(&str->value(), &str->value());
+
+    EXPECT_EQ("A\xc3\xa9\xe2\x82\xac", ParseString(R"('\x41é€')")->value());
+    EXPECT_EQ("\xf0\x9f\x98\x80\xf0\x9f\x98\x80",
+        ParseString(R"('\u{1F600}😀')")->value());
+    EXPECT_EQ(std::string("\0" "a\x07\xc3\xbf", 5),
+        ParseString(R"('\0a\7\377')")->value());
+    EXPECT_EQ("ab", ParseString("'a\\\nb'")->value());
+    EXPECT_EQ("ab", ParseString("'a\\\xe2\x80\xa8" "b'")->value());
+    EXPECT_EQ("ab", ParseString("'a\\\xe2\x80\xa9" "b'")->value());
+
+    // a new text is decoded again
+    str->set_string("\\t");
+    EXPECT_EQ("\t", str->value());
+
+    // malformed escapes are kept
+    EXPECT_EQ(R"(\xg\u12)", ParseString(R"('\xg\u12')")->value());
+}
+
+TEST(ParserTest, Errors) {
+    EXPECT_THROW(Parse("a ? b;"), std::exception);
+    EXPECT_THROW(Parse("a ? b : ;"), std::exception);
+    EXPECT_THROW(Parse("a + ;"), std::exception);
+    EXPECT_THROW(Parse("a = ;"), std::exception);
+}
+
+// none of these may recurse once per operator
+TEST(ParserTest, LongChains) {
+    const size_t length = 100000;
+    std::string assign = "a", ternary = "a", prefix;
+    for (size_t i = 0; i < length; i++) {
+        assign += "=a";
+        ternary += "?a:a";
+        prefix += "!";
+    }
+    prefix += "a";
+
+    Depth depth;
+    depth.Walk(Parse(assign + ";"));
+    EXPECT_EQ(length + 2, depth.max);
+
+    depth.max = 0;
+    depth.Walk(Parse(ternary + ";"));
+    EXPECT_EQ(length + 2, depth.max);
+
+    depth.max = 0;
+    depth.Walk(Parse(prefix + ";"));
+    EXPECT_EQ(length + 2, depth.max);
+}
+
+// a reset builder parses like a new one, also after an error, and the trees
+// it returned before stay valid
+TEST(ParserTest, Reuse) {
+    const char *inputs[] = {
+        "var a = [1, 2, 3];",
+        "x = a ? b : c + d * e;",
+        "function f(x) { if (x) return x.y(1); }",
+        "switch (a) { case 1: b; default: c; }",
+    };
+
+    std::istringstream is("first;");
+    ParserBuilder builder(is);
+    auto first = ParseProgram(builder.Build());
+
+    std::vector<Handle<Expression>> asts;
+    for (auto input : inputs) {
+        builder.Reset(input);
+        asts.push_back(ParseProgram(builder.Build()));
+        EXPECT_TRUE(LazyASTMatcher::match(Parse(input), asts.back()))
+            << input;
+
+        // an error half way through an operator expression
+        builder.Reset("a + b * (c ? d");
+        EXPECT_THROW(ParseProgram(builder.Build()), std::exception);
+    }
+
+    builder.Reset(std::string("\n\n  y;"));
+    auto last = ParseProgram(builder.Build());
+    auto stmt = Statement(last);
+    EXPECT_EQ(2u, stmt->loc().row());
+
+    EXPECT_TRUE(LazyASTMatcher::match(Parse("first;"), first));
+    for (size_t i = 0; i < asts.size(); i++)
+        EXPECT_TRUE(LazyASTMatcher::match(Parse(inputs[i]), asts[i]));
+}
+
+}
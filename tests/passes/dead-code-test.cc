@@ -0,0 +1,189 @@
+#include <jast/parser-builder.h>
+#include <jast/code-printer.h>
+#include <jast/dead-code.h>
+#include <jast/constant-folder.h>
+#include <jast/ast-hash.h>
+#include <jast/ast-match.h>
+
+#include <gtest/gtest.h>
+
+#include "../test-helpers.h"
+
+#include <sstream>
+#include <string>
+
+using namespace jast;
+using namespace jast::test;
+
+namespace {
+
+// `source` after a round of `Pass`
+template <typename Pass>
+std::string RunPass(const std::string &source)
+{
+    auto ast = Parse(source);
+    Pass pass;
+    pass.Run(ast);
+    return Print(ast);
+}
+
+std::string Optimize(const std::string &source)
+{
+    auto ast = Parse(source);
+    PassManager manager;
+    AddDeadCodePasses(&manager);
+    manager.Run(ast);
+    return Print(ast);
+}
+
+TEST(DeadCodeTest, DeadBranches) {
+    using Pass = DeadBranchElimination;
+    EXPECT_EQ("a();", RunPass<Pass>("if (1) a();"));
+    EXPECT_EQ("b();", RunPass<Pass>("if (0) a();b();"));
+    EXPECT_EQ("b();", RunPass<Pass>("if ('') a(); else b();"));
+    EXPECT_EQ("{a();}", RunPass<Pass>("if (!0 && 'x') { a(); } else b();"));
+    EXPECT_EQ("a();", RunPass<Pass>("if (typeof 1 == 'number' ? 1 : x) a();"));
+    EXPECT_EQ("while(x);", RunPass<Pass>("while (x) if (null) a();"));
+
+    // not a constant, or with a side effect
+    EXPECT_EQ("if(x)a();", RunPass<Pass>("if (x) a();"));
+    EXPECT_EQ("if(void f())a();", RunPass<Pass>("if (void f()) a();"));
+    EXPECT_EQ("if(0&&f()||g())a();", RunPass<Pass>("if (0 && f() || g()) a();"));
+
+    // the declarations of a dead branch are still hoisted
+    EXPECT_EQ("if(0){var x=1;}", RunPass<Pass>("if (0) { var x = 1; }"));
+    EXPECT_EQ("if(1)a();else function f(){}",
+        RunPass<Pass>("if (1) a(); else function f() {}"));
+    EXPECT_EQ("a();", RunPass<Pass>("if (1) a(); else (function () { var x; });"));
+}
+
+TEST(DeadCodeTest, UnreachableCode) {
+    using Pass = UnreachableCodeElimination;
+    EXPECT_EQ("function f(){a();return 1;}",
+        RunPass<Pass>("function f() { a(); return 1; b(); c(); }"));
+    EXPECT_EQ("while(x){continue;}", RunPass<Pass>("while (x) { continue; a(); }"));
+    EXPECT_EQ("throw e;", RunPass<Pass>("throw e; a();"));
+    EXPECT_EQ("while(x){if(a){break;}else{continue;}}",
+        RunPass<Pass>("while (x) { if (a) { break; } else { continue; } b(); }"));
+    EXPECT_EQ("while(x){{break;}}", RunPass<Pass>("while (x) { { break; } b(); }"));
+    EXPECT_EQ("while(x){if(a)break;b();}",
+        RunPass<Pass>("while (x) { if (a) break; b(); }"));
+
+    // a function or var after a return still declares its name
+    EXPECT_EQ("function f(){return g();function g(){}var x;}",
+        RunPass<Pass>("function f() { return g(); h(); function g() {} var x; }"));
+
+    // breaking to the label continues after it
+    EXPECT_EQ("l:{break l;}a();", RunPass<Pass>("l: { break l; } a();"));
+}
+
+TEST(DeadCodeTest, EmptyBlocks) {
+    using Pass = EmptyBlockElimination;
+    EXPECT_EQ("a();b();", RunPass<Pass>("a(); {} ; { {} ; } b();"));
+    EXPECT_EQ("if(x)a();", RunPass<Pass>("if (x) a(); else {}"));
+    EXPECT_EQ("if(x){}", RunPass<Pass>("if (x) {} else ;"));
+    EXPECT_EQ("while(x){}", RunPass<Pass>("while (x) { {} }"));
+    EXPECT_EQ("function f(){}", RunPass<Pass>("function f() { {} }"));
+    EXPECT_EQ("l:{}a();", RunPass<Pass>("l: {} a();"));
+
+    // the braces of a block in a block go, unless it declares something
+    EXPECT_EQ("a();b();c();", RunPass<Pass>("a(); { b(); { c(); } }"));
+    EXPECT_EQ("{var x=1;f(x);}", RunPass<Pass>("{ let x = 1; f(x); }"));
+    EXPECT_EQ("{function f(){}}", RunPass<Pass>("{ function f() {} }"));
+    EXPECT_EQ("l:{a();break l;}b();", RunPass<Pass>("l: { a(); break l; } b();"));
+    EXPECT_EQ("while(x){a();}", RunPass<Pass>("while (x) { { a(); } }"));
+}
+
+TEST(DeadCodeTest, DeadLoops) {
+    using Pass = DeadLoopElimination;
+    EXPECT_EQ("a();", RunPass<Pass>("while (false) { f(); } a();"));
+    EXPECT_EQ("if(x);", RunPass<Pass>("if (x) while (0) f();"));
+    EXPECT_EQ("while(1){f();}", RunPass<Pass>("while (1) { f(); }"));
+    EXPECT_EQ("while(0){var i;}", RunPass<Pass>("while (0) { var i; }"));
+    EXPECT_EQ("l:;a();", RunPass<Pass>("l: while (0) f(); a();"));
+}
+
+TEST(DeadCodeTest, Pipeline) {
+    EXPECT_EQ("function f(){a();return;}",
+        Optimize("function f() { if (1) { a(); return; } else b(); c(); }"));
+    EXPECT_EQ("a();", Optimize("while (0) {} if (0) { f(); } else {} a();"));
+    EXPECT_EQ("if(x)a();", Optimize("if (x) a(); else if (0) b();"));
+    EXPECT_EQ("", Optimize("{ if (!1) { while (0) ; } }"));
+}
+
+TEST(DeadCodeTest, Rounds) {
+    // EmptyBlocks runs last, so a second round finds what it left
+    auto ast = Parse("l: {} while (x) { if (0) a(); }");
+    PassManager manager;
+    manager.Add<EmptyBlockElimination>();
+    manager.Add<DeadBranchElimination>();
+    EXPECT_EQ(2u, manager.size());
+    EXPECT_TRUE(manager.Run(ast, 1));
+    EXPECT_EQ("l:{}while(x){}", Print(ast));
+
+    ast = Parse("while (x) { if (0) a(); }");
+    EXPECT_TRUE(manager.Run(ast, 3));
+    EXPECT_EQ("while(x){}", Print(ast));
+    EXPECT_FALSE(manager.Run(ast, 3));
+}
+
+// a tree which was hashed before the passes still matches what they made
+TEST(DeadCodeTest, Hashes) {
+    const char *source =
+        "if (0) { a(); } b();\n"
+        "while (x) { if (1) { d(); } else e(); }\n"
+        "g(2 * 3);\n";
+    const char *expected =
+        "b();\n"
+        "while (x) { d(); }\n"
+        "g(6);\n";
+    auto ast = Parse(source);
+    auto optimized = Parse(expected);
+    StructuralHasher::Hash(ast, HashSensitivity::kTypesAndValues);
+    StructuralHasher::Hash(optimized, HashSensitivity::kTypesAndValues);
+
+    PassManager manager;
+    manager.Add<ConstantFoldingPass>();
+    AddDeadCodePasses(&manager);
+    EXPECT_TRUE(manager.Run(ast, 2));
+    EXPECT_EQ(Print(optimized), Print(ast));
+    EXPECT_TRUE(LazyASTMatcher::match(ast, optimized));
+    EXPECT_EQ(StructuralHasher::Hash(optimized, HashSensitivity::kTypesAndValues),
+        StructuralHasher::Hash(ast, HashSensitivity::kTypesAndValues));
+}
+
+TEST(DeadCodeTest, Statistics) {
+    SKIP_WITHOUT_COUNTERS();
+    auto ast = Parse("if (0) { a(); b(); } while (0) c(); d();");
+    Statistics stats;
+    stats.SetTimersEnabled(true);
+    PassManager manager(&stats);
+    AddDeadCodePasses(&manager);
+    manager.Run(ast, 2);
+    EXPECT_EQ("d();", Print(ast));
+
+    auto &passes = stats.passes();
+    ASSERT_EQ(4u, passes.size());
+    EXPECT_EQ("DeadLoops", passes[0].name);
+    EXPECT_EQ("DeadBranches", passes[1].name);
+    for (auto &pass : passes) {
+        EXPECT_EQ(2u, pass.runs);
+        EXPECT_GE(pass.nodes_before, pass.nodes_after);
+    }
+
+    // a call is 3 nodes, with its callee and arguments, so the loop was 5
+    // and the if 9
+    EXPECT_EQ(passes[0].nodes_before, passes[0].nodes_after + 5);
+    EXPECT_EQ(passes[1].nodes_before, passes[1].nodes_after + 9);
+    EXPECT_EQ(1u, stats.histogram(Phase::kOptimize).count());
+
+    std::ostringstream json;
+    stats.DumpJSON(json);
+    EXPECT_NE(std::string::npos, json.str().find("\"DeadLoops\": {\"runs\": 2"));
+    std::ostringstream prometheus;
+    stats.DumpPrometheus(prometheus);
+    EXPECT_NE(std::string::npos, prometheus.str().find(
+        "jast_pass_runs_total{pass=\"DeadBranches\"} 2\n"));
+}
+
+}
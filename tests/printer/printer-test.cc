@@ -0,0 +1,336 @@
+#include <jast/parser-builder.h>
+#include <jast/code-printer.h>
+#include <jast/source-map.h>
+#include <jast/ast-match.h>
+
+#include <gtest/gtest.h>
+
+#include "../test-helpers.h"
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <sstream>
+#include <vector>
+
+using namespace jast;
+using namespace jast::test;
+
+namespace {
+
+std::string Print(const std::string &source, bool minify,
+    SourceMapGenerator *map = nullptr, bool names = false)
+{
+    return test::Print(Parse(source), minify, map, names);
+}
+
+// output of the printer must parse back into something that prints the same
+#define ROUNDTRIP_TEST(str, expected) \
+do {    \
+    std::string printed = Print(str, true); \
+    ASSERT_EQ(printed, expected); \
+    ASSERT_EQ(Print(printed, true), printed); \
+    ASSERT_EQ(Print(Print(str, false), true), printed); \
+} while (0)
+
+std::string Encode(int64_t value)
+{
+    std::string out;
+    VLQ::Encode(out, value);
+    return out;
+}
+
+TEST(VLQTest, Encode) {
+    ASSERT_EQ(Encode(0), "A");
+    ASSERT_EQ(Encode(1), "C");
+    ASSERT_EQ(Encode(-1), "D");
+    ASSERT_EQ(Encode(15), "e");
+    ASSERT_EQ(Encode(16), "gB");
+    ASSERT_EQ(Encode(-16), "hB");
+    ASSERT_EQ(Encode(1000), "w+B");
+}
+
+TEST(VLQTest, Decode) {
+    std::string in;
+    const int64_t values[] = { 0, 1, -1, 16, -17, 123456789, -987654321 };
+    for (auto value : values)
+        VLQ::Encode(in, value);
+
+    size_t pos = 0;
+    int64_t value;
+    for (auto expected : values) {
+        ASSERT_TRUE(VLQ::Decode(in, pos, value));
+        ASSERT_EQ(value, expected);
+    }
+    ASSERT_EQ(pos, in.length());
+    ASSERT_FALSE(VLQ::Decode(in, pos, value));
+
+    pos = 0;
+    ASSERT_FALSE(VLQ::Decode("g", pos, value));
+    pos = 0;
+    ASSERT_FALSE(VLQ::Decode("!", pos, value));
+}
+
+TEST(SourceMapTest, Mappings) {
+    SourceMapGenerator map("out.js");
+    map.AddSource("in.js");
+    int name = map.AddName("foo");
+    ASSERT_EQ(map.AddName("foo"), name);
+
+    map.AddMapping(0, 0, 0, 0);
+    map.AddMapping(0, 4, 0, 4, 0, name);
+    map.AddMapping(0, 6, 0, 4);     // same original position, dropped
+    map.AddMapping(2, 2, 1, 2);
+    ASSERT_EQ(map.mappings(), "AAAA,IAAIA;;EACF");
+    ASSERT_EQ(map.size(), 3u);
+    ASSERT_EQ(map.ToString(),
+        "{\"version\":3,\"file\":\"out.js\",\"sources\":[\"in.js\"],"
+        "\"names\":[\"foo\"],\"mappings\":\"AAAA,IAAIA;;EACF\"}");
+}
+
+TEST(CodePrinterTest, Expressions) {
+    ROUNDTRIP_TEST("a = b + c * d;", "a=b+c*d;");
+    ROUNDTRIP_TEST("a = (b + c) * d;", "a=(b+c)*d;");
+    ROUNDTRIP_TEST("a - (b - c);", "a-(b-c);");
+    ROUNDTRIP_TEST("a = b = c;", "a=b=c;");
+    ROUNDTRIP_TEST("x = a ? b : c ? d : e;", "x=a?b:c?d:e;");
+    ROUNDTRIP_TEST("a - -b + +c;", "a- -b+ +c;");
+    ROUNDTRIP_TEST("a++ + ++b;", "a++ + ++b;");
+    ROUNDTRIP_TEST("x = typeof !a;", "x=typeof!a;");
+    ROUNDTRIP_TEST("new Foo(1).bar[2](3);", "new Foo(1).bar[2](3);");
+    ROUNDTRIP_TEST("(1).toString();", "(1).toString();");
+    ROUNDTRIP_TEST("x = 'it\\'s';", "x=\"it\\'s\";");
+    ROUNDTRIP_TEST("x = 'say \"hi\"';", "x=\"say \\\"hi\\\"\";");
+    ROUNDTRIP_TEST("r = /ab+c/gi;", "r=/ab+c/gi;");
+    ROUNDTRIP_TEST("o = {a: 1, 'b c': [1, 2]};", "o={a:1,\"b c\":[1,2]};");
+    ROUNDTRIP_TEST("o = {b: 1, a: 2, b: 3};", "o={b:1,a:2,b:3};");
+    // arrays which are packed with packing on, see PackedArrays
+    ROUNDTRIP_TEST("t = [0, 0.5, 1, 1.5, 2, 2.5, 3, 3.5, 4, 4.5, 5, 5.5, 6, 6.5,"
+        " 7, 1000];", "t=[0,0.5,1,1.5,2,2.5,3,3.5,4,4.5,5,5.5,6,6.5,7,1000];");
+    ROUNDTRIP_TEST("t = ['a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k',"
+        " 'l', 'm', 'n', 'o', 'say \\'hi\\''];", "t=[\"a\",\"b\",\"c\",\"d\","
+        "\"e\",\"f\",\"g\",\"h\",\"i\",\"j\",\"k\",\"l\",\"m\",\"n\",\"o\","
+        "\"say \\'hi\\'\"];");
+    ROUNDTRIP_TEST("({a: 1}).a;", "({a:1}.a);");
+    ROUNDTRIP_TEST("(function() { return 1; })();",
+        "(function(){return 1;}());");
+}
+
+// packed arrays print like the same arrays made of nodes
+TEST(CodePrinterTest, PackedArrays) {
+    std::string numbers = "t = [", strings = "s = [";
+    for (int i = 0; i < 20; i++) {
+        numbers += std::to_string(i) + ".5, ";
+        strings += "'" + std::to_string(i) + "\\'', ";
+    }
+    numbers += "1000];";
+    strings += "'last'];";
+
+    for (auto &source : { numbers, strings }) {
+        auto packed = Parse(source, ParseOptions::Packing());
+        ASSERT_TRUE(Statement(packed)->AsAssignExpression()->rhs()
+            ->AsArrayLiteral()->packed());
+        for (bool minify : { true, false })
+            EXPECT_EQ(Print(source, minify), test::Print(packed, minify));
+    }
+}
+
+TEST(CodePrinterTest, Statements) {
+    ROUNDTRIP_TEST("var a = 1, b;", "var a=1,b;");
+    ROUNDTRIP_TEST("if (a) if (b) c(); else d();",
+        "if(a)if(b)c();else d();");
+    ROUNDTRIP_TEST("if (a) { if (b) c(); } else d();",
+        "if(a){if(b)c();}else d();");
+    ROUNDTRIP_TEST("for (var i = 0; i < 10; i++) f(i);",
+        "for(var i=0;i<10;i++)f(i);");
+    ROUNDTRIP_TEST("for (k in o) f(k);", "for(k in o)f(k);");
+    ROUNDTRIP_TEST("do x--; while (x);", "do x--;while(x);");
+    ROUNDTRIP_TEST("switch (x) { case 1: case 2: y(); default: z(); }",
+        "switch(x){case 1:case 2:y();default:z();}");
+    ROUNDTRIP_TEST("try { a(); } catch (e) { b(e); } finally { c(); }",
+        "try{a();}catch(e){b(e);}finally{c();}");
+    ROUNDTRIP_TEST("function f(a, b) { return a, b; }",
+        "function f(a,b){return a,b;}");
+    ROUNDTRIP_TEST("function f() { if (a) return; return; }",
+        "function f(){if(a)return;return;}");
+    ROUNDTRIP_TEST("l: for (;;) { if (a) continue l; break l; }",
+        "l:for(;true;){if(a)continue l;break l;}");
+    ROUNDTRIP_TEST("while (a) if (b) throw c;", "while(a)if(b)throw c;");
+}
+
+// a program written the way the printer lays it out prints back as its own
+// source text, which catches what a lossy tree and its reparse both forget
+#define SOURCE_TEST(str) EXPECT_EQ(Print(str, false), str)
+
+TEST(CodePrinterTest, Source) {
+    SOURCE_TEST("a = 1;\n");
+    SOURCE_TEST("a += 1;\nb -= c;\nc *= 2;\nd /= 2;\ne %= 2;\n");
+    SOURCE_TEST("a <<= 1;\nb >>= 1;\nc >>>= 2;\n");
+    SOURCE_TEST("a &= 1;\nb |= 1;\nc ^= 1;\n");
+    SOURCE_TEST("a = b += c -= 1;\n");
+    SOURCE_TEST("o.x += f(a = 1);\n");
+    ROUNDTRIP_TEST("a += 1; b -= c; a >>>= 2;", "a+=1;b-=c;a>>>=2;");
+
+    SOURCE_TEST("o = {get x() {\n    return 1;\n}, set x(v) {\n    y = v;\n"
+        "}, get: 1};\n");
+    ROUNDTRIP_TEST("o = {get x() { return 1; }, set y(v) { y = v; }};",
+        "o={get x(){return 1;},set y(v){y=v;}};");
+
+    // the ';' the parser leaves to an empty statement stays on the line
+    SOURCE_TEST("function f() {\n    if (a)\n        return;\n    throw e;\n"
+        "    while (1) {\n        break;\n        continue;\n    }\n"
+        "    return;\n}\n");
+}
+
+// an accessor whose value is not a function can't be printed as one
+TEST(CodePrinterTest, AccessorNotAFunction) {
+    auto ast = Parse("o = {get x() { return 1; }};");
+    auto &props = Statement(ast)->AsAssignExpression()->rhs()
+        ->AsObjectLiteral()->proxy();
+    props[0].second = Parse("1;");
+    EXPECT_THROW(test::Print(ast), std::runtime_error);
+}
+
+// the printed program must parse back into the tree it was printed from
+#define REPARSE_TEST(str) \
+do {    \
+    for (bool minify : { true, false }) { \
+        std::string printed = Print(str, minify); \
+        EXPECT_TRUE(LazyASTMatcher::match(Parse(str), Parse(printed))) \
+            << str << " printed as " << printed; \
+    } \
+} while (0)
+
+TEST(CodePrinterTest, Reparse) {
+    REPARSE_TEST("a = {2: 1, '3': 2, 10: x, 0.5: y, 1e3: z};");
+    REPARSE_TEST("a = {2:1}; b = {\"2\":[1]};");
+    REPARSE_TEST("a = 1e21 + 1.5e-7 + 2e+3 + 0x1f; b = .5 + 1.;");
+    REPARSE_TEST("a = b ? 1:2; c = {f: function () { return 1; }, 1: 2};");
+    REPARSE_TEST("x = a - -b + +c - (-d) + !(e && f || g);");
+    REPARSE_TEST("function f(a, b) { return a.b[c](new D(e), `t`); }");
+}
+
+// a decoded mapping: generated line and column, source index, original line
+// and column and, when present, the name index
+typedef std::vector<int64_t> Segment;
+
+std::vector<Segment> DecodeMappings(const std::string &mappings)
+{
+    std::vector<Segment> segments;
+    size_t pos = 0;
+    int64_t gen_line = 0, gen_col = 0, source = 0, line = 0, col = 0, name = 0;
+    while (pos < mappings.length()) {
+        if (mappings[pos] == ';') {
+            gen_line++;
+            gen_col = 0;
+            pos++;
+            continue;
+        }
+        if (mappings[pos] == ',') {
+            pos++;
+            continue;
+        }
+
+        int64_t delta;
+        Segment segment{ gen_line };
+        EXPECT_TRUE(VLQ::Decode(mappings, pos, delta));
+        segment.push_back(gen_col += delta);
+        EXPECT_TRUE(VLQ::Decode(mappings, pos, delta));
+        segment.push_back(source += delta);
+        EXPECT_TRUE(VLQ::Decode(mappings, pos, delta));
+        segment.push_back(line += delta);
+        EXPECT_TRUE(VLQ::Decode(mappings, pos, delta));
+        segment.push_back(col += delta);
+        if (pos < mappings.length() && mappings[pos] != ','
+                && mappings[pos] != ';') {
+            EXPECT_TRUE(VLQ::Decode(mappings, pos, delta));
+            segment.push_back(name += delta);
+        }
+        segments.push_back(segment);
+    }
+    return segments;
+}
+
+std::vector<std::string> SplitLines(const std::string &text)
+{
+    std::vector<std::string> lines;
+    std::istringstream is(text);
+    std::string line;
+    while (std::getline(is, line))
+        lines.push_back(line);
+    return lines;
+}
+
+// the token at `col` of `line`: a word, or else a single character
+std::string TokenAt(const std::string &line, size_t col)
+{
+    if (col >= line.length())
+        return std::string();
+    size_t end = col;
+    while (end < line.length() && (isalnum(line[end]) || line[end] == '_'
+                || line[end] == '$' || line[end] == '.'))
+        end++;
+    return line.substr(col, std::max(end, col + 1) - col);
+}
+
+TEST(CodePrinterTest, SourceMap) {
+    SourceMapGenerator map;
+    map.AddSource("in.js");
+    std::string printed = Print("var   a =\n  foo;", true, &map, true);
+    ASSERT_EQ(printed, "var a=foo;");
+
+    // `foo` is printed at column 6 and comes from line 1, column 2
+    auto segments = DecodeMappings(map.mappings());
+    ASSERT_FALSE(segments.empty());
+    bool found_foo = false;
+    for (auto &segment : segments) {
+        if (segment[1] == 6) {
+            ASSERT_EQ(segment[3], 1);
+            ASSERT_EQ(segment[4], 2);
+            ASSERT_EQ(segment.size(), 6u);
+            ASSERT_NE(map.ToString().find("\"names\":[\"foo\"]"),
+                std::string::npos);
+            found_foo = true;
+        }
+    }
+    ASSERT_TRUE(found_foo);
+}
+
+TEST(CodePrinterTest, SourceMapPositions) {
+    const char *source =
+        "var a = [1, 'two', /3/g],\n"
+        "    b = { x: a, y: function (z) {\n"
+        "        return z * 2;\n"
+        "    } };\n"
+        "for (var k in b) { if (!k) { continue; } else a.push(new F(k, this)); }\n"
+        "do {\n"
+        "  a = a ? (a, null) : void 0;\n"
+        "} while (--i);\n"
+        "switch (x) { case 1: y = f(a, b); break; default: y = -x; }\n"
+        "function g(p, q) { let r = p[q] || q.r; return r; }\n";
+    auto original = SplitLines(source);
+
+    for (bool minify : { true, false }) {
+        SourceMapGenerator map;
+        map.AddSource("in.js");
+        auto generated = SplitLines(Print(source, minify, &map));
+
+        // every mapping starts a token which is spelled the same in the
+        // source, strings only differ in the quotes
+        auto segments = DecodeMappings(map.mappings());
+        ASSERT_GT(segments.size(), 25u);
+        for (auto &segment : segments) {
+            ASSERT_LT(segment[0], (int64_t)generated.size());
+            ASSERT_LT(segment[3], (int64_t)original.size());
+            std::string out = TokenAt(generated[segment[0]], segment[1]);
+            std::string in = TokenAt(original[segment[3]], segment[4]);
+            if (out == "\"")
+                out = "'";
+            EXPECT_EQ(in, out) << "generated " << segment[0] << ":"
+                << segment[1] << ", original " << segment[3] << ":"
+                << segment[4];
+        }
+    }
+}
+
+}
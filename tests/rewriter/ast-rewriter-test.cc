@@ -0,0 +1,252 @@
+#include <jast/parser-builder.h>
+#include <jast/ast-children.h>
+#include <jast/ast-hash.h>
+#include <jast/ast-match.h>
+#include <jast/ast-rewriter.h>
+#include <jast/code-printer.h>
+#include <jast/constant-folder.h>
+
+#include <gtest/gtest.h>
+
+#include "../test-helpers.h"
+
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace jast;
+using namespace jast::test;
+
+namespace {
+
+void Preorder(Expression *node, std::vector<Expression*> &out)
+{
+    out.push_back(node);
+    ForEachChild(node, [&out](Expression *child) { Preorder(child, out); });
+}
+
+bool IsIdentifier(Expression *expr, const char *name)
+{
+    return expr->IsIdentifier()
+        && static_cast<Identifier*>(expr)->GetName() == name;
+}
+
+// a rewriter which calls `leave`
+class Lambda : public ASTRewriter {
+public:
+    using Function = std::function<Handle<Expression>(Lambda*,
+        Handle<Expression>)>;
+
+    explicit Lambda(Function leave) : leave_{ leave } { }
+
+    using ASTRewriter::InsertBefore;
+    using ASTRewriter::InsertAfter;
+
+protected:
+    Handle<Expression> Leave(Handle<Expression> expr) override
+    {
+        return leave_(this, expr);
+    }
+
+private:
+    Function leave_;
+};
+
+const char *kSource =
+    "var a = [1, 2, 3], b = { x: a, y: function (z) { return z * 2; } };\n"
+    "for (;;) { if (a) break; }\n"
+    "switch (x) { case 1: y = f(a, b); break; default: y = !x; }\n"
+    "try { g(a); } catch (e) { h(e); } finally { a = 0; }\n";
+
+// slots are the children ForEachChild gives, and visiting them changes
+// nothing
+TEST(ASTRewriterTest, Identity) {
+    auto ast = Parse(kSource);
+    std::vector<Expression*> nodes;
+    Preorder(ast.GetPtr(), nodes);
+    std::vector<int> references;
+    for (auto node : nodes)
+        references.push_back(node->GetNumReferences());
+    auto printed = Print(ast);
+
+    Lambda rewriter([](Lambda *, Handle<Expression> expr) { return expr; });
+    EXPECT_EQ(ast.GetPtr(), rewriter.Rewrite(ast).GetPtr());
+
+    std::vector<Expression*> after;
+    Preorder(ast.GetPtr(), after);
+    EXPECT_EQ(nodes, after);
+    for (size_t i = 0; i < nodes.size(); i++)
+        EXPECT_EQ(references[i], nodes[i]->GetNumReferences());
+    EXPECT_EQ(printed, Print(ast));
+}
+
+// the parents of a new node are kept and changed in place
+TEST(ASTRewriterTest, Replace) {
+    auto ast = Parse("f(a + g(a * 2), [a]); b = a;");
+    std::vector<Expression*> nodes;
+    Preorder(ast.GetPtr(), nodes);
+    std::vector<bool> replaced;
+    for (auto node : nodes)
+        replaced.push_back(IsIdentifier(node, "a"));
+    auto c = Parse("c;");
+    auto replacement = Statement(c);
+
+    Lambda rewriter([&replacement](Lambda *, Handle<Expression> expr) {
+        return IsIdentifier(expr.GetPtr(), "a") ? replacement : expr;
+    });
+    EXPECT_EQ(ast.GetPtr(), rewriter.Rewrite(ast).GetPtr());
+    EXPECT_EQ("f(c+g(c*2),[c]);b=c;", Print(ast));
+
+    std::vector<Expression*> after;
+    Preorder(ast.GetPtr(), after);
+    ASSERT_EQ(nodes.size(), after.size());
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (!replaced[i])
+            EXPECT_EQ(nodes[i], after[i]);
+        else
+            EXPECT_EQ(replacement.GetPtr(), after[i]);
+    }
+}
+
+// the hashes of the nodes which were written to and of their ancestors are
+// reset, the others are kept
+TEST(ASTRewriterTest, Hashes) {
+    auto ast = Parse("f(a + g(a * 2), [a]); b = a; h(1 + 2);");
+    auto expected = Parse("f(c + g(c * 2), [c]); b = c; h(1 + 2);");
+    StructuralHasher::Hash(ast);
+    StructuralHasher::Hash(expected);
+    EXPECT_FALSE(LazyASTMatcher::match(ast, expected));
+    auto untouched = Statement(ast, 2);
+    uint64_t hash = untouched->hash();
+
+    auto c = Parse("c;");
+    auto replacement = Statement(c);
+    Lambda rewriter([&replacement](Lambda *, Handle<Expression> expr) {
+        return IsIdentifier(expr.GetPtr(), "a") ? replacement : expr;
+    });
+    rewriter.Rewrite(ast);
+    EXPECT_EQ(0u, ast->hash());
+    EXPECT_EQ(0u, Statement(ast)->hash());
+    EXPECT_EQ(0u, Statement(ast, 1)->hash());
+    EXPECT_EQ(hash, untouched->hash());
+
+    EXPECT_TRUE(LazyASTMatcher::match(ast, expected));
+    EXPECT_EQ(StructuralHasher::Hash(expected), StructuralHasher::Hash(ast));
+}
+
+TEST(ASTRewriterTest, Remove) {
+    auto ast = Parse("log(1); f(0, 1, 0); a = [0, 2]; { log(2); }"
+                     " var x = 1, y = 0; return 0;");
+    Lambda rewriter([](Lambda *, Handle<Expression> expr) {
+        if (expr->IsIntegralLiteral()
+                && !static_cast<IntegralLiteral*>(expr.GetPtr())->value())
+            return Handle<Expression>();
+        if (expr->IsMemberExpression() && IsIdentifier(
+                expr->AsMemberExpression()->expr().GetPtr(), "log"))
+            return Handle<Expression>();
+        if (expr->IsDeclaration() && expr->AsDeclaration()->name() == "y")
+            return Handle<Expression>();
+        return expr;
+    });
+    rewriter.Rewrite(ast);
+    EXPECT_EQ("f(1);a=[2];{}var x=1;return;", Print(ast));
+
+    // the root too
+    EXPECT_FALSE(rewriter.Rewrite(Parse("log(3);")
+        ->AsBlockStatement()->statements()->raw_list()[0]));
+}
+
+TEST(ASTRewriterTest, Insert) {
+    auto ast = Parse("function f(a) { if (a) return 1; g(); return 2; }"
+                     " h(a, b);");
+    auto trace = Parse("trace();");
+    auto call = Statement(trace);
+
+    Lambda rewriter([&call](Lambda *self, Handle<Expression> expr) {
+        if (expr->IsReturnStatement()) {
+            // a single slot, the if's body, takes no siblings
+            self->InsertBefore(call);
+        } else if (IsIdentifier(expr.GetPtr(), "a")) {
+            self->InsertAfter(call);
+        } else if (IsIdentifier(expr.GetPtr(), "b")) {
+            self->InsertBefore(call);
+            self->InsertAfter(call);
+            return Handle<Expression>();
+        }
+        return expr;
+    });
+    rewriter.Rewrite(ast);
+    EXPECT_EQ("function f(a){if(a)return 1;g();trace();return 2;}"
+              "h(a,trace(),trace(),trace());", Print(ast));
+}
+
+// Enter() can keep a subtree out of the rewrite
+class OutsideFunctions : public ASTRewriter {
+protected:
+    bool Enter(Expression *expr) override
+    {
+        return !expr->IsFunctionStatement();
+    }
+
+    Handle<Expression> Leave(Handle<Expression> expr) override
+    {
+        return expr->IsIdentifier() ? Handle<Expression>(nullptr) : expr;
+    }
+};
+
+TEST(ASTRewriterTest, Enter) {
+    auto ast = Parse("f(a, function () { return a; }, b);");
+    OutsideFunctions rewriter;
+    rewriter.Rewrite(ast);
+    EXPECT_EQ("(function(){return a;});", Print(ast));
+}
+
+// a million levels, on the heap
+TEST(ASTRewriterTest, Deep) {
+    std::string source = "x = a";
+    for (int i = 0; i < 100000; i++)
+        source += " + a";
+    auto ast = Parse(source + ";");
+
+    size_t replaced = 0;
+    auto b = Parse("b;")->AsBlockStatement()->statements()->raw_list()[0];
+    Lambda rewriter([&b, &replaced](Lambda *, Handle<Expression> expr) {
+        if (!IsIdentifier(expr.GetPtr(), "a"))
+            return expr;
+        replaced++;
+        return b;
+    });
+    rewriter.Rewrite(ast);
+    EXPECT_EQ(100001u, replaced);
+}
+
+TEST(ASTRewriterTest, ConstantFolding) {
+    const char *sources[] = {
+        "x = 1 + 2 * 3; y = 'a' + 1 + x;",
+        "f(!0 ? a : b, typeof 'x', 1 << 31, 0 && g(), '' || h);",
+        "if (2 > 1 && x) { z = -(4 / 2) + +'3'; }",
+    };
+    for (auto source : sources) {
+        auto ast = Parse(source);
+        auto statement = Statement(ast);
+
+        ConstantFoldingPass pass;
+        EXPECT_TRUE(pass.Run(ast));
+        EXPECT_EQ(Print(Parse(source, ParseOptions::Folding())), Print(ast));
+        EXPECT_EQ(statement.GetPtr(),
+            Statement(ast).GetPtr());
+        EXPECT_FALSE(pass.Run(ast));
+    }
+
+    // the tree matches the folded one even if it was hashed before
+    auto ast = Parse("x = 1 + 2; y = [a, 2 * 3];");
+    auto folded = Parse("x = 1 + 2; y = [a, 2 * 3];", ParseOptions::Folding());
+    StructuralHasher::Hash(ast);
+    StructuralHasher::Hash(folded);
+    ConstantFoldingPass pass;
+    EXPECT_TRUE(pass.Run(ast));
+    EXPECT_TRUE(LazyASTMatcher::match(ast, folded));
+}
+
+}
@@ -0,0 +1,142 @@
+#include <jast/parser-builder.h>
+#include <jast/ast-walker.h>
+#include <jast/scope-resolver.h>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace jast;
+
+namespace {
+
+// every Identifier with its binding, in source order
+class Identifiers : public ASTWalker {
+public:
+    std::vector<Identifier*> all;
+
+protected:
+    bool Enter(Expression *expr) override
+    {
+        if (expr->IsIdentifier())
+            all.push_back(expr->AsIdentifier().GetPtr());
+        return true;
+    }
+};
+
+std::string Show(const Binding &binding)
+{
+    if (!binding.resolved())
+        return "-";
+    if (binding.global())
+        return "global";
+    return std::to_string(binding.depth) + ":" + std::to_string(binding.slot);
+}
+
+// `name=binding` for every identifier
+std::string Resolve(ParserBuilder &builder, Handle<Expression> ast)
+{
+    ScopeResolver(builder.manager()).Resolve(ast);
+
+    Identifiers identifiers;
+    identifiers.Walk(ast);
+    std::string result;
+    for (auto ident : identifiers.all) {
+        if (!result.empty())
+            result += " ";
+        result += ident->GetName() + "=" + Show(ident->binding());
+    }
+    return result;
+}
+
+std::string Resolve(const char *source)
+{
+    std::istringstream is(source);
+    ParserBuilder builder(is);
+    return Resolve(builder, ParseProgram(builder.Build()));
+}
+
+// a `var` is declared by its Declaration, the identifiers are the uses
+TEST(ScopeResolverTest, Globals) {
+    EXPECT_EQ("b=global a=0:0 c=global",
+        Resolve("var a = b; a = c;"));
+    EXPECT_EQ("x=global y=- z=- y=global", Resolve("x.y.z = y;"));
+}
+
+TEST(ScopeResolverTest, Functions) {
+    // parameters come first, then the hoisted `var`s and functions
+    EXPECT_EQ("b=1:1 a=1:0 g=1:2 c=2:0 a=1:0 b=1:1 f=0:0",
+        Resolve("function f(a, b) {\n"
+                "    b = a + g();\n"
+                "    var g = function (c) { return c + a + b; };\n"
+                "}\n"
+                "f();\n"));
+
+    // a declaration binds the name outside, an expression only inside
+    EXPECT_EQ("g=1:0 g=global h=0:1",
+        Resolve("var f = function g() { g(); }; g(); function h() { h(); }"));
+}
+
+TEST(ScopeResolverTest, Catch) {
+    EXPECT_EQ("x=global e=1:0 e=1:0 x=global e=1:0 e=0:0",
+        Resolve("try { throw x; } catch (e) { var e = e; x = e; } e;"));
+}
+
+TEST(ScopeResolverTest, NotVariables) {
+    EXPECT_EQ("a=global b=- a=- o=global b=- c=global a=-",
+        Resolve("a.b(); a: while (1) { o.b[c]; break a; }"));
+}
+
+TEST(ScopeResolverTest, Arguments) {
+    EXPECT_EQ("arguments=1:1 x=1:0 arguments=global",
+        Resolve("function f(x) { return arguments[0] + x; } arguments;"));
+}
+
+// every node points at its innermost scope
+TEST(ScopeResolverTest, Scopes) {
+    std::istringstream is("var a; function f(x) { try { } catch (e) { a; } }");
+    ParserBuilder builder(is);
+    auto ast = ParseProgram(builder.Build());
+    Resolve(builder, ast);
+
+    Identifiers identifiers;
+    identifiers.Walk(ast);
+    ASSERT_EQ(2u, identifiers.all.size());
+    auto catch_scope = identifiers.all[1]->GetScope();
+    ASSERT_EQ(Scope::Kind::kCatch, catch_scope->kind());
+    EXPECT_EQ(2u, catch_scope->depth());
+    EXPECT_EQ(identifiers.all[0]->GetScope(), catch_scope);
+
+    auto function_scope = catch_scope->parent();
+    EXPECT_EQ(Scope::Kind::kFunction, function_scope->kind());
+    EXPECT_EQ(function_scope, catch_scope->VarScope());
+    EXPECT_TRUE(function_scope->root()->IsFunctionStatement());
+    EXPECT_EQ(builder.manager()->global_scope(), function_scope->parent());
+    EXPECT_EQ(2u, builder.manager()->global_scope()->symbol_table()->size());
+}
+
+// a hash-consed tree shares the identifiers of different scopes, which
+// can't each have their own binding
+TEST(ScopeResolverTest, HashConsed) {
+    const char *source = "var x; function f(x) { return x + 1; } x + 1;";
+    std::istringstream is(source);
+    ParserBuilder builder(is);
+    builder.builder()->SetHashConsing(true);
+    auto ast = ParseProgram(builder.Build());
+    EXPECT_THROW(ScopeResolver(builder.manager()).Resolve(ast),
+        std::runtime_error);
+
+    EXPECT_EQ("x=1:0 x=0:0", Resolve(source));
+}
+
+// the statements of `case 1:` and `case 2:` are the same nodes, declared and
+// resolved once, and the walk sees them under both clauses
+TEST(ScopeResolverTest, FallThrough) {
+    EXPECT_EQ("x=global y=2:0 a=1:0 e=1:1 y=2:0 a=1:0 e=1:1",
+        Resolve("switch (x) { case 1: case 2: var f = function (a) {"
+                " try { } catch (y) { a = e; var e; } }; }"));
+}
+
+}
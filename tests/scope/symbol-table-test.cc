@@ -0,0 +1,79 @@
+#include <jast/context.h>
+#include <jast/scope.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace jast;
+
+namespace {
+
+std::vector<SymT::Name> Names(ScopeManager &manager, int count)
+{
+    std::vector<SymT::Name> names;
+    for (int i = 0; i < count; i++)
+        names.push_back(manager.Intern("name" + std::to_string(i)));
+    return names;
+}
+
+TEST(SymTTest, Intern) {
+    ParserContext context;
+    ScopeManager manager(&context);
+    EXPECT_EQ(manager.Intern("a"), manager.Intern(std::string("a")));
+    EXPECT_NE(manager.Intern("a"), manager.Intern("b"));
+}
+
+// slots follow the declarations, in the inline entries and past them
+TEST(SymTTest, Slots) {
+    ParserContext context;
+    ScopeManager manager(&context);
+    auto names = Names(manager, 1000);
+    SymT *table = manager.global_scope()->symbol_table();
+
+    for (size_t i = 0; i < names.size(); i++) {
+        EXPECT_EQ(i, table->Push(names[i], nullptr));
+        EXPECT_EQ(i + 1, table->size());
+
+        // again, and the ones before, keep their slots
+        EXPECT_EQ(i, table->Push(names[i], nullptr));
+        EXPECT_EQ(i / 2, table->Push(names[i / 2], nullptr));
+        for (size_t j = 0; j <= i; j += 1 + i / 8) {
+            auto entry = table->Lookup(names[j]);
+            ASSERT_NE(nullptr, entry);
+            EXPECT_EQ(j, entry->slot);
+        }
+    }
+    EXPECT_EQ(names.size(), table->size());
+    EXPECT_FALSE(table->Exists(manager.Intern("other")));
+
+    table->Clear();
+    EXPECT_EQ(0u, table->size());
+    EXPECT_FALSE(table->Exists(names[0]));
+    EXPECT_EQ(0u, table->Push(names[999], nullptr));
+    EXPECT_TRUE(table->Exists(names[999]));
+}
+
+// scopes come from the context and are gone with Reset()
+TEST(SymTTest, Scopes) {
+    ParserContext context;
+    ScopeManager manager(&context);
+    auto name = manager.Intern("a");
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 200; i++) {
+            Scope *scope = manager.NewScope(nullptr);
+            EXPECT_EQ((uint32_t)i + 1, scope->depth());
+            EXPECT_EQ(0u, scope->symbol_table()->size());
+            scope->symbol_table()->Push(name, nullptr);
+        }
+        for (int i = 0; i < 200; i++)
+            manager.PopScope();
+        EXPECT_EQ(manager.global_scope(), manager.current());
+        manager.Reset();
+        name = manager.Intern("a");
+    }
+}
+
+}
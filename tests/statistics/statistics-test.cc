@@ -0,0 +1,122 @@
+#include <jast/parser-builder.h>
+#include <jast/statistics.h>
+
+#include <gtest/gtest.h>
+
+#include "../test-helpers.h"
+
+#include <string>
+#include <sstream>
+
+using namespace jast;
+
+namespace {
+
+const char *kSource =
+    "var a = 1 + 2;\n"
+    "function f(x) { return x / 2; }\n"
+    "f(a);\n";
+
+void Parse(Statistics *stats, bool timers)
+{
+    std::istringstream is(kSource);
+    ParserBuilder builder(is);
+    builder.context()->Counters().SetTimersEnabled(timers);
+    ParseProgram(builder.Build());
+    *stats = builder.context()->Counters();
+}
+
+TEST(StatisticsTest, Histogram) {
+    LatencyHistogram h;
+    EXPECT_EQ(0u, h.Percentile(50));
+
+    h.Record(0);
+    h.Record(1);
+    h.Record(1000);
+    h.Record(1023);
+    h.Record(1024);
+    EXPECT_EQ(1u, h.bucket(0));
+    EXPECT_EQ(1u, h.bucket(1));
+    EXPECT_EQ(2u, h.bucket(10));
+    EXPECT_EQ(1u, h.bucket(11));
+    EXPECT_EQ(5u, h.count());
+    EXPECT_EQ(3048u, h.sum());
+    EXPECT_EQ(0u, h.min());
+    EXPECT_EQ(1024u, h.max());
+
+    // upper bounds of the buckets, never more than the maximum
+    EXPECT_EQ(1024u, h.Percentile(60));
+    EXPECT_EQ(1024u, h.Percentile(100));
+
+    h += h;
+    EXPECT_EQ(10u, h.count());
+    EXPECT_EQ(4u, h.bucket(10));
+
+    EXPECT_EQ(LatencyHistogram::kBuckets - 1,
+        LatencyHistogram::Bucket(UINT64_MAX));
+}
+
+TEST(StatisticsTest, NodeCounts) {
+    SKIP_WITHOUT_COUNTERS();
+    Statistics stats;
+    Parse(&stats, false);
+
+    size_t nodes = 0;
+    for (int i = 1; i < (int)ASTNodeType::kNrType; i++)
+        nodes += stats.NodeCount((ASTNodeType)i);
+    EXPECT_EQ(stats.ASTNode(), nodes);
+
+    EXPECT_EQ(2u, stats.NodeCount(ASTNodeType::kBinaryExpression));
+    EXPECT_EQ(2 * sizeof(BinaryExpression),
+        stats.NodeBytes(ASTNodeType::kBinaryExpression));
+}
+
+TEST(StatisticsTest, Timers) {
+    SKIP_WITHOUT_COUNTERS();
+    Statistics stats;
+    Parse(&stats, false);
+    EXPECT_EQ(0u, stats.histogram(Phase::kParse).count());
+    EXPECT_EQ(0u, stats.histogram(Phase::kTokenize).count());
+
+    Parse(&stats, true);
+    EXPECT_EQ(1u, stats.histogram(Phase::kParse).count());
+    EXPECT_EQ(stats.Token(), stats.histogram(Phase::kTokenize).count());
+    EXPECT_LE(stats.histogram(Phase::kTokenize).sum(),
+        stats.histogram(Phase::kParse).sum());
+
+    Statistics total;
+    total += stats;
+    total += stats;
+    EXPECT_EQ(2 * stats.Token(), total.Token());
+    EXPECT_EQ(2u, total.histogram(Phase::kParse).count());
+    EXPECT_EQ(4u, total.NodeCount(ASTNodeType::kBinaryExpression));
+}
+
+TEST(StatisticsTest, Output) {
+    SKIP_WITHOUT_COUNTERS();
+    Statistics stats;
+    Parse(&stats, true);
+
+    std::ostringstream json;
+    stats.DumpJSON(json);
+    EXPECT_NE(std::string::npos, json.str().find("\"Token\": "
+        + std::to_string(stats.Token())));
+    EXPECT_NE(std::string::npos, json.str().find(
+        "\"BinaryExpression\": {\"count\": 2"));
+    EXPECT_NE(std::string::npos, json.str().find("\"parse\": {\"count\": 1"));
+    EXPECT_EQ(std::string::npos, json.str().find("\"visit\""));
+
+    std::ostringstream prometheus;
+    stats.DumpPrometheus(prometheus, "js");
+    auto text = prometheus.str();
+    EXPECT_NE(std::string::npos, text.find("js_token_total "
+        + std::to_string(stats.Token()) + "\n"));
+    EXPECT_NE(std::string::npos, text.find(
+        "js_ast_nodes_by_type_total{type=\"BinaryExpression\"} 2\n"));
+    EXPECT_NE(std::string::npos, text.find(
+        "js_phase_duration_seconds_bucket{phase=\"parse\",le=\"+Inf\"} 1\n"));
+    EXPECT_NE(std::string::npos, text.find(
+        "js_phase_duration_seconds_count{phase=\"parse\"} 1\n"));
+}
+
+}
@@ -0,0 +1,114 @@
+#ifndef TEST_HELPERS_H_
+#define TEST_HELPERS_H_
+
+#include <jast/parser-builder.h>
+#include <jast/code-printer.h>
+#include <jast/scope-resolver.h>
+#include <jast/statistics.h>
+
+#include <sstream>
+#include <string>
+
+// skips a test which reads the counters, the node counts, the phase timers
+// or the allocation profiler when they are compiled out (DISABLE_COUNTERS)
+#ifdef DISABLE_COUNTERS
+#define SKIP_WITHOUT_COUNTERS() GTEST_SKIP() << "built with DISABLE_COUNTERS"
+#else
+#define SKIP_WITHOUT_COUNTERS()
+#endif
+
+// helpers shared by the gtest suites under tests/
+namespace jast {
+namespace test {
+
+// a program which has a node of most types, with children of every kind of
+// slot: lists, optional ones, a function scope and shared clause bodies
+const char *const kProgram =
+    "var a = [1, 'two', /3/g, `four`], b = { x: a, 'y': function (z) {"
+    " return z * 2; } };\n"
+    "for (var k in b) { if (!k) { continue; } else a.push(new F(k, this)); }\n"
+    "do { a = a ? (a, null) : void 0; } while (--i);\n"
+    "switch (x) { case 1: case 2: y = f(a, b); break; default: y = -x; }\n"
+    "outer: while (true) { try { throw e; } catch (e) { break outer; }"
+    " finally { i++; } }\n"
+    "function g(p, q) { let r = p[q] || q.r; return r; }\n";
+
+struct ParseOptions {
+    bool folding = false;
+    bool hash_consing = false;
+    bool packing = false;
+    // the identifiers are bound by a ScopeResolver
+    bool resolve = false;
+    // the counters of the parse are copied to it
+    Statistics *stats = nullptr;
+
+    static ParseOptions Folding()
+    {
+        ParseOptions options;
+        options.folding = true;
+        return options;
+    }
+
+    static ParseOptions HashConsing()
+    {
+        ParseOptions options;
+        options.hash_consing = true;
+        return options;
+    }
+
+    static ParseOptions Packing()
+    {
+        ParseOptions options;
+        options.packing = true;
+        return options;
+    }
+
+    static ParseOptions Resolved()
+    {
+        ParseOptions options;
+        options.resolve = true;
+        return options;
+    }
+};
+
+// the AST of the program `source`, throws on a syntax error
+inline Handle<Expression> Parse(const std::string &source,
+    const ParseOptions &options = ParseOptions())
+{
+    std::istringstream is(source);
+    ParserBuilder builder(is);
+    builder.builder()->SetConstantFolding(options.folding);
+    builder.builder()->SetHashConsing(options.hash_consing);
+    builder.builder()->SetArrayPacking(options.packing);
+    auto ast = ParseProgram(builder.Build());
+    if (options.resolve)
+        ScopeResolver(builder.manager()).Resolve(ast);
+    if (options.stats)
+        *options.stats = builder.context()->Counters();
+    return ast;
+}
+
+// `ast` printed, minified by default. with a `map`, its source map is added
+// to it, with the `names` of the identifiers if set
+inline std::string Print(Handle<Expression> ast, bool minify = true,
+    SourceMapGenerator *map = nullptr, bool names = false)
+{
+    std::ostringstream os;
+    CodePrinter printer(os, map, minify);
+    printer.SetRecordNames(names);
+    printer.Print(ast);
+    printer.Flush();
+    return os.str();
+}
+
+// the statement `index` of the program `program`
+inline Handle<Expression> Statement(Handle<Expression> program,
+    size_t index = 0)
+{
+    return program->AsBlockStatement()->statements()->raw_list()[index];
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,153 @@
+#include <jast/parser-builder.h>
+#include <jast/ast-hash.h>
+#include <jast/ast-match.h>
+#include <jast/code-printer.h>
+
+#include <gtest/gtest.h>
+
+#include "../test-helpers.h"
+
+#include <atomic>
+#include <string>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace jast;
+using namespace jast::test;
+
+namespace {
+
+const int kThreads = 8;
+const int kRounds = 50;
+
+const char *kSources[] = {
+    "var a = [1, 2, 3], b = { x: a, 'y': function (z) { return z * 2; } };\n",
+    "function f(n) { return n < 2 ? n : f(n - 1) + f(n - 2); }\nf(10);\n",
+    "switch (x) { case 1: y = /ab+c/g.test(s); break; default: y = !x; }\n",
+    "for (var i = 0; i < 10; i++) { while (j--) { if (k) continue; } }\n",
+    "try { throw new Error('e'); } catch (e) { a.b.c(e, 1, 'two'); }\n",
+};
+
+// each one is a syntax error
+const char *kErrors[] = {
+    "a ? b;",
+    "var = 1;",
+    "f(1, 2;",
+};
+
+std::string Error(ParserBuilder &builder)
+{
+    try {
+        ParseProgram(builder.Build());
+    } catch (std::exception &e) {
+        return e.what();
+    }
+    return "";
+}
+
+// every thread parses everything over and over, with a new builder or a
+// reused one, and must always get what a single thread gets
+TEST(ThreadsTest, IndependentParses) {
+    std::vector<std::string> printed, errors;
+    for (auto source : kSources) {
+        std::istringstream is(source);
+        ParserBuilder builder(is);
+        printed.push_back(Print(ParseProgram(builder.Build())));
+    }
+    for (auto source : kErrors) {
+        std::istringstream is(source);
+        ParserBuilder builder(is);
+        errors.push_back(Error(builder));
+        ASSERT_NE("", errors.back());
+    }
+
+    std::atomic<int> mismatches{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t]() {
+            std::istringstream empty;
+            ParserBuilder reused(empty);
+            reused.builder()->SetHashConsing(t % 2 == 1);
+
+            for (int round = 0; round < kRounds; round++) {
+                for (size_t i = 0; i < printed.size(); i++) {
+                    std::istringstream is(kSources[i]);
+                    ParserBuilder builder(is);
+                    if (Print(ParseProgram(builder.Build())) != printed[i])
+                        mismatches++;
+
+                    reused.Reset(kSources[i]);
+                    if (Print(ParseProgram(reused.Build())) != printed[i])
+                        mismatches++;
+                }
+                for (size_t i = 0; i < errors.size(); i++) {
+                    reused.Reset(kErrors[i]);
+                    if (Error(reused) != errors[i])
+                        mismatches++;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    EXPECT_EQ(0, mismatches.load());
+}
+
+// trees parsed by workers are read and freed by the main thread after the
+// workers are joined
+TEST(ThreadsTest, Handoff) {
+    std::vector<Handle<Expression>> trees(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&trees, t]() {
+            std::istringstream is(kSources[t % 5]);
+            ParserBuilder builder(is);
+            trees[t] = ParseProgram(builder.Build());
+            StructuralHasher::Hash(trees[t]);
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    for (int t = 0; t < kThreads; t++) {
+        std::istringstream is(kSources[t % 5]);
+        ParserBuilder builder(is);
+        EXPECT_TRUE(FastASTMatcher::match(trees[t],
+            ParseProgram(builder.Build())));
+    }
+    trees.clear();
+}
+
+#ifdef ATOMIC_REFCOUNT
+// with atomic reference counts, threads may all read, hash and drop
+// handles to the same tree
+TEST(ThreadsTest, SharedTree) {
+    std::istringstream is(kSources[0]);
+    ParserBuilder builder(is);
+    auto shared = ParseProgram(builder.Build());
+    auto expected = Print(shared);
+    int references = shared->GetNumReferences();
+
+    std::atomic<int> mismatches{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&]() {
+            for (int round = 0; round < kRounds; round++) {
+                Handle<Expression> copy = shared;
+                StructuralHasher::Hash(copy);
+                if (Print(copy) != expected)
+                    mismatches++;
+                if (!LazyASTMatcher::match(copy, shared))
+                    mismatches++;
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    EXPECT_EQ(0, mismatches.load());
+    EXPECT_EQ(references, shared->GetNumReferences());
+}
+#endif
+
+}
@@ -43,5 +43,30 @@ TEST(ScannerTest, normalScanning) {
     delete scanner;
 }
 
+TEST(ScannerTest, readUntil) {
+    // longer than a chunk, so that the scan goes on in the next one
+    std::string source = "'" + std::string(20000, 'a') + "\\n'";
+    std::istringstream stream(source);
+    Scanner buffered(stream);
+    Scanner *scanner = &buffered;
+    std::string str;
+
+    Expect('\'');
+    scanner->putback('b');
+    scanner->putback('c');
+    EXPECT_EQ(20002u, scanner->readuntil(str, '\'', '\\', '\n'));
+    EXPECT_EQ("cb" + std::string(20000, 'a'), str);
+    Expect('\\');
+
+    // a put back character it stops at stays
+    scanner->putback('\\');
+    EXPECT_EQ(0u, scanner->readuntil(str, '\'', '\\', '\n'));
+    Expect('\\');
+    EXPECT_EQ(1u, scanner->readuntil(str, '\'', '\\', '\n'));
+    Expect('\'');
+    EXPECT_EQ(0u, scanner->readuntil(str, '\'', '\\', '\n'));
+    Expect(EOF);
+}
+
 }
 
@@ -42,6 +42,9 @@ TEST_F(TokenizerTest, Integers) {
     TOKENIZER_TEST("123", NUMBER, "123");
     TOKENIZER_TEST("0", NUMBER, "0");
     TOKENIZER_TEST("2", NUMBER, "2");
+    TOKENIZER_TEST("2:", NUMBER, "2");
+    TOKENIZER_TEST("10,", NUMBER, "10");
+    TOKENIZER_TEST("1+2", NUMBER, "1");
 }
 
 TEST_F(TokenizerTest, RealNumbers) {
@@ -53,6 +56,9 @@ TEST_F(TokenizerTest, RealNumbers) {
     TOKENIZER_TEST("1e10", NUMBER, "1e10");
     TOKENIZER_TEST("1.2e.123", NUMBER, "1.2e");
     TOKENIZER_TEST("1.23e103", NUMBER, "1.23e103");
+    TOKENIZER_TEST("1e+21", NUMBER, "1e+21");
+    TOKENIZER_TEST("1.5e-7-1", NUMBER, "1.5e-7");
+    TOKENIZER_TEST("0.5:", NUMBER, "0.5");
 }
 
 TEST_F(TokenizerTest, HexNumbers) {
@@ -99,6 +105,31 @@ TEST_F(TokenizerTest, ComplexTest1) {
     ASSERT_EQ(tokenizer.peek(), tok);   \
     tokenizer.advance()
 
+TEST_F(TokenizerTest, LongStrings) {
+    // the escapes stay as they were written, over the chunks of the input
+    std::string text;
+    for (int i = 0; i < 4000; i++)
+        text += "ab\\'cd\\\\";
+    INIT("x = '" + text + "' +\n`a\nb` + y");
+
+    CHECK(IDENTIFIER);
+    CHECK(ASSIGN);
+    ASSERT_EQ(tokenizer.peek(), TokenType::STRING);
+    EXPECT_EQ(text, tokenizer.currentToken().view());
+    tokenizer.advance();
+    EXPECT_EQ(0u, tokenizer.currentToken().position().row());
+    // the `+`, columns count from 1
+    EXPECT_EQ(text.size() + 8, tokenizer.currentToken().position().col());
+    CHECK(ADD);
+
+    ASSERT_EQ(tokenizer.peek(), TokenType::TEMPLATE);
+    EXPECT_EQ("a\nb", tokenizer.currentToken().view());
+    tokenizer.advance();
+    EXPECT_EQ(2u, tokenizer.currentToken().position().row());
+    CHECK(ADD);
+    CHECK(IDENTIFIER);
+}
+
 TEST_F(TokenizerTest, ComplexTest2) {
     INIT("1.23.poer??:-=+");
     CHECK(NUMBER);
@@ -0,0 +1,142 @@
+#include <jast/parser-builder.h>
+#include <jast/trace.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace jast;
+
+namespace {
+
+const char *kSource =
+    "function f(x) { return function () { return x; }; }\n"
+    "var a = f(1);\n";
+
+void Parse()
+{
+    std::istringstream is(kSource);
+    ParserBuilder builder(is);
+    ParseProgram(builder.Build());
+}
+
+std::string Trace()
+{
+    std::ostringstream os;
+    Tracer::Write(os);
+    return os.str();
+}
+
+size_t Count(const std::string &str, const std::string &what)
+{
+    size_t count = 0;
+    for (size_t i = str.find(what); i != std::string::npos;
+            i = str.find(what, i + 1))
+        count++;
+    return count;
+}
+
+class TraceTest : public ::testing::Test {
+protected:
+    void TearDown() override
+    {
+        Tracer::Stop();
+        Tracer::Clear();
+    }
+};
+
+TEST_F(TraceTest, Disabled) {
+    Tracer::Clear();
+    Parse();
+    EXPECT_EQ(0u, Count(Trace(), "\"ph\""));
+}
+
+TEST_F(TraceTest, ParseEvents) {
+    Tracer::Clear();
+    Tracer::Start();
+    Parse();
+    Tracer::Stop();
+
+    // stopped, nothing more is recorded
+    Parse();
+
+    auto trace = Trace();
+    EXPECT_EQ(1u, Count(trace, "\"name\": \"ParseProgram\""));
+    EXPECT_EQ(2u, Count(trace, "\"name\": \"statement\""));
+    EXPECT_EQ(2u, Count(trace, "\"name\": \"function\""));
+    EXPECT_EQ(1u, Count(trace, "\"args\": {\"name\": \"f\"}"));
+    EXPECT_EQ(1u, Count(trace, "\"args\": {\"name\": \"(anonymous)\"}"));
+    EXPECT_EQ(1u, Count(trace, "\"args\": {\"name\": \"line 2\"}"));
+    EXPECT_EQ(Count(trace, "\"ph\": \"B\""), Count(trace, "\"ph\": \"E\""));
+}
+
+TEST_F(TraceTest, Refills) {
+    // more than three chunks of the scanner
+    std::string source;
+    while (source.size() <= 3 * 16384)
+        source += "var a = 1;\n";
+
+    Tracer::Clear();
+    Tracer::Start();
+    {
+        std::istringstream is(source);
+        ParserBuilder builder(is);
+        ParseProgram(builder.Build());
+    }
+    Tracer::Stop();
+
+    auto trace = Trace();
+    EXPECT_LE(4u, Count(trace, "\"name\": \"refill\""));
+    EXPECT_EQ(Count(trace, "\"name\": \"refill\""),
+        Count(trace, "\"cat\": \"tokenizer\""));
+    EXPECT_EQ(Count(trace, "\"ph\": \"B\""), Count(trace, "\"ph\": \"E\""));
+}
+
+TEST_F(TraceTest, FullBufferStaysBalanced) {
+    Tracer::Clear();
+    Tracer::Start(8);
+    {
+        TraceScope a("a", "test");
+        TraceScope b("b", "test");
+        for (int i = 0; i < 10; i++)
+            TraceScope c("c", "test");
+    }
+    Tracer::Stop();
+
+    auto trace = Trace();
+    EXPECT_EQ(4u, Count(trace, "\"ph\": \"B\""));
+    EXPECT_EQ(4u, Count(trace, "\"ph\": \"E\""));
+    EXPECT_EQ(8u, Tracer::dropped());
+}
+
+TEST_F(TraceTest, Threads) {
+    Tracer::Clear();
+    Tracer::Start();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([i]() {
+            Tracer::SetThreadName("worker \"" + std::to_string(i) + "\"");
+            Parse();
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    Tracer::Stop();
+
+    auto trace = Trace();
+    EXPECT_EQ(4u, Count(trace, "\"name\": \"ParseProgram\""));
+    EXPECT_EQ(4u, Count(trace, "\"name\": \"thread_name\""));
+    EXPECT_EQ(1u, Count(trace, "\"name\": \"worker \\\"3\\\"\""));
+
+    // the thread name, 5 begin and end pairs of the parser and 2 of the
+    // refills, the one which reads the source and the one which finds its
+    // end, on each track
+    for (int tid = 1; tid <= 4; tid++)
+        EXPECT_EQ(15u, Count(trace, "\"tid\": " + std::to_string(tid))) << tid;
+}
+
+}
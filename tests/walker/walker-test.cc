@@ -0,0 +1,120 @@
+#include <jast/parser-builder.h>
+#include <jast/ast-hash.h>
+#include <jast/ast-walker.h>
+
+#include <gtest/gtest.h>
+
+#include "../test-helpers.h"
+
+#include <string>
+#include <sstream>
+#include <vector>
+
+using namespace jast;
+using namespace jast::test;
+
+namespace {
+
+// records "+Type" on enter and "-Type" on leave
+class Recorder : public ASTWalker {
+public:
+    std::vector<std::string> events;
+    ASTNodeType skip = ASTNodeType::kNullLiteral;
+
+protected:
+    bool Enter(Expression *expr) override
+    {
+        events.push_back("+" + Name(expr));
+        return expr->type() != skip;
+    }
+
+    void Leave(Expression *expr) override
+    {
+        events.push_back("-" + Name(expr));
+    }
+
+private:
+    static std::string Name(Expression *expr)
+    {
+        if (expr->IsIdentifier())
+            return expr->AsIdentifier()->GetName();
+        if (expr->IsBinaryExpression())
+            return "bin";
+        if (expr->IsBlockStatement())
+            return "block";
+        return "?";
+    }
+};
+
+class Counter : public ASTWalker {
+public:
+    size_t count = 0;
+
+protected:
+    bool Enter(Expression *expr) override
+    {
+        count++;
+        return true;
+    }
+};
+
+TEST(ASTWalkerTest, SourceOrder) {
+    Recorder recorder;
+    recorder.Walk(Parse("a + b * c;"));
+
+    std::vector<std::string> expected = {
+        "+block", "+bin", "+a", "-a", "+bin", "+b", "-b", "+c", "-c", "-bin",
+        "-bin", "-block"
+    };
+    ASSERT_EQ(expected, recorder.events);
+}
+
+TEST(ASTWalkerTest, SkipChildren) {
+    Recorder recorder;
+    recorder.skip = ASTNodeType::kBinaryExpression;
+    recorder.Walk(Parse("a * b; c;"));
+
+    std::vector<std::string> expected = {
+        "+block", "+bin", "+c", "-c", "-block"
+    };
+    ASSERT_EQ(expected, recorder.events);
+}
+
+// neither walking, hashing nor freeing may recurse once per level
+TEST(ASTWalkerTest, DeepChain) {
+    const size_t depth = 300000;
+    std::string source = "a";
+    for (size_t i = 0; i < depth; i++)
+        source += "+a";
+    source += ";";
+
+    auto ast = Parse(source);
+    Counter counter;
+    counter.Walk(ast);
+    ASSERT_EQ(2 * depth + 2, counter.count);
+
+    ASSERT_NE(0u, StructuralHasher::Hash(ast, HashSensitivity::kTypes));
+    StructuralHasher::Clear(ast);
+    ASSERT_EQ(0u, ast->hash());
+    ast.clear();
+}
+
+TEST(ASTWalkerTest, DeepLadder) {
+    const size_t depth = 300000;
+    auto factory = ASTFactory::GetFactoryInstance();
+    Position pos;
+
+    Handle<Expression> tail = factory->NewIdentifier(pos, nullptr, "a");
+    for (size_t i = 0; i < depth; i++) {
+        tail = factory->NewIfElseStatement(pos, nullptr,
+            factory->NewIdentifier(pos, nullptr, "a"),
+            factory->NewIdentifier(pos, nullptr, "a"), tail);
+    }
+
+    Counter counter;
+    counter.Walk(tail);
+    ASSERT_EQ(3 * depth + 1, counter.count);
+    tail.clear();
+}
+
+}